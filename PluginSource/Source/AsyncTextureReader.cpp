@@ -1,4 +1,3 @@
-
 //  Copyright(c) 2016, Michal Skalsky
 //  All rights reserved.
 //
@@ -29,6 +28,11 @@
 #include "Unity/IUnityGraphics.h"
 #include "PlatformBase.h"
 #include "RendererAPI.h"
+#include "CommandQueue.h"
+#include "HandleTable.h"
+#include "CompletionNotifier.h"
+#include "ReadbackStats.h"
+#include "ReadbackTrace.h"
 
 #include "assert.h"
 #include <vector>
@@ -43,14 +47,46 @@ FuncPtr DebugLog;
 
 static Status sLastStatus = Status::Succeeded;
 
-// list of resource handles waiting for request
-// maximum of 128 resources can be requested at one time. can't be dynamic and thread safe at the same time. 128 should be big enough
-// still not necessary thread safe !!!
-//std::vector<void*> sResources(128);
-static const int sResourcesSize = 128;
-static void* sResources[sResourcesSize];
+// id of the last request, or of the data returned by the last successful retrieve
+static int sLastRequestId = -1;
+static int sNextRequestId = 0;
+
+// data handed out by AcquireReadback, lease id is id of the request
+struct Lease
+{
+	int requestId;
+	int resourceHandle;
+};
+static std::vector<Lease> sLeases;
+
+// commands waiting for render thread. main thread pushes command and returns its event id,
+// user code passes the id to IssuePluginEvent and render thread executes all commands up to that id
+static CommandQueue sCommands;
+static int sNextEventId = 0;
+
+// resources requested together by RequestBatch, delivered together by RetrieveBatch
+struct BatchMember
+{
+	int resourceHandle;
+	int requestId;
+};
+
+struct Batch
+{
+	std::vector<BatchMember> members;
+};
+static HandleTable<Batch> sBatches;
+
+// finished requests of every resource, outlives renderer so wait handle stays valid
+static CompletionNotifier sCompletions;
+// counters of every thread, outlive renderer so queued commands are counted across device resets
+static ReadbackStats sStats;
+// timeline of request steps, disabled until SetReadbackTrace
+static ReadbackTrace sTrace;
 
 static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType eventType);
+static void UNITY_INTERFACE_API OnRenderEvent(int eventID);
+static void UNITY_INTERFACE_API OnPollEvent(int eventID);
 
 //-------------------------------------------------------------------------------------------------
 // UnityPluginLoad
@@ -83,12 +119,18 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
         assert(sCurrentAPI == NULL);
         sDeviceType = sUnityGraphics->GetRenderer();
         sCurrentAPI = CreateRendererAPI(sDeviceType);
+        if (sCurrentAPI != NULL)
+        {
+            sCurrentAPI->SetCompletionNotifier(&sCompletions);
+            sCurrentAPI->SetReadbackStats(&sStats);
+            sCurrentAPI->SetReadbackTrace(&sTrace);
+        }
+    }
 
-		// clear resources array
-		for (int i = 0; i < sResourcesSize; ++i)
-		{
-			sResources[i] = NULL;
-		}
+    if (eventType == kUnityGfxDeviceEventShutdown)
+    {
+        // finish queued commands, some of them own released resources
+        OnRenderEvent((sNextEventId - 1) & 0x7fffffff);
     }
 
     if (sCurrentAPI != NULL)
@@ -99,168 +141,372 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
     if (eventType == kUnityGfxDeviceEventShutdown)
     {        
         SAFE_DELETE(sCurrentAPI);
+        sLeases.clear();
+        sBatches.Clear([](Batch* batch) { delete batch; });
         sDeviceType = kUnityGfxRendererNull;
     }
 }
 
 //-------------------------------------------------------------------------------------------------
-// FindFreeResourceSlot
+// PushCommand
 //-------------------------------------------------------------------------------------------------
-int FindFreeResourceSlot()
+// adds command to the next event, TakeEventId closes the event once all its commands are queued
+static bool PushCommand(CommandType type, int resourceHandle, void* resource = NULL)
 {
-	for (int i = 0; i < sResourcesSize; ++i)
-	{
-		if (sResources[i] == NULL)
-			return i;
-	}
+	Command command;
+	command.eventId = sNextEventId;
+	command.type = type;
+	command.resourceHandle = resourceHandle;
+	command.resource = resource;
 
-	return -1;
+	if (!sCommands.Push(command))
+		return false;
+
+	ReadbackStats::Raise(sStats.maxQueuedCommands, sStats.queuedCommands.fetch_add(1, std::memory_order_relaxed) + 1);
+	return true;
+}
 
-	// can't resize vector. it isn't thread safe
-	//sResources.push_back(NULL);
-	//return sResources.size() - 1;
+//-------------------------------------------------------------------------------------------------
+// TakeEventId
+//-------------------------------------------------------------------------------------------------
+static int TakeEventId()
+{
+	int eventId = sNextEventId;
+	sNextEventId = (sNextEventId + 1) & 0x7fffffff;
+	return eventId;
 }
 
 //-------------------------------------------------------------------------------------------------
-// OnRequestTextureEvent
+// QueueCommand
 //-------------------------------------------------------------------------------------------------
-static void UNITY_INTERFACE_API OnRequestTextureEvent(int eventID)
+static int QueueCommand(CommandType type, int resourceHandle, void* resource = NULL)
 {
-	if (sCurrentAPI != NULL && eventID >= 0 && eventID < sResourcesSize && sResources[eventID] != NULL)
+	if (!PushCommand(type, resourceHandle, resource))
 	{
-		sCurrentAPI->RequestTextureData_RenderThread(sResources[eventID]);
-		// free resource slot for future use
-		sResources[eventID] = NULL;
+		sLastStatus = Status::Error_TooManyRequests;
+		return -1;
 	}
+
+	return TakeEventId();
 }
 
 //-------------------------------------------------------------------------------------------------
-// GetRequestTextureEventFunc
+// OnRenderEvent
 //-------------------------------------------------------------------------------------------------
-extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRequestTextureEventFunc()
+static void UNITY_INTERFACE_API OnRenderEvent(int eventID)
 {
-	return OnRequestTextureEvent;
+	ReadbackStats::Clock::time_point start = ReadbackStats::Clock::now();
+
+	// execute everything that was queued for this event (and earlier events that got lost)
+	Command command;
+	while (sCommands.Pop(eventID, &command))
+	{
+		ReadbackStats::Add(sStats.queuedCommands, -1);
+		if (sCurrentAPI == NULL)
+			continue;
+
+		switch (command.type)
+		{
+		case CommandType::RequestTexture:
+			sCurrentAPI->RequestTextureData_RenderThread(command.resourceHandle);
+			break;
+		case CommandType::RequestBuffer:
+			sCurrentAPI->RequestBufferData_RenderThread(command.resourceHandle);
+			break;
+		case CommandType::CopyTexture:
+			sCurrentAPI->CopyTextureData_RenderThread(command.resourceHandle);
+			break;
+		case CommandType::CopyBuffer:
+			sCurrentAPI->CopyBufferData_RenderThread(command.resourceHandle);
+			break;
+		case CommandType::RequestData:
+			sCurrentAPI->RequestData_RenderThread(command.resourceHandle);
+			break;
+		case CommandType::CopyData:
+			sCurrentAPI->CopyData_RenderThread(command.resourceHandle);
+			break;
+		case CommandType::ReleaseTempResources:
+			sCurrentAPI->ReleaseTempResources_RenderThread(command.resource);
+			break;
+		case CommandType::Subscribe:
+			sCurrentAPI->Subscribe_RenderThread(command.resourceHandle);
+			break;
+		case CommandType::Unsubscribe:
+			sCurrentAPI->Unsubscribe_RenderThread(command.resource);
+			break;
+		}
+	}
+
+	ReadbackStats::Clock::time_point end = ReadbackStats::Clock::now();
+	sStats.renderEventUs.Add(ReadbackStats::Microseconds(start, end));
+	if (sTrace.IsEnabled())
+	{
+		ReadbackTrace::NameThread("Render thread");
+		sTrace.Record(TracePhase::RenderEvent, -1, -1, 0, start, end);
+	}
 }
 
 //-------------------------------------------------------------------------------------------------
-// OnRequestBufferEvent
+// OnPollEvent
 //-------------------------------------------------------------------------------------------------
-static void UNITY_INTERFACE_API OnRequestBufferEvent(int eventID)
+static void UNITY_INTERFACE_API OnPollEvent(int eventID)
 {
-	if (sCurrentAPI != NULL && eventID >= 0 && eventID < sResourcesSize && sResources[eventID] != NULL)
+	// event id isn't used, queued commands are left to their own events
+	if (sCurrentAPI == NULL)
+		return;
+
+	ReadbackStats::Clock::time_point start = ReadbackStats::Clock::now();
+	sCurrentAPI->PollCopies_RenderThread();
+
+	ReadbackStats::Clock::time_point end = ReadbackStats::Clock::now();
+	sStats.renderEventUs.Add(ReadbackStats::Microseconds(start, end));
+	if (sTrace.IsEnabled())
 	{
-		sCurrentAPI->RequestBufferData_RenderThread(sResources[eventID]);
-		// free resource slot for future use
-		sResources[eventID] = NULL;
+		ReadbackTrace::NameThread("Render thread");
+		sTrace.Record(TracePhase::RenderEvent, -1, -1, 0, start, end);
 	}
 }
 
+//-------------------------------------------------------------------------------------------------
+// GetRequestTextureEventFunc
+//-------------------------------------------------------------------------------------------------
+extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRequestTextureEventFunc()
+{
+	return OnRenderEvent;
+}
+
 //-------------------------------------------------------------------------------------------------
 // GetRequestBufferEventFunc
 //-------------------------------------------------------------------------------------------------
 extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRequestBufferEventFunc()
 {
-	return OnRequestBufferEvent;
+	return OnRenderEvent;
+}
+
+//-------------------------------------------------------------------------------------------------
+// GetReleaseTempResourcesEventFunc
+//-------------------------------------------------------------------------------------------------
+extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetReleaseTempResourcesEventFunc()
+{
+	return OnRenderEvent;
 }
 
 //-------------------------------------------------------------------------------------------------
-// OnReleaseTempResourcesEvent
+// RegisterResource
 //-------------------------------------------------------------------------------------------------
-static void UNITY_INTERFACE_API OnReleaseTempResourcesEvent(int eventID)
+static int RegisterResource(void* nativeResource, bool isBuffer)
 {
-	if (sCurrentAPI != NULL && eventID >= 0 && eventID < sResourcesSize && sResources[eventID] != NULL)
+	if (nativeResource == NULL)
+	{
+		sLastStatus = Status::Error_InvalidArguments;
+		return -1;
+	}
+
+	if (sCurrentAPI == NULL)
 	{
-		sCurrentAPI->ReleaseTempResources(sResources[eventID]);
-		// free resource slot for future use
-		sResources[eventID] = NULL;
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return -1;
 	}
+
+	int resourceHandle = -1;
+	sLastStatus = sCurrentAPI->RegisterResource_MainThread(nativeResource, isBuffer, &resourceHandle);
+	return sLastStatus == Status::Succeeded ? resourceHandle : -1;
 }
 
 //-------------------------------------------------------------------------------------------------
-// GetReleaseTempResourcesEventFunc
+// RegisterTexture
 //-------------------------------------------------------------------------------------------------
-extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetReleaseTempResourcesEventFunc()
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RegisterTexture(void* nativeTexture)
 {
-	return OnReleaseTempResourcesEvent;
+	return RegisterResource(nativeTexture, false);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RegisterBuffer
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RegisterBuffer(void* nativeBuffer)
+{
+	return RegisterResource(nativeBuffer, true);
 }
 
 //-------------------------------------------------------------------------------------------------
 // ReleaseTempResources
 //-------------------------------------------------------------------------------------------------
-extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseTempResources(void* resourceHandle)
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseTempResources(int resourceHandle)
 {
-	if (resourceHandle == NULL)
+	if (sCurrentAPI == NULL)
 	{
-		sLastStatus = Status::Error_InvalidArguments;
+		sLastStatus = Status::Error_UnsupportedAPI;
 		return -1;
 	}
 
-	// store resource handle
-	int resourceSlot = FindFreeResourceSlot();
-	if (resourceSlot == -1)
+	// staging resources can be released only when render thread isn't using them
+	if (sCommands.IsFull())
 	{
 		sLastStatus = Status::Error_TooManyRequests;
 		return -1;
 	}
 
-	sResources[resourceSlot] = resourceHandle;
+	void* resource = sCurrentAPI->ReleaseTempResources_MainThread(resourceHandle);
+	if (resource == NULL)
+	{
+		sLastStatus = Status::Error_InvalidArguments;
+		return -1;
+	}
 
-	if (sCurrentAPI != NULL)
+	// leases of released resource are gone too
+	for (size_t i = 0; i < sLeases.size();)
 	{
-		sLastStatus = Status::Succeeded;
-		return resourceSlot;
+		if (sLeases[i].resourceHandle == resourceHandle)
+		{
+			sLeases[i] = sLeases.back();
+			sLeases.pop_back();
+		}
+		else
+		{
+			++i;
+		}
 	}
-	else
+
+	sLastStatus = Status::Succeeded;
+	return QueueCommand(CommandType::ReleaseTempResources, resourceHandle, resource);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RequestTexture
+//-------------------------------------------------------------------------------------------------
+static int RequestTexture(int textureHandle, const ReadRequest& request)
+{
+	if (sCurrentAPI == NULL)
 	{
 		sLastStatus = Status::Error_UnsupportedAPI;
 		return -1;
 	}
+
+	// main thread request reserves staging slot, make sure the render thread part can be queued
+	if (sCommands.IsFull())
+	{
+		sLastStatus = Status::Error_TooManyRequests;
+		return -1;
+	}
+
+	int requestId = sNextRequestId;
+	sLastStatus = sCurrentAPI->RequestTextureData_MainThread(textureHandle, requestId, request);
+	if (sLastStatus != Status::Succeeded)
+		return -1;
+
+	sNextRequestId = (sNextRequestId + 1) & 0x7fffffff;
+	sLastRequestId = requestId;
+	return QueueCommand(CommandType::RequestTexture, textureHandle);
 }
 
 //-------------------------------------------------------------------------------------------------
 // RequestTextureData
 //-------------------------------------------------------------------------------------------------
-extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureData(void* textureHandle)
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureData(int textureHandle)
 {
-	if (textureHandle == NULL)
+	return RequestTexture(textureHandle, ReadRegion());
+}
+
+//-------------------------------------------------------------------------------------------------
+// RequestTextureRegion
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureRegion(int textureHandle, int x, int y, int width, int height)
+{
+	// bounds are checked against the texture on render thread
+	if (width <= 0 || height <= 0)
 	{
 		sLastStatus = Status::Error_InvalidArguments;
 		return -1;
 	}
 
-	// store resource handle
-	int resourceSlot = FindFreeResourceSlot();
-	if (resourceSlot == -1)
+	return RequestTexture(textureHandle, ReadRegion(x, y, width, height));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RequestTextureSubresource
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureSubresource(int textureHandle, int mipLevel, int slice, int sliceCount, int x, int y, int width, int height)
+{
+	// zero width and height read the whole mip level, bounds are checked against the texture on render thread
+	bool wholeLevel = x == 0 && y == 0 && width == 0 && height == 0;
+	if ((!wholeLevel && (width <= 0 || height <= 0)) || sliceCount <= 0)
 	{
-		sLastStatus = Status::Error_TooManyRequests;
+		sLastStatus = Status::Error_InvalidArguments;
 		return -1;
 	}
 
-	sResources[resourceSlot] = textureHandle;
+	ReadRegion region(x, y, width, height);
+	region.mipLevel = mipLevel;
+	region.slice = slice;
+	region.sliceCount = sliceCount;
+	return RequestTexture(textureHandle, region);
+}
 
-	if (sCurrentAPI != NULL)
+//-------------------------------------------------------------------------------------------------
+// RequestTextureReduction
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureReduction(int textureHandle, int mipLevel, int slice, int flags, int histogramChannel, float histogramMin, float histogramMax)
+{
+	// the rest is checked against the texture format on render thread
+	if (flags == 0)
 	{
-		sLastStatus = sCurrentAPI->RequestTextureData_MainThread(textureHandle);
-		return resourceSlot;
+		sLastStatus = Status::Error_InvalidArguments;
+		return -1;
 	}
-	else
+
+	ReadRequest request;
+	request.region.mipLevel = mipLevel;
+	request.region.slice = slice;
+	request.reduction.flags = flags;
+	request.reduction.histogramChannel = histogramChannel;
+	request.reduction.histogramMin = histogramMin;
+	request.reduction.histogramMax = histogramMax;
+	return RequestTexture(textureHandle, request);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RequestTextureConversion
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureConversion(int textureHandle, int mipLevel, int slice, int sliceCount, int x, int y, int width, int height, int outputType, int channelMask, int flags)
+{
+	// channel layout of the format is checked on render thread
+	bool wholeLevel = x == 0 && y == 0 && width == 0 && height == 0;
+	if ((!wholeLevel && (width <= 0 || height <= 0)) || sliceCount <= 0 || 
+		(outputType != (int)OutputType::Float32 && outputType != (int)OutputType::UNorm8))
 	{
-		sLastStatus = Status::Error_UnsupportedAPI;
+		sLastStatus = Status::Error_InvalidArguments;
 		return -1;
 	}
+
+	ReadRequest request(ReadRegion(x, y, width, height));
+	request.region.mipLevel = mipLevel;
+	request.region.slice = slice;
+	request.region.sliceCount = sliceCount;
+	request.conversion.outputType = (OutputType)outputType;
+	request.conversion.channelMask = channelMask;
+	request.conversion.flags = flags;
+	return RequestTexture(textureHandle, request);
 }
 
 //-------------------------------------------------------------------------------------------------
-// OnCopyTextureEvent
+// RequestTextureDelta
 //-------------------------------------------------------------------------------------------------
-static void UNITY_INTERFACE_API OnCopyTextureEvent(int eventID)
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestTextureDelta(int textureHandle, int mipLevel, int slice, int sliceCount, int tileSize)
 {
-	if (sCurrentAPI != NULL && eventID >= 0 && eventID < sResourcesSize && sResources[eventID] != NULL)
+	// tiles have to cover whole blocks of compressed formats
+	if (sliceCount <= 0 || tileSize < kMinDeltaTileSize || tileSize > kMaxDeltaTileSize || (tileSize & (tileSize - 1)) != 0)
 	{
-		sCurrentAPI->CopyTextureData_RenderThread(sResources[eventID]);
-		// free resource slot for future use
-		sResources[eventID] = NULL;
+		sLastStatus = Status::Error_InvalidArguments;
+		return -1;
 	}
+
+	ReadRequest request;
+	request.region.mipLevel = mipLevel;
+	request.region.slice = slice;
+	request.region.sliceCount = sliceCount;
+	request.delta.tileSize = tileSize;
+	return RequestTexture(textureHandle, request);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -268,68 +514,324 @@ static void UNITY_INTERFACE_API OnCopyTextureEvent(int eventID)
 //-------------------------------------------------------------------------------------------------
 extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetCopyTextureEventFunc()
 {
-	return OnCopyTextureEvent;
+	return OnRenderEvent;
 }
 
 //-------------------------------------------------------------------------------------------------
 // RetrieveTextureData
 //-------------------------------------------------------------------------------------------------
-extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RetrieveTextureData(void* textureHandle, void* data, int dataSize)
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RetrieveTextureData(int textureHandle, void* data, int dataSize)
 {
 	// parameters were tested on C# side and can't be invalid
 	assert(data != NULL && dataSize >= 0);
 
-	if (textureHandle == NULL)
+	if (sCurrentAPI == NULL)
 	{
-		sLastStatus = Status::Error_InvalidArguments;
+		sLastStatus = Status::Error_UnsupportedAPI;
 		return -1;
 	}
 
-	if (sCurrentAPI != NULL)
-	{
-		sLastStatus = sCurrentAPI->RetrieveTextureData_MainThread(textureHandle, data, dataSize);
-		if (sLastStatus == Status::NotReady)
-		{
-			int slot = FindFreeResourceSlot();
-			// save texture for issue plugin event call
-			sResources[slot] = textureHandle;
-			return slot;
-		}
+	sLastStatus = sCurrentAPI->RetrieveTextureData_MainThread(textureHandle, data, dataSize, &sLastRequestId);
+
+	// ask render thread to check if the copy is finished
+	if (sLastStatus == Status::NotReady)
+		return QueueCommand(CommandType::CopyTexture, textureHandle);
+
+	return -1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RetrieveTextureDelta
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RetrieveTextureDelta(int textureHandle, void* data, int dataSize, int* deltaSize)
+{
+	// parameters were tested on C# side and can't be invalid
+	assert(data != NULL && dataSize >= 0 && deltaSize != NULL);
 
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
 		return -1;
 	}
-	else
+
+	sLastStatus = sCurrentAPI->RetrieveDelta_MainThread(textureHandle, data, dataSize, deltaSize, &sLastRequestId);
+
+	// ask render thread to check if the copy is finished
+	if (sLastStatus == Status::NotReady)
+		return QueueCommand(CommandType::CopyTexture, textureHandle);
+
+	return -1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RequestBuffer
+//-------------------------------------------------------------------------------------------------
+static int RequestBuffer(int bufferHandle, const ReadRequest& request)
+{
+	if (sCurrentAPI == NULL)
 	{
 		sLastStatus = Status::Error_UnsupportedAPI;
 		return -1;
 	}
+
+	// main thread request reserves staging slot, make sure the render thread part can be queued
+	if (sCommands.IsFull())
+	{
+		sLastStatus = Status::Error_TooManyRequests;
+		return -1;
+	}
+
+	int requestId = sNextRequestId;
+	sLastStatus = sCurrentAPI->RequestBufferData_MainThread(bufferHandle, requestId, request);
+	if (sLastStatus != Status::Succeeded)
+		return -1;
+
+	sNextRequestId = (sNextRequestId + 1) & 0x7fffffff;
+	sLastRequestId = requestId;
+	return QueueCommand(CommandType::RequestBuffer, bufferHandle);
 }
 
 //-------------------------------------------------------------------------------------------------
 // RequestBufferData
 //-------------------------------------------------------------------------------------------------
-extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestBufferData(void* bufferHandle)
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestBufferData(int bufferHandle)
+{
+	return RequestBuffer(bufferHandle, ReadRegion());
+}
+
+//-------------------------------------------------------------------------------------------------
+// RequestBufferRange
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestBufferRange(int bufferHandle, int offset, int length)
 {
-	if (bufferHandle == NULL)
+	// bounds are checked against the buffer on render thread
+	if (length <= 0)
 	{
 		sLastStatus = Status::Error_InvalidArguments;
 		return -1;
 	}
 
-	// store resource handle
-	int resourceSlot = FindFreeResourceSlot();
-	if (resourceSlot == -1)
+	return RequestBuffer(bufferHandle, ReadRegion(offset, 0, length, 1));
+}
+
+//-------------------------------------------------------------------------------------------------
+// GetCopyBufferEventFunc
+//-------------------------------------------------------------------------------------------------
+extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetCopyBufferEventFunc()
+{
+	return OnRenderEvent;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RetrieveBufferData
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RetrieveBufferData(int bufferHandle, void* data, int dataSize)
+{
+	// parameters were tested on C# side and can't be invalid
+	assert(data != NULL && dataSize >= 0);
+
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return -1;
+	}
+
+	sLastStatus = sCurrentAPI->RetrieveBufferData_MainThread(bufferHandle, data, dataSize, &sLastRequestId);
+
+	// ask render thread to check if the copy is finished
+	if (sLastStatus == Status::NotReady)
+		return QueueCommand(CommandType::CopyBuffer, bufferHandle);
+
+	return -1;
+}
+//-------------------------------------------------------------------------------------------------
+// RequestBatch
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestBatch(const int* resourceHandles, int count, int* batchId)
+{
+	// parameters were tested on C# side and can't be invalid
+	assert(batchId != NULL);
+
+	if (resourceHandles == NULL || count <= 0)
+	{
+		sLastStatus = Status::Error_InvalidArguments;
+		return -1;
+	}
+
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return -1;
+	}
+
+	if (!sCommands.HasSpace(count))
+	{
+		sLastStatus = Status::Error_TooManyRequests;
+		return -1;
+	}
+
+	// all or nothing, check every resource before anything is reserved
+	for (int i = 0; i < count; ++i)
+	{
+		for (int j = 0; j < i; ++j)
+		{
+			if (resourceHandles[i] == resourceHandles[j])
+			{
+				sLastStatus = Status::Error_InvalidArguments;
+				return -1;
+			}
+		}
+
+		sLastStatus = sCurrentAPI->CanRequestData_MainThread(resourceHandles[i]);
+		if (sLastStatus != Status::Succeeded)
+			return -1;
+	}
+
+	Batch* batch = new Batch();
+	int handle = sBatches.Add(batch);
+	if (handle == -1)
 	{
+		delete batch;
 		sLastStatus = Status::Error_TooManyRequests;
 		return -1;
 	}
-	
-	sResources[resourceSlot] = bufferHandle;
+
+	// every copy goes to the same render event so all of them see the same frame
+	batch->members.resize(count);
+	for (int i = 0; i < count; ++i)
+	{
+		BatchMember& member = batch->members[i];
+		member.resourceHandle = resourceHandles[i];
+		member.requestId = sNextRequestId;
+		sNextRequestId = (sNextRequestId + 1) & 0x7fffffff;
+
+		Status status = sCurrentAPI->RequestData_MainThread(member.resourceHandle, member.requestId, ReadRequest());
+		assert(status == Status::Succeeded);
+		PushCommand(CommandType::RequestData, member.resourceHandle);
+	}
+
+	*batchId = handle;
+	sLastStatus = Status::Succeeded;
+	return TakeEventId();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RetrieveBatch
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RetrieveBatch(int batchId, void** data, const int* dataSizes, int count)
+{
+	Batch* batch = sBatches.Get(batchId);
+	if (batch == NULL || data == NULL || dataSizes == NULL || count != (int)batch->members.size())
+	{
+		sLastStatus = Status::Error_InvalidArguments;
+		return -1;
+	}
+
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return -1;
+	}
+
+	// batch is delivered at once, every member has to be finished first
+	Status batchStatus = Status::Succeeded;
+	int pending = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		const BatchMember& member = batch->members[i];
+
+		int requestId = -1;
+		int dataSize = 0;
+		Status status = sCurrentAPI->PeekData_MainThread(member.resourceHandle, &requestId, &dataSize);
+		if (status == Status::NotReady)
+		{
+			++pending;
+			continue;
+		}
+
+		// older request of the same resource has to be retrieved first, its result isn't the member's even when it failed
+		if (requestId != -1 && requestId != member.requestId)
+		{
+			sLastStatus = Status::Error_CopyInProgress;
+			return -1;
+		}
+
+		if (status == Status::Succeeded)
+		{
+			// nothing is retrieved, user can try again with bigger buffer
+			if (dataSize > dataSizes[i])
+			{
+				sLastStatus = Status::Error_WrongBufferSize;
+				return -1;
+			}
+		}
+		else if (batchStatus == Status::Succeeded)
+		{
+			// failed member fails the whole batch, the rest is still retrieved to free staging slots
+			batchStatus = status;
+		}
+	}
+
+	if (pending > 0)
+	{
+		// ask render thread to check all unfinished copies in one event
+		if (!sCommands.HasSpace(pending))
+		{
+			sLastStatus = Status::Error_TooManyRequests;
+			return -1;
+		}
+
+		for (int i = 0; i < count; ++i)
+		{
+			int requestId;
+			int dataSize;
+			if (sCurrentAPI->PeekData_MainThread(batch->members[i].resourceHandle, &requestId, &dataSize) == Status::NotReady)
+				PushCommand(CommandType::CopyData, batch->members[i].resourceHandle);
+		}
+
+		sLastStatus = Status::NotReady;
+		return TakeEventId();
+	}
+
+	for (int i = 0; i < count; ++i)
+	{
+		int requestId;
+		sCurrentAPI->RetrieveData_MainThread(batch->members[i].resourceHandle, data[i], dataSizes[i], &requestId);
+	}
+
+	delete sBatches.Remove(batchId);
+
+	sLastStatus = batchStatus;
+	return -1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// AcquireReadback
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AcquireReadback(int resourceHandle, const void** data, int* dataSize, int* rowPitch, int* lease)
+{
+	// parameters were tested on C# side and can't be invalid
+	assert(data != NULL && dataSize != NULL && rowPitch != NULL && lease != NULL);
 
 	if (sCurrentAPI != NULL)
 	{
-		sLastStatus = sCurrentAPI->RequestBufferData_MainThread(bufferHandle);
-		return resourceSlot;
+		int requestId = -1;
+		sLastStatus = sCurrentAPI->AcquireData_MainThread(resourceHandle, data, dataSize, rowPitch, &requestId);
+		if (sLastStatus == Status::Succeeded)
+		{
+			Lease newLease = { requestId, resourceHandle };
+			sLeases.push_back(newLease);
+
+			*lease = requestId;
+			sLastRequestId = requestId;
+		}
+		else if (sLastStatus == Status::NotReady)
+		{
+			// ask render thread to check if the copy is finished
+			return QueueCommand(CommandType::CopyData, resourceHandle);
+		}
+
+		return -1;
 	}
 	else
 	{
@@ -339,59 +841,223 @@ extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RequestBufferData(void
 }
 
 //-------------------------------------------------------------------------------------------------
-// OnCopyBufferEvent
+// ReleaseReadback
 //-------------------------------------------------------------------------------------------------
-static void UNITY_INTERFACE_API OnCopyBufferEvent(int eventID)
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseReadback(int lease)
 {
-	if (sCurrentAPI != NULL && eventID >= 0 && eventID < sResourcesSize && sResources[eventID] != NULL)
+	for (size_t i = 0; i < sLeases.size(); ++i)
 	{
-		sCurrentAPI->CopyBufferData_RenderThread(sResources[eventID]);
-		// free resource slot for future use
-		sResources[eventID] = NULL;
+		if (sLeases[i].requestId != lease)
+			continue;
+
+		sLastStatus = sCurrentAPI != NULL ? sCurrentAPI->ReleaseData_MainThread(sLeases[i].resourceHandle, lease) : Status::Error_UnsupportedAPI;
+
+		sLeases[i] = sLeases.back();
+		sLeases.pop_back();
+		return (int)sLastStatus;
 	}
+
+	sLastStatus = Status::Error_InvalidArguments;
+	return (int)sLastStatus;
 }
 
 //-------------------------------------------------------------------------------------------------
-// GetCopyBufferEventFunc
+// GetPollEventFunc
 //-------------------------------------------------------------------------------------------------
-extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetCopyBufferEventFunc()
+extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPollEventFunc()
 {
-	return OnCopyBufferEvent;
+	// checks every copy in flight and reports finished requests, meant to be issued once per frame
+	// (for example from camera command buffer) instead of retrieving every resource until it succeeds
+	return OnPollEvent;
 }
 
 //-------------------------------------------------------------------------------------------------
-// RetrieveBufferData
+// GetSubscriptionEventFunc
 //-------------------------------------------------------------------------------------------------
-extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RetrieveBufferData(void* bufferHandle, void* data, int dataSize)
+extern "C" UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetSubscriptionEventFunc()
+{
+	return OnRenderEvent;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Subscribe
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API Subscribe(int resourceHandle, int everyNFrames, int ringDepth, int* subscription)
 {
 	// parameters were tested on C# side and can't be invalid
-	assert(data != NULL && dataSize >= 0);
+	assert(subscription != NULL);
 
-	if (bufferHandle == NULL)
+	if (sCurrentAPI == NULL)
 	{
-		sLastStatus = Status::Error_InvalidArguments;
+		sLastStatus = Status::Error_UnsupportedAPI;
 		return -1;
 	}
 
-	if (sCurrentAPI != NULL)
+	if (sCommands.IsFull())
 	{
-		sLastStatus = sCurrentAPI->RetrieveBufferData_MainThread(bufferHandle, data, dataSize);
+		sLastStatus = Status::Error_TooManyRequests;
+		return -1;
+	}
 
-		if (sLastStatus == Status::NotReady)
-		{
-			int slot = FindFreeResourceSlot();
-			// save texture for issue plugin event call
-			sResources[slot] = bufferHandle;
-			return slot;
-		}
+	// copies are requested by poll events (GetPollEventFunc), this event only starts the subscription
+	int handle = -1;
+	sLastStatus = sCurrentAPI->Subscribe_MainThread(resourceHandle, everyNFrames, ringDepth, &handle);
+	if (sLastStatus != Status::Succeeded)
+		return -1;
+
+	*subscription = handle;
+	return QueueCommand(CommandType::Subscribe, handle);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Unsubscribe
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API Unsubscribe(int subscription)
+{
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return -1;
+	}
 
+	// staging copies of the subscription can be released only when render thread isn't using them
+	if (sCommands.IsFull())
+	{
+		sLastStatus = Status::Error_TooManyRequests;
 		return -1;
 	}
-	else
+
+	void* object = sCurrentAPI->Unsubscribe_MainThread(subscription);
+	if (object == NULL)
+	{
+		sLastStatus = Status::Error_InvalidArguments;
+		return -1;
+	}
+
+	sLastStatus = Status::Succeeded;
+	return QueueCommand(CommandType::Unsubscribe, subscription, object);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RetrieveSubscription
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RetrieveSubscription(int subscription, int latest, void* data, int dataSize, int* frame, int* dropped)
+{
+	// parameters were tested on C# side and can't be invalid
+	assert(data != NULL && dataSize >= 0 && frame != NULL && dropped != NULL);
+
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return (int)sLastStatus;
+	}
+
+	// results are published by poll events, there is nothing to ask render thread for
+	unsigned int resultFrame = 0;
+	int resultDropped = 0;
+	sLastStatus = sCurrentAPI->RetrieveSubscription_MainThread(subscription, latest != 0, data, dataSize, &resultFrame, &resultDropped);
+	*frame = (int)(resultFrame & 0x7fffffff);
+	*dropped = resultDropped;
+	return (int)sLastStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+// StartCapture
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API StartCapture(int resourceHandle, int everyNFrames, int depth, const char* path, int maxMB, int* capture)
+{
+	// parameters were tested on C# side and can't be invalid
+	assert(path != NULL && capture != NULL);
+
+	if (sCurrentAPI == NULL)
 	{
 		sLastStatus = Status::Error_UnsupportedAPI;
 		return -1;
 	}
+
+	if (sCommands.IsFull())
+	{
+		sLastStatus = Status::Error_TooManyRequests;
+		return -1;
+	}
+
+	// file is created now, capture is started by the returned event like subscription
+	int handle = -1;
+	sLastStatus = sCurrentAPI->StartCapture_MainThread(resourceHandle, everyNFrames, depth, path, (long long)maxMB << 20, &handle);
+	if (sLastStatus != Status::Succeeded)
+		return -1;
+
+	*capture = handle;
+	return QueueCommand(CommandType::Subscribe, handle);
+}
+
+//-------------------------------------------------------------------------------------------------
+// StopCapture
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API StopCapture(int capture)
+{
+	// returned event stops the copies, writer thread closes the file afterwards. handle stays valid for
+	// GetCaptureStatus until it reports the capture finished
+	return Unsubscribe(capture);
+}
+
+//-------------------------------------------------------------------------------------------------
+// GetCaptureStatus
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetCaptureStatus(int capture, int* written, int* skipped, int* failed, long long* bytes, int* finished)
+{
+	// parameters were tested on C# side and can't be invalid
+	assert(written != NULL && skipped != NULL && failed != NULL && bytes != NULL && finished != NULL);
+
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return (int)sLastStatus;
+	}
+
+	// counters are updated by render and writer threads, they are read without waiting for them
+	bool captureFinished = false;
+	sLastStatus = sCurrentAPI->GetCaptureStatus_MainThread(capture, written, skipped, failed, bytes, &captureFinished);
+	*finished = captureFinished ? 1 : 0;
+	return (int)sLastStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SetCompletionCallback
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetCompletionCallback(CompletionCallback callback, void* userData)
+{
+	// NULL removes the callback, it isn't called anymore once this returns
+	sCompletions.SetCallback(callback, userData);
+	sLastStatus = Status::Succeeded;
+	return (int)sLastStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+// GetCompletionHandle
+//-------------------------------------------------------------------------------------------------
+extern "C" intptr_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetCompletionHandle()
+{
+	// any thread, doesn't change last status
+	return sCompletions.GetWaitHandle();
+}
+
+//-------------------------------------------------------------------------------------------------
+// PopCompletion
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API PopCompletion(int* resourceHandle, int* requestId, int* status)
+{
+	// any thread, doesn't change last status. returns 1 when completion was popped, 0 when there's none and 2 when
+	// completion was popped but the queue overflowed before, consumer has to retrieve every resource until NotReady
+	Completion completion;
+	bool overflowed = false;
+	if (resourceHandle == NULL || requestId == NULL || status == NULL || !sCompletions.Pop(&completion, &overflowed))
+		return 0;
+
+	*resourceHandle = completion.resourceHandle;
+	*requestId = completion.requestId;
+	*status = completion.status;
+	return overflowed ? 2 : 1;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -402,6 +1068,129 @@ extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetLastStatus()
 	return (int)sLastStatus;
 }
 
+//-------------------------------------------------------------------------------------------------
+// GetLastRequestId
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetLastRequestId()
+{
+	return sLastRequestId;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SetStagingRingSize
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetStagingRingSize(int size)
+{
+	if (size < 1 || size > RendererAPI::kMaxStagingRingSize)
+	{
+		sLastStatus = Status::Error_InvalidArguments;
+		return (int)sLastStatus;
+	}
+
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return (int)sLastStatus;
+	}
+
+	sCurrentAPI->SetStagingRingSize(size);
+	sLastStatus = Status::Succeeded;
+	return (int)sLastStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SetCopyThread
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetCopyThread(int enabled)
+{
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return (int)sLastStatus;
+	}
+
+	sCurrentAPI->SetCopyThreadEnabled(enabled != 0);
+	sLastStatus = Status::Succeeded;
+	return (int)sLastStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SetStagingPool
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetStagingPool(int budgetMB, int idleFrames)
+{
+	if (budgetMB < 0 || idleFrames < 0)
+	{
+		sLastStatus = Status::Error_InvalidArguments;
+		return (int)sLastStatus;
+	}
+
+	if (sCurrentAPI == NULL)
+	{
+		sLastStatus = Status::Error_UnsupportedAPI;
+		return (int)sLastStatus;
+	}
+
+	sCurrentAPI->SetStagingPool((long long)budgetMB * 1024 * 1024, idleFrames);
+	sLastStatus = Status::Succeeded;
+	return (int)sLastStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+// GetReadbackStats
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetReadbackStats(void* stats, int statsSize, int reset)
+{
+	// snapshot is an array of 64 bit values, size check catches callers built against different layout
+	if (stats == NULL || statsSize != (int)sizeof(ReadbackStatsSnapshot))
+	{
+		sLastStatus = Status::Error_WrongBufferSize;
+		return (int)sLastStatus;
+	}
+
+	sStats.Read((ReadbackStatsSnapshot*)stats, reset != 0);
+	sLastStatus = Status::Succeeded;
+	return (int)sLastStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SetReadbackTrace
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetReadbackTrace(int enabled)
+{
+	// ring is allocated by the first call that enables the trace, events stay in it when the trace is disabled
+	sTrace.Enable(enabled != 0);
+	sLastStatus = Status::Succeeded;
+	return (int)sLastStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SetResourceName
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetResourceName(int resourceHandle, const char* name)
+{
+	// only used to label the trace, NULL or empty name falls back to the handle
+	sTrace.SetResourceName(resourceHandle, name);
+	sLastStatus = Status::Succeeded;
+	return (int)sLastStatus;
+}
+
+//-------------------------------------------------------------------------------------------------
+// WriteReadbackTrace
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API WriteReadbackTrace(const char* path)
+{
+	if (path == NULL)
+	{
+		sLastStatus = Status::Error_InvalidArguments;
+		return (int)sLastStatus;
+	}
+
+	// ring isn't cleared, other threads keep recording while the file is written
+	sLastStatus = sTrace.Write(path) ? Status::Succeeded : Status::Error_UnknownError;
+	return (int)sLastStatus;
+}
+
 //-------------------------------------------------------------------------------------------------
 // SetDebugFunction
 //-------------------------------------------------------------------------------------------------
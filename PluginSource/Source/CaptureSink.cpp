@@ -0,0 +1,316 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "CaptureSink.h"
+#include "PlatformBase.h"
+#include "ReadbackTrace.h"
+#include <string.h>
+
+#if UNITY_WIN || UNITY_METRO
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char kCaptureMagic[8] = "ATRCAPT";
+
+//-------------------------------------------------------------------------------------------------
+// AlignCapture()
+//-------------------------------------------------------------------------------------------------
+static long long AlignCapture(long long offset)
+{
+	return (offset + kCaptureAlignment - 1) / kCaptureAlignment * kCaptureAlignment;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::CaptureSink()
+//-------------------------------------------------------------------------------------------------
+CaptureSink::CaptureSink() : _file(-1), _maxBytes(0), _end(0), _queued(0), _quit(false), _closed(false), _written(0), _skipped(0), _failed(0), _bytes(0)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::~CaptureSink()
+//-------------------------------------------------------------------------------------------------
+CaptureSink::~CaptureSink()
+{
+	// only waits when the sink is destroyed before the writer finished, device shutdown
+	Close();
+	if (_thread.joinable())
+		_thread.join();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::Open()
+//-------------------------------------------------------------------------------------------------
+bool CaptureSink::Open(const char* path, long long maxBytes)
+{
+	if (_file != -1 || path == NULL || maxBytes < 2 * kCaptureAlignment)
+		return false;
+
+#if UNITY_WIN || UNITY_METRO
+	wchar_t widePath[MAX_PATH];
+	if (MultiByteToWideChar(CP_UTF8, 0, path, -1, widePath, MAX_PATH) == 0)
+		return false;
+
+#if UNITY_METRO
+	HANDLE file = CreateFile2(widePath, GENERIC_WRITE, 0, CREATE_ALWAYS, NULL);
+#else
+	HANDLE file = CreateFileW(widePath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+#endif
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	// disk space is allocated without moving the end of file, nothing is zero filled
+	FILE_ALLOCATION_INFO allocation;
+	allocation.AllocationSize.QuadPart = maxBytes;
+	if (!SetFileInformationByHandle(file, FileAllocationInfo, &allocation, sizeof(allocation)))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = (intptr_t)file;
+#else
+	int file = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (file == -1)
+		return false;
+
+#if UNITY_LINUX || UNITY_ANDROID
+	int error = posix_fallocate(file, 0, maxBytes);
+#elif UNITY_OSX || UNITY_IPHONE
+	fstore_t store = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, maxBytes, 0 };
+	int error = fcntl(file, F_PREALLOCATE, &store) == -1 ? errno : 0;
+#else
+	int error = ftruncate(file, maxBytes) == -1 ? errno : 0;
+#endif
+	if (error != 0)
+	{
+		close(file);
+		return false;
+	}
+
+	_file = file;
+#endif
+
+	// header without index marks the file as capture even if it is never closed
+	CaptureHeader header = {};
+	memcpy(header.magic, kCaptureMagic, sizeof(header.magic));
+	header.version = kCaptureVersion;
+	header.entrySize = sizeof(CaptureEntry);
+	if (!WriteAt(&header, sizeof(header), 0))
+	{
+		Finish();
+		return false;
+	}
+
+	_maxBytes = maxBytes;
+	_end = kCaptureAlignment;
+	_start = Clock::now();
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::Write()
+//-------------------------------------------------------------------------------------------------
+bool CaptureSink::Write(const void* data, const CaptureEntry& entry, const Done& done)
+{
+	// space for index of every queued copy is kept at the end of the file
+	long long end = AlignCapture(_end + entry.size);
+	long long indexSize = (long long)(_queued + 1) * sizeof(CaptureEntry);
+	if (_file == -1 || end + indexSize > _maxBytes)
+	{
+		++_skipped;
+		return false;
+	}
+
+	Job job = { data, entry, done };
+	job.entry.offset = _end;
+	job.entry.time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _start).count();
+	_end = end;
+	++_queued;
+
+	if (!_thread.joinable())
+		_thread = std::thread(&CaptureSink::ThreadFunc, this);
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(job);
+	}
+	_wake.notify_one();
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::Skip()
+//-------------------------------------------------------------------------------------------------
+void CaptureSink::Skip()
+{
+	++_skipped;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::Fail()
+//-------------------------------------------------------------------------------------------------
+void CaptureSink::Fail()
+{
+	++_failed;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::Close()
+//-------------------------------------------------------------------------------------------------
+void CaptureSink::Close()
+{
+	// file without writes is finalized by the writer as well. _file belongs to the writer once it runs
+	if (!_thread.joinable() && _file != -1)
+		_thread = std::thread(&CaptureSink::ThreadFunc, this);
+
+	if (!_thread.joinable())
+	{
+		_closed = true;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_one();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::ThreadFunc()
+//-------------------------------------------------------------------------------------------------
+void CaptureSink::ThreadFunc()
+{
+	ReadbackTrace::NameThread("Capture thread");
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_wake.wait(lock, [this] { return _quit || !_jobs.empty(); });
+
+		// close is handled once the writes queued before it are done
+		if (_jobs.empty())
+		{
+			lock.unlock();
+			Finish();
+			_closed = true;
+			return;
+		}
+
+		Job job = _jobs.front();
+		_jobs.pop_front();
+		lock.unlock();
+
+		// failed copy leaves a hole in the file, it isn't in the index
+		if (WriteAt(job.data, job.entry.size, job.entry.offset))
+		{
+			_index.push_back(job.entry);
+			_bytes += job.entry.size;
+			++_written;
+		}
+		else
+		{
+			++_failed;
+		}
+		job.done();
+
+		lock.lock();
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::Finish()
+//-------------------------------------------------------------------------------------------------
+void CaptureSink::Finish()
+{
+	// header is only updated when the index was written, reader can rely on it
+	long long indexSize = (long long)_index.size() * sizeof(CaptureEntry);
+	if (_maxBytes != 0 && (_index.empty() || WriteAt(_index.data(), (size_t)indexSize, _end)))
+	{
+		CaptureHeader header = {};
+		memcpy(header.magic, kCaptureMagic, sizeof(header.magic));
+		header.version = kCaptureVersion;
+		header.entrySize = sizeof(CaptureEntry);
+		header.indexOffset = _end;
+		header.entryCount = (int)_index.size();
+		header.skipped = _skipped;
+		WriteAt(&header, sizeof(header), 0);
+	}
+
+	// unused part of reserved space is given back
+	long long fileSize = _maxBytes != 0 ? _end + indexSize : 0;
+#if UNITY_WIN || UNITY_METRO
+	FILE_END_OF_FILE_INFO endOfFile;
+	endOfFile.EndOfFile.QuadPart = fileSize;
+	SetFileInformationByHandle((HANDLE)_file, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile));
+	CloseHandle((HANDLE)_file);
+#else
+	if (ftruncate((int)_file, fileSize) == -1)
+		++_failed;
+	close((int)_file);
+#endif
+	_file = -1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink::WriteAt()
+//-------------------------------------------------------------------------------------------------
+bool CaptureSink::WriteAt(const void* data, size_t size, long long offset)
+{
+	const char* bytes = (const char*)data;
+	while (size > 0)
+	{
+#if UNITY_WIN || UNITY_METRO
+		// positional write on synchronous handle, file pointer isn't shared with other writes
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+		DWORD written = 0;
+		DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+		if (!WriteFile((HANDLE)_file, bytes, chunk, &written, &overlapped) || written == 0)
+			return false;
+#else
+		ssize_t written = pwrite((int)_file, bytes, size, (off_t)offset);
+		if (written == -1 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return false;
+#endif
+		bytes += written;
+		size -= written;
+		offset += written;
+	}
+
+	return true;
+}
@@ -0,0 +1,163 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// capture file starts with CaptureHeader. every captured copy starts at multiple of kCaptureAlignment, the first one
+// right after the header. index of CaptureEntry records follows the last copy
+const int kCaptureAlignment = 4096;
+const int kCaptureVersion = 1;
+
+//-------------------------------------------------------------------------------------------------
+// CaptureHeader
+//-------------------------------------------------------------------------------------------------
+// written when the capture is closed, file without index (crash during capture) has zero indexOffset
+struct CaptureHeader
+{
+	// "ATRCAPT" and zero
+	char magic[8];
+	int version;
+	// size of CaptureEntry
+	int entrySize;
+	long long indexOffset;
+	int entryCount;
+	// copies that weren't captured because the writer fell behind or the file was full
+	int skipped;
+};
+
+//-------------------------------------------------------------------------------------------------
+// CaptureEntry
+//-------------------------------------------------------------------------------------------------
+// one captured copy, data are tightly packed rows of rowPitch bytes, slice after slice
+struct CaptureEntry
+{
+	long long offset;
+	int size;
+	// poll event that issued the copy
+	unsigned int frame;
+	// microseconds from the start of the capture to the moment the finished copy was queued for writing
+	long long time;
+	// region in texels (bytes of buffer)
+	int width;
+	int height;
+	int slices;
+	// row of pixels, row of 4x4 blocks for compressed formats
+	int rowPitch;
+	// FormatTraits of the resource: bytes per block, block size, channels, ComponentType and kFormat* flags
+	unsigned char blockSize;
+	unsigned char blockWidth;
+	unsigned char blockHeight;
+	unsigned char channels;
+	unsigned char type;
+	unsigned char flags;
+	unsigned char reserved[2];
+};
+
+//-------------------------------------------------------------------------------------------------
+// CaptureSink
+//-------------------------------------------------------------------------------------------------
+// writes finished copies to a file on dedicated writer thread. disk space for the whole capture is reserved 
+// when the file is opened and copies are written with positional writes one after another. data are written 
+// straight from plugin memory of the copy, the memory is handed back by the done callback. file is finalized by
+// the writer thread too, render thread never waits for the disk.
+// Write, Skip and Close are called from render thread, counters and IsClosed can be read from any thread
+class CaptureSink
+{
+public:
+	typedef std::function<void()> Done;
+	typedef std::chrono::steady_clock Clock;
+
+	CaptureSink();
+	~CaptureSink();
+
+	// creates the file and reserves maxBytes of disk space for it
+	bool Open(const char* path, long long maxBytes);
+	// queues write of entry.size bytes of data, offset and time of the entry are filled in. done is called on writer
+	// thread once the data were written (or the write failed). false when the file is full, done isn't called then
+	bool Write(const void* data, const CaptureEntry& entry, const Done& done);
+	// copy wasn't captured, every copy of the capture waits for the writer
+	void Skip();
+	// copy failed on gpu side
+	void Fail();
+	// queues close behind the writes, writer thread then writes the index and header and cuts the file to its size.
+	// doesn't wait, nothing can be written afterwards
+	void Close();
+	// file is closed and every done callback was called, memory of the copies isn't used anymore
+	bool IsClosed() const { return _closed; }
+
+	int GetWritten() const { return _written; }
+	int GetSkipped() const { return _skipped; }
+	int GetFailed() const { return _failed; }
+	long long GetBytes() const { return _bytes; }
+
+private:
+	struct Job
+	{
+		const void* data;
+		CaptureEntry entry;
+		Done done;
+	};
+
+	void ThreadFunc();
+	void Finish();
+	bool WriteAt(const void* data, size_t size, long long offset);
+
+private:
+	// file descriptor or HANDLE, -1 when the file isn't open
+	intptr_t _file;
+	long long _maxBytes;
+	// end of the last queued copy and number of queued copies, render thread only
+	long long _end;
+	int _queued;
+	Clock::time_point _start;
+
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	// guarded by _mutex
+	std::deque<Job> _jobs;
+	bool _quit;
+	// entries of written copies, writer thread only
+	std::vector<CaptureEntry> _index;
+	std::atomic<bool> _closed;
+
+	std::atomic<int> _written;
+	std::atomic<int> _skipped;
+	std::atomic<int> _failed;
+	std::atomic<long long> _bytes;
+};
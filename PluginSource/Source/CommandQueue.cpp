@@ -0,0 +1,163 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "CommandQueue.h"
+#include "PlatformBase.h"
+
+//-------------------------------------------------------------------------------------------------
+// CommandQueue::CommandQueue()
+//-------------------------------------------------------------------------------------------------
+CommandQueue::CommandQueue()
+	: _tail(NULL), _head(NULL), _headIndex(0), _spareBlock(NULL), _blockCount(0)
+{
+	_head = _tail = AllocateBlock();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CommandQueue::~CommandQueue()
+//-------------------------------------------------------------------------------------------------
+CommandQueue::~CommandQueue()
+{
+	Block* block = _head;
+	while (block != NULL)
+	{
+		Block* next = block->next;
+		delete block;
+		block = next;
+	}
+
+	delete _spareBlock.load();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CommandQueue::AllocateBlock()
+//-------------------------------------------------------------------------------------------------
+CommandQueue::Block* CommandQueue::AllocateBlock()
+{
+	// reuse block released by consumer if there is one
+	Block* block = _spareBlock.exchange(NULL);
+	if (block == NULL)
+	{
+		block = new Block();
+	}
+	else
+	{
+		block->count.store(0, std::memory_order_relaxed);
+		block->next.store(NULL, std::memory_order_relaxed);
+	}
+
+	++_blockCount;
+	return block;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CommandQueue::FreeBlock()
+//-------------------------------------------------------------------------------------------------
+void CommandQueue::FreeBlock(Block* block)
+{
+	--_blockCount;
+
+	// keep one block for reuse
+	Block* previous = _spareBlock.exchange(block);
+	SAFE_DELETE(previous);
+}
+
+//-------------------------------------------------------------------------------------------------
+// CommandQueue::IsFull()
+//-------------------------------------------------------------------------------------------------
+bool CommandQueue::IsFull() const
+{
+	return !HasSpace(1);
+}
+
+//-------------------------------------------------------------------------------------------------
+// CommandQueue::HasSpace()
+//-------------------------------------------------------------------------------------------------
+bool CommandQueue::HasSpace(int count) const
+{
+	// block count can only go down on consumer side, that many pushes are guaranteed to succeed if this returns true
+	int space = kBlockSize - _tail->count.load(std::memory_order_relaxed);
+	space += (kMaxBlocks - _blockCount) * kBlockSize;
+	return count <= space;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CommandQueue::Push()
+//-------------------------------------------------------------------------------------------------
+bool CommandQueue::Push(const Command& command)
+{
+	if (IsFull())
+		return false;
+
+	Block* tail = _tail;
+	int index = tail->count.load(std::memory_order_relaxed);
+	if (index == kBlockSize)
+	{
+		// last block is full, link new one
+		Block* block = AllocateBlock();
+		tail->next.store(block, std::memory_order_release);
+		_tail = tail = block;
+		index = 0;
+	}
+
+	tail->commands[index] = command;
+	// publish command to consumer
+	tail->count.store(index + 1, std::memory_order_release);
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CommandQueue::Pop()
+//-------------------------------------------------------------------------------------------------
+bool CommandQueue::Pop(int eventId, Command* command)
+{
+	if (_headIndex == kBlockSize)
+	{
+		// move to next block once producer linked it, producer doesn't touch the old one anymore
+		Block* next = _head->next.load(std::memory_order_acquire);
+		if (next == NULL)
+			return false;
+
+		FreeBlock(_head);
+		_head = next;
+		_headIndex = 0;
+	}
+
+	if (_headIndex >= _head->count.load(std::memory_order_acquire))
+		return false;
+
+	// command was queued for later event. IssuePluginEvent calls are executed in order so the
+	// command has to wait for its own event, otherwise it could run before rendering commands
+	// that were issued before it on main thread
+	const Command& front = _head->commands[_headIndex];
+	if (IsEventAfter(front.eventId, eventId))
+		return false;
+
+	*command = front;
+	++_headIndex;
+	return true;
+}
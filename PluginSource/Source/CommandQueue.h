@@ -0,0 +1,114 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+
+enum class CommandType
+{
+	RequestTexture,
+	RequestBuffer,
+	CopyTexture,
+	CopyBuffer,
+	RequestData,
+	CopyData,
+	ReleaseTempResources,
+	Subscribe,
+	Unsubscribe
+};
+
+//-------------------------------------------------------------------------------------------------
+// Command
+//-------------------------------------------------------------------------------------------------
+struct Command
+{
+	// IssuePluginEvent event id, command is executed by render event with the same or later id
+	int eventId;
+	CommandType type;
+	int resourceHandle;
+	// resource object for commands that run after the handle was released
+	void* resource;
+};
+
+//-------------------------------------------------------------------------------------------------
+// CommandQueue
+//-------------------------------------------------------------------------------------------------
+// single producer (main thread), single consumer (render thread) lock-free queue.
+// commands are stored in linked blocks, new block is added when the last one is full so there is
+// no fixed limit apart from kMaxBlocks. consumer frees blocks it has finished reading (one block
+// is kept around for reuse)
+class CommandQueue
+{
+public:
+	CommandQueue();
+	~CommandQueue();
+
+	// main thread
+	bool IsFull() const;
+	bool HasSpace(int count) const;
+	bool Push(const Command& command);
+
+	// render thread. pops next command if it belongs to the given or earlier event
+	bool Pop(int eventId, Command* command);
+
+public:
+	static const int kBlockSize = 256;
+	static const int kMaxBlocks = 256;
+
+private:
+	struct Block
+	{
+		Command commands[kBlockSize];
+		std::atomic<int> count;
+		std::atomic<Block*> next;
+
+		Block() : count(0), next(NULL) {}
+	};
+
+	Block* AllocateBlock();
+	void FreeBlock(Block* block);
+
+private:
+	// producer side
+	Block* _tail;
+
+	// consumer side
+	Block* _head;
+	int _headIndex;
+
+	std::atomic<Block*> _spareBlock;
+	std::atomic<int> _blockCount;
+};
+
+// true if event id a was issued after event id b. ids are 31-bit wrapping counters
+inline bool IsEventAfter(int a, int b)
+{
+	int diff = (a - b) & 0x7fffffff;
+	return diff != 0 && diff < 0x40000000;
+}
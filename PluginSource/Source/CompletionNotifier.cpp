@@ -0,0 +1,192 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "CompletionNotifier.h"
+#include "PlatformBase.h"
+
+#if UNITY_WIN || UNITY_METRO
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if UNITY_LINUX || UNITY_ANDROID
+#include <sys/eventfd.h>
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// CompletionNotifier::CompletionNotifier()
+//-------------------------------------------------------------------------------------------------
+CompletionNotifier::CompletionNotifier() : _callback(NULL), _userData(NULL), _lost(0), _waitHandle(-1), _signalFd(-1)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// CompletionNotifier::~CompletionNotifier()
+//-------------------------------------------------------------------------------------------------
+CompletionNotifier::~CompletionNotifier()
+{
+	if (_waitHandle == -1)
+		return;
+
+#if UNITY_WIN || UNITY_METRO
+	CloseHandle((HANDLE)_waitHandle);
+#else
+	close((int)_waitHandle);
+	if (_signalFd != -1)
+		close(_signalFd);
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+// CompletionNotifier::SetCallback()
+//-------------------------------------------------------------------------------------------------
+void CompletionNotifier::SetCallback(CompletionCallback callback, void* userData)
+{
+	std::lock_guard<std::mutex> lock(_callbackMutex);
+	_callback = callback;
+	_userData = userData;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CompletionNotifier::GetWaitHandle()
+//-------------------------------------------------------------------------------------------------
+intptr_t CompletionNotifier::GetWaitHandle()
+{
+	std::lock_guard<std::mutex> lock(_queueMutex);
+	if (_waitHandle == -1 && !CreateWaitHandle())
+		return -1;
+
+	// completions queued before the handle existed have to wake the consumer too
+	if (!_queue.empty())
+		Signal();
+
+	return _waitHandle;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CompletionNotifier::CreateWaitHandle()
+//-------------------------------------------------------------------------------------------------
+bool CompletionNotifier::CreateWaitHandle()
+{
+#if UNITY_WIN || UNITY_METRO
+	// auto-reset, consumer wakes up once for any number of completions and pops all of them
+	HANDLE event = CreateEventExW(NULL, NULL, 0, SYNCHRONIZE | EVENT_MODIFY_STATE);
+	if (event == NULL)
+		return false;
+
+	_waitHandle = (intptr_t)event;
+#elif UNITY_LINUX || UNITY_ANDROID
+	// counter is reset by read, consumer blocks in read or poll
+	int fd = eventfd(0, EFD_CLOEXEC);
+	if (fd == -1)
+		return false;
+
+	_waitHandle = fd;
+#else
+	// consumer blocks on the read end, write end doesn't block when the pipe is full (consumer has to wake up anyway)
+	int fds[2];
+	if (pipe(fds) != 0)
+		return false;
+
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+	_waitHandle = fds[0];
+	_signalFd = fds[1];
+#endif
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CompletionNotifier::Signal()
+//-------------------------------------------------------------------------------------------------
+void CompletionNotifier::Signal()
+{
+	// called with _queueMutex held
+	if (_waitHandle == -1)
+		return;
+
+#if UNITY_WIN || UNITY_METRO
+	SetEvent((HANDLE)_waitHandle);
+#elif UNITY_LINUX || UNITY_ANDROID
+	uint64_t value = 1;
+	while (write((int)_waitHandle, &value, sizeof(value)) == -1 && errno == EINTR) {}
+#else
+	char value = 1;
+	while (write(_signalFd, &value, 1) == -1 && errno == EINTR) {}
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+// CompletionNotifier::Pop()
+//-------------------------------------------------------------------------------------------------
+bool CompletionNotifier::Pop(Completion* completion, bool* overflowed)
+{
+	std::lock_guard<std::mutex> lock(_queueMutex);
+	if (_queue.empty())
+		return false;
+
+	// queue was full at some point, lost completions came after the queued ones
+	*completion = _queue.front();
+	*overflowed = _lost != 0;
+	_queue.pop_front();
+	_lost = 0;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CompletionNotifier::Notify()
+//-------------------------------------------------------------------------------------------------
+bool CompletionNotifier::Notify(int resourceHandle, int requestId, int status)
+{
+	bool queued;
+	{
+		std::lock_guard<std::mutex> lock(_queueMutex);
+		queued = (int)_queue.size() < kMaxQueued;
+		if (queued)
+		{
+			Completion completion = { resourceHandle, requestId, status };
+			_queue.push_back(completion);
+		}
+		else
+		{
+			++_lost;
+		}
+		Signal();
+	}
+
+	std::lock_guard<std::mutex> lock(_callbackMutex);
+	if (_callback != NULL)
+		_callback(resourceHandle, requestId, status, _userData);
+
+	return queued;
+}
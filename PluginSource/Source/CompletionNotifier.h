@@ -0,0 +1,96 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+
+// called when a request is finished (data are ready in plugin memory or the request failed), status is Status value.
+// runs on render thread or copy thread
+typedef void(*CompletionCallback)(int resourceHandle, int requestId, int status, void* userData);
+
+//-------------------------------------------------------------------------------------------------
+// Completion
+//-------------------------------------------------------------------------------------------------
+struct Completion
+{
+	int resourceHandle;
+	int requestId;
+	int status;
+};
+
+//-------------------------------------------------------------------------------------------------
+// CompletionNotifier
+//-------------------------------------------------------------------------------------------------
+// tells consumers that requests are finished so they don't have to retrieve every resource every frame.
+// every completion calls the callback, is queued and signals the wait handle. consumer thread blocks on 
+// the handle and pops queued completions, main thread then retrieves exactly the finished requests.
+// queue is bounded, completions that don't fit are lost for Pop and the next Pop reports the overflow.
+// consumer has to fall back to polling (retrieve every resource until NotReady) then
+class CompletionNotifier
+{
+public:
+	CompletionNotifier();
+	~CompletionNotifier();
+
+	// any thread. callback isn't called anymore once the function returns, so user data can be released
+	void SetCallback(CompletionCallback callback, void* userData);
+	// any thread. eventfd (Linux, Android), read end of a pipe (macOS, iOS) or auto-reset event (Windows).
+	// created with the first call, stays valid until the plugin is unloaded. -1 if it can't be created
+	intptr_t GetWaitHandle();
+	// any thread. oldest queued completion, false when the queue is empty. overflowed is set when completions
+	// were lost because the queue was full since the last Pop that reported it
+	bool Pop(Completion* completion, bool* overflowed);
+
+	// render thread or copy thread. false when the queue was full, the completion is only signaled and passed 
+	// to the callback
+	bool Notify(int resourceHandle, int requestId, int status);
+
+public:
+	static const int kMaxQueued = 1024;
+
+private:
+	bool CreateWaitHandle();
+	void Signal();
+
+private:
+	// held while the callback runs so SetCallback waits for callbacks in progress
+	std::mutex _callbackMutex;
+	CompletionCallback _callback;
+	void* _userData;
+
+	std::mutex _queueMutex;
+	std::deque<Completion> _queue;
+	// completions that didn't fit since the last overflow reported by Pop
+	int _lost;
+	intptr_t _waitHandle;
+	// write end of the pipe where eventfd isn't available
+	int _signalFd;
+};
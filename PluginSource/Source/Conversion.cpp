@@ -0,0 +1,432 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Conversion.h"
+#include "PlatformBase.h"
+#include <string.h>
+#include <math.h>
+
+#if SUPPORT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if SUPPORT_F16C
+#include <immintrin.h>
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// ConversionTables
+//-------------------------------------------------------------------------------------------------
+// lookup tables of 8 bit unorm values, built on first use
+struct ConversionTables
+{
+	float unormToFloat[256];
+	float srgbToFloat[256];
+	unsigned char identity[256];
+	unsigned char srgbToUNorm8[256];
+
+	ConversionTables()
+	{
+		for (int i = 0; i < 256; ++i)
+		{
+			float value = i / 255.0f;
+			float linear = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+			unormToFloat[i] = value;
+			srgbToFloat[i] = linear;
+			identity[i] = (unsigned char)i;
+			srgbToUNorm8[i] = (unsigned char)(linear * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const ConversionTables& GetConversionTables()
+{
+	static const ConversionTables tables;
+	return tables;
+}
+
+//-------------------------------------------------------------------------------------------------
+// HalfToFloat
+//-------------------------------------------------------------------------------------------------
+float HalfToFloat(unsigned short half)
+{
+	unsigned int sign = (half & 0x8000u) << 16;
+	unsigned int exponent = (half >> 10) & 0x1f;
+	unsigned int mantissa = half & 0x3ff;
+
+	unsigned int bits;
+	if (exponent == 0x1f)
+	{
+		// infinity and NaN
+		bits = sign | 0x7f800000u | (mantissa << 13);
+	}
+	else if (exponent != 0)
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	else
+	{
+		// zero and denormals, value is mantissa * 2^-24
+		float value = mantissa * (1.0f / 16777216.0f);
+		return sign != 0 ? -value : value;
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+#if SUPPORT_SSE2 && !SUPPORT_F16C
+//-------------------------------------------------------------------------------------------------
+// HalfToFloat4
+//-------------------------------------------------------------------------------------------------
+// four halves in low 16 bits of every lane. exponent and mantissa are moved to float position and
+// rebiased by multiplication with 2^112, that handles denormals too. infinity and NaN keep all ones exponent
+static __m128 HalfToFloat4(__m128i half)
+{
+	const __m128i signMask = _mm_set1_epi32(0x8000);
+	const __m128i valueMask = _mm_set1_epi32(0x7fff);
+	const __m128i exponentMask = _mm_set1_epi32(0x7c00);
+	const __m128i infinity = _mm_set1_epi32(0x7f800000);
+	const __m128 rebias = _mm_castsi128_ps(_mm_set1_epi32(0x77800000));
+
+	__m128i sign = _mm_slli_epi32(_mm_and_si128(half, signMask), 16);
+	__m128i value = _mm_slli_epi32(_mm_and_si128(half, valueMask), 13);
+	__m128i special = _mm_cmpeq_epi32(_mm_and_si128(half, exponentMask), exponentMask);
+
+	__m128i scaled = _mm_castps_si128(_mm_mul_ps(_mm_castsi128_ps(value), rebias));
+	__m128i result = _mm_or_si128(_mm_andnot_si128(special, scaled), _mm_and_si128(special, _mm_or_si128(value, infinity)));
+	return _mm_castsi128_ps(_mm_or_si128(result, sign));
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// HalfToFloatN
+//-------------------------------------------------------------------------------------------------
+static void HalfToFloatN(const unsigned short* halves, int count, float* result)
+{
+	int i = 0;
+
+#if SUPPORT_F16C
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i values = _mm_loadu_si128((const __m128i*)(halves + i));
+		_mm_storeu_ps(result + i, _mm_cvtph_ps(values));
+		_mm_storeu_ps(result + i + 4, _mm_cvtph_ps(_mm_unpackhi_epi64(values, values)));
+	}
+#elif SUPPORT_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i values = _mm_loadu_si128((const __m128i*)(halves + i));
+		_mm_storeu_ps(result + i, HalfToFloat4(_mm_unpacklo_epi16(values, zero)));
+		_mm_storeu_ps(result + i + 4, HalfToFloat4(_mm_unpackhi_epi16(values, zero)));
+	}
+#endif
+
+	for (; i < count; ++i)
+		result[i] = HalfToFloat(halves[i]);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadComponent
+//-------------------------------------------------------------------------------------------------
+static float ReadComponent(const void* data, int index, ComponentType type)
+{
+	switch (type)
+	{
+	case ComponentType::Float32:
+		return ((const float*)data)[index];
+	case ComponentType::UInt32:
+		return (float)((const unsigned int*)data)[index];
+	case ComponentType::SInt32:
+		return (float)((const int*)data)[index];
+	case ComponentType::Float16:
+		return HalfToFloat(((const unsigned short*)data)[index]);
+	case ComponentType::UNorm16:
+		return ((const unsigned short*)data)[index] * (1.0f / 65535.0f);
+	case ComponentType::SNorm16:
+	{
+		float value = ((const short*)data)[index] * (1.0f / 32767.0f);
+		return value < -1.0f ? -1.0f : value;
+	}
+	case ComponentType::UInt16:
+		return (float)((const unsigned short*)data)[index];
+	case ComponentType::SInt16:
+		return (float)((const short*)data)[index];
+	case ComponentType::UNorm8:
+		return ((const unsigned char*)data)[index] * (1.0f / 255.0f);
+	case ComponentType::SNorm8:
+	{
+		// -128 and -127 both map to -1
+		float value = ((const signed char*)data)[index] * (1.0f / 127.0f);
+		return value < -1.0f ? -1.0f : value;
+	}
+	case ComponentType::UInt8:
+		return (float)((const unsigned char*)data)[index];
+	case ComponentType::SInt8:
+		return (float)((const signed char*)data)[index];
+	default:
+		// packed and compressed formats don't have channels of one type
+		return 0.0f;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// ConvertToFloat4
+//-------------------------------------------------------------------------------------------------
+void ConvertToFloat4(const void* pixels, int count, ComponentType type, int channels, float* result)
+{
+	// four channel formats have the same layout as float4
+	if (channels == 4 && type == ComponentType::Float32)
+	{
+		memcpy(result, pixels, count * 4 * sizeof(float));
+		return;
+	}
+
+	if (channels == 4 && type == ComponentType::Float16)
+	{
+		HalfToFloatN((const unsigned short*)pixels, count * 4, result);
+		return;
+	}
+
+	int i = 0;
+
+#if SUPPORT_SSE2
+	// four RGBA8 pixels at once
+	if (channels == 4 && type == ComponentType::UNorm8)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)((const char*)pixels + i * 4));
+			__m128i lo = _mm_unpacklo_epi8(bytes, zero);
+			__m128i hi = _mm_unpackhi_epi8(bytes, zero);
+			_mm_storeu_ps(result + i * 4 + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+			_mm_storeu_ps(result + i * 4 + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+			_mm_storeu_ps(result + i * 4 + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+			_mm_storeu_ps(result + i * 4 + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+		}
+	}
+#endif
+
+	// missing channels are zero
+	for (; i < count; ++i)
+	{
+		for (int c = 0; c < 4; ++c)
+			result[i * 4 + c] = c < channels ? ReadComponent(pixels, i * channels + c, type) : 0.0f;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Converter::Converter()
+//-------------------------------------------------------------------------------------------------
+Converter::Converter(const ConversionDesc& desc, const FormatTraits& format)
+	: _type(format.type), _channels(format.channels), _pixelSize(format.blockSize), _outputType(desc.outputType), _outputChannels(0)
+{
+	const ConversionTables& tables = GetConversionTables();
+	bool bgra = (format.flags & kFormatBGRA) != 0;
+	bool linear = (desc.flags & kConversionLinear) != 0;
+	int channelMask = desc.channelMask != 0 ? desc.channelMask : (1 << format.channels) - 1;
+
+	// output channels are packed in RGBA order
+	bool identity = true;
+	for (int c = 0; c < 4; ++c)
+	{
+		if ((channelMask & (1 << c)) == 0)
+			continue;
+
+		int channel = bgra && (c == 0 || c == 2) ? 2 - c : c;
+		int index = _outputChannels++;
+		_swizzle[index] = channel < format.channels ? channel : -1;
+		_defaults[index] = c == 3 ? 1.0f : 0.0f;
+		identity = identity && _swizzle[index] == index;
+
+		bool decode = linear && c < 3;
+		_floatTables[index] = decode ? tables.srgbToFloat : tables.unormToFloat;
+		_byteTables[index] = decode ? tables.srgbToUNorm8 : tables.identity;
+	}
+	identity = identity && _outputChannels == format.channels;
+
+	if (identity && !linear && ((_type == ComponentType::Float32 && _outputType == OutputType::Float32) || 
+		(_type == ComponentType::UNorm8 && _outputType == OutputType::UNorm8)))
+		_kernel = Kernel::Copy;
+	else if (identity && _type == ComponentType::Float16 && _outputType == OutputType::Float32)
+		_kernel = Kernel::Half;
+	else if (bgra && !linear && _channels == 4 && channelMask == kChannelRGBA && _outputType == OutputType::UNorm8)
+		_kernel = Kernel::SwapRB8;
+	else if (_type == ComponentType::UNorm8)
+		_kernel = Kernel::Table8;
+	else
+		_kernel = Kernel::Generic;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Converter::IsSupported()
+//-------------------------------------------------------------------------------------------------
+bool Converter::IsSupported(const ConversionDesc& desc, const FormatTraits& format)
+{
+	if (desc.outputType != OutputType::Float32 && desc.outputType != OutputType::UNorm8)
+		return false;
+
+	if ((desc.channelMask & ~kChannelRGBA) != 0 || (desc.flags & ~kConversionLinear) != 0)
+		return false;
+
+	// only formats with channels of one type
+	if (!format.HasChannels() || format.IsCompressed() || format.channels > 4)
+		return false;
+
+	// sRGB encoding is used only by 8 bit formats
+	if ((desc.flags & kConversionLinear) != 0 && format.type != ComponentType::UNorm8)
+		return false;
+
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Converter::GetPixelSize()
+//-------------------------------------------------------------------------------------------------
+int Converter::GetPixelSize(const ConversionDesc& desc, const FormatTraits& format)
+{
+	int channelMask = desc.channelMask != 0 ? desc.channelMask : (1 << format.channels) - 1;
+
+	int channels = 0;
+	for (int c = 0; c < 4; ++c)
+		channels += (channelMask >> c) & 1;
+
+	return channels * (desc.outputType == OutputType::Float32 ? sizeof(float) : 1);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Converter::ConvertPixels()
+//-------------------------------------------------------------------------------------------------
+void Converter::ConvertPixels(const void* pixels, int count, void* result) const
+{
+	switch (_kernel)
+	{
+	case Kernel::Copy:
+		memcpy(result, pixels, count * _pixelSize);
+		return;
+	case Kernel::Half:
+		HalfToFloatN((const unsigned short*)pixels, count * _channels, (float*)result);
+		return;
+	case Kernel::Table8:
+		ConvertTable8((const unsigned char*)pixels, count, result);
+		return;
+	case Kernel::Generic:
+		ConvertGeneric(pixels, count, result);
+		return;
+	case Kernel::SwapRB8:
+		break;
+	}
+
+	// BGRA8 to RGBA8, bytes 0 and 2 of every pixel are swapped
+	const unsigned int* src = (const unsigned int*)pixels;
+	unsigned int* dest = (unsigned int*)result;
+	int i = 0;
+
+#if SUPPORT_SSE2
+	const __m128i greenAlpha = _mm_set1_epi32((int)0xff00ff00);
+	const __m128i lowByte = _mm_set1_epi32(0xff);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i values = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i red = _mm_and_si128(_mm_srli_epi32(values, 16), lowByte);
+		__m128i blue = _mm_slli_epi32(_mm_and_si128(values, lowByte), 16);
+		_mm_storeu_si128((__m128i*)(dest + i), _mm_or_si128(_mm_and_si128(values, greenAlpha), _mm_or_si128(red, blue)));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		unsigned int value = src[i];
+		dest[i] = (value & 0xff00ff00u) | ((value >> 16) & 0xffu) | ((value & 0xffu) << 16);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Converter::ConvertTable8()
+//-------------------------------------------------------------------------------------------------
+void Converter::ConvertTable8(const unsigned char* pixels, int count, void* result) const
+{
+	if (_outputType == OutputType::Float32)
+	{
+		float* dest = (float*)result;
+		for (int i = 0; i < count; ++i, pixels += _channels)
+		{
+			for (int c = 0; c < _outputChannels; ++c)
+				*dest++ = _swizzle[c] >= 0 ? _floatTables[c][pixels[_swizzle[c]]] : _defaults[c];
+		}
+	}
+	else
+	{
+		unsigned char* dest = (unsigned char*)result;
+		for (int i = 0; i < count; ++i, pixels += _channels)
+		{
+			for (int c = 0; c < _outputChannels; ++c)
+				*dest++ = _swizzle[c] >= 0 ? _byteTables[c][pixels[_swizzle[c]]] : (unsigned char)(_defaults[c] * 255.0f);
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Converter::ConvertGeneric()
+//-------------------------------------------------------------------------------------------------
+void Converter::ConvertGeneric(const void* pixels, int count, void* result) const
+{
+	// chunks of float4 stay in L1 cache
+	float converted[kChunkSize * 4];
+	const char* src = (const char*)pixels;
+	float* floatDest = (float*)result;
+	unsigned char* byteDest = (unsigned char*)result;
+
+	for (int i = 0; i < count; i += kChunkSize)
+	{
+		int chunk = count - i < kChunkSize ? count - i : kChunkSize;
+		ConvertToFloat4(src + i * _pixelSize, chunk, _type, _channels, converted);
+
+		for (int p = 0; p < chunk; ++p)
+		{
+			for (int c = 0; c < _outputChannels; ++c)
+			{
+				float value = _swizzle[c] >= 0 ? converted[p * 4 + _swizzle[c]] : _defaults[c];
+				if (_outputType == OutputType::Float32)
+				{
+					*floatDest++ = value;
+				}
+				else
+				{
+					// saturate, NaN becomes zero
+					value = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+					*byteDest++ = (unsigned char)(value * 255.0f + 0.5f);
+				}
+			}
+		}
+	}
+}
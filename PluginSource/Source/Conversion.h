@@ -0,0 +1,130 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "FormatTraits.h"
+
+// channels returned by conversion, always in RGBA order regardless of memory order of the format
+const int kChannelR = 1 << 0;
+const int kChannelG = 1 << 1;
+const int kChannelB = 1 << 2;
+const int kChannelA = 1 << 3;
+const int kChannelRGBA = kChannelR | kChannelG | kChannelB | kChannelA;
+
+// color channels of 8 bit unorm formats are decoded from sRGB to linear, alpha stays as it is
+const int kConversionLinear = 1 << 0;
+
+// type of one channel of converted pixel
+enum class OutputType
+{
+	// data are returned as they are stored in the resource
+	Native = 0,
+	Float32,
+	UNorm8
+};
+
+//-------------------------------------------------------------------------------------------------
+// ConversionDesc
+//-------------------------------------------------------------------------------------------------
+struct ConversionDesc
+{
+	OutputType outputType;
+	// combination of kChannel* flags, zero selects all channels of the format.
+	// selected channels the format doesn't have are 0, alpha is 1
+	int channelMask;
+	// combination of kConversion* flags
+	int flags;
+
+	ConversionDesc() : outputType(OutputType::Native), channelMask(0), flags(0) {}
+
+	bool IsEnabled() const { return outputType != OutputType::Native; }
+};
+
+//-------------------------------------------------------------------------------------------------
+// HalfToFloat
+//-------------------------------------------------------------------------------------------------
+float HalfToFloat(unsigned short half);
+
+//-------------------------------------------------------------------------------------------------
+// ConvertToFloat4
+//-------------------------------------------------------------------------------------------------
+// pixels of format with channels of one type to float4 in memory order, missing channels are zero
+void ConvertToFloat4(const void* pixels, int count, ComponentType type, int channels, float* result);
+
+//-------------------------------------------------------------------------------------------------
+// Converter
+//-------------------------------------------------------------------------------------------------
+// converts rows of pixels from staging memory straight to the output buffer. 
+// common cases have dedicated SSE2/F16C kernels, the rest goes through float4
+class Converter
+{
+public:
+	Converter(const ConversionDesc& desc, const FormatTraits& format);
+
+	static bool IsSupported(const ConversionDesc& desc, const FormatTraits& format);
+	// size of one converted pixel in bytes
+	static int GetPixelSize(const ConversionDesc& desc, const FormatTraits& format);
+
+	// tightly packed pixels in the source format
+	void ConvertPixels(const void* pixels, int count, void* result) const;
+
+private:
+	enum class Kernel
+	{
+		// source and output layout are the same
+		Copy,
+		// all channels of half format to float
+		Half,
+		// all channels of BGRA8 format to RGBA8
+		SwapRB8,
+		// 8 bit unorm source, every channel through lookup table
+		Table8,
+		// everything else, chunks are converted to float4 first
+		Generic
+	};
+
+	void ConvertTable8(const unsigned char* pixels, int count, void* result) const;
+	void ConvertGeneric(const void* pixels, int count, void* result) const;
+
+private:
+	static const int kChunkSize = 256;
+
+	Kernel _kernel;
+	ComponentType _type;
+	int _channels;
+	int _pixelSize;
+	OutputType _outputType;
+	int _outputChannels;
+	// memory channel of every output channel, -1 for channels the format doesn't have
+	int _swizzle[4];
+	float _defaults[4];
+	// Table8 kernel, lookup table of every output channel
+	const float* _floatTables[4];
+	const unsigned char* _byteTables[4];
+};
@@ -0,0 +1,252 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "CopyEngine.h"
+#include "PlatformBase.h"
+#include <string.h>
+
+#if SUPPORT_SSE2
+#include <emmintrin.h>
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// CopyEngine::CopyEngine()
+//-------------------------------------------------------------------------------------------------
+CopyEngine::CopyEngine() : _workersStarted(false), _job(NULL), _jobGeneration(0), _activeWorkers(0), _quit(false)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyEngine::~CopyEngine()
+//-------------------------------------------------------------------------------------------------
+CopyEngine::~CopyEngine()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_all();
+
+	for (size_t i = 0; i < _workers.size(); ++i)
+		_workers[i].join();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyEngine::StartWorkers()
+//-------------------------------------------------------------------------------------------------
+void CopyEngine::StartWorkers()
+{
+	// workers are started with the first large copy, calling thread is one of the copying threads
+	_workersStarted = true;
+	unsigned int cores = std::thread::hardware_concurrency();
+	int count = cores > 1 ? (int)cores - 1 : 0;
+	count = count < kMaxWorkers ? count : kMaxWorkers;
+
+	for (int i = 0; i < count; ++i)
+		_workers.push_back(std::thread(&CopyEngine::WorkerThread, this));
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyEngine::CopyRows()
+//-------------------------------------------------------------------------------------------------
+void CopyEngine::CopyRows(void* dest, int destPitch, const void* src, int srcPitch, int rowSize, int rowCount)
+{
+	size_t size = (size_t)rowSize * rowCount;
+	bool bulk = destPitch == rowSize && srcPitch == rowSize;
+
+	// small copies aren't worth waking up workers
+	if (size < kParallelThreshold)
+	{
+		if (bulk)
+		{
+			memcpy(dest, src, size);
+			return;
+		}
+
+		for (int row = 0; row < rowCount; ++row)
+			memcpy((char*)dest + (size_t)row * destPitch, (const char*)src + (size_t)row * srcPitch, rowSize);
+		return;
+	}
+
+	if (!_workersStarted)
+		StartWorkers();
+
+	Job job;
+	job.dest = (char*)dest;
+	job.src = (const char*)src;
+	job.destPitch = destPitch;
+	job.srcPitch = srcPitch;
+	job.rowSize = rowSize;
+	job.rowCount = rowCount;
+	job.bulk = bulk;
+	job.stream = size > kStreamingThreshold;
+
+	// two bands per thread balance uneven progress of the threads, bands are never smaller than kMinBandSize
+	size_t threads = _workers.size() + 1;
+	size_t bandCount = size / kMinBandSize < threads * 2 ? size / kMinBandSize : threads * 2;
+	if (bulk)
+	{
+		// 64 byte aligned ranges keep streaming stores on whole cache lines
+		job.bandSize = ((size + bandCount - 1) / bandCount + 63) & ~(size_t)63;
+		job.bandCount = (int)((size + job.bandSize - 1) / job.bandSize);
+	}
+	else
+	{
+		job.bandSize = (job.rowCount + bandCount - 1) / bandCount;
+		job.bandCount = (int)((job.rowCount + job.bandSize - 1) / job.bandSize);
+	}
+	job.nextBand = 0;
+	job.finishedBands = 0;
+
+	if (_workers.empty())
+	{
+		RunBands(&job);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_job = &job;
+		++_jobGeneration;
+	}
+	_wake.notify_all();
+
+	RunBands(&job);
+
+	// job lives on this stack, wait until no worker can touch it
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [&] { return job.finishedBands == job.bandCount && _activeWorkers == 0; });
+	_job = NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyEngine::WorkerThread()
+//-------------------------------------------------------------------------------------------------
+void CopyEngine::WorkerThread()
+{
+	unsigned int generation = 0;
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_wake.wait(lock, [&] { return _quit || (_job != NULL && _jobGeneration != generation); });
+		if (_quit)
+			return;
+
+		Job* job = _job;
+		generation = _jobGeneration;
+		++_activeWorkers;
+		lock.unlock();
+
+		RunBands(job);
+
+		lock.lock();
+		--_activeWorkers;
+		_done.notify_one();
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyEngine::RunBands()
+//-------------------------------------------------------------------------------------------------
+void CopyEngine::RunBands(Job* job)
+{
+	while (true)
+	{
+		int band = job->nextBand++;
+		if (band >= job->bandCount)
+			return;
+
+		CopyBand(*job, band);
+		++job->finishedBands;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyEngine::CopyBand()
+//-------------------------------------------------------------------------------------------------
+void CopyEngine::CopyBand(const Job& job, int band)
+{
+	if (job.bulk)
+	{
+		size_t offset = band * job.bandSize;
+		size_t total = job.rowSize * job.rowCount;
+		size_t size = total - offset < job.bandSize ? total - offset : job.bandSize;
+		CopyBlock(job.dest + offset, job.src + offset, size, job.stream);
+	}
+	else
+	{
+		size_t first = band * job.bandSize;
+		size_t last = first + job.bandSize < job.rowCount ? first + job.bandSize : job.rowCount;
+		for (size_t row = first; row < last; ++row)
+			CopyBlock(job.dest + row * job.destPitch, job.src + row * job.srcPitch, job.rowSize, job.stream);
+	}
+
+#if SUPPORT_SSE2
+	// streaming stores have to be visible before the band is reported as finished
+	if (job.stream)
+		_mm_sfence();
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyEngine::CopyBlock()
+//-------------------------------------------------------------------------------------------------
+void CopyEngine::CopyBlock(void* dest, const void* src, size_t size, bool stream)
+{
+#if SUPPORT_SSE2
+	if (stream && size >= 64)
+	{
+		// unaligned head, 16 byte aligned streaming stores, unaligned tail
+		char* d = (char*)dest;
+		const char* s = (const char*)src;
+		size_t head = (16 - ((size_t)d & 15)) & 15;
+		memcpy(d, s, head);
+		d += head;
+		s += head;
+		size -= head;
+
+		size_t i = 0;
+		for (; i + 64 <= size; i += 64)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(s + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(s + i + 16));
+			__m128i c = _mm_loadu_si128((const __m128i*)(s + i + 32));
+			__m128i e = _mm_loadu_si128((const __m128i*)(s + i + 48));
+			_mm_stream_si128((__m128i*)(d + i), a);
+			_mm_stream_si128((__m128i*)(d + i + 16), b);
+			_mm_stream_si128((__m128i*)(d + i + 32), c);
+			_mm_stream_si128((__m128i*)(d + i + 48), e);
+		}
+
+		memcpy(d + i, s + i, size - i);
+		return;
+	}
+#endif
+
+	memcpy(dest, src, size);
+}
@@ -0,0 +1,97 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+// CopyEngine
+//-------------------------------------------------------------------------------------------------
+// copies rows of mapped staging memory to system memory. large copies are split into bands of rows
+// that are copied by small worker pool together with the calling thread, outputs bigger than last
+// level cache are written with non-temporal stores so they don't evict the rest of the frame.
+// tightly packed rows are copied as one block.
+// CopyRows blocks until everything is copied and can be called only from one thread at a time
+class CopyEngine
+{
+public:
+	CopyEngine();
+	~CopyEngine();
+
+	void CopyRows(void* dest, int destPitch, const void* src, int srcPitch, int rowSize, int rowCount);
+
+public:
+	// smaller copies run only on the calling thread
+	static const size_t kParallelThreshold = 1024 * 1024;
+	static const size_t kMinBandSize = 256 * 1024;
+	// typical size of last level cache, bigger outputs are streamed
+	static const size_t kStreamingThreshold = 8 * 1024 * 1024;
+	static const int kMaxWorkers = 4;
+
+private:
+	// rows are split into bands, tightly packed data are split into byte ranges
+	struct Job
+	{
+		char* dest;
+		const char* src;
+		size_t destPitch;
+		size_t srcPitch;
+		size_t rowSize;
+		size_t rowCount;
+		bool bulk;
+		bool stream;
+		size_t bandSize;
+		int bandCount;
+		std::atomic<int> nextBand;
+		std::atomic<int> finishedBands;
+	};
+
+	void StartWorkers();
+	void WorkerThread();
+	void RunBands(Job* job);
+	static void CopyBand(const Job& job, int band);
+	static void CopyBlock(void* dest, const void* src, size_t size, bool stream);
+
+private:
+	std::vector<std::thread> _workers;
+	bool _workersStarted;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _done;
+	// current job and number of workers that still hold pointer to it, guarded by _mutex
+	Job* _job;
+	unsigned int _jobGeneration;
+	int _activeWorkers;
+	bool _quit;
+};
@@ -0,0 +1,105 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "CopyThread.h"
+#include "ReadbackTrace.h"
+
+//-------------------------------------------------------------------------------------------------
+// CopyThread::CopyThread()
+//-------------------------------------------------------------------------------------------------
+CopyThread::CopyThread() : _quit(false)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyThread::~CopyThread()
+//-------------------------------------------------------------------------------------------------
+CopyThread::~CopyThread()
+{
+	if (!_thread.joinable())
+		return;
+
+	// pending jobs are finished first
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_wake.notify_one();
+	_thread.join();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyThread::Push()
+//-------------------------------------------------------------------------------------------------
+void CopyThread::Push(const Job& job)
+{
+	if (!_thread.joinable())
+		_thread = std::thread(&CopyThread::ThreadFunc, this);
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_jobs.push_back(job);
+	}
+	_wake.notify_one();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyThread::WaitIdle()
+//-------------------------------------------------------------------------------------------------
+void CopyThread::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_idle.wait(lock, [this] { return _jobs.empty(); });
+}
+
+//-------------------------------------------------------------------------------------------------
+// CopyThread::ThreadFunc()
+//-------------------------------------------------------------------------------------------------
+void CopyThread::ThreadFunc()
+{
+	ReadbackTrace::NameThread("Copy thread");
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_wake.wait(lock, [this] { return _quit || !_jobs.empty(); });
+		if (_jobs.empty())
+			return;
+
+		// job stays in the queue while it runs so WaitIdle waits for it too
+		Job job = _jobs.front();
+		lock.unlock();
+
+		job(&_copyEngine);
+
+		lock.lock();
+		_jobs.pop_front();
+		if (_jobs.empty())
+			_idle.notify_all();
+	}
+}
@@ -0,0 +1,66 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "CopyEngine.h"
+#include <deque>
+#include <functional>
+
+//-------------------------------------------------------------------------------------------------
+// CopyThread
+//-------------------------------------------------------------------------------------------------
+// dedicated thread that copies mapped staging memory so render thread only maps/unmaps resources.
+// jobs run in the order they were pushed. the thread is started with the first job.
+// Push and WaitIdle are called from render thread
+class CopyThread
+{
+public:
+	typedef std::function<void(CopyEngine* copyEngine)> Job;
+
+	CopyThread();
+	~CopyThread();
+
+	void Push(const Job& job);
+	// blocks until every pushed job is finished
+	void WaitIdle();
+
+private:
+	void ThreadFunc();
+
+private:
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _idle;
+	// guarded by _mutex, job is removed from the queue when it is finished
+	std::deque<Job> _jobs;
+	bool _quit;
+	// used only by the copy thread, render thread has its own
+	CopyEngine _copyEngine;
+};
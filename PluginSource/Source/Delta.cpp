@@ -0,0 +1,237 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "Delta.h"
+#include "PlatformBase.h"
+#include <string.h>
+
+#if SUPPORT_SSE2
+#include <emmintrin.h>
+#endif
+
+// hash lanes start from and keys step by odd 64 bit constants, every 16 byte block of the tile gets different key
+static const unsigned long long kSeed0 = 0x9E3779B185EBCA87ULL;
+static const unsigned long long kSeed1 = 0xC2B2AE3D27D4EB4FULL;
+static const unsigned long long kKey0 = 0x165667B19E3779F9ULL;
+static const unsigned long long kKey1 = 0x85EBCA77C2B2AE63ULL;
+static const unsigned long long kKeyStep = 0x27D4EB2F165667C5ULL;
+
+//-------------------------------------------------------------------------------------------------
+// DeltaLayout::DeltaLayout()
+//-------------------------------------------------------------------------------------------------
+DeltaLayout::DeltaLayout(int tileSize, const FormatTraits& format, int mipLevel, int firstSlice, int x, int y, int width, int height, int slices) :
+	tileSize(tileSize), tileRowPitch(format.RowPitch(tileSize)), tileRowCount(format.RowCount(tileSize)), 
+	rowPitch(format.RowPitch(width)), rowCount(format.RowCount(height)), slices(slices),
+	tilesX((width + tileSize - 1) / tileSize), tilesY((height + tileSize - 1) / tileSize),
+	mipLevel(mipLevel), firstSlice(firstSlice), x(x), y(y)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// Avalanche
+//-------------------------------------------------------------------------------------------------
+// every bit of the input affects every bit of the result
+static unsigned long long Avalanche(unsigned long long hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+//-------------------------------------------------------------------------------------------------
+// HashRows
+//-------------------------------------------------------------------------------------------------
+// two 64 bit lanes, every 16 byte block adds product of low and high half of (data ^ key) of one lane and 
+// the data of the other lane. keys change with every block so moved or swapped blocks change the hash.
+// partial block at the end of the row is padded with zeros
+static unsigned long long HashRows(const char* rows, size_t rowPitch, int rowSize, int rowCount)
+{
+	int blocks = rowSize / 16;
+	int tail = rowSize % 16;
+
+#if SUPPORT_SSE2
+	// _mm_set_epi64x isn't available in 32 bit builds of every compiler
+	__m128i acc = _mm_set_epi32((int)(kSeed1 >> 32), (int)kSeed1, (int)(kSeed0 >> 32), (int)kSeed0);
+	__m128i key = _mm_set_epi32((int)(kKey1 >> 32), (int)kKey1, (int)(kKey0 >> 32), (int)kKey0);
+	const __m128i step = _mm_set_epi32((int)(kKeyStep >> 32), (int)kKeyStep, (int)(kKeyStep >> 32), (int)kKeyStep);
+
+	for (int row = 0; row < rowCount; ++row)
+	{
+		const char* src = rows + row * rowPitch;
+		for (int i = 0; i <= blocks; ++i)
+		{
+			__m128i data;
+			if (i < blocks)
+			{
+				data = _mm_loadu_si128((const __m128i*)(src + i * 16));
+			}
+			else
+			{
+				if (tail == 0)
+					break;
+
+				char last[16] = {};
+				memcpy(last, src + i * 16, tail);
+				data = _mm_loadu_si128((const __m128i*)last);
+			}
+
+			__m128i mixed = _mm_xor_si128(data, key);
+			__m128i product = _mm_mul_epu32(mixed, _mm_srli_epi64(mixed, 32));
+			acc = _mm_add_epi64(acc, _mm_add_epi64(product, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+			key = _mm_add_epi64(key, step);
+		}
+	}
+
+	unsigned long long lanes[2];
+	_mm_storeu_si128((__m128i*)lanes, acc);
+	unsigned long long acc0 = lanes[0];
+	unsigned long long acc1 = lanes[1];
+#else
+	unsigned long long acc0 = kSeed0;
+	unsigned long long acc1 = kSeed1;
+	unsigned long long key0 = kKey0;
+	unsigned long long key1 = kKey1;
+
+	for (int row = 0; row < rowCount; ++row)
+	{
+		const char* src = rows + row * rowPitch;
+		for (int i = 0; i <= blocks; ++i)
+		{
+			unsigned long long data[2] = {};
+			if (i < blocks)
+				memcpy(data, src + i * 16, 16);
+			else if (tail != 0)
+				memcpy(data, src + i * 16, tail);
+			else
+				break;
+
+			unsigned long long mixed0 = data[0] ^ key0;
+			unsigned long long mixed1 = data[1] ^ key1;
+			acc0 += (mixed0 & 0xFFFFFFFFULL) * (mixed0 >> 32) + data[1];
+			acc1 += (mixed1 & 0xFFFFFFFFULL) * (mixed1 >> 32) + data[0];
+			key0 += kKeyStep;
+			key1 += kKeyStep;
+		}
+	}
+#endif
+
+	return Avalanche(acc0 + Avalanche(acc1 ^ (unsigned long long)rowSize * rowCount));
+}
+
+//-------------------------------------------------------------------------------------------------
+// HashTileBand
+//-------------------------------------------------------------------------------------------------
+void HashTileBand(const DeltaLayout& layout, const void* rows, int rowCount, unsigned long long* hashes)
+{
+	// band was just written to cpuBuffer and is still in cache
+	for (int x = 0; x < layout.tilesX; ++x)
+	{
+		int offset = x * layout.tileRowPitch;
+		int size = layout.rowPitch - offset < layout.tileRowPitch ? layout.rowPitch - offset : layout.tileRowPitch;
+		hashes[x] = HashRows((const char*)rows + offset, layout.rowPitch, size, rowCount);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// CountDirtyTiles
+//-------------------------------------------------------------------------------------------------
+int CountDirtyTiles(const DeltaLayout& layout, const unsigned long long* hashes, const unsigned long long* previous)
+{
+	int tileCount = layout.GetTileCount();
+	if (previous == NULL)
+		return tileCount;
+
+	int dirtyTiles = 0;
+	for (int i = 0; i < tileCount; ++i)
+		dirtyTiles += hashes[i] != previous[i] ? 1 : 0;
+	return dirtyTiles;
+}
+
+//-------------------------------------------------------------------------------------------------
+// WriteDelta
+//-------------------------------------------------------------------------------------------------
+void WriteDelta(const DeltaLayout& layout, const void* data, const unsigned long long* hashes, const unsigned long long* previous, int dirtyTiles, void* result)
+{
+	// result is user memory without alignment guarantee, header and bitmap are written with memcpy
+	DeltaHeader header;
+	header.tileSize = layout.tileSize;
+	header.tilesX = layout.tilesX;
+	header.tilesY = layout.tilesY;
+	header.slices = layout.slices;
+	header.dirtyTiles = dirtyTiles;
+	header.tileRowPitch = layout.tileRowPitch;
+	header.tileRowCount = layout.tileRowCount;
+	header.tileDataSize = layout.GetTileDataSize();
+	memcpy(result, &header, sizeof(header));
+
+	char* bitmap = (char*)result + sizeof(DeltaHeader);
+	char* tile = bitmap + layout.GetBitmapWords() * 4;
+	size_t sliceSize = (size_t)layout.rowPitch * layout.rowCount;
+	unsigned int word = 0;
+
+	int tileCount = layout.GetTileCount();
+	for (int i = 0; i < tileCount; ++i)
+	{
+		if (previous == NULL || hashes[i] != previous[i])
+		{
+			word |= 1u << (i % 32);
+
+			int x = i % layout.tilesX;
+			int y = i / layout.tilesX % layout.tilesY;
+			int slice = i / (layout.tilesX * layout.tilesY);
+
+			// edge tiles are cut by the region, the rest of the tile is zero
+			int offset = x * layout.tileRowPitch;
+			int firstRow = y * layout.tileRowCount;
+			int size = layout.rowPitch - offset < layout.tileRowPitch ? layout.rowPitch - offset : layout.tileRowPitch;
+			int rows = layout.rowCount - firstRow < layout.tileRowCount ? layout.rowCount - firstRow : layout.tileRowCount;
+
+			const char* src = (const char*)data + slice * sliceSize + (size_t)firstRow * layout.rowPitch + offset;
+			for (int row = 0; row < rows; ++row)
+			{
+				memcpy(tile + row * layout.tileRowPitch, src + (size_t)row * layout.rowPitch, size);
+				if (size < layout.tileRowPitch)
+					memset(tile + row * layout.tileRowPitch + size, 0, layout.tileRowPitch - size);
+			}
+
+			if (rows < layout.tileRowCount)
+				memset(tile + rows * layout.tileRowPitch, 0, (size_t)(layout.tileRowCount - rows) * layout.tileRowPitch);
+
+			tile += layout.GetTileDataSize();
+		}
+
+		if (i % 32 == 31 || i == tileCount - 1)
+		{
+			memcpy(bitmap + i / 32 * 4, &word, 4);
+			word = 0;
+		}
+	}
+}
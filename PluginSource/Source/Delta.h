@@ -0,0 +1,125 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "FormatTraits.h"
+
+// tile size in texels, power of two so tiles of compressed formats cover whole blocks
+const int kMinDeltaTileSize = 8;
+const int kMaxDeltaTileSize = 256;
+
+//-------------------------------------------------------------------------------------------------
+// DeltaDesc
+//-------------------------------------------------------------------------------------------------
+struct DeltaDesc
+{
+	// zero means the whole region is returned, otherwise only tiles changed since the last delivered request
+	// of the resource are returned
+	int tileSize;
+
+	DeltaDesc() : tileSize(0) {}
+
+	bool IsEnabled() const { return tileSize != 0; }
+};
+
+//-------------------------------------------------------------------------------------------------
+// DeltaHeader
+//-------------------------------------------------------------------------------------------------
+// start of the data returned by delta request. header is followed by bitmap of dirty tiles (32 bit words, 
+// bit n of word n / 32 is tile n) and by dirty tiles in tile order. tile n is column n % tilesX, row 
+// n / tilesX % tilesY and slice n / (tilesX * tilesY). every tile is tileRowCount tightly packed rows of 
+// tileRowPitch bytes (rows of blocks for compressed formats), part of edge tile outside the region is zero
+struct DeltaHeader
+{
+	int tileSize;
+	int tilesX;
+	int tilesY;
+	int slices;
+	int dirtyTiles;
+	int tileRowPitch;
+	int tileRowCount;
+	int tileDataSize;
+};
+
+//-------------------------------------------------------------------------------------------------
+// DeltaLayout
+//-------------------------------------------------------------------------------------------------
+// tiles of tightly packed slices of the region
+struct DeltaLayout
+{
+	int tileSize;
+	int tileRowPitch;
+	int tileRowCount;
+	// tightly packed row of the region and rows of one slice
+	int rowPitch;
+	int rowCount;
+	int slices;
+	int tilesX;
+	int tilesY;
+	// source of the region, hashes of other mip level, slices or origin are never compared even when the size matches
+	int mipLevel;
+	int firstSlice;
+	int x;
+	int y;
+
+	DeltaLayout() : tileSize(0), tileRowPitch(0), tileRowCount(0), rowPitch(0), rowCount(0), slices(0), tilesX(0), tilesY(0), mipLevel(0), firstSlice(0), x(0), y(0) {}
+	DeltaLayout(int tileSize, const FormatTraits& format, int mipLevel, int firstSlice, int x, int y, int width, int height, int slices);
+
+	bool operator==(const DeltaLayout& layout) const
+	{
+		return tileSize == layout.tileSize && tileRowPitch == layout.tileRowPitch && tileRowCount == layout.tileRowCount &&
+			rowPitch == layout.rowPitch && rowCount == layout.rowCount && slices == layout.slices &&
+			mipLevel == layout.mipLevel && firstSlice == layout.firstSlice && x == layout.x && y == layout.y;
+	}
+
+	int GetTileCount() const { return tilesX * tilesY * slices; }
+	int GetTileDataSize() const { return tileRowPitch * tileRowCount; }
+	int GetBitmapWords() const { return (GetTileCount() + 31) / 32; }
+	// size of the returned data, header + bitmap + dirty tiles
+	long long GetDeltaSize(int dirtyTiles) const { return (long long)sizeof(DeltaHeader) + GetBitmapWords() * 4 + (long long)dirtyTiles * GetTileDataSize(); }
+};
+
+//-------------------------------------------------------------------------------------------------
+// HashTileBand
+//-------------------------------------------------------------------------------------------------
+// hashes one row of tiles, rows point to the first row of the band (fewer rows than tileRowCount in the last
+// band). writes tilesX hashes. 64 bit hashes with SSE2 kernel, equal hashes are taken as unchanged tiles
+void HashTileBand(const DeltaLayout& layout, const void* rows, int rowCount, unsigned long long* hashes);
+
+//-------------------------------------------------------------------------------------------------
+// CountDirtyTiles
+//-------------------------------------------------------------------------------------------------
+// tiles whose hash differs from the previous one, every tile is dirty without previous hashes
+int CountDirtyTiles(const DeltaLayout& layout, const unsigned long long* hashes, const unsigned long long* previous);
+
+//-------------------------------------------------------------------------------------------------
+// WriteDelta
+//-------------------------------------------------------------------------------------------------
+// writes header, bitmap and dirty tiles of data (tightly packed slices) to result of GetDeltaSize bytes
+void WriteDelta(const DeltaLayout& layout, const void* data, const unsigned long long* hashes, const unsigned long long* previous, int dirtyTiles, void* result);
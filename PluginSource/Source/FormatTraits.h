@@ -0,0 +1,112 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+// type of one channel of the pixel
+enum class ComponentType
+{
+	Float32,
+	Float16,
+	UInt32,
+	SInt32,
+	UNorm16,
+	SNorm16,
+	UInt16,
+	SInt16,
+	UNorm8,
+	SNorm8,
+	UInt8,
+	SInt8,
+	// channels packed into bit fields (R10G10B10A2, R11G11B10, D24S8, ...), raw readback only
+	Packed,
+	// type of the data isn't known, raw readback only
+	Typeless,
+	// block compressed (BCn), raw readback only
+	Compressed
+};
+
+const int kFormatSRGB = 1 << 0;
+const int kFormatBGRA = 1 << 1;
+const int kFormatDepth = 1 << 2;
+
+//-------------------------------------------------------------------------------------------------
+// FormatTraits
+//-------------------------------------------------------------------------------------------------
+// memory layout of pixel format. uncompressed formats are 1x1 blocks, BCn formats are 4x4 blocks
+struct FormatTraits
+{
+	// bytes per block (pixel), zero for formats that can't be read
+	unsigned char blockSize;
+	unsigned char blockWidth;
+	unsigned char blockHeight;
+	// channels stored in memory for formats with ComponentType of one channel, zero otherwise
+	unsigned char channels;
+	ComponentType type;
+	// combination of kFormat* flags
+	unsigned char flags;
+
+	constexpr bool IsSupported() const { return blockSize != 0; }
+	constexpr bool IsCompressed() const { return blockWidth > 1 || blockHeight > 1; }
+	constexpr bool HasChannels() const { return channels != 0; }
+
+	// size of tightly packed row of blocks, partial blocks at the edge of small mip levels count as whole blocks
+	constexpr int RowPitch(int width) const { return (width + blockWidth - 1) / blockWidth * blockSize; }
+	constexpr int RowCount(int height) const { return (height + blockHeight - 1) / blockHeight; }
+	constexpr int AlignWidth(int width) const { return (width + blockWidth - 1) / blockWidth * blockWidth; }
+	constexpr int AlignHeight(int height) const { return (height + blockHeight - 1) / blockHeight * blockHeight; }
+};
+
+//-------------------------------------------------------------------------------------------------
+// PixelTraits
+//-------------------------------------------------------------------------------------------------
+constexpr FormatTraits PixelTraits(int channels, ComponentType type, int flags = 0)
+{
+	return FormatTraits{ 
+		(unsigned char)(channels * (type == ComponentType::UNorm8 || type == ComponentType::SNorm8 || type == ComponentType::UInt8 || type == ComponentType::SInt8 ? 1 :
+			type == ComponentType::Float32 || type == ComponentType::UInt32 || type == ComponentType::SInt32 ? 4 : 2)),
+		1, 1, (unsigned char)channels, type, (unsigned char)flags };
+}
+
+//-------------------------------------------------------------------------------------------------
+// RawTraits
+//-------------------------------------------------------------------------------------------------
+// formats without per-channel type, blockSize bytes per blockWidth x blockHeight pixels
+constexpr FormatTraits RawTraits(int blockSize, ComponentType type, int flags = 0, int blockWidth = 1, int blockHeight = 1)
+{
+	return FormatTraits{ (unsigned char)blockSize, (unsigned char)blockWidth, (unsigned char)blockHeight, 0, type, (unsigned char)flags };
+}
+
+//-------------------------------------------------------------------------------------------------
+// BlockTraits
+//-------------------------------------------------------------------------------------------------
+constexpr FormatTraits BlockTraits(int blockSize, int flags = 0)
+{
+	return RawTraits(blockSize, ComponentType::Compressed, flags, 4, 4);
+}
+
+constexpr FormatTraits kUnsupportedFormat = { 0, 1, 1, 0, ComponentType::Typeless, 0 };
@@ -0,0 +1,177 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "FormatTraits.h"
+#include "PlatformBase.h"
+
+#if SUPPORT_D3D11
+
+#include <d3d11.h>
+
+//-------------------------------------------------------------------------------------------------
+// DxgiFormatEntry
+//-------------------------------------------------------------------------------------------------
+struct DxgiFormatEntry
+{
+	DXGI_FORMAT format;
+	FormatTraits traits;
+};
+
+// traits of every DXGI format up to BC7, indexed by DXGI_FORMAT value
+constexpr DxgiFormatEntry kDxgiFormats[] =
+{
+	{ DXGI_FORMAT_UNKNOWN,						kUnsupportedFormat },
+	{ DXGI_FORMAT_R32G32B32A32_TYPELESS,		RawTraits(16, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R32G32B32A32_FLOAT,			PixelTraits(4, ComponentType::Float32) },
+	{ DXGI_FORMAT_R32G32B32A32_UINT,			PixelTraits(4, ComponentType::UInt32) },
+	{ DXGI_FORMAT_R32G32B32A32_SINT,			PixelTraits(4, ComponentType::SInt32) },
+	{ DXGI_FORMAT_R32G32B32_TYPELESS,			RawTraits(12, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R32G32B32_FLOAT,				PixelTraits(3, ComponentType::Float32) },
+	{ DXGI_FORMAT_R32G32B32_UINT,				PixelTraits(3, ComponentType::UInt32) },
+	{ DXGI_FORMAT_R32G32B32_SINT,				PixelTraits(3, ComponentType::SInt32) },
+	{ DXGI_FORMAT_R16G16B16A16_TYPELESS,		RawTraits(8, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R16G16B16A16_FLOAT,			PixelTraits(4, ComponentType::Float16) },
+	{ DXGI_FORMAT_R16G16B16A16_UNORM,			PixelTraits(4, ComponentType::UNorm16) },
+	{ DXGI_FORMAT_R16G16B16A16_UINT,			PixelTraits(4, ComponentType::UInt16) },
+	{ DXGI_FORMAT_R16G16B16A16_SNORM,			PixelTraits(4, ComponentType::SNorm16) },
+	{ DXGI_FORMAT_R16G16B16A16_SINT,			PixelTraits(4, ComponentType::SInt16) },
+	{ DXGI_FORMAT_R32G32_TYPELESS,				RawTraits(8, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R32G32_FLOAT,					PixelTraits(2, ComponentType::Float32) },
+	{ DXGI_FORMAT_R32G32_UINT,					PixelTraits(2, ComponentType::UInt32) },
+	{ DXGI_FORMAT_R32G32_SINT,					PixelTraits(2, ComponentType::SInt32) },
+	{ DXGI_FORMAT_R32G8X24_TYPELESS,			RawTraits(8, ComponentType::Typeless, kFormatDepth) },
+	{ DXGI_FORMAT_D32_FLOAT_S8X24_UINT,			RawTraits(8, ComponentType::Packed, kFormatDepth) },
+	{ DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS,		RawTraits(8, ComponentType::Packed, kFormatDepth) },
+	{ DXGI_FORMAT_X32_TYPELESS_G8X24_UINT,		RawTraits(8, ComponentType::Packed, kFormatDepth) },
+	{ DXGI_FORMAT_R10G10B10A2_TYPELESS,			RawTraits(4, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R10G10B10A2_UNORM,			RawTraits(4, ComponentType::Packed) },
+	{ DXGI_FORMAT_R10G10B10A2_UINT,				RawTraits(4, ComponentType::Packed) },
+	{ DXGI_FORMAT_R11G11B10_FLOAT,				RawTraits(4, ComponentType::Packed) },
+	{ DXGI_FORMAT_R8G8B8A8_TYPELESS,			RawTraits(4, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R8G8B8A8_UNORM,				PixelTraits(4, ComponentType::UNorm8) },
+	{ DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,			PixelTraits(4, ComponentType::UNorm8, kFormatSRGB) },
+	{ DXGI_FORMAT_R8G8B8A8_UINT,				PixelTraits(4, ComponentType::UInt8) },
+	{ DXGI_FORMAT_R8G8B8A8_SNORM,				PixelTraits(4, ComponentType::SNorm8) },
+	{ DXGI_FORMAT_R8G8B8A8_SINT,				PixelTraits(4, ComponentType::SInt8) },
+	{ DXGI_FORMAT_R16G16_TYPELESS,				RawTraits(4, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R16G16_FLOAT,					PixelTraits(2, ComponentType::Float16) },
+	{ DXGI_FORMAT_R16G16_UNORM,					PixelTraits(2, ComponentType::UNorm16) },
+	{ DXGI_FORMAT_R16G16_UINT,					PixelTraits(2, ComponentType::UInt16) },
+	{ DXGI_FORMAT_R16G16_SNORM,					PixelTraits(2, ComponentType::SNorm16) },
+	{ DXGI_FORMAT_R16G16_SINT,					PixelTraits(2, ComponentType::SInt16) },
+	{ DXGI_FORMAT_R32_TYPELESS,					RawTraits(4, ComponentType::Typeless) },
+	{ DXGI_FORMAT_D32_FLOAT,					PixelTraits(1, ComponentType::Float32, kFormatDepth) },
+	{ DXGI_FORMAT_R32_FLOAT,					PixelTraits(1, ComponentType::Float32) },
+	{ DXGI_FORMAT_R32_UINT,						PixelTraits(1, ComponentType::UInt32) },
+	{ DXGI_FORMAT_R32_SINT,						PixelTraits(1, ComponentType::SInt32) },
+	{ DXGI_FORMAT_R24G8_TYPELESS,				RawTraits(4, ComponentType::Typeless, kFormatDepth) },
+	{ DXGI_FORMAT_D24_UNORM_S8_UINT,			RawTraits(4, ComponentType::Packed, kFormatDepth) },
+	{ DXGI_FORMAT_R24_UNORM_X8_TYPELESS,		RawTraits(4, ComponentType::Packed, kFormatDepth) },
+	{ DXGI_FORMAT_X24_TYPELESS_G8_UINT,			RawTraits(4, ComponentType::Packed, kFormatDepth) },
+	{ DXGI_FORMAT_R8G8_TYPELESS,				RawTraits(2, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R8G8_UNORM,					PixelTraits(2, ComponentType::UNorm8) },
+	{ DXGI_FORMAT_R8G8_UINT,					PixelTraits(2, ComponentType::UInt8) },
+	{ DXGI_FORMAT_R8G8_SNORM,					PixelTraits(2, ComponentType::SNorm8) },
+	{ DXGI_FORMAT_R8G8_SINT,					PixelTraits(2, ComponentType::SInt8) },
+	{ DXGI_FORMAT_R16_TYPELESS,					RawTraits(2, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R16_FLOAT,					PixelTraits(1, ComponentType::Float16) },
+	{ DXGI_FORMAT_D16_UNORM,					PixelTraits(1, ComponentType::UNorm16, kFormatDepth) },
+	{ DXGI_FORMAT_R16_UNORM,					PixelTraits(1, ComponentType::UNorm16) },
+	{ DXGI_FORMAT_R16_UINT,						PixelTraits(1, ComponentType::UInt16) },
+	{ DXGI_FORMAT_R16_SNORM,					PixelTraits(1, ComponentType::SNorm16) },
+	{ DXGI_FORMAT_R16_SINT,						PixelTraits(1, ComponentType::SInt16) },
+	{ DXGI_FORMAT_R8_TYPELESS,					RawTraits(1, ComponentType::Typeless) },
+	{ DXGI_FORMAT_R8_UNORM,						PixelTraits(1, ComponentType::UNorm8) },
+	{ DXGI_FORMAT_R8_UINT,						PixelTraits(1, ComponentType::UInt8) },
+	{ DXGI_FORMAT_R8_SNORM,						PixelTraits(1, ComponentType::SNorm8) },
+	{ DXGI_FORMAT_R8_SINT,						PixelTraits(1, ComponentType::SInt8) },
+	{ DXGI_FORMAT_A8_UNORM,						PixelTraits(1, ComponentType::UNorm8) },
+	// 8 pixels per byte, can't be staged
+	{ DXGI_FORMAT_R1_UNORM,						kUnsupportedFormat },
+	{ DXGI_FORMAT_R9G9B9E5_SHAREDEXP,			RawTraits(4, ComponentType::Packed) },
+	// two pixels share G channel, 4 bytes per 2x1 block
+	{ DXGI_FORMAT_R8G8_B8G8_UNORM,				RawTraits(4, ComponentType::Packed, 0, 2, 1) },
+	{ DXGI_FORMAT_G8R8_G8B8_UNORM,				RawTraits(4, ComponentType::Packed, 0, 2, 1) },
+	{ DXGI_FORMAT_BC1_TYPELESS,					BlockTraits(8) },
+	{ DXGI_FORMAT_BC1_UNORM,					BlockTraits(8) },
+	{ DXGI_FORMAT_BC1_UNORM_SRGB,				BlockTraits(8, kFormatSRGB) },
+	{ DXGI_FORMAT_BC2_TYPELESS,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC2_UNORM,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC2_UNORM_SRGB,				BlockTraits(16, kFormatSRGB) },
+	{ DXGI_FORMAT_BC3_TYPELESS,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC3_UNORM,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC3_UNORM_SRGB,				BlockTraits(16, kFormatSRGB) },
+	{ DXGI_FORMAT_BC4_TYPELESS,					BlockTraits(8) },
+	{ DXGI_FORMAT_BC4_UNORM,					BlockTraits(8) },
+	{ DXGI_FORMAT_BC4_SNORM,					BlockTraits(8) },
+	{ DXGI_FORMAT_BC5_TYPELESS,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC5_UNORM,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC5_SNORM,					BlockTraits(16) },
+	{ DXGI_FORMAT_B5G6R5_UNORM,					RawTraits(2, ComponentType::Packed) },
+	{ DXGI_FORMAT_B5G5R5A1_UNORM,				RawTraits(2, ComponentType::Packed) },
+	{ DXGI_FORMAT_B8G8R8A8_UNORM,				PixelTraits(4, ComponentType::UNorm8, kFormatBGRA) },
+	// X channel is undefined
+	{ DXGI_FORMAT_B8G8R8X8_UNORM,				PixelTraits(4, ComponentType::UNorm8, kFormatBGRA) },
+	{ DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM,	RawTraits(4, ComponentType::Packed) },
+	{ DXGI_FORMAT_B8G8R8A8_TYPELESS,			RawTraits(4, ComponentType::Typeless, kFormatBGRA) },
+	{ DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,			PixelTraits(4, ComponentType::UNorm8, kFormatBGRA | kFormatSRGB) },
+	{ DXGI_FORMAT_B8G8R8X8_TYPELESS,			RawTraits(4, ComponentType::Typeless, kFormatBGRA) },
+	{ DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,			PixelTraits(4, ComponentType::UNorm8, kFormatBGRA | kFormatSRGB) },
+	{ DXGI_FORMAT_BC6H_TYPELESS,				BlockTraits(16) },
+	{ DXGI_FORMAT_BC6H_UF16,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC6H_SF16,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC7_TYPELESS,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC7_UNORM,					BlockTraits(16) },
+	{ DXGI_FORMAT_BC7_UNORM_SRGB,				BlockTraits(16, kFormatSRGB) },
+};
+
+const int kDxgiFormatCount = sizeof(kDxgiFormats) / sizeof(kDxgiFormats[0]);
+
+//-------------------------------------------------------------------------------------------------
+// IsDxgiFormatTableOrdered
+//-------------------------------------------------------------------------------------------------
+constexpr bool IsDxgiFormatTableOrdered(int index = 0)
+{
+	return index == kDxgiFormatCount || ((int)kDxgiFormats[index].format == index && IsDxgiFormatTableOrdered(index + 1));
+}
+
+static_assert(IsDxgiFormatTableOrdered(), "kDxgiFormats has to be indexed by DXGI_FORMAT value");
+static_assert(kDxgiFormats[DXGI_FORMAT_R32G32B32A32_FLOAT].traits.blockSize == 16, "wrong RGBA32F size");
+static_assert(kDxgiFormats[DXGI_FORMAT_R16G16B16A16_FLOAT].traits.blockSize == 8, "wrong RGBA16F size");
+static_assert(kDxgiFormats[DXGI_FORMAT_BC1_UNORM].traits.RowPitch(10) == 3 * 8, "wrong BC1 pitch");
+
+//-------------------------------------------------------------------------------------------------
+// GetDxgiFormatTraits
+//-------------------------------------------------------------------------------------------------
+constexpr FormatTraits GetDxgiFormatTraits(DXGI_FORMAT format)
+{
+	return (int)format >= 0 && (int)format < kDxgiFormatCount ? kDxgiFormats[format].traits : kUnsupportedFormat;
+}
+
+#endif // SUPPORT_D3D11
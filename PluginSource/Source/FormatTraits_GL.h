@@ -0,0 +1,146 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "FormatTraits.h"
+#include "PlatformBase.h"
+
+#if SUPPORT_OPENGL_CORE_BACKEND
+
+#if UNITY_OSX
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glcorearb.h>
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// GLFormatEntry
+//-------------------------------------------------------------------------------------------------
+// internal format of texture and format/type pair used to read it to pixel pack buffer
+struct GLFormatEntry
+{
+	GLenum internalFormat;
+	GLenum format;
+	GLenum type;
+	FormatTraits traits;
+};
+
+// uncompressed and depth formats Unity creates on core profile. compressed formats are missing, region of
+// compressed texture can be read only by glGetCompressedTextureSubImage (GL 4.5) and it has no fallback
+constexpr GLFormatEntry kGLFormats[] =
+{
+	{ GL_R8,					GL_RED,				GL_UNSIGNED_BYTE,					PixelTraits(1, ComponentType::UNorm8) },
+	{ GL_RG8,					GL_RG,				GL_UNSIGNED_BYTE,					PixelTraits(2, ComponentType::UNorm8) },
+	{ GL_RGB8,					GL_RGB,				GL_UNSIGNED_BYTE,					PixelTraits(3, ComponentType::UNorm8) },
+	{ GL_RGBA8,					GL_RGBA,			GL_UNSIGNED_BYTE,					PixelTraits(4, ComponentType::UNorm8) },
+	{ GL_SRGB8,					GL_RGB,				GL_UNSIGNED_BYTE,					PixelTraits(3, ComponentType::UNorm8, kFormatSRGB) },
+	{ GL_SRGB8_ALPHA8,			GL_RGBA,			GL_UNSIGNED_BYTE,					PixelTraits(4, ComponentType::UNorm8, kFormatSRGB) },
+	{ GL_R8_SNORM,				GL_RED,				GL_BYTE,							PixelTraits(1, ComponentType::SNorm8) },
+	{ GL_RG8_SNORM,				GL_RG,				GL_BYTE,							PixelTraits(2, ComponentType::SNorm8) },
+	{ GL_RGB8_SNORM,			GL_RGB,				GL_BYTE,							PixelTraits(3, ComponentType::SNorm8) },
+	{ GL_RGBA8_SNORM,			GL_RGBA,			GL_BYTE,							PixelTraits(4, ComponentType::SNorm8) },
+	{ GL_R8UI,					GL_RED_INTEGER,		GL_UNSIGNED_BYTE,					PixelTraits(1, ComponentType::UInt8) },
+	{ GL_RG8UI,					GL_RG_INTEGER,		GL_UNSIGNED_BYTE,					PixelTraits(2, ComponentType::UInt8) },
+	{ GL_RGB8UI,				GL_RGB_INTEGER,		GL_UNSIGNED_BYTE,					PixelTraits(3, ComponentType::UInt8) },
+	{ GL_RGBA8UI,				GL_RGBA_INTEGER,	GL_UNSIGNED_BYTE,					PixelTraits(4, ComponentType::UInt8) },
+	{ GL_R8I,					GL_RED_INTEGER,		GL_BYTE,							PixelTraits(1, ComponentType::SInt8) },
+	{ GL_RG8I,					GL_RG_INTEGER,		GL_BYTE,							PixelTraits(2, ComponentType::SInt8) },
+	{ GL_RGB8I,					GL_RGB_INTEGER,		GL_BYTE,							PixelTraits(3, ComponentType::SInt8) },
+	{ GL_RGBA8I,				GL_RGBA_INTEGER,	GL_BYTE,							PixelTraits(4, ComponentType::SInt8) },
+	{ GL_R16,					GL_RED,				GL_UNSIGNED_SHORT,					PixelTraits(1, ComponentType::UNorm16) },
+	{ GL_RG16,					GL_RG,				GL_UNSIGNED_SHORT,					PixelTraits(2, ComponentType::UNorm16) },
+	{ GL_RGB16,					GL_RGB,				GL_UNSIGNED_SHORT,					PixelTraits(3, ComponentType::UNorm16) },
+	{ GL_RGBA16,				GL_RGBA,			GL_UNSIGNED_SHORT,					PixelTraits(4, ComponentType::UNorm16) },
+	{ GL_R16_SNORM,				GL_RED,				GL_SHORT,							PixelTraits(1, ComponentType::SNorm16) },
+	{ GL_RG16_SNORM,			GL_RG,				GL_SHORT,							PixelTraits(2, ComponentType::SNorm16) },
+	{ GL_RGB16_SNORM,			GL_RGB,				GL_SHORT,							PixelTraits(3, ComponentType::SNorm16) },
+	{ GL_RGBA16_SNORM,			GL_RGBA,			GL_SHORT,							PixelTraits(4, ComponentType::SNorm16) },
+	{ GL_R16UI,					GL_RED_INTEGER,		GL_UNSIGNED_SHORT,					PixelTraits(1, ComponentType::UInt16) },
+	{ GL_RG16UI,				GL_RG_INTEGER,		GL_UNSIGNED_SHORT,					PixelTraits(2, ComponentType::UInt16) },
+	{ GL_RGB16UI,				GL_RGB_INTEGER,		GL_UNSIGNED_SHORT,					PixelTraits(3, ComponentType::UInt16) },
+	{ GL_RGBA16UI,				GL_RGBA_INTEGER,	GL_UNSIGNED_SHORT,					PixelTraits(4, ComponentType::UInt16) },
+	{ GL_R16I,					GL_RED_INTEGER,		GL_SHORT,							PixelTraits(1, ComponentType::SInt16) },
+	{ GL_RG16I,					GL_RG_INTEGER,		GL_SHORT,							PixelTraits(2, ComponentType::SInt16) },
+	{ GL_RGB16I,				GL_RGB_INTEGER,		GL_SHORT,							PixelTraits(3, ComponentType::SInt16) },
+	{ GL_RGBA16I,				GL_RGBA_INTEGER,	GL_SHORT,							PixelTraits(4, ComponentType::SInt16) },
+	{ GL_R16F,					GL_RED,				GL_HALF_FLOAT,						PixelTraits(1, ComponentType::Float16) },
+	{ GL_RG16F,					GL_RG,				GL_HALF_FLOAT,						PixelTraits(2, ComponentType::Float16) },
+	{ GL_RGB16F,				GL_RGB,				GL_HALF_FLOAT,						PixelTraits(3, ComponentType::Float16) },
+	{ GL_RGBA16F,				GL_RGBA,			GL_HALF_FLOAT,						PixelTraits(4, ComponentType::Float16) },
+	{ GL_R32UI,					GL_RED_INTEGER,		GL_UNSIGNED_INT,					PixelTraits(1, ComponentType::UInt32) },
+	{ GL_RG32UI,				GL_RG_INTEGER,		GL_UNSIGNED_INT,					PixelTraits(2, ComponentType::UInt32) },
+	{ GL_RGB32UI,				GL_RGB_INTEGER,		GL_UNSIGNED_INT,					PixelTraits(3, ComponentType::UInt32) },
+	{ GL_RGBA32UI,				GL_RGBA_INTEGER,	GL_UNSIGNED_INT,					PixelTraits(4, ComponentType::UInt32) },
+	{ GL_R32I,					GL_RED_INTEGER,		GL_INT,								PixelTraits(1, ComponentType::SInt32) },
+	{ GL_RG32I,					GL_RG_INTEGER,		GL_INT,								PixelTraits(2, ComponentType::SInt32) },
+	{ GL_RGB32I,				GL_RGB_INTEGER,		GL_INT,								PixelTraits(3, ComponentType::SInt32) },
+	{ GL_RGBA32I,				GL_RGBA_INTEGER,	GL_INT,								PixelTraits(4, ComponentType::SInt32) },
+	{ GL_R32F,					GL_RED,				GL_FLOAT,							PixelTraits(1, ComponentType::Float32) },
+	{ GL_RG32F,					GL_RG,				GL_FLOAT,							PixelTraits(2, ComponentType::Float32) },
+	{ GL_RGB32F,				GL_RGB,				GL_FLOAT,							PixelTraits(3, ComponentType::Float32) },
+	{ GL_RGBA32F,				GL_RGBA,			GL_FLOAT,							PixelTraits(4, ComponentType::Float32) },
+	// packed formats are read in their storage layout
+	{ GL_RGB10_A2,				GL_RGBA,			GL_UNSIGNED_INT_2_10_10_10_REV,		RawTraits(4, ComponentType::Packed) },
+	{ GL_RGB10_A2UI,			GL_RGBA_INTEGER,	GL_UNSIGNED_INT_2_10_10_10_REV,		RawTraits(4, ComponentType::Packed) },
+	{ GL_R11F_G11F_B10F,		GL_RGB,				GL_UNSIGNED_INT_10F_11F_11F_REV,	RawTraits(4, ComponentType::Packed) },
+	{ GL_RGB9_E5,				GL_RGB,				GL_UNSIGNED_INT_5_9_9_9_REV,		RawTraits(4, ComponentType::Packed) },
+	{ GL_RGB565,				GL_RGB,				GL_UNSIGNED_SHORT_5_6_5,			RawTraits(2, ComponentType::Packed) },
+	{ GL_RGBA4,					GL_RGBA,			GL_UNSIGNED_SHORT_4_4_4_4,			RawTraits(2, ComponentType::Packed) },
+	{ GL_RGB5_A1,				GL_RGBA,			GL_UNSIGNED_SHORT_5_5_5_1,			RawTraits(2, ComponentType::Packed) },
+	// depth is read as float except 16 bit depth, depth stencil formats in their storage layout
+	{ GL_DEPTH_COMPONENT16,		GL_DEPTH_COMPONENT,	GL_UNSIGNED_SHORT,					PixelTraits(1, ComponentType::UNorm16, kFormatDepth) },
+	{ GL_DEPTH_COMPONENT24,		GL_DEPTH_COMPONENT,	GL_FLOAT,							PixelTraits(1, ComponentType::Float32, kFormatDepth) },
+	{ GL_DEPTH_COMPONENT32,		GL_DEPTH_COMPONENT,	GL_FLOAT,							PixelTraits(1, ComponentType::Float32, kFormatDepth) },
+	{ GL_DEPTH_COMPONENT32F,	GL_DEPTH_COMPONENT,	GL_FLOAT,							PixelTraits(1, ComponentType::Float32, kFormatDepth) },
+	{ GL_DEPTH24_STENCIL8,		GL_DEPTH_STENCIL,	GL_UNSIGNED_INT_24_8,				RawTraits(4, ComponentType::Packed, kFormatDepth) },
+	{ GL_DEPTH32F_STENCIL8,		GL_DEPTH_STENCIL,	GL_FLOAT_32_UNSIGNED_INT_24_8_REV,	RawTraits(8, ComponentType::Packed, kFormatDepth) },
+};
+
+const int kGLFormatCount = sizeof(kGLFormats) / sizeof(kGLFormats[0]);
+
+static_assert(kGLFormats[3].internalFormat == GL_RGBA8 && kGLFormats[3].traits.blockSize == 4, "wrong RGBA8 size");
+static_assert(kGLFormats[kGLFormatCount - 1].traits.blockSize == 8, "wrong D32FS8 size");
+
+//-------------------------------------------------------------------------------------------------
+// FindGLFormat
+//-------------------------------------------------------------------------------------------------
+// GL format enums are sparse, the table is searched. NULL for unsupported formats
+inline const GLFormatEntry* FindGLFormat(GLenum internalFormat)
+{
+	for (int i = 0; i < kGLFormatCount; ++i)
+	{
+		if (kGLFormats[i].internalFormat == internalFormat)
+			return &kGLFormats[i];
+	}
+
+	return NULL;
+}
+
+#endif // SUPPORT_OPENGL_CORE_BACKEND
@@ -0,0 +1,263 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "FormatTraits.h"
+#include "PlatformBase.h"
+
+#if SUPPORT_VULKAN
+
+#define VK_NO_PROTOTYPES
+#include <vulkan/vulkan.h>
+
+//-------------------------------------------------------------------------------------------------
+// VkFormatEntry
+//-------------------------------------------------------------------------------------------------
+struct VkFormatEntry
+{
+	VkFormat format;
+	FormatTraits traits;
+};
+
+// traits of every core VkFormat up to ASTC, indexed by VkFormat value. depth/stencil formats describe the
+// aspect that is read (depth, stencil for S8), copies of D24 depth aspect are 32 bit words with 24 bits of depth
+constexpr VkFormatEntry kVkFormats[] =
+{
+	{ VK_FORMAT_UNDEFINED,								kUnsupportedFormat },
+	{ VK_FORMAT_R4G4_UNORM_PACK8,						RawTraits(1, ComponentType::Packed) },
+	{ VK_FORMAT_R4G4B4A4_UNORM_PACK16,					RawTraits(2, ComponentType::Packed) },
+	{ VK_FORMAT_B4G4R4A4_UNORM_PACK16,					RawTraits(2, ComponentType::Packed) },
+	{ VK_FORMAT_R5G6B5_UNORM_PACK16,					RawTraits(2, ComponentType::Packed) },
+	{ VK_FORMAT_B5G6R5_UNORM_PACK16,					RawTraits(2, ComponentType::Packed) },
+	{ VK_FORMAT_R5G5B5A1_UNORM_PACK16,					RawTraits(2, ComponentType::Packed) },
+	{ VK_FORMAT_B5G5R5A1_UNORM_PACK16,					RawTraits(2, ComponentType::Packed) },
+	{ VK_FORMAT_A1R5G5B5_UNORM_PACK16,					RawTraits(2, ComponentType::Packed) },
+	{ VK_FORMAT_R8_UNORM,								PixelTraits(1, ComponentType::UNorm8) },
+	{ VK_FORMAT_R8_SNORM,								PixelTraits(1, ComponentType::SNorm8) },
+	{ VK_FORMAT_R8_USCALED,								PixelTraits(1, ComponentType::UInt8) },
+	{ VK_FORMAT_R8_SSCALED,								PixelTraits(1, ComponentType::SInt8) },
+	{ VK_FORMAT_R8_UINT,								PixelTraits(1, ComponentType::UInt8) },
+	{ VK_FORMAT_R8_SINT,								PixelTraits(1, ComponentType::SInt8) },
+	{ VK_FORMAT_R8_SRGB,								PixelTraits(1, ComponentType::UNorm8, kFormatSRGB) },
+	{ VK_FORMAT_R8G8_UNORM,								PixelTraits(2, ComponentType::UNorm8) },
+	{ VK_FORMAT_R8G8_SNORM,								PixelTraits(2, ComponentType::SNorm8) },
+	{ VK_FORMAT_R8G8_USCALED,							PixelTraits(2, ComponentType::UInt8) },
+	{ VK_FORMAT_R8G8_SSCALED,							PixelTraits(2, ComponentType::SInt8) },
+	{ VK_FORMAT_R8G8_UINT,								PixelTraits(2, ComponentType::UInt8) },
+	{ VK_FORMAT_R8G8_SINT,								PixelTraits(2, ComponentType::SInt8) },
+	{ VK_FORMAT_R8G8_SRGB,								PixelTraits(2, ComponentType::UNorm8, kFormatSRGB) },
+	{ VK_FORMAT_R8G8B8_UNORM,							PixelTraits(3, ComponentType::UNorm8) },
+	{ VK_FORMAT_R8G8B8_SNORM,							PixelTraits(3, ComponentType::SNorm8) },
+	{ VK_FORMAT_R8G8B8_USCALED,							PixelTraits(3, ComponentType::UInt8) },
+	{ VK_FORMAT_R8G8B8_SSCALED,							PixelTraits(3, ComponentType::SInt8) },
+	{ VK_FORMAT_R8G8B8_UINT,							PixelTraits(3, ComponentType::UInt8) },
+	{ VK_FORMAT_R8G8B8_SINT,							PixelTraits(3, ComponentType::SInt8) },
+	{ VK_FORMAT_R8G8B8_SRGB,							PixelTraits(3, ComponentType::UNorm8, kFormatSRGB) },
+	{ VK_FORMAT_B8G8R8_UNORM,							RawTraits(3, ComponentType::Typeless) },
+	{ VK_FORMAT_B8G8R8_SNORM,							RawTraits(3, ComponentType::Typeless) },
+	{ VK_FORMAT_B8G8R8_USCALED,							RawTraits(3, ComponentType::Typeless) },
+	{ VK_FORMAT_B8G8R8_SSCALED,							RawTraits(3, ComponentType::Typeless) },
+	{ VK_FORMAT_B8G8R8_UINT,							RawTraits(3, ComponentType::Typeless) },
+	{ VK_FORMAT_B8G8R8_SINT,							RawTraits(3, ComponentType::Typeless) },
+	{ VK_FORMAT_B8G8R8_SRGB,							RawTraits(3, ComponentType::Typeless, kFormatSRGB) },
+	{ VK_FORMAT_R8G8B8A8_UNORM,							PixelTraits(4, ComponentType::UNorm8) },
+	{ VK_FORMAT_R8G8B8A8_SNORM,							PixelTraits(4, ComponentType::SNorm8) },
+	{ VK_FORMAT_R8G8B8A8_USCALED,						PixelTraits(4, ComponentType::UInt8) },
+	{ VK_FORMAT_R8G8B8A8_SSCALED,						PixelTraits(4, ComponentType::SInt8) },
+	{ VK_FORMAT_R8G8B8A8_UINT,							PixelTraits(4, ComponentType::UInt8) },
+	{ VK_FORMAT_R8G8B8A8_SINT,							PixelTraits(4, ComponentType::SInt8) },
+	{ VK_FORMAT_R8G8B8A8_SRGB,							PixelTraits(4, ComponentType::UNorm8, kFormatSRGB) },
+	{ VK_FORMAT_B8G8R8A8_UNORM,							PixelTraits(4, ComponentType::UNorm8, kFormatBGRA) },
+	{ VK_FORMAT_B8G8R8A8_SNORM,							PixelTraits(4, ComponentType::SNorm8, kFormatBGRA) },
+	{ VK_FORMAT_B8G8R8A8_USCALED,						PixelTraits(4, ComponentType::UInt8, kFormatBGRA) },
+	{ VK_FORMAT_B8G8R8A8_SSCALED,						PixelTraits(4, ComponentType::SInt8, kFormatBGRA) },
+	{ VK_FORMAT_B8G8R8A8_UINT,							PixelTraits(4, ComponentType::UInt8, kFormatBGRA) },
+	{ VK_FORMAT_B8G8R8A8_SINT,							PixelTraits(4, ComponentType::SInt8, kFormatBGRA) },
+	{ VK_FORMAT_B8G8R8A8_SRGB,							PixelTraits(4, ComponentType::UNorm8, kFormatSRGB | kFormatBGRA) },
+	{ VK_FORMAT_A8B8G8R8_UNORM_PACK32,					PixelTraits(4, ComponentType::UNorm8) },
+	{ VK_FORMAT_A8B8G8R8_SNORM_PACK32,					PixelTraits(4, ComponentType::SNorm8) },
+	{ VK_FORMAT_A8B8G8R8_USCALED_PACK32,				PixelTraits(4, ComponentType::UInt8) },
+	{ VK_FORMAT_A8B8G8R8_SSCALED_PACK32,				PixelTraits(4, ComponentType::SInt8) },
+	{ VK_FORMAT_A8B8G8R8_UINT_PACK32,					PixelTraits(4, ComponentType::UInt8) },
+	{ VK_FORMAT_A8B8G8R8_SINT_PACK32,					PixelTraits(4, ComponentType::SInt8) },
+	{ VK_FORMAT_A8B8G8R8_SRGB_PACK32,					PixelTraits(4, ComponentType::UNorm8, kFormatSRGB) },
+	{ VK_FORMAT_A2R10G10B10_UNORM_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2R10G10B10_SNORM_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2R10G10B10_USCALED_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2R10G10B10_SSCALED_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2R10G10B10_UINT_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2R10G10B10_SINT_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2B10G10R10_UNORM_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2B10G10R10_SNORM_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2B10G10R10_USCALED_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2B10G10R10_SSCALED_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2B10G10R10_UINT_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_A2B10G10R10_SINT_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_R16_UNORM,								PixelTraits(1, ComponentType::UNorm16) },
+	{ VK_FORMAT_R16_SNORM,								PixelTraits(1, ComponentType::SNorm16) },
+	{ VK_FORMAT_R16_USCALED,							PixelTraits(1, ComponentType::UInt16) },
+	{ VK_FORMAT_R16_SSCALED,							PixelTraits(1, ComponentType::SInt16) },
+	{ VK_FORMAT_R16_UINT,								PixelTraits(1, ComponentType::UInt16) },
+	{ VK_FORMAT_R16_SINT,								PixelTraits(1, ComponentType::SInt16) },
+	{ VK_FORMAT_R16_SFLOAT,								PixelTraits(1, ComponentType::Float16) },
+	{ VK_FORMAT_R16G16_UNORM,							PixelTraits(2, ComponentType::UNorm16) },
+	{ VK_FORMAT_R16G16_SNORM,							PixelTraits(2, ComponentType::SNorm16) },
+	{ VK_FORMAT_R16G16_USCALED,							PixelTraits(2, ComponentType::UInt16) },
+	{ VK_FORMAT_R16G16_SSCALED,							PixelTraits(2, ComponentType::SInt16) },
+	{ VK_FORMAT_R16G16_UINT,							PixelTraits(2, ComponentType::UInt16) },
+	{ VK_FORMAT_R16G16_SINT,							PixelTraits(2, ComponentType::SInt16) },
+	{ VK_FORMAT_R16G16_SFLOAT,							PixelTraits(2, ComponentType::Float16) },
+	{ VK_FORMAT_R16G16B16_UNORM,						PixelTraits(3, ComponentType::UNorm16) },
+	{ VK_FORMAT_R16G16B16_SNORM,						PixelTraits(3, ComponentType::SNorm16) },
+	{ VK_FORMAT_R16G16B16_USCALED,						PixelTraits(3, ComponentType::UInt16) },
+	{ VK_FORMAT_R16G16B16_SSCALED,						PixelTraits(3, ComponentType::SInt16) },
+	{ VK_FORMAT_R16G16B16_UINT,							PixelTraits(3, ComponentType::UInt16) },
+	{ VK_FORMAT_R16G16B16_SINT,							PixelTraits(3, ComponentType::SInt16) },
+	{ VK_FORMAT_R16G16B16_SFLOAT,						PixelTraits(3, ComponentType::Float16) },
+	{ VK_FORMAT_R16G16B16A16_UNORM,						PixelTraits(4, ComponentType::UNorm16) },
+	{ VK_FORMAT_R16G16B16A16_SNORM,						PixelTraits(4, ComponentType::SNorm16) },
+	{ VK_FORMAT_R16G16B16A16_USCALED,					PixelTraits(4, ComponentType::UInt16) },
+	{ VK_FORMAT_R16G16B16A16_SSCALED,					PixelTraits(4, ComponentType::SInt16) },
+	{ VK_FORMAT_R16G16B16A16_UINT,						PixelTraits(4, ComponentType::UInt16) },
+	{ VK_FORMAT_R16G16B16A16_SINT,						PixelTraits(4, ComponentType::SInt16) },
+	{ VK_FORMAT_R16G16B16A16_SFLOAT,					PixelTraits(4, ComponentType::Float16) },
+	{ VK_FORMAT_R32_UINT,								PixelTraits(1, ComponentType::UInt32) },
+	{ VK_FORMAT_R32_SINT,								PixelTraits(1, ComponentType::SInt32) },
+	{ VK_FORMAT_R32_SFLOAT,								PixelTraits(1, ComponentType::Float32) },
+	{ VK_FORMAT_R32G32_UINT,							PixelTraits(2, ComponentType::UInt32) },
+	{ VK_FORMAT_R32G32_SINT,							PixelTraits(2, ComponentType::SInt32) },
+	{ VK_FORMAT_R32G32_SFLOAT,							PixelTraits(2, ComponentType::Float32) },
+	{ VK_FORMAT_R32G32B32_UINT,							PixelTraits(3, ComponentType::UInt32) },
+	{ VK_FORMAT_R32G32B32_SINT,							PixelTraits(3, ComponentType::SInt32) },
+	{ VK_FORMAT_R32G32B32_SFLOAT,						PixelTraits(3, ComponentType::Float32) },
+	{ VK_FORMAT_R32G32B32A32_UINT,						PixelTraits(4, ComponentType::UInt32) },
+	{ VK_FORMAT_R32G32B32A32_SINT,						PixelTraits(4, ComponentType::SInt32) },
+	{ VK_FORMAT_R32G32B32A32_SFLOAT,					PixelTraits(4, ComponentType::Float32) },
+	{ VK_FORMAT_R64_UINT,								RawTraits(8, ComponentType::Typeless) },
+	{ VK_FORMAT_R64_SINT,								RawTraits(8, ComponentType::Typeless) },
+	{ VK_FORMAT_R64_SFLOAT,								RawTraits(8, ComponentType::Typeless) },
+	{ VK_FORMAT_R64G64_UINT,							RawTraits(16, ComponentType::Typeless) },
+	{ VK_FORMAT_R64G64_SINT,							RawTraits(16, ComponentType::Typeless) },
+	{ VK_FORMAT_R64G64_SFLOAT,							RawTraits(16, ComponentType::Typeless) },
+	{ VK_FORMAT_R64G64B64_UINT,							RawTraits(24, ComponentType::Typeless) },
+	{ VK_FORMAT_R64G64B64_SINT,							RawTraits(24, ComponentType::Typeless) },
+	{ VK_FORMAT_R64G64B64_SFLOAT,						RawTraits(24, ComponentType::Typeless) },
+	{ VK_FORMAT_R64G64B64A64_UINT,						RawTraits(32, ComponentType::Typeless) },
+	{ VK_FORMAT_R64G64B64A64_SINT,						RawTraits(32, ComponentType::Typeless) },
+	{ VK_FORMAT_R64G64B64A64_SFLOAT,					RawTraits(32, ComponentType::Typeless) },
+	{ VK_FORMAT_B10G11R11_UFLOAT_PACK32,				RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_E5B9G9R9_UFLOAT_PACK32,					RawTraits(4, ComponentType::Packed) },
+	{ VK_FORMAT_D16_UNORM,								PixelTraits(1, ComponentType::UNorm16, kFormatDepth) },
+	{ VK_FORMAT_X8_D24_UNORM_PACK32,					RawTraits(4, ComponentType::Packed, kFormatDepth) },
+	{ VK_FORMAT_D32_SFLOAT,								PixelTraits(1, ComponentType::Float32, kFormatDepth) },
+	{ VK_FORMAT_S8_UINT,								PixelTraits(1, ComponentType::UInt8, kFormatDepth) },
+	{ VK_FORMAT_D16_UNORM_S8_UINT,						PixelTraits(1, ComponentType::UNorm16, kFormatDepth) },
+	{ VK_FORMAT_D24_UNORM_S8_UINT,						RawTraits(4, ComponentType::Packed, kFormatDepth) },
+	{ VK_FORMAT_D32_SFLOAT_S8_UINT,						PixelTraits(1, ComponentType::Float32, kFormatDepth) },
+	{ VK_FORMAT_BC1_RGB_UNORM_BLOCK,					BlockTraits(8) },
+	{ VK_FORMAT_BC1_RGB_SRGB_BLOCK,						BlockTraits(8, kFormatSRGB) },
+	{ VK_FORMAT_BC1_RGBA_UNORM_BLOCK,					BlockTraits(8) },
+	{ VK_FORMAT_BC1_RGBA_SRGB_BLOCK,					BlockTraits(8, kFormatSRGB) },
+	{ VK_FORMAT_BC2_UNORM_BLOCK,						BlockTraits(16) },
+	{ VK_FORMAT_BC2_SRGB_BLOCK,							BlockTraits(16, kFormatSRGB) },
+	{ VK_FORMAT_BC3_UNORM_BLOCK,						BlockTraits(16) },
+	{ VK_FORMAT_BC3_SRGB_BLOCK,							BlockTraits(16, kFormatSRGB) },
+	{ VK_FORMAT_BC4_UNORM_BLOCK,						BlockTraits(8) },
+	{ VK_FORMAT_BC4_SNORM_BLOCK,						BlockTraits(8) },
+	{ VK_FORMAT_BC5_UNORM_BLOCK,						BlockTraits(16) },
+	{ VK_FORMAT_BC5_SNORM_BLOCK,						BlockTraits(16) },
+	{ VK_FORMAT_BC6H_UFLOAT_BLOCK,						BlockTraits(16) },
+	{ VK_FORMAT_BC6H_SFLOAT_BLOCK,						BlockTraits(16) },
+	{ VK_FORMAT_BC7_UNORM_BLOCK,						BlockTraits(16) },
+	{ VK_FORMAT_BC7_SRGB_BLOCK,							BlockTraits(16, kFormatSRGB) },
+	{ VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK,				BlockTraits(8) },
+	{ VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK,					BlockTraits(8, kFormatSRGB) },
+	{ VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK,				BlockTraits(8) },
+	{ VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK,				BlockTraits(8, kFormatSRGB) },
+	{ VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK,				BlockTraits(16) },
+	{ VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK,				BlockTraits(16, kFormatSRGB) },
+	{ VK_FORMAT_EAC_R11_UNORM_BLOCK,					BlockTraits(8) },
+	{ VK_FORMAT_EAC_R11_SNORM_BLOCK,					BlockTraits(8) },
+	{ VK_FORMAT_EAC_R11G11_UNORM_BLOCK,					BlockTraits(16) },
+	{ VK_FORMAT_EAC_R11G11_SNORM_BLOCK,					BlockTraits(16) },
+	{ VK_FORMAT_ASTC_4x4_UNORM_BLOCK,					BlockTraits(16) },
+	{ VK_FORMAT_ASTC_4x4_SRGB_BLOCK,					BlockTraits(16, kFormatSRGB) },
+	{ VK_FORMAT_ASTC_5x4_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 5, 4) },
+	{ VK_FORMAT_ASTC_5x4_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 5, 4) },
+	{ VK_FORMAT_ASTC_5x5_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 5, 5) },
+	{ VK_FORMAT_ASTC_5x5_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 5, 5) },
+	{ VK_FORMAT_ASTC_6x5_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 6, 5) },
+	{ VK_FORMAT_ASTC_6x5_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 6, 5) },
+	{ VK_FORMAT_ASTC_6x6_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 6, 6) },
+	{ VK_FORMAT_ASTC_6x6_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 6, 6) },
+	{ VK_FORMAT_ASTC_8x5_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 8, 5) },
+	{ VK_FORMAT_ASTC_8x5_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 8, 5) },
+	{ VK_FORMAT_ASTC_8x6_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 8, 6) },
+	{ VK_FORMAT_ASTC_8x6_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 8, 6) },
+	{ VK_FORMAT_ASTC_8x8_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 8, 8) },
+	{ VK_FORMAT_ASTC_8x8_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 8, 8) },
+	{ VK_FORMAT_ASTC_10x5_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 10, 5) },
+	{ VK_FORMAT_ASTC_10x5_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 10, 5) },
+	{ VK_FORMAT_ASTC_10x6_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 10, 6) },
+	{ VK_FORMAT_ASTC_10x6_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 10, 6) },
+	{ VK_FORMAT_ASTC_10x8_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 10, 8) },
+	{ VK_FORMAT_ASTC_10x8_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 10, 8) },
+	{ VK_FORMAT_ASTC_10x10_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 10, 10) },
+	{ VK_FORMAT_ASTC_10x10_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 10, 10) },
+	{ VK_FORMAT_ASTC_12x10_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 12, 10) },
+	{ VK_FORMAT_ASTC_12x10_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 12, 10) },
+	{ VK_FORMAT_ASTC_12x12_UNORM_BLOCK,					RawTraits(16, ComponentType::Compressed, 0, 12, 12) },
+	{ VK_FORMAT_ASTC_12x12_SRGB_BLOCK,					RawTraits(16, ComponentType::Compressed, kFormatSRGB, 12, 12) },
+};
+
+const int kVkFormatCount = sizeof(kVkFormats) / sizeof(kVkFormats[0]);
+
+//-------------------------------------------------------------------------------------------------
+// IsVkFormatTableOrdered
+//-------------------------------------------------------------------------------------------------
+constexpr bool IsVkFormatTableOrdered(int index = 0)
+{
+	return index == kVkFormatCount || ((int)kVkFormats[index].format == index && IsVkFormatTableOrdered(index + 1));
+}
+
+static_assert(IsVkFormatTableOrdered(), "kVkFormats has to be indexed by VkFormat value");
+static_assert(kVkFormats[VK_FORMAT_R32G32B32A32_SFLOAT].traits.blockSize == 16, "wrong RGBA32F size");
+static_assert(kVkFormats[VK_FORMAT_R16G16B16A16_SFLOAT].traits.blockSize == 8, "wrong RGBA16F size");
+static_assert(kVkFormats[VK_FORMAT_BC1_RGB_UNORM_BLOCK].traits.RowPitch(10) == 3 * 8, "wrong BC1 pitch");
+static_assert(kVkFormats[VK_FORMAT_ASTC_12x12_SRGB_BLOCK].traits.RowPitch(13) == 2 * 16, "wrong ASTC 12x12 pitch");
+
+//-------------------------------------------------------------------------------------------------
+// GetVkFormatTraits
+//-------------------------------------------------------------------------------------------------
+constexpr FormatTraits GetVkFormatTraits(VkFormat format)
+{
+	return (int)format >= 0 && (int)format < kVkFormatCount ? kVkFormats[format].traits : kUnsupportedFormat;
+}
+
+#endif // SUPPORT_VULKAN
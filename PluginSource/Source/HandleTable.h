@@ -0,0 +1,214 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+
+//-------------------------------------------------------------------------------------------------
+// HandleTable
+//-------------------------------------------------------------------------------------------------
+// maps int handles to objects. handle is slot index + generation counter, slot is reused through
+// free list and its generation is increased every time it is freed so stale handles are detected.
+// slots are stored in fixed size pages that never move, Get can be called from render thread while
+// main thread adds/removes objects. Add and Remove are main thread only.
+// table doesn't own the objects
+template<typename T>
+class HandleTable
+{
+public:
+	HandleTable();
+	~HandleTable();
+
+	// main thread. returns -1 when table is full
+	int Add(T* value);
+	// main thread. invalidates handle and returns the object, NULL if handle isn't valid
+	T* Remove(int handle);
+
+	// any thread. NULL if handle isn't valid
+	T* Get(int handle) const;
+
+	// main thread or when the other thread is idle. calls func for every object and empties the table
+	template<typename F>
+	void Clear(F func);
+
+public:
+	static const int kIndexBits = 16;
+	static const int kPageSize = 256;
+	static const int kMaxPages = (1 << kIndexBits) / kPageSize;
+	static const int kMaxGeneration = 0x7fff;
+
+private:
+	struct Entry
+	{
+		std::atomic<T*> value;
+		std::atomic<int> generation;
+		int nextFree;
+	};
+
+	Entry* GetEntry(int index) const;
+
+private:
+	std::atomic<Entry*> _pages[kMaxPages];
+	int _pageCount;
+	int _freeList;
+};
+
+//-------------------------------------------------------------------------------------------------
+// HandleTable::HandleTable()
+//-------------------------------------------------------------------------------------------------
+template<typename T>
+HandleTable<T>::HandleTable()
+	: _pageCount(0), _freeList(-1)
+{
+	for (int i = 0; i < kMaxPages; ++i)
+		_pages[i] = NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// HandleTable::~HandleTable()
+//-------------------------------------------------------------------------------------------------
+template<typename T>
+HandleTable<T>::~HandleTable()
+{
+	for (int i = 0; i < _pageCount; ++i)
+		delete[] _pages[i].load();
+}
+
+//-------------------------------------------------------------------------------------------------
+// HandleTable::GetEntry()
+//-------------------------------------------------------------------------------------------------
+template<typename T>
+typename HandleTable<T>::Entry* HandleTable<T>::GetEntry(int index) const
+{
+	Entry* page = _pages[index / kPageSize].load(std::memory_order_acquire);
+	if (page == NULL)
+		return NULL;
+
+	return &page[index % kPageSize];
+}
+
+//-------------------------------------------------------------------------------------------------
+// HandleTable::Add()
+//-------------------------------------------------------------------------------------------------
+template<typename T>
+int HandleTable<T>::Add(T* value)
+{
+	if (_freeList == -1)
+	{
+		if (_pageCount == kMaxPages)
+			return -1;
+
+		// new page, chain its slots to free list
+		Entry* page = new Entry[kPageSize];
+		for (int i = 0; i < kPageSize; ++i)
+		{
+			page[i].value = NULL;
+			page[i].generation = 1;
+			page[i].nextFree = i + 1 < kPageSize ? _pageCount * kPageSize + i + 1 : -1;
+		}
+
+		_freeList = _pageCount * kPageSize;
+		_pages[_pageCount].store(page, std::memory_order_release);
+		++_pageCount;
+	}
+
+	int index = _freeList;
+	Entry* entry = GetEntry(index);
+	_freeList = entry->nextFree;
+
+	entry->value = value;
+	return (entry->generation << kIndexBits) | index;
+}
+
+//-------------------------------------------------------------------------------------------------
+// HandleTable::Remove()
+//-------------------------------------------------------------------------------------------------
+template<typename T>
+T* HandleTable<T>::Remove(int handle)
+{
+	T* value = Get(handle);
+	if (value == NULL)
+		return NULL;
+
+	int index = handle & ((1 << kIndexBits) - 1);
+	Entry* entry = GetEntry(index);
+
+	// new generation first, Get on other thread rejects the handle before the slot is reused
+	int generation = entry->generation;
+	entry->generation = generation == kMaxGeneration ? 1 : generation + 1;
+	entry->value = NULL;
+
+	entry->nextFree = _freeList;
+	_freeList = index;
+	return value;
+}
+
+//-------------------------------------------------------------------------------------------------
+// HandleTable::Get()
+//-------------------------------------------------------------------------------------------------
+template<typename T>
+T* HandleTable<T>::Get(int handle) const
+{
+	if (handle <= 0)
+		return NULL;
+
+	int index = handle & ((1 << kIndexBits) - 1);
+	int generation = handle >> kIndexBits;
+
+	Entry* entry = GetEntry(index);
+	if (entry == NULL || entry->generation != generation)
+		return NULL;
+
+	T* value = entry->value;
+
+	// slot could be removed and reused while the value was read
+	if (entry->generation != generation)
+		return NULL;
+
+	return value;
+}
+
+//-------------------------------------------------------------------------------------------------
+// HandleTable::Clear()
+//-------------------------------------------------------------------------------------------------
+template<typename T>
+template<typename F>
+void HandleTable<T>::Clear(F func)
+{
+	for (int i = 0; i < _pageCount * kPageSize; ++i)
+	{
+		Entry* entry = GetEntry(i);
+		T* value = entry->value;
+		if (value == NULL)
+			continue;
+
+		Remove((entry->generation << kIndexBits) | i);
+		func(value);
+	}
+}
@@ -54,6 +54,37 @@
 #define SUPPORT_METAL 1
 #endif
 
+// GL core backend calls core profile entry points directly, Windows would need an extension loader for them
+#if !defined(SUPPORT_OPENGL_CORE_BACKEND) && SUPPORT_OPENGL_CORE && (UNITY_OSX || UNITY_LINUX)
+#define SUPPORT_OPENGL_CORE_BACKEND 1
+#endif
+
+// Vulkan backend requires Vulkan SDK headers (vulkan/vulkan.h), functions are loaded through Unity at runtime
+#ifndef SUPPORT_VULKAN
+#define SUPPORT_VULKAN 0
+#endif
+
+// host memory backend for the null device, runs without gpu. Only for tools and CI (Linux Makefile defines it),
+// shipping builds report Error_UnsupportedAPI on the null device
+#ifndef SUPPORT_SOFTWARE
+#define SUPPORT_SOFTWARE 0
+#endif
+
+// SSE2 is part of every x64 cpu, x86 builds have it when compiled with /arch:SSE2 (default) or -msse2.
+// SUPPORT_SSE2=0 builds the scalar kernels
+#ifndef SUPPORT_SSE2
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SUPPORT_SSE2 1
+#else
+#define SUPPORT_SSE2 0
+#endif
+#endif
+
+// hardware half to float conversion, requires -mf16c or /arch:AVX2
+#if SUPPORT_SSE2 && (defined(__F16C__) || defined(__AVX2__))
+#define SUPPORT_F16C 1
+#endif
+
 
 
 // COM-like Release macro
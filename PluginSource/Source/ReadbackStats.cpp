@@ -0,0 +1,134 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "ReadbackStats.h"
+
+//-------------------------------------------------------------------------------------------------
+// ReadCounter
+//-------------------------------------------------------------------------------------------------
+static long long ReadCounter(std::atomic<long long>& counter, bool reset)
+{
+	return reset ? counter.exchange(0, std::memory_order_relaxed) : counter.load(std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+// StatsHistogram::StatsHistogram()
+//-------------------------------------------------------------------------------------------------
+StatsHistogram::StatsHistogram() : _count(0), _sum(0), _max(0)
+{
+	for (int i = 0; i < kBucketCount; ++i)
+		_buckets[i] = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// StatsHistogram::Add()
+//-------------------------------------------------------------------------------------------------
+void StatsHistogram::Add(long long value)
+{
+	if (value < 0)
+		value = 0;
+
+	// bucket is the number of significant bits
+	int bucket = 0;
+	for (long long v = value; v != 0 && bucket < kBucketCount - 1; v >>= 1)
+		++bucket;
+
+	_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	_count.fetch_add(1, std::memory_order_relaxed);
+	_sum.fetch_add(value, std::memory_order_relaxed);
+	ReadbackStats::Raise(_max, value);
+}
+
+//-------------------------------------------------------------------------------------------------
+// StatsHistogram::Read()
+//-------------------------------------------------------------------------------------------------
+void StatsHistogram::Read(HistogramSnapshot* snapshot, bool reset)
+{
+	snapshot->count = ReadCounter(_count, reset);
+	snapshot->sum = ReadCounter(_sum, reset);
+	snapshot->max = ReadCounter(_max, reset);
+	for (int i = 0; i < kBucketCount; ++i)
+		snapshot->buckets[i] = ReadCounter(_buckets[i], reset);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackStats::ReadbackStats()
+//-------------------------------------------------------------------------------------------------
+ReadbackStats::ReadbackStats() : requests(0), rejectedRequests(0), copies(0), completed(0), failed(0), notReadyPolls(0), mapFailures(0), 
+	bytesCopied(0), bytesRetrieved(0), stagingBytes(0), pooledStagingBytes(0), maxSlotsInFlight(0), maxQueuedCommands(0), queuedCommands(0), completionOverflows(0)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackStats::Read()
+//-------------------------------------------------------------------------------------------------
+void ReadbackStats::Read(ReadbackStatsSnapshot* snapshot, bool reset)
+{
+	snapshot->requests = ReadCounter(requests, reset);
+	snapshot->rejectedRequests = ReadCounter(rejectedRequests, reset);
+	snapshot->copies = ReadCounter(copies, reset);
+	snapshot->completed = ReadCounter(completed, reset);
+	snapshot->failed = ReadCounter(failed, reset);
+	snapshot->notReadyPolls = ReadCounter(notReadyPolls, reset);
+	snapshot->mapFailures = ReadCounter(mapFailures, reset);
+	snapshot->bytesCopied = ReadCounter(bytesCopied, reset);
+	snapshot->bytesRetrieved = ReadCounter(bytesRetrieved, reset);
+
+	// gauges describe current state, they are never reset
+	snapshot->stagingBytes = stagingBytes.load(std::memory_order_relaxed);
+	snapshot->pooledStagingBytes = pooledStagingBytes.load(std::memory_order_relaxed);
+
+	// new window starts from zero, the next update raises the mark again
+	snapshot->maxSlotsInFlight = ReadCounter(maxSlotsInFlight, reset);
+	snapshot->maxQueuedCommands = ReadCounter(maxQueuedCommands, reset);
+
+	latencyFrames.Read(&snapshot->latencyFrames, reset);
+	latencyUs.Read(&snapshot->latencyUs, reset);
+	renderEventUs.Read(&snapshot->renderEventUs, reset);
+	snapshot->completionOverflows = ReadCounter(completionOverflows, reset);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackStats::Microseconds()
+//-------------------------------------------------------------------------------------------------
+long long ReadbackStats::Microseconds(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackStats::Raise()
+//-------------------------------------------------------------------------------------------------
+void ReadbackStats::Raise(std::atomic<long long>& highWater, long long value)
+{
+	// plain load is enough in the common case when the mark isn't exceeded
+	long long current = highWater.load(std::memory_order_relaxed);
+	while (value > current && !highWater.compare_exchange_weak(current, value, std::memory_order_relaxed))
+	{
+	}
+}
@@ -0,0 +1,143 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+//-------------------------------------------------------------------------------------------------
+// HistogramSnapshot
+//-------------------------------------------------------------------------------------------------
+// bucket 0 counts zero values, bucket i counts values from 2^(i-1) to 2^i - 1, last bucket everything bigger
+struct HistogramSnapshot
+{
+	long long count;
+	long long sum;
+	long long max;
+	long long buckets[20];
+};
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackStatsSnapshot
+//-------------------------------------------------------------------------------------------------
+// exported as is, every field is 64 bit so managed code reads it as array of longs.
+// counters and histograms cover the time since the last reset
+struct ReadbackStatsSnapshot
+{
+	// main thread requests that got a slot, requests refused because of full ring or invalid arguments
+	long long requests;
+	long long rejectedRequests;
+	// gpu copies issued on render thread
+	long long copies;
+	long long completed;
+	long long failed;
+	// polls that found the copy still in flight, completion marker or map errors
+	long long notReadyPolls;
+	long long mapFailures;
+	// staging memory copied to plugin memory, plugin memory copied to user memory
+	long long bytesCopied;
+	long long bytesRetrieved;
+	// current memory of staging copies lent to requests and free in the pool
+	long long stagingBytes;
+	long long pooledStagingBytes;
+	// high-water marks: copies in flight of one resource, commands waiting for render event
+	long long maxSlotsInFlight;
+	long long maxQueuedCommands;
+	// poll events (frames) and microseconds from the copy issue/main thread request to finished data
+	HistogramSnapshot latencyFrames;
+	HistogramSnapshot latencyUs;
+	// render thread microseconds spent in one plugin event
+	HistogramSnapshot renderEventUs;
+	// completions that didn't fit into the full completion queue, PopCompletion consumers missed them
+	long long completionOverflows;
+};
+
+//-------------------------------------------------------------------------------------------------
+// StatsHistogram
+//-------------------------------------------------------------------------------------------------
+class StatsHistogram
+{
+public:
+	StatsHistogram();
+
+	// any thread
+	void Add(long long value);
+	void Read(HistogramSnapshot* snapshot, bool reset);
+
+public:
+	static const int kBucketCount = sizeof(HistogramSnapshot::buckets) / sizeof(HistogramSnapshot::buckets[0]);
+
+private:
+	std::atomic<long long> _count;
+	std::atomic<long long> _sum;
+	std::atomic<long long> _max;
+	std::atomic<long long> _buckets[kBucketCount];
+};
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackStats
+//-------------------------------------------------------------------------------------------------
+// counters updated by main, render and copy thread. every update is one relaxed atomic operation so the
+// stats stay on in shipping builds. snapshot reads (and resets) fields one by one without locks, it isn't
+// one consistent moment but no update is lost or counted twice
+class ReadbackStats
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	ReadbackStats();
+
+	void Read(ReadbackStatsSnapshot* snapshot, bool reset);
+
+	static long long Microseconds(Clock::time_point start, Clock::time_point end);
+	static void Add(std::atomic<long long>& counter, long long value) { counter.fetch_add(value, std::memory_order_relaxed); }
+	static void Raise(std::atomic<long long>& highWater, long long value);
+
+public:
+	std::atomic<long long> requests;
+	std::atomic<long long> rejectedRequests;
+	std::atomic<long long> copies;
+	std::atomic<long long> completed;
+	std::atomic<long long> failed;
+	std::atomic<long long> notReadyPolls;
+	std::atomic<long long> mapFailures;
+	std::atomic<long long> bytesCopied;
+	std::atomic<long long> bytesRetrieved;
+	std::atomic<long long> stagingBytes;
+	std::atomic<long long> pooledStagingBytes;
+	std::atomic<long long> maxSlotsInFlight;
+	std::atomic<long long> maxQueuedCommands;
+	// commands pushed and not yet executed, kept across resets
+	std::atomic<long long> queuedCommands;
+	std::atomic<long long> completionOverflows;
+
+	StatsHistogram latencyFrames;
+	StatsHistogram latencyUs;
+	StatsHistogram renderEventUs;
+};
@@ -0,0 +1,255 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "ReadbackTrace.h"
+
+#include <stdio.h>
+#include <vector>
+
+std::atomic<int> ReadbackTrace::sThreadCount(0);
+std::atomic<const char*> ReadbackTrace::sThreadNames[ReadbackTrace::kMaxThreads];
+
+static const char* kPhaseNames[] = { "Request", "Rejected", "Render event", "Copy issued", "Mapped", "Copy finished", "Failed", "Delivered" };
+
+//-------------------------------------------------------------------------------------------------
+// TraceRecord
+//-------------------------------------------------------------------------------------------------
+// plain copy of TraceEvent taken by Write
+struct TraceRecord
+{
+	long long start;
+	long long duration;
+	int phase;
+	int threadId;
+	int resourceHandle;
+	int requestId;
+	int status;
+};
+
+//-------------------------------------------------------------------------------------------------
+// WriteString
+//-------------------------------------------------------------------------------------------------
+static void WriteString(FILE* file, const std::string& str)
+{
+	fputc('"', file);
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		unsigned char c = (unsigned char)str[i];
+		if (c == '"' || c == '\\')
+			fprintf(file, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(file, "\\u%04x", c);
+		else
+			fputc(c, file);
+	}
+	fputc('"', file);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackTrace::ReadbackTrace()
+//-------------------------------------------------------------------------------------------------
+ReadbackTrace::ReadbackTrace() : _events(NULL), _next(0), _enabled(false), _epoch(Clock::now())
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackTrace::~ReadbackTrace()
+//-------------------------------------------------------------------------------------------------
+ReadbackTrace::~ReadbackTrace()
+{
+	delete[] _events;
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackTrace::Enable()
+//-------------------------------------------------------------------------------------------------
+void ReadbackTrace::Enable(bool enabled)
+{
+	// ring is never released while the plugin is loaded, other threads can still be writing to it
+	if (enabled && _events == NULL)
+	{
+		_events = new TraceEvent[kCapacity];
+		for (int i = 0; i < kCapacity; ++i)
+			_events[i].sequence.store(0, std::memory_order_relaxed);
+	}
+
+	NameThread("Main thread");
+	_enabled.store(enabled, std::memory_order_release);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackTrace::SetResourceName()
+//-------------------------------------------------------------------------------------------------
+void ReadbackTrace::SetResourceName(int resourceHandle, const char* name)
+{
+	if (name != NULL && name[0] != '\0')
+		_resourceNames[resourceHandle] = name;
+	else
+		_resourceNames.erase(resourceHandle);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackTrace::Record()
+//-------------------------------------------------------------------------------------------------
+void ReadbackTrace::Record(TracePhase phase, int resourceHandle, int requestId, int status, Clock::time_point start, Clock::time_point end)
+{
+	if (!IsEnabled())
+		return;
+
+	// sequence is cleared first so reader skips the event until every field is written
+	unsigned int index = _next.fetch_add(1, std::memory_order_relaxed);
+	TraceEvent& event = _events[index & (kCapacity - 1)];
+	event.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	event.start.store(std::chrono::duration_cast<std::chrono::nanoseconds>(start - _epoch).count(), std::memory_order_relaxed);
+	event.duration.store(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(), std::memory_order_relaxed);
+	event.phase.store((int)phase, std::memory_order_relaxed);
+	event.threadId.store(ThreadId(), std::memory_order_relaxed);
+	event.resourceHandle.store(resourceHandle, std::memory_order_relaxed);
+	event.requestId.store(requestId, std::memory_order_relaxed);
+	event.status.store(status, std::memory_order_relaxed);
+
+	event.sequence.store(index + 1, std::memory_order_release);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackTrace::Write()
+//-------------------------------------------------------------------------------------------------
+bool ReadbackTrace::Write(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+
+	// copy complete events first, writers keep going and can overwrite the oldest ones meanwhile
+	std::vector<TraceRecord> records;
+	unsigned int end = _next.load(std::memory_order_acquire);
+	unsigned int count = _events != NULL ? (end < (unsigned int)kCapacity ? end : kCapacity) : 0;
+	records.reserve(count);
+
+	for (unsigned int index = end - count; index != end; ++index)
+	{
+		const TraceEvent& event = _events[index & (kCapacity - 1)];
+		unsigned int sequence = event.sequence.load(std::memory_order_acquire);
+		if (sequence != index + 1)
+			continue;
+
+		TraceRecord record;
+		record.start = event.start.load(std::memory_order_relaxed);
+		record.duration = event.duration.load(std::memory_order_relaxed);
+		record.phase = event.phase.load(std::memory_order_relaxed);
+		record.threadId = event.threadId.load(std::memory_order_relaxed);
+		record.resourceHandle = event.resourceHandle.load(std::memory_order_relaxed);
+		record.requestId = event.requestId.load(std::memory_order_relaxed);
+		record.status = event.status.load(std::memory_order_relaxed);
+
+		// event was overwritten while it was copied
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (event.sequence.load(std::memory_order_relaxed) != sequence)
+			continue;
+
+		records.push_back(record);
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"AsyncTextureReader\"}}");
+
+	int threadCount = sThreadCount.load(std::memory_order_relaxed);
+	for (int i = 0; i < threadCount && i < kMaxThreads; ++i)
+	{
+		const char* name = sThreadNames[i].load(std::memory_order_relaxed);
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", i + 1);
+		WriteString(file, name != NULL ? name : "Thread " + std::to_string(i + 1));
+		fprintf(file, "}}");
+	}
+
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		const TraceRecord& record = records[i];
+		TracePhase phase = (TracePhase)record.phase;
+		double ts = record.start / 1000.0;
+
+		std::string resourceName;
+		if (record.resourceHandle >= 0)
+		{
+			auto it = _resourceNames.find(record.resourceHandle);
+			resourceName = it != _resourceNames.end() ? it->second : "Resource " + std::to_string(record.resourceHandle);
+		}
+
+		// step on the track of the thread that did it
+		fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"readback\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d", 
+			kPhaseNames[record.phase], ts, record.duration / 1000.0, record.threadId + 1);
+		if (record.resourceHandle >= 0)
+		{
+			fprintf(file, ",\"args\":{\"resource\":");
+			WriteString(file, resourceName);
+			fprintf(file, ",\"handle\":%d,\"request\":%d,\"status\":%d}", record.resourceHandle, record.requestId, record.status);
+		}
+		fprintf(file, "}");
+
+		// rejected request id is given to the next request, render events don't belong to any request
+		if (phase == TracePhase::Rejected || phase == TracePhase::RenderEvent)
+			continue;
+
+		// request track begins with the request, ends with the delivery and marks steps between them
+		const char* asyncPhase = phase == TracePhase::Request ? "b" : (phase == TracePhase::Delivered ? "e" : "n");
+		double asyncTs = phase == TracePhase::Delivered ? ts + record.duration / 1000.0 : ts;
+		fprintf(file, ",\n{\"name\":");
+		WriteString(file, phase == TracePhase::Request || phase == TracePhase::Delivered ? resourceName : kPhaseNames[record.phase]);
+		fprintf(file, ",\"cat\":\"request\",\"ph\":\"%s\",\"id\":%d,\"ts\":%.3f,\"pid\":1,\"tid\":%d}", asyncPhase, record.requestId, asyncTs, record.threadId + 1);
+	}
+
+	fprintf(file, "\n]}\n");
+	bool succeeded = ferror(file) == 0;
+	fclose(file);
+	return succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackTrace::NameThread()
+//-------------------------------------------------------------------------------------------------
+void ReadbackTrace::NameThread(const char* name)
+{
+	int threadId = ThreadId();
+	if (threadId < kMaxThreads)
+		sThreadNames[threadId].store(name, std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackTrace::ThreadId()
+//-------------------------------------------------------------------------------------------------
+int ReadbackTrace::ThreadId()
+{
+	// small ids in order of the first event, tracks of the trace are sorted by them
+	static thread_local int threadId = -1;
+	if (threadId < 0)
+		threadId = sThreadCount.fetch_add(1, std::memory_order_relaxed);
+
+	return threadId;
+}
@@ -0,0 +1,121 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+enum class TracePhase
+{
+	// main thread got a slot for the request, or refused it
+	Request,
+	Rejected,
+	// render thread event that executes queued commands or polls copies, no request
+	RenderEvent,
+	// render thread resolved the region, took staging copy and submitted gpu copy
+	CopyIssued,
+	// first successful completion query and map of the staging copy
+	Mapped,
+	// data copied from staging memory to plugin memory, on render thread or copy thread
+	CopyFinished,
+	// request failed on render thread or copy thread
+	Failed,
+	// main thread copied the data to user memory or handed them out by lease
+	Delivered
+};
+
+//-------------------------------------------------------------------------------------------------
+// TraceEvent
+//-------------------------------------------------------------------------------------------------
+// fields are atomic so a writer that laps the reader can't tear them, sequence tells if the event is complete
+struct TraceEvent
+{
+	// index of the event in the ring + 1, 0 while the event is written
+	std::atomic<unsigned int> sequence;
+	// nanoseconds since the trace was created
+	std::atomic<long long> start;
+	std::atomic<long long> duration;
+	std::atomic<int> phase;
+	std::atomic<int> threadId;
+	std::atomic<int> resourceHandle;
+	std::atomic<int> requestId;
+	std::atomic<int> status;
+};
+
+//-------------------------------------------------------------------------------------------------
+// ReadbackTrace
+//-------------------------------------------------------------------------------------------------
+// timeline of every request step written by main, render and copy thread into a fixed-size ring, oldest
+// events are overwritten. writing an event is one atomic increment and a few relaxed stores, disabled
+// trace costs one atomic load. ring is allocated by the first Enable and written as Chrome trace json
+// (chrome://tracing, ui.perfetto.dev): every thread has its own track with step durations, every request 
+// has async track from the request to the delivery
+class ReadbackTrace
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	ReadbackTrace();
+	~ReadbackTrace();
+
+	// main thread
+	void Enable(bool enabled);
+	void SetResourceName(int resourceHandle, const char* name);
+	bool Write(const char* path);
+
+	// any thread
+	bool IsEnabled() const { return _enabled.load(std::memory_order_acquire); }
+	void Record(TracePhase phase, int resourceHandle, int requestId, int status, Clock::time_point start, Clock::time_point end);
+	void Record(TracePhase phase, int resourceHandle, int requestId, int status) { Clock::time_point now = Clock::now(); Record(phase, resourceHandle, requestId, status, now, now); }
+
+	// any thread. names the calling thread in the trace, name has to be a string literal
+	static void NameThread(const char* name);
+
+public:
+	// power of two, 48 bytes per event
+	static const int kCapacity = 32768;
+	static const int kMaxThreads = 64;
+
+private:
+	static int ThreadId();
+
+private:
+	TraceEvent* _events;
+	std::atomic<unsigned int> _next;
+	std::atomic<bool> _enabled;
+	Clock::time_point _epoch;
+
+	// main thread
+	std::unordered_map<int, std::string> _resourceNames;
+
+	static std::atomic<int> sThreadCount;
+	static std::atomic<const char*> sThreadNames[kMaxThreads];
+};
@@ -0,0 +1,260 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "Reduction.h"
+#include "Conversion.h"
+#include "PlatformBase.h"
+#include <string.h>
+#include <math.h>
+
+#if SUPPORT_SSE2
+#include <emmintrin.h>
+#endif
+
+//-------------------------------------------------------------------------------------------------
+// Reducer::Reducer()
+//-------------------------------------------------------------------------------------------------
+Reducer::Reducer(const ReductionDesc& desc, const FormatTraits& format)
+	: _desc(desc), _type(format.type), _channels(format.channels), _pixelSize(format.blockSize), _bgra((format.flags & kFormatBGRA) != 0), _count(0)
+{
+	// histogram channel is given in RGBA order, data are in memory order
+	if (_bgra && (_desc.histogramChannel == 0 || _desc.histogramChannel == 2))
+		_desc.histogramChannel = 2 - _desc.histogramChannel;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		_min[i] = INFINITY;
+		_max[i] = -INFINITY;
+		_sum[i] = 0.0;
+	}
+
+	_histogramScale = kHistogramBins / (desc.histogramMax - desc.histogramMin);
+	memset(_histogram, 0, sizeof(_histogram));
+}
+
+//-------------------------------------------------------------------------------------------------
+// Reducer::IsSupported()
+//-------------------------------------------------------------------------------------------------
+bool Reducer::IsSupported(const ReductionDesc& desc, const FormatTraits& format)
+{
+	const int allFlags = kReductionMinMax | kReductionMean | kReductionHistogram;
+	if (desc.flags == 0 || (desc.flags & ~allFlags) != 0)
+		return false;
+
+	// only formats with channels of one type
+	if (!format.HasChannels() || format.IsCompressed() || format.channels > 4)
+		return false;
+
+	if ((desc.flags & kReductionHistogram) != 0)
+	{
+		if (desc.histogramChannel < 0 || desc.histogramChannel >= format.channels || !(desc.histogramMax > desc.histogramMin))
+			return false;
+	}
+
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Reducer::AddPixels()
+//-------------------------------------------------------------------------------------------------
+void Reducer::AddPixels(const void* pixels, int count)
+{
+	_count += count;
+
+	// float formats are reduced directly from staging memory
+	if (_type == ComponentType::Float32 && _channels == 4)
+	{
+		AddFloat4((const float*)pixels, count);
+		return;
+	}
+
+	if (_type == ComponentType::Float32 && _channels == 1)
+	{
+		AddFloat1((const float*)pixels, count);
+		return;
+	}
+
+	// everything else is converted to float4 in small chunks that stay in L1 cache
+	float converted[kChunkSize * 4];
+	const char* src = (const char*)pixels;
+	for (int i = 0; i < count; i += kChunkSize)
+	{
+		int chunk = count - i < kChunkSize ? count - i : kChunkSize;
+		ConvertToFloat4(src + i * _pixelSize, chunk, _type, _channels, converted);
+		AddFloat4(converted, chunk);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Reducer::AddFloat4()
+//-------------------------------------------------------------------------------------------------
+void Reducer::AddFloat4(const float* pixels, int count)
+{
+	if ((_desc.flags & (kReductionMinMax | kReductionMean)) != 0)
+	{
+		// row sum is accumulated in float and added to double total, rows are short enough to keep precision
+#if SUPPORT_SSE2
+		__m128 min = _mm_loadu_ps(_min);
+		__m128 max = _mm_loadu_ps(_max);
+		__m128 sum = _mm_setzero_ps();
+		for (int i = 0; i < count; ++i)
+		{
+			__m128 pixel = _mm_loadu_ps(pixels + i * 4);
+			// pixel goes first, min/max return the second operand when the first one is NaN
+			min = _mm_min_ps(pixel, min);
+			max = _mm_max_ps(pixel, max);
+			sum = _mm_add_ps(sum, pixel);
+		}
+
+		float rowSum[4];
+		_mm_storeu_ps(_min, min);
+		_mm_storeu_ps(_max, max);
+		_mm_storeu_ps(rowSum, sum);
+#else
+		float rowSum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < count; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				float value = pixels[i * 4 + c];
+				_min[c] = value < _min[c] ? value : _min[c];
+				_max[c] = value > _max[c] ? value : _max[c];
+				rowSum[c] += value;
+			}
+		}
+#endif
+		for (int c = 0; c < 4; ++c)
+			_sum[c] += rowSum[c];
+	}
+
+	if ((_desc.flags & kReductionHistogram) != 0)
+	{
+		for (int i = 0; i < count; ++i)
+			AddToHistogram(pixels[i * 4 + _desc.histogramChannel]);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Reducer::AddFloat1()
+//-------------------------------------------------------------------------------------------------
+void Reducer::AddFloat1(const float* pixels, int count)
+{
+	if ((_desc.flags & (kReductionMinMax | kReductionMean)) != 0)
+	{
+		int i = 0;
+		float rowSum = 0.0f;
+#if SUPPORT_SSE2
+		// four pixels per register, lanes are combined at the end
+		__m128 min = _mm_set1_ps(_min[0]);
+		__m128 max = _mm_set1_ps(_max[0]);
+		__m128 sum = _mm_setzero_ps();
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 values = _mm_loadu_ps(pixels + i);
+			min = _mm_min_ps(values, min);
+			max = _mm_max_ps(values, max);
+			sum = _mm_add_ps(sum, values);
+		}
+
+		float lanes[3][4];
+		_mm_storeu_ps(lanes[0], min);
+		_mm_storeu_ps(lanes[1], max);
+		_mm_storeu_ps(lanes[2], sum);
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			_min[0] = lanes[0][lane] < _min[0] ? lanes[0][lane] : _min[0];
+			_max[0] = lanes[1][lane] > _max[0] ? lanes[1][lane] : _max[0];
+			rowSum += lanes[2][lane];
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			float value = pixels[i];
+			_min[0] = value < _min[0] ? value : _min[0];
+			_max[0] = value > _max[0] ? value : _max[0];
+			rowSum += value;
+		}
+
+		_sum[0] += rowSum;
+	}
+
+	if ((_desc.flags & kReductionHistogram) != 0)
+	{
+		for (int i = 0; i < count; ++i)
+			AddToHistogram(pixels[i]);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// Reducer::AddToHistogram()
+//-------------------------------------------------------------------------------------------------
+void Reducer::AddToHistogram(float value)
+{
+	// NaN doesn't belong to any bin
+	if (value != value)
+		return;
+
+	float bin = (value - _desc.histogramMin) * _histogramScale;
+	int index = bin < 0.0f ? 0 : (bin >= kHistogramBins - 1 ? kHistogramBins - 1 : (int)bin);
+	++_histogram[index];
+}
+
+//-------------------------------------------------------------------------------------------------
+// Reducer::GetResult()
+//-------------------------------------------------------------------------------------------------
+void Reducer::GetResult(ReductionResult* result) const
+{
+	memset(result, 0, sizeof(ReductionResult));
+	if (_count == 0)
+		return;
+
+	for (int c = 0; c < _channels; ++c)
+	{
+		if ((_desc.flags & kReductionMinMax) != 0)
+		{
+			result->min[c] = _min[c];
+			result->max[c] = _max[c];
+		}
+
+		if ((_desc.flags & kReductionMean) != 0)
+			result->mean[c] = (float)(_sum[c] / _count);
+	}
+
+	if ((_desc.flags & kReductionHistogram) != 0)
+		memcpy(result->histogram, _histogram, sizeof(_histogram));
+
+	if (_bgra)
+	{
+		float* channels[3] = { result->min, result->max, result->mean };
+		for (int i = 0; i < 3; ++i)
+		{
+			float blue = channels[i][0];
+			channels[i][0] = channels[i][2];
+			channels[i][2] = blue;
+		}
+	}
+}
@@ -0,0 +1,105 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "FormatTraits.h"
+
+// reductions computed while data are copied out of staging memory, only the result is returned to the user
+const int kReductionMinMax = 1 << 0;
+const int kReductionMean = 1 << 1;
+const int kReductionHistogram = 1 << 2;
+
+const int kHistogramBins = 256;
+
+//-------------------------------------------------------------------------------------------------
+// ReductionDesc
+//-------------------------------------------------------------------------------------------------
+struct ReductionDesc
+{
+	// combination of kReduction* flags, zero means raw data are returned
+	int flags;
+	// histogram of one channel, values are split into kHistogramBins bins between histogramMin and histogramMax.
+	// values outside of the range go to the first/last bin
+	int histogramChannel;
+	float histogramMin;
+	float histogramMax;
+
+	ReductionDesc() : flags(0), histogramChannel(0), histogramMin(0.0f), histogramMax(1.0f) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// ReductionResult
+//-------------------------------------------------------------------------------------------------
+// data returned instead of pixels. values that weren't requested and missing channels are zero. 
+// normalized formats are reduced as floats (0-1 or -1-1), NaNs are ignored by min/max.
+// channels are always in RGBA order, sRGB values are reduced as they are stored
+struct ReductionResult
+{
+	float min[4];
+	float max[4];
+	float mean[4];
+	unsigned int histogram[kHistogramBins];
+};
+
+//-------------------------------------------------------------------------------------------------
+// Reducer
+//-------------------------------------------------------------------------------------------------
+// accumulates pixels row by row. SSE2 kernels are used where available
+class Reducer
+{
+public:
+	Reducer(const ReductionDesc& desc, const FormatTraits& format);
+
+	static bool IsSupported(const ReductionDesc& desc, const FormatTraits& format);
+
+	// tightly packed pixels in the source format
+	void AddPixels(const void* pixels, int count);
+	void GetResult(ReductionResult* result) const;
+
+private:
+	void AddFloat4(const float* pixels, int count);
+	void AddFloat1(const float* pixels, int count);
+	void AddToHistogram(float value);
+
+private:
+	static const int kChunkSize = 256;
+
+	ReductionDesc _desc;
+	ComponentType _type;
+	int _channels;
+	int _pixelSize;
+	// BGRA formats are reduced in memory order and swizzled in GetResult
+	bool _bgra;
+
+	float _min[4];
+	float _max[4];
+	double _sum[4];
+	long long _count;
+	float _histogramScale;
+	unsigned int _histogram[kHistogramBins];
+};
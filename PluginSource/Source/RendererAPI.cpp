@@ -42,6 +42,30 @@ RendererAPI* CreateRendererAPI(UnityGfxRenderer apiType)
     }
 #	endif // if SUPPORT_D3D11
 
+#	if SUPPORT_OPENGL_CORE_BACKEND
+    if (apiType == kUnityGfxRendererOpenGLCore)
+    {
+        extern RendererAPI* CreateRendererAPI_GL();
+        return CreateRendererAPI_GL();
+    }
+#	endif // if SUPPORT_OPENGL_CORE_BACKEND
+
+#	if SUPPORT_VULKAN
+    if (apiType == kUnityGfxRendererVulkan)
+    {
+        extern RendererAPI* CreateRendererAPI_Vulkan();
+        return CreateRendererAPI_Vulkan();
+    }
+#	endif // if SUPPORT_VULKAN
+
+#	if SUPPORT_SOFTWARE
+    if (apiType == kUnityGfxRendererNull)
+    {
+        extern RendererAPI* CreateRendererAPI_Software();
+        return CreateRendererAPI_Software();
+    }
+#	endif // if SUPPORT_SOFTWARE
+
     // Unsupported API
     return NULL;
 }
@@ -28,6 +28,11 @@
 #pragma once
 
 #include "Unity/IUnityGraphics.h"
+#include "Reduction.h"
+#include "Conversion.h"
+#include "Delta.h"
+#include <stddef.h>
+#include <atomic>
 
 enum class Status
 {
@@ -43,30 +48,156 @@ enum class Status
 	Error_CopyInProgress
 };
 
+//-------------------------------------------------------------------------------------------------
+// ReadRegion
+//-------------------------------------------------------------------------------------------------
+// part of the resource that is read back. textures use texel box within selected mip level, buffers use 
+// x as byte offset and width as byte length. zero width/height means the whole mip level (whole buffer).
+// slice is array slice, cube face (array slice of cube texture) or depth slice of 3D texture.
+// sliceCount consecutive slices are read by one request and packed one after another
+struct ReadRegion
+{
+	int x;
+	int y;
+	int width;
+	int height;
+	int mipLevel;
+	int slice;
+	int sliceCount;
+
+	ReadRegion() : x(0), y(0), width(0), height(0), mipLevel(0), slice(0), sliceCount(1) {}
+	ReadRegion(int x, int y, int width, int height) : x(x), y(y), width(width), height(height), mipLevel(0), slice(0), sliceCount(1) {}
+
+	bool IsWholeLevel() const { return x == 0 && y == 0 && width == 0 && height == 0; }
+};
+
+//-------------------------------------------------------------------------------------------------
+// ReadRequest
+//-------------------------------------------------------------------------------------------------
+// what is read from the resource and what is returned to the user
+struct ReadRequest
+{
+	ReadRegion region;
+	// optional reduction, the request returns ReductionResult instead of pixels
+	ReductionDesc reduction;
+	// optional conversion of pixels to another type/channel layout, can't be combined with reduction
+	ConversionDesc conversion;
+	// optional delta of raw texture data, only tiles changed since the last delivered request are returned
+	DeltaDesc delta;
+
+	ReadRequest() {}
+	ReadRequest(const ReadRegion& region) : region(region) {}
+};
+
 typedef void(*FuncPtr)(const char *);
 extern FuncPtr DebugLog;
 
+class CompletionNotifier;
+class ReadbackStats;
+class ReadbackTrace;
+
 //-------------------------------------------------------------------------------------------------
 // RendererAPI
 //-------------------------------------------------------------------------------------------------
 class RendererAPI
 {
 public:
+    RendererAPI() : _stagingRingSize(kDefaultStagingRingSize), _copyThreadEnabled(false), _stagingBudget(0), _stagingIdleFrames(kDefaultStagingIdleFrames), _notifier(NULL), _stats(NULL), _trace(NULL) {}
     virtual ~RendererAPI() {}
 
+	// number of staging copies kept per resource, applies to resources requested for the first time after the call
+	void SetStagingRingSize(int size) { _stagingRingSize = size; }
+	int GetStagingRingSize() const { return _stagingRingSize; }
+
+	// finished copies are only mapped on render thread, data are copied to system memory by dedicated copy thread 
+	// and staging memory is unmapped on a later render event. applies to copies that finish after the call
+	void SetCopyThreadEnabled(bool enabled) { _copyThreadEnabled = enabled; }
+	bool IsCopyThreadEnabled() const { return _copyThreadEnabled; }
+
+	// staging copies are shared by all resources. budget limits their memory (zero is unlimited), free copies
+	// unused for idleFrames poll events are released (zero keeps them). render thread applies it on the next copy or poll
+	void SetStagingPool(long long budget, int idleFrames) { _stagingBudget = budget; _stagingIdleFrames = idleFrames; }
+
+	// every finished request is reported to the notifier, set before the first request
+	void SetCompletionNotifier(CompletionNotifier* notifier) { _notifier = notifier; }
+	// requests, copies and staging memory are counted in stats, set before the first request
+	void SetReadbackStats(ReadbackStats* stats) { _stats = stats; }
+	// every step of every request is recorded to the trace while it is enabled, set before the first request
+	void SetReadbackTrace(ReadbackTrace* trace) { _trace = trace; }
+
     virtual void ProcessDeviceEvent(UnityGfxDeviceEventType eventType, IUnityInterfaces* interfaces) = 0;
 
-	virtual Status RequestTextureData_MainThread(void* textureHandle) = 0;
-    virtual Status RequestTextureData_RenderThread(void* textureHandle) = 0;
-	virtual void CopyTextureData_RenderThread(void* textureHandle) = 0;
-    virtual Status RetrieveTextureData_MainThread(void* textureHandle, void* data, int dataSize) = 0;
+	// native texture/buffer has to be registered before it can be used, other functions take returned handle
+	virtual Status RegisterResource_MainThread(void* nativeResource, bool isBuffer, int* resourceHandle) = 0;
+
+	virtual Status RequestTextureData_MainThread(int textureHandle, int requestId, const ReadRequest& request) = 0;
+    virtual Status RequestTextureData_RenderThread(int textureHandle) = 0;
+	virtual void CopyTextureData_RenderThread(int textureHandle) = 0;
+    virtual Status RetrieveTextureData_MainThread(int textureHandle, void* data, int dataSize, int* requestId) = 0;
+
+	virtual Status RequestBufferData_MainThread(int bufferHandle, int requestId, const ReadRequest& request) = 0;
+	virtual Status RequestBufferData_RenderThread(int bufferHandle) = 0;
+	virtual void CopyBufferData_RenderThread(int bufferHandle) = 0;
+	virtual Status RetrieveBufferData_MainThread(int bufferHandle, void* data, int dataSize, int* requestId) = 0;
 
-	virtual Status RequestBufferData_MainThread(void* bufferHandle) = 0;
-	virtual Status RequestBufferData_RenderThread(void* bufferHandle) = 0;
-	virtual void CopyBufferData_RenderThread(void* textureHandle) = 0;
-	virtual Status RetrieveBufferData_MainThread(void* bufferHandle, void* data, int dataSize) = 0;
+	// zero copy access to finished request, data stay valid until ReleaseData_MainThread is called
+	virtual Status AcquireData_MainThread(int resourceHandle, const void** data, int* dataSize, int* rowPitch, int* requestId) = 0;
+	virtual Status ReleaseData_MainThread(int resourceHandle, int requestId) = 0;
+
+	// same as texture/buffer functions above for resource of any type
+	virtual Status CanRequestData_MainThread(int resourceHandle) = 0;
+	virtual Status RequestData_MainThread(int resourceHandle, int requestId, const ReadRequest& request) = 0;
+	virtual Status RequestData_RenderThread(int resourceHandle) = 0;
+	virtual void CopyData_RenderThread(int resourceHandle) = 0;
+	// checks copies of every resource with requests in flight, finished ones are handled like in CopyData_RenderThread
+	virtual void PollCopies_RenderThread() = 0;
+	// status, request id and size of the oldest finished request without retrieving it
+	virtual Status PeekData_MainThread(int resourceHandle, int* requestId, int* dataSize) = 0;
+	virtual Status RetrieveData_MainThread(int resourceHandle, void* data, int dataSize, int* requestId) = 0;
+	// retrieves delta request as DeltaHeader, dirty tile bitmap and dirty tiles. deltaSize is the size of written
+	// data, or the size needed when data are too small (request stays, it can be retrieved again)
+	virtual Status RetrieveDelta_MainThread(int resourceHandle, void* data, int dataSize, int* deltaSize, int* requestId) = 0;
+
+	// main thread part invalidates the handle and returns internal resource object (NULL if handle isn't valid).
+	// the object is released later on render thread
+	virtual void* ReleaseTempResources_MainThread(int resourceHandle) = 0;
+	virtual void ReleaseTempResources_RenderThread(void* resource) = 0;
+
+	// continuous readback of the whole resource. poll event requests a copy every everyNFrames poll events and the
+	// newest ringDepth finished copies are kept. render thread part starts the subscription with the next poll event
+	virtual Status Subscribe_MainThread(int resourceHandle, int everyNFrames, int ringDepth, int* subscription) = 0;
+	virtual void Subscribe_RenderThread(int subscription) = 0;
+	// same as ReleaseTempResources, returns subscription object released later on render thread
+	virtual void* Unsubscribe_MainThread(int subscription) = 0;
+	virtual void Unsubscribe_RenderThread(void* subscription) = 0;
+	// oldest unread result (newest one if latest is set) and poll event that copied it. dropped is the number of 
+	// results overwritten before they were read since the last call
+	virtual Status RetrieveSubscription_MainThread(int subscription, bool latest, void* data, int dataSize, unsigned int* frame, int* dropped) = 0;
+
+	// subscription whose copies are written to file at path instead of being retrieved, up to maxBytes of disk space is 
+	// reserved now. depth copies can be in flight or waiting for the writer, copy is skipped when all of them are.
+	// started and stopped like subscription, but the handle stays valid after Unsubscribe_MainThread. writer thread
+	// finishes the remaining writes and closes the file, poll events release the slots afterwards
+	virtual Status StartCapture_MainThread(int resourceHandle, int everyNFrames, int depth, const char* path, long long maxBytes, int* capture) = 0;
+	// copies written to the file, copies skipped because the writer fell behind or the file was full, failed copies
+	// and writes, and bytes written so far. finished is set once stopped capture closed its file and released its
+	// slots, the handle is invalid after that call
+	virtual Status GetCaptureStatus_MainThread(int capture, int* written, int* skipped, int* failed, long long* bytes, bool* finished) = 0;
+
+public:
+	static const int kDefaultStagingRingSize = 3;
+	static const int kMaxStagingRingSize = 16;
+	static const int kDefaultStagingIdleFrames = 120;
+	static const int kMaxSubscriptionDepth = 64;
 
-	virtual void ReleaseTempResources(void* resourceHandle) = 0;
+protected:
+	int _stagingRingSize;
+	std::atomic<bool> _copyThreadEnabled;
+	std::atomic<long long> _stagingBudget;
+	std::atomic<int> _stagingIdleFrames;
+	CompletionNotifier* _notifier;
+	ReadbackStats* _stats;
+	ReadbackTrace* _trace;
 };
 
 RendererAPI* CreateRendererAPI(UnityGfxRenderer apiType);
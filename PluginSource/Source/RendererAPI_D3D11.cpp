@@ -25,8 +25,8 @@
 //  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
 //  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+
 #include "RendererAPI_D3D11.h"
-#include <assert.h>
 
 //-------------------------------------------------------------------------------------------------
 // RendererAPI_D3D11::RendererAPI_D3D11()
@@ -66,418 +66,272 @@ void RendererAPI_D3D11::ProcessDeviceEvent(UnityGfxDeviceEventType eventType, IU
 }
 
 //-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::ReleaseResources()
+// RendererAPI_D3D11::DescribeResource()
 //-------------------------------------------------------------------------------------------------
-void RendererAPI_D3D11::ReleaseResources()
+Status RendererAPI_D3D11::DescribeResource(CpuResource* cpuResource, ResourceDesc* desc)
 {
-	// release resource copies in staging memory
-	for (TextureMapIter iter = _resourceMap.begin(); iter != _resourceMap.end(); ++iter)
+	if (cpuResource->isBuffer)
 	{
-		CpuResource* resource = iter->second;
-		if (resource != NULL)
-		{
-			SAFE_RELEASE(resource->stagingBuffer);
-			if (resource->cpuBuffer != NULL)
-				delete[] resource->cpuBuffer;
-
-			SAFE_DELETE(resource);
-		}
+		D3D11_BUFFER_DESC bufferDesc;
+		((ID3D11Buffer*)cpuResource->gpuResource)->GetDesc(&bufferDesc);
+		desc->width = bufferDesc.ByteWidth;
+		return Status::Succeeded;
 	}
 
-	_resourceMap.clear();
-}
-
-//-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::RequestTextureData_MainThread()
-//-------------------------------------------------------------------------------------------------
-void RendererAPI_D3D11::ReleaseTempResources(void* resourceHandle)
-{
-	ID3D11Resource* resource = (ID3D11Resource*)resourceHandle;
-	CpuResource* cpuResource = _resourceMap[resource];
-
-	if (cpuResource == NULL)
-		return;
-
-	// temp buffers are currently in use
-	//if (cpuResource->bufferStatus != CpuResourceStatus::Ready)
-		//return;
-
-	SAFE_RELEASE(cpuResource->stagingBuffer);
-	if (cpuResource->cpuBuffer != NULL)
-		delete[] cpuResource->cpuBuffer;
+	D3D11_RESOURCE_DIMENSION dimension;
+	((ID3D11Resource*)cpuResource->gpuResource)->GetType(&dimension);
+	if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+	{
+		// cube textures are 2D texture arrays with 6 slices per cube
+		D3D11_TEXTURE2D_DESC textureDesc;
+		((ID3D11Texture2D*)cpuResource->gpuResource)->GetDesc(&textureDesc);
+
+		// multisampled texture can't be copied to staging texture, it would have to be resolved first
+		if (textureDesc.SampleDesc.Count > 1)
+			return Status::Error_UnsupportedFormat;
+
+		desc->width = textureDesc.Width;
+		desc->height = textureDesc.Height;
+		desc->slices = textureDesc.ArraySize;
+		desc->mipLevels = textureDesc.MipLevels;
+		desc->is3D = false;
+		desc->format = GetDxgiFormatTraits(textureDesc.Format);
+		desc->stagingFormat = textureDesc.Format;
+		return Status::Succeeded;
+	}
 
-	SAFE_DELETE(cpuResource);
+	if (dimension == D3D11_RESOURCE_DIMENSION_TEXTURE3D)
+	{
+		D3D11_TEXTURE3D_DESC textureDesc;
+		((ID3D11Texture3D*)cpuResource->gpuResource)->GetDesc(&textureDesc);
+		desc->width = textureDesc.Width;
+		desc->height = textureDesc.Height;
+		desc->slices = textureDesc.Depth;
+		desc->mipLevels = textureDesc.MipLevels;
+		desc->is3D = true;
+		desc->format = GetDxgiFormatTraits(textureDesc.Format);
+		desc->stagingFormat = textureDesc.Format;
+		return Status::Succeeded;
+	}
 
-	_resourceMap[resource] = NULL;
+	return Status::Error_UnsupportedFormat;
 }
 
 //-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::RequestTextureData_MainThread()
+// RendererAPI_D3D11::CreateStaging()
 //-------------------------------------------------------------------------------------------------
-Status RendererAPI_D3D11::RequestTextureData_MainThread(void* textureHandle)
+Status RendererAPI_D3D11::CreateStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot)
 {
-	// executed on main thread 
-	// prepare for render thread request that will come later
-	ID3D11Texture2D* texture = (ID3D11Texture2D*)textureHandle;
+	// create cpu texture/buffer
+	ID3D11Resource* resource;
+	if (cpuResource->isBuffer)
+		resource = CreateStagingBuffer((ID3D11Buffer*)cpuResource->gpuResource, copyRegion.width);
+	else
+		resource = CreateStagingTexture((ID3D11Resource*)cpuResource->gpuResource, copyRegion);
+
+	if (resource == NULL)
+		return Status::Error_UnknownError;
 
-	CpuResource* cpuResource = _resourceMap[texture];
-	if (cpuResource == NULL)
-	{
-		cpuResource = new CpuResource();
+	D3D11_QUERY_DESC queryDesc;
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	queryDesc.MiscFlags = 0;
 
-		// not thread safe!
-		_resourceMap[texture] = cpuResource;
+	ID3D11Query* query = NULL;
+	if (FAILED(_device->CreateQuery(&queryDesc, &query)))
+	{
+		resource->Release();
+		return Status::Error_UnknownError;
 	}
 
-	cpuResource->lastStatus = Status::NotReady;
-	cpuResource->bufferStatus = CpuResourceStatus::WaitingForGpu;
-
+	StagingResource_D3D11* staging = new StagingResource_D3D11();
+	staging->resource = resource;
+	staging->query = query;
+	slot->staging = staging;
 	return Status::Succeeded;
 }
 
 //-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::RequestTextureData_RenderThread()
+// RendererAPI_D3D11::ReleaseStaging()
 //-------------------------------------------------------------------------------------------------
-Status RendererAPI_D3D11::RequestTextureData_RenderThread(void* textureHandle)
+void RendererAPI_D3D11::ReleaseStaging(StagingResource* staging)
 {
-	ID3D11Texture2D* texture = (ID3D11Texture2D*)textureHandle;
-
-	CpuResource* cpuResource = _resourceMap[texture];
-	if (cpuResource->stagingBuffer == NULL)
-	{		
-		// create cpu texture
-		Status status = CreateStagingTexture(texture, cpuResource);
-		if (status != Status::Succeeded)
-			return status;
-	}
-
-	// not sure about this
-	// copy is already in progress
-	//if (cpuResource->bufferStatus != CpuResourceStatus::Ready)
-		//return Status::Error_CopyInProgress;
-
-	// request texture copy to cpu memory
-	cpuResource->bufferStatus = CpuResourceStatus::WaitingForGpu;
-	cpuResource->lastStatus = Status::NotReady;
-	_context->CopyResource(cpuResource->stagingBuffer, texture);
-
-    return Status::Succeeded;
+	StagingResource_D3D11* stagingD3D11 = (StagingResource_D3D11*)staging;
+	SAFE_RELEASE(stagingD3D11->query);
+	SAFE_RELEASE(stagingD3D11->resource);
+	delete stagingD3D11;
 }
 
 //-------------------------------------------------------------------------------------------------
 // RendererAPI_D3D11::CreateStagingTexture()
 //-------------------------------------------------------------------------------------------------
-Status RendererAPI_D3D11::CreateStagingTexture(ID3D11Texture2D* gpuTexture, CpuResource* cpuResource)
+ID3D11Resource* RendererAPI_D3D11::CreateStagingTexture(ID3D11Resource* gpuTexture, const CopyRegion& copyRegion)
 {
-	D3D11_TEXTURE2D_DESC desc;
-	gpuTexture->GetDesc(&desc);
-
-	// is format supported?
-	int pixelSize = GetPixelSize(desc.Format);
-	if (pixelSize == -1)
-		return Status::Error_UnsupportedFormat;
+	// staging texture holds only the copied region of one mip level.
+	// 2D slices (array slices, cube faces) become array slices of plain 2D texture, 3D slices stay depth slices.
+	// compressed textures have to be made of whole blocks
+	if (copyRegion.is3D)
+	{
+		D3D11_TEXTURE3D_DESC desc;
+		((ID3D11Texture3D*)gpuTexture)->GetDesc(&desc);
+		desc.Width = copyRegion.format.AlignWidth(copyRegion.width);
+		desc.Height = copyRegion.format.AlignHeight(copyRegion.height);
+		desc.Depth = copyRegion.sliceCount;
+		desc.MipLevels = 1;
+		desc.Usage = D3D11_USAGE_STAGING;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		desc.BindFlags = 0;
+		desc.MiscFlags = 0;
+
+		ID3D11Texture3D* texture = NULL;
+		if (FAILED(_device->CreateTexture3D(&desc, NULL, &texture)))
+			return NULL;
+
+		return texture;
+	}
 
-	int size = desc.Width * desc.Height * pixelSize;
-	
+	D3D11_TEXTURE2D_DESC desc;
+	((ID3D11Texture2D*)gpuTexture)->GetDesc(&desc);
+	desc.Width = copyRegion.format.AlignWidth(copyRegion.width);
+	desc.Height = copyRegion.format.AlignHeight(copyRegion.height);
+	desc.MipLevels = 1;
+	desc.ArraySize = copyRegion.sliceCount;
 	desc.Usage = D3D11_USAGE_STAGING;
 	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
 	desc.BindFlags = 0;
 	desc.MiscFlags = 0;
 
-	ID3D11Texture2D* cpuTexture = NULL;
-	if (FAILED(_device->CreateTexture2D(&desc, NULL, &cpuTexture)))
-	{	
-		return Status::Error_UnknownError;
-	}
+	ID3D11Texture2D* texture = NULL;
+	if (FAILED(_device->CreateTexture2D(&desc, NULL, &texture)))
+		return NULL;
 
-	cpuResource->stagingBuffer = cpuTexture;
-	cpuResource->bufferSize = size;
-	cpuResource->cpuBuffer = new byte[size];
-	
-	return Status::Succeeded;
+	return texture;
 }
 
 //-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::CopyTextureData_RenderThread()
-//-------------------------------------------------------------------------------------------------
-void RendererAPI_D3D11::CopyTextureData_RenderThread(void* textureHandle)
-{
-	ID3D11Texture2D* gpuTexture = (ID3D11Texture2D*)textureHandle;
-	CpuResource* cpuResource = _resourceMap[gpuTexture];
-
-	if (cpuResource == NULL)
-		return;
-
-	if (cpuResource->bufferStatus != CpuResourceStatus::WaitingForGpu)
-		return;
-
-	ID3D11Texture2D* cpuTexture = (ID3D11Texture2D*)cpuResource->stagingBuffer;
-	
-	D3D11_TEXTURE2D_DESC desc;
-	cpuTexture->GetDesc(&desc);
-
-	int pixelSize = GetPixelSize(desc.Format);
-	if (pixelSize == -1)
-	{
-		cpuResource->lastStatus = Status::Error_UnsupportedFormat;
-		return;
-	}
-	
-	// try to map resource
-	D3D11_MAPPED_SUBRESOURCE resource;
-	HRESULT result = _context->Map(cpuTexture, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &resource);
-	// resource is not ready, return
-	if (result == DXGI_ERROR_WAS_STILL_DRAWING)
-	{
-		cpuResource->lastStatus = Status::NotReady;
-		return;
-	}
-	// something went wrong
-	if (FAILED(result))
-	{
-		cpuResource->lastStatus = Status::Error_UnknownError;
-		return;
-	}
-
-	// copy line by line to managed memory
-	for (unsigned int row = 0; row < desc.Height; ++row)
-	{
-		char* dest = ((char*)cpuResource->cpuBuffer) + row * desc.Width * pixelSize;
-		char* src = ((char*)resource.pData) + row * resource.RowPitch;
-		memcpy(dest, src, desc.Width * pixelSize);
-	}
-
-	_context->Unmap(cpuTexture, 0);
-
-	cpuResource->bufferStatus = CpuResourceStatus::CopyFinished;
-	cpuResource->lastStatus = Status::Succeeded;
-}
-
-//-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::RetrieveTextureData_MainThread()
+// RendererAPI_D3D11::CreateStagingBuffer()
 //-------------------------------------------------------------------------------------------------
-Status RendererAPI_D3D11::RetrieveTextureData_MainThread(void* textureHandle, void* data, int dataSize)
+ID3D11Resource* RendererAPI_D3D11::CreateStagingBuffer(ID3D11Buffer* gpuBuffer, int size)
 {
-	ID3D11Texture2D* gpuTexture = (ID3D11Texture2D*)textureHandle;
-	CpuResource* cpuResource = _resourceMap[gpuTexture];
+	D3D11_BUFFER_DESC desc;
+	gpuBuffer->GetDesc(&desc);
 	
-	// texture data wasn't requested, there's nothing to retrieve
-	if (cpuResource == NULL)
-		return Status::Error_NoRequest;
-	if (cpuResource->bufferStatus == CpuResourceStatus::Ready)
-		return Status::Error_NoRequest;
-
-	if (cpuResource->bufferStatus == CpuResourceStatus::WaitingForGpu)
-		return cpuResource->lastStatus;
-
-	assert(cpuResource->bufferStatus == CpuResourceStatus::CopyFinished);
-
-	if (cpuResource->bufferSize > dataSize)
-		return Status::Error_WrongBufferSize;
+	// staging buffer holds the copied byte range rounded up to the size class of the staging pool
+	desc.ByteWidth = size;
+	desc.Usage = D3D11_USAGE_STAGING;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	desc.BindFlags = 0;
+	desc.MiscFlags = 0;
+	desc.StructureByteStride = 0;
 
-	// copy to managed mem
-	memcpy(data, cpuResource->cpuBuffer, cpuResource->bufferSize);
+	ID3D11Buffer* buffer = NULL;
+	if (FAILED(_device->CreateBuffer(&desc, NULL, &buffer)))
+		return NULL;
 
-	cpuResource->bufferStatus = CpuResourceStatus::Ready;
-	return Status::Succeeded;	
+	return buffer;
 }
 
 //-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::GetPixelSize()
+// RendererAPI_D3D11::IssueGpuCopy()
 //-------------------------------------------------------------------------------------------------
-int RendererAPI_D3D11::GetPixelSize(DXGI_FORMAT format)
+void RendererAPI_D3D11::IssueGpuCopy(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot)
 {
-	int pixelSize = -1;
-	switch (format)
+	StagingResource_D3D11* staging = (StagingResource_D3D11*)slot->staging;
+	ID3D11Resource* gpuResource = (ID3D11Resource*)cpuResource->gpuResource;
+
+	// front/back select depth slices of 3D texture
+	D3D11_BOX box;
+	box.left = copyRegion.x;
+	box.top = copyRegion.y;
+	box.front = copyRegion.is3D ? copyRegion.firstSlice : 0;
+	box.right = copyRegion.x + copyRegion.width;
+	box.bottom = copyRegion.y + copyRegion.height;
+	box.back = copyRegion.is3D ? copyRegion.firstSlice + copyRegion.sliceCount : 1;
+	const D3D11_BOX* copyBox = copyRegion.wholeSubresource ? NULL : &box;
+
+	if (cpuResource->isBuffer || copyRegion.is3D)
 	{
-	case DXGI_FORMAT_R32G32B32A32_TYPELESS:
-	case DXGI_FORMAT_R32G32B32A32_FLOAT:
-	case DXGI_FORMAT_R32G32B32A32_UINT:
-	case DXGI_FORMAT_R32G32B32A32_SINT:
-		pixelSize = 4 * 4;
-		break;
-
-	case DXGI_FORMAT_R32G32B32_TYPELESS:
-	case DXGI_FORMAT_R32G32B32_FLOAT:
-	case DXGI_FORMAT_R32G32B32_UINT:
-	case DXGI_FORMAT_R32G32B32_SINT:
-		pixelSize = 4 * 3;
-		break;
-
-	case DXGI_FORMAT_R32G32_TYPELESS:
-	case DXGI_FORMAT_R32G32_FLOAT:
-	case DXGI_FORMAT_R32G32_UINT:
-	case DXGI_FORMAT_R32G32_SINT:
-		pixelSize = 4 * 2;
-		break;
-
-	case DXGI_FORMAT_R32_TYPELESS:
-	case DXGI_FORMAT_R32_FLOAT:
-	case DXGI_FORMAT_R32_UINT:
-	case DXGI_FORMAT_R32_SINT:
-		pixelSize = 4 * 1;
-		break;
-
-	case DXGI_FORMAT_R8G8B8A8_TYPELESS:
-	case DXGI_FORMAT_R8G8B8A8_UNORM:
-	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
-	case DXGI_FORMAT_R8G8B8A8_UINT:
-	case DXGI_FORMAT_R8G8B8A8_SINT:
-	case DXGI_FORMAT_R8G8B8A8_SNORM:
-		pixelSize = 4 * 1;
-		break;
-
-	default:
-		pixelSize = -1;
+		// buffer range or block of 3D texture slices is a single subresource
+		UINT subresource = D3D11CalcSubresource(copyRegion.mipLevel, 0, copyRegion.mipLevels);
+		_context->CopySubresourceRegion(staging->resource, 0, 0, 0, 0, gpuResource, subresource, copyBox);
 	}
-
-	return pixelSize;
-}
-
-//-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::RequestBufferData_MainThread()
-//-------------------------------------------------------------------------------------------------
-Status RendererAPI_D3D11::RequestBufferData_MainThread(void* bufferHandle)
-{
-	// executed on main thread 
-	// prepare for render thread request that will come later
-	ID3D11Buffer* buffer = (ID3D11Buffer*)bufferHandle;
-
-	CpuResource* cpuResource = _resourceMap[buffer];
-	if (cpuResource == NULL)
+	else
 	{
-		cpuResource = new CpuResource();	
-
-		// not thread safe, will have to do for now...
-		_resourceMap[buffer] = cpuResource;
+		// every array slice/cube face is separate subresource, staging texture has one array slice for each of them
+		for (int i = 0; i < copyRegion.sliceCount; ++i)
+		{
+			UINT subresource = D3D11CalcSubresource(copyRegion.mipLevel, copyRegion.firstSlice + i, copyRegion.mipLevels);
+			_context->CopySubresourceRegion(staging->resource, i, 0, 0, 0, gpuResource, subresource, copyBox);
+		}
 	}
 
-	cpuResource->bufferStatus = CpuResourceStatus::WaitingForGpu;
-	cpuResource->lastStatus = Status::NotReady;
-
-	return Status::Succeeded;
+	// query is signaled after the copy, render thread polls it instead of trying to map the staging copy
+	_context->End(staging->query);
+	staging->flushed = false;
 }
 
 //-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::RequestBufferData_RenderThread()
+// RendererAPI_D3D11::QueryCompletion()
 //-------------------------------------------------------------------------------------------------
-Status RendererAPI_D3D11::RequestBufferData_RenderThread(void* bufferHandle)
+Status RendererAPI_D3D11::QueryCompletion(StagingSlot* slot)
 {
-	ID3D11Buffer* buffer = (ID3D11Buffer*)bufferHandle;
-
-	CpuResource* cpuResource = _resourceMap[buffer];
-	if (cpuResource->stagingBuffer == NULL)
-	{
-		// create cpu buffer
-		Status status = CreateStagingBuffer(buffer, cpuResource);
-		if (status != Status::Succeeded)
-			return status;
-	}
+	// first poll flushes the context so the copy gets to gpu, following polls don't flush again
+	StagingResource_D3D11* staging = (StagingResource_D3D11*)slot->staging;
+	HRESULT result = _context->GetData(staging->query, NULL, 0, staging->flushed ? D3D11_ASYNC_GETDATA_DONOTFLUSH : 0);
+	staging->flushed = true;
 
-	// not sure about this
-	// copy is already in progress
-	//if (cpuResource->bufferStatus != CpuResourceStatus::Ready)
-	//return Status::Error_CopyInProgress;
+	if (result == S_FALSE)
+		return Status::NotReady;
 
-	// request buffer copy to cpu memory
-	cpuResource->bufferStatus = CpuResourceStatus::WaitingForGpu;
-	cpuResource->lastStatus = Status::NotReady;
-	_context->CopyResource(cpuResource->stagingBuffer, buffer);
-
-	return Status::Succeeded;
+	return SUCCEEDED(result) ? Status::Succeeded : Status::Error_UnknownError;
 }
 
 //-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::CreateStagingBuffer()
+// RendererAPI_D3D11::MapStaging()
 //-------------------------------------------------------------------------------------------------
-Status RendererAPI_D3D11::CreateStagingBuffer(ID3D11Buffer* gpuBuffer, CpuResource* cpuResource)
+Status RendererAPI_D3D11::MapStaging(StagingSlot* slot)
 {
-	D3D11_BUFFER_DESC desc;
-	gpuBuffer->GetDesc(&desc);
-	
-	desc.Usage = D3D11_USAGE_STAGING;
-	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-	desc.BindFlags = 0;
-	desc.MiscFlags = 0;
-
-	ID3D11Buffer* cpuBuffer = NULL;
-	if (FAILED(_device->CreateBuffer(&desc, NULL, &cpuBuffer)))
+	// 2D staging texture has one subresource per slice, buffer and 3D staging texture have all data in one
+	StagingResource_D3D11* staging = (StagingResource_D3D11*)slot->staging;
+	D3D11_RESOURCE_DIMENSION dimension;
+	staging->resource->GetType(&dimension);
+	int subresources = dimension == D3D11_RESOURCE_DIMENSION_TEXTURE2D ? slot->stagingSlices : 1;
+
+	slot->mapped.resize(subresources);
+	for (int subresource = 0; subresource < subresources; ++subresource)
 	{
-		return Status::Error_UnknownError;
-	}
-
-	int size = desc.ByteWidth;
-		
-	cpuResource->stagingBuffer = cpuBuffer;
-	cpuResource->bufferSize = size;
-	cpuResource->cpuBuffer = new byte[size];
-	return Status::Succeeded;
-}
-
-//-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::CopyBufferData_RenderThread()
-//-------------------------------------------------------------------------------------------------
-void RendererAPI_D3D11::CopyBufferData_RenderThread(void* bufferHandle)
-{
-	ID3D11Buffer* gpuBuffer = (ID3D11Buffer*)bufferHandle;
-	CpuResource* cpuResource = _resourceMap[gpuBuffer];
-
-	if (cpuResource == NULL)
-		return;
+		// copy is already finished, map doesn't stall
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		HRESULT result = _context->Map(staging->resource, subresource, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+		if (FAILED(result))
+		{
+			// resource is not ready, all subresources are mapped again next time
+			for (int i = 0; i < subresource; ++i)
+				_context->Unmap(staging->resource, i);
+			slot->mapped.clear();
 
-	if (cpuResource->bufferStatus != CpuResourceStatus::WaitingForGpu)
-		return;
+			return result == DXGI_ERROR_WAS_STILL_DRAWING ? Status::NotReady : Status::Error_UnknownError;
+		}
 
-	ID3D11Buffer* cpuBuffer = (ID3D11Buffer*)cpuResource->stagingBuffer;
-	
-	D3D11_MAPPED_SUBRESOURCE resource;
-	HRESULT result = _context->Map(cpuBuffer, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &resource);
-	// buffer isn't ready yet, return
-	if (result == DXGI_ERROR_WAS_STILL_DRAWING)
-	{
-		cpuResource->lastStatus = Status::NotReady;
-		return;
-	}
-	if (FAILED(result))
-	{
-		cpuResource->lastStatus = Status::Error_UnknownError;
-		return;
+		slot->mapped[subresource].data = mapped.pData;
+		slot->mapped[subresource].rowPitch = mapped.RowPitch;
+		slot->mapped[subresource].depthPitch = mapped.DepthPitch;
 	}
 
-	// copy to sys mem
-	memcpy(cpuResource->cpuBuffer, resource.pData, cpuResource->bufferSize);
+	// buffer is one row of bytes
+	if (dimension == D3D11_RESOURCE_DIMENSION_BUFFER)
+		slot->mapped[0].rowPitch = slot->bufferSize;
 
-	_context->Unmap(cpuBuffer, 0);
-
-	cpuResource->bufferStatus = CpuResourceStatus::CopyFinished;
-	cpuResource->lastStatus = Status::Succeeded;
+	return Status::Succeeded;
 }
 
 //-------------------------------------------------------------------------------------------------
-// RendererAPI_D3D11::RetrieveBufferData_MainThread()
+// RendererAPI_D3D11::UnmapStaging()
 //-------------------------------------------------------------------------------------------------
-Status RendererAPI_D3D11::RetrieveBufferData_MainThread(void* bufferHandle, void* data, int dataSize)
+void RendererAPI_D3D11::UnmapStaging(StagingSlot* slot)
 {
-	ID3D11Buffer* gpuBuffer = (ID3D11Buffer*)bufferHandle;
-	CpuResource* cpuResource = _resourceMap[gpuBuffer];
-
-	// texture data wasn't requested, there's nothing to retrieve
-	if (cpuResource == NULL)
-		return Status::Error_NoRequest;
-	if(cpuResource->bufferStatus == CpuResourceStatus::Ready)
-		return Status::Error_NoRequest;
-
-	if (cpuResource->bufferStatus == CpuResourceStatus::WaitingForGpu)
-		return cpuResource->lastStatus;
+	StagingResource_D3D11* staging = (StagingResource_D3D11*)slot->staging;
+	for (size_t subresource = 0; subresource < slot->mapped.size(); ++subresource)
+		_context->Unmap(staging->resource, (UINT)subresource);
 
-	assert(cpuResource->bufferStatus == CpuResourceStatus::CopyFinished);
-	
-	if (cpuResource->bufferSize > dataSize)
-		return Status::Error_WrongBufferSize;
-		
-	// copy to managed mem
-	memcpy(data, cpuResource->cpuBuffer, cpuResource->bufferSize);
-
-	cpuResource->bufferStatus = CpuResourceStatus::Ready;
-	return Status::Succeeded;
+	slot->mapped.clear();
 }
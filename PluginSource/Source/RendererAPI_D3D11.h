@@ -27,41 +27,33 @@
 
 #pragma once
 
-#include "RendererAPI.h"
+#include "RendererAPI_Staging.h"
 #include "PlatformBase.h"
-#include <atomic>
 
 #if SUPPORT_D3D11
 
 #include <d3d11.h>
-#include <map>
 #include "Unity/IUnityGraphicsD3D11.h"
-
-enum class CpuResourceStatus
-{
-	Ready,
-	WaitingForGpu,
-	CopyFinished
-};
+#include "FormatTraits_D3D11.h"
 
 //-------------------------------------------------------------------------------------------------
-// CpuResource
+// StagingResource_D3D11
 //-------------------------------------------------------------------------------------------------
-struct CpuResource
+struct StagingResource_D3D11 : public StagingResource
 {
-	ID3D11Resource* stagingBuffer;
-	void* cpuBuffer;
-	int bufferSize;
-	std::atomic<CpuResourceStatus> bufferStatus;
-	std::atomic<Status> lastStatus;
+	ID3D11Resource* resource;
+	// event query issued right after the copy, it is signaled once gpu finishes the copy
+	ID3D11Query* query;
+	// GetData flushes the context only on the first poll after the copy
+	bool flushed;
 
-	CpuResource() : stagingBuffer(NULL), cpuBuffer(NULL), bufferSize(0), bufferStatus(CpuResourceStatus::Ready) {}
+	StagingResource_D3D11() : resource(NULL), query(NULL), flushed(false) {}
 };
 
 //-------------------------------------------------------------------------------------------------
 // RendererAPI_D3D11
 //-------------------------------------------------------------------------------------------------
-class RendererAPI_D3D11 : public RendererAPI
+class RendererAPI_D3D11 : public RendererAPI_Staging
 {
 public:
     RendererAPI_D3D11();
@@ -69,33 +61,22 @@ public:
 
     virtual void ProcessDeviceEvent(UnityGfxDeviceEventType eventType, IUnityInterfaces* interfaces);
 
-	virtual Status RequestTextureData_MainThread(void* textureHandle);
-    virtual Status RequestTextureData_RenderThread(void* textureHandle);
-	virtual void CopyTextureData_RenderThread(void* textureHandle);
-    virtual Status RetrieveTextureData_MainThread(void* textureHandle, void* data, int dataSize);
-
-	virtual Status RequestBufferData_MainThread(void* bufferHandle);
-	virtual Status RequestBufferData_RenderThread(void* bufferHandle);
-	virtual void CopyBufferData_RenderThread(void* textureHandle);
-	virtual Status RetrieveBufferData_MainThread(void* bufferHandle, void* data, int dataSize);
-
-	virtual void ReleaseTempResources(void* resourceHandle);
+protected:
+	virtual Status DescribeResource(CpuResource* cpuResource, ResourceDesc* desc);
+	virtual Status CreateStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot);
+	virtual void ReleaseStaging(StagingResource* staging);
+	virtual void IssueGpuCopy(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot);
+	virtual Status QueryCompletion(StagingSlot* slot);
+	virtual Status MapStaging(StagingSlot* slot);
+	virtual void UnmapStaging(StagingSlot* slot);
 
 private:
-	void ReleaseResources();
-	Status CreateStagingTexture(ID3D11Texture2D* gpuTexture, CpuResource* cpuResource);
-	Status CreateStagingBuffer(ID3D11Buffer* gpuTexture, CpuResource* cpuResource);
-	int GetPixelSize(DXGI_FORMAT format);
+	ID3D11Resource* CreateStagingTexture(ID3D11Resource* gpuTexture, const CopyRegion& copyRegion);
+	ID3D11Resource* CreateStagingBuffer(ID3D11Buffer* gpuBuffer, int size);
 
 private:
-	// std::map<gpu resource, cpu resource>
-	typedef std::map<ID3D11Resource*, CpuResource*> ResourceMap;
-	typedef ResourceMap::iterator TextureMapIter;
-
     ID3D11Device* _device;
 	ID3D11DeviceContext* _context;
-	
-	ResourceMap _resourceMap;
 };
 
 //-------------------------------------------------------------------------------------------------
@@ -0,0 +1,510 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "RendererAPI_GL.h"
+
+#if SUPPORT_OPENGL_CORE_BACKEND
+
+#include <stdint.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------------------------------
+// BufferBindingScope
+//-------------------------------------------------------------------------------------------------
+// binds buffer to the target and restores previous binding, Unity caches its own bindings
+class BufferBindingScope
+{
+public:
+	BufferBindingScope(GLenum target, GLenum binding, GLuint buffer) : _target(target), _previous(0)
+	{
+		glGetIntegerv(binding, &_previous);
+		glBindBuffer(target, buffer);
+	}
+
+	~BufferBindingScope()
+	{
+		glBindBuffer(_target, (GLuint)_previous);
+	}
+
+private:
+	GLenum _target;
+	GLint _previous;
+};
+
+//-------------------------------------------------------------------------------------------------
+// PackStateScope
+//-------------------------------------------------------------------------------------------------
+// tightly packed rows in pixel pack buffer regardless of pack state set by Unity
+class PackStateScope
+{
+public:
+	PackStateScope()
+	{
+		for (int i = 0; i < kParameterCount; ++i)
+		{
+			glGetIntegerv(kParameters[i], &_previous[i]);
+			glPixelStorei(kParameters[i], kParameters[i] == GL_PACK_ALIGNMENT ? 1 : 0);
+		}
+	}
+
+	~PackStateScope()
+	{
+		for (int i = 0; i < kParameterCount; ++i)
+			glPixelStorei(kParameters[i], _previous[i]);
+	}
+
+private:
+	static const int kParameterCount = 6;
+	static const GLenum kParameters[kParameterCount];
+	GLint _previous[kParameterCount];
+};
+
+const GLenum PackStateScope::kParameters[PackStateScope::kParameterCount] = 
+{ 
+	GL_PACK_ALIGNMENT, GL_PACK_ROW_LENGTH, GL_PACK_IMAGE_HEIGHT, GL_PACK_SKIP_PIXELS, GL_PACK_SKIP_ROWS, GL_PACK_SKIP_IMAGES
+};
+
+// readable texture targets and their binding queries, multisampled textures can't be read
+static const GLenum kTextureTargets[][2] =
+{
+	{ GL_TEXTURE_2D,				GL_TEXTURE_BINDING_2D },
+	{ GL_TEXTURE_2D_ARRAY,			GL_TEXTURE_BINDING_2D_ARRAY },
+	{ GL_TEXTURE_CUBE_MAP,			GL_TEXTURE_BINDING_CUBE_MAP },
+	{ GL_TEXTURE_3D,				GL_TEXTURE_BINDING_3D },
+	{ GL_TEXTURE_CUBE_MAP_ARRAY,	GL_TEXTURE_BINDING_CUBE_MAP_ARRAY },
+};
+
+//-------------------------------------------------------------------------------------------------
+// ClearErrors
+//-------------------------------------------------------------------------------------------------
+static void ClearErrors()
+{
+	// errors raised before the plugin event are dropped, probes below need clean error state
+	for (int i = 0; i < 16 && glGetError() != GL_NO_ERROR; ++i)
+	{
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// GetObjectName
+//-------------------------------------------------------------------------------------------------
+static GLuint GetObjectName(void* nativeResource)
+{
+	// native pointer of GL texture/buffer is its name
+	return (GLuint)(uintptr_t)nativeResource;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::RendererAPI_GL()
+//-------------------------------------------------------------------------------------------------
+RendererAPI_GL::RendererAPI_GL()
+	: _capsInitialized(false), _bufferStorage(false), _textureSubImage(false), _readFramebuffer(0)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::~RendererAPI_GL()
+//-------------------------------------------------------------------------------------------------
+RendererAPI_GL::~RendererAPI_GL()
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::ProcessDeviceEvent()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_GL::ProcessDeviceEvent(UnityGfxDeviceEventType eventType, IUnityInterfaces* interfaces)
+{
+	if (eventType == kUnityGfxDeviceEventShutdown)
+	{
+		ReleaseResources();
+		if (_readFramebuffer != 0)
+			glDeleteFramebuffers(1, &_readFramebuffer);
+		_readFramebuffer = 0;
+		_capsInitialized = false;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::InitializeCaps()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_GL::InitializeCaps()
+{
+	_capsInitialized = true;
+
+#if UNITY_OSX
+	// macOS stops at GL 4.1, staging buffers are mapped on demand and textures are read through framebuffer
+	_bufferStorage = false;
+	_textureSubImage = false;
+#else
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	int version = major * 10 + minor;
+	_bufferStorage = version >= 44;
+	_textureSubImage = version >= 45;
+
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (GLint i = 0; i < extensionCount; ++i)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension == NULL)
+			continue;
+
+		if (strcmp(extension, "GL_ARB_buffer_storage") == 0)
+			_bufferStorage = true;
+		else if (strcmp(extension, "GL_ARB_get_texture_sub_image") == 0)
+			_textureSubImage = true;
+	}
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::DescribeTexture()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_GL::DescribeTexture(GLuint texture, TextureDesc_GL* desc)
+{
+	if (!glIsTexture(texture))
+		return Status::Error_InvalidArguments;
+
+	// texture name doesn't tell its target, binding it to other target than it was created with fails.
+	// texture is bound to the active texture unit only for the queries, previous binding is restored
+	ClearErrors();
+	for (size_t i = 0; i < sizeof(kTextureTargets) / sizeof(kTextureTargets[0]); ++i)
+	{
+		GLenum target = kTextureTargets[i][0];
+		GLint previous = 0;
+		glGetIntegerv(kTextureTargets[i][1], &previous);
+		glBindTexture(target, texture);
+		if (glGetError() != GL_NO_ERROR)
+			continue;
+
+		// level parameters of cube map are queried per face, all faces are the same
+		GLenum levelTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+		GLint internalFormat = 0;
+		GLint width = 0;
+		GLint height = 0;
+		GLint depth = 0;
+		GLint maxLevel = 0;
+		glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+		glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_DEPTH, &depth);
+		glGetTexParameteriv(target, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+
+		// mutable textures can have fewer levels than the full chain, undefined levels have zero size
+		int largest = width > height ? width : height;
+		if (target == GL_TEXTURE_3D && depth > largest)
+			largest = depth;
+
+		int mipLevels = 1;
+		while (mipLevels <= maxLevel && (largest >> mipLevels) > 0)
+		{
+			GLint levelWidth = 0;
+			glGetTexLevelParameteriv(levelTarget, mipLevels, GL_TEXTURE_WIDTH, &levelWidth);
+			if (levelWidth == 0)
+				break;
+			++mipLevels;
+		}
+
+		glBindTexture(target, (GLuint)previous);
+
+		desc->target = target;
+		desc->format = FindGLFormat((GLenum)internalFormat);
+		desc->width = width;
+		desc->height = height;
+		desc->slices = target == GL_TEXTURE_CUBE_MAP ? 6 : depth;
+		desc->mipLevels = mipLevels;
+		return width > 0 && height > 0 ? Status::Succeeded : Status::Error_InvalidArguments;
+	}
+
+	return Status::Error_UnsupportedFormat;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::DescribeResource()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_GL::DescribeResource(CpuResource* cpuResource, ResourceDesc* desc)
+{
+	if (!_capsInitialized)
+		InitializeCaps();
+
+	GLuint name = GetObjectName(cpuResource->gpuResource);
+	if (cpuResource->isBuffer)
+	{
+		if (!glIsBuffer(name))
+			return Status::Error_InvalidArguments;
+
+		BufferBindingScope binding(GL_COPY_READ_BUFFER, GL_COPY_READ_BUFFER_BINDING, name);
+		GLint size = 0;
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+		desc->width = size;
+		return Status::Succeeded;
+	}
+
+	TextureDesc_GL textureDesc;
+	Status status = DescribeTexture(name, &textureDesc);
+	if (status != Status::Succeeded)
+		return status;
+
+	desc->width = textureDesc.width;
+	desc->height = textureDesc.height;
+	desc->slices = textureDesc.slices;
+	desc->mipLevels = textureDesc.mipLevels;
+	desc->is3D = textureDesc.target == GL_TEXTURE_3D;
+	desc->format = textureDesc.format != NULL ? textureDesc.format->traits : kUnsupportedFormat;
+	// staging copy keeps target and pixel transfer format of the texture it was created for
+	desc->stagingFormat = textureDesc.format != NULL ? ((int)(textureDesc.format - kGLFormats) << 16) | (int)(textureDesc.target & 0xffff) : 0;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::CreateStaging()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_GL::CreateStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot)
+{
+	StagingResource_GL* staging = new StagingResource_GL();
+	if (!cpuResource->isBuffer)
+	{
+		// pixel transfer format is resolved once, texture keeps its format for its whole life
+		TextureDesc_GL textureDesc;
+		Status status = DescribeTexture(GetObjectName(cpuResource->gpuResource), &textureDesc);
+		if (status != Status::Succeeded || textureDesc.format == NULL)
+		{
+			delete staging;
+			return status != Status::Succeeded ? status : Status::Error_UnsupportedFormat;
+		}
+
+		staging->target = textureDesc.target;
+		staging->format = textureDesc.format->format;
+		staging->type = textureDesc.format->type;
+	}
+
+	// rows are tightly packed, pack alignment is 1 during the read
+	staging->rowPitch = copyRegion.format.RowPitch(copyRegion.width);
+	staging->slicePitch = staging->rowPitch * copyRegion.format.RowCount(copyRegion.height);
+	staging->size = staging->slicePitch * copyRegion.sliceCount;
+	staging->subresources = cpuResource->isBuffer || copyRegion.is3D ? 1 : copyRegion.sliceCount;
+
+	glGenBuffers(1, &staging->buffer);
+	BufferBindingScope binding(GL_PIXEL_PACK_BUFFER, GL_PIXEL_PACK_BUFFER_BINDING, staging->buffer);
+	ClearErrors();
+
+#if !UNITY_OSX
+	if (_bufferStorage)
+	{
+		// immutable storage in client memory stays mapped, coherent mapping sees the data once fence is signaled
+		const GLbitfield mapFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_PIXEL_PACK_BUFFER, staging->size, NULL, mapFlags | GL_CLIENT_STORAGE_BIT);
+		staging->persistentData = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, staging->size, mapFlags);
+	}
+	else
+#endif
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, staging->size, NULL, GL_STREAM_READ);
+	}
+
+	if (glGetError() != GL_NO_ERROR || (_bufferStorage && staging->persistentData == NULL))
+	{
+		ReleaseStaging(staging);
+		return Status::Error_UnknownError;
+	}
+
+	slot->staging = staging;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::ReleaseStaging()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_GL::ReleaseStaging(StagingResource* staging)
+{
+	// deleting the buffer unmaps it, GL keeps it alive until pending read finishes
+	StagingResource_GL* stagingGL = (StagingResource_GL*)staging;
+	if (stagingGL->fence != NULL)
+		glDeleteSync(stagingGL->fence);
+	if (stagingGL->buffer != 0)
+		glDeleteBuffers(1, &stagingGL->buffer);
+
+	delete stagingGL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::IssueGpuCopy()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_GL::IssueGpuCopy(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot)
+{
+	StagingResource_GL* staging = (StagingResource_GL*)slot->staging;
+	GLuint name = GetObjectName(cpuResource->gpuResource);
+
+	if (cpuResource->isBuffer)
+	{
+		BufferBindingScope readBinding(GL_COPY_READ_BUFFER, GL_COPY_READ_BUFFER_BINDING, name);
+		BufferBindingScope writeBinding(GL_COPY_WRITE_BUFFER, GL_COPY_WRITE_BUFFER_BINDING, staging->buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, copyRegion.x, 0, copyRegion.width);
+	}
+	else
+	{
+		// with pixel pack buffer bound the read is queued on gpu and returns immediately
+		BufferBindingScope binding(GL_PIXEL_PACK_BUFFER, GL_PIXEL_PACK_BUFFER_BINDING, staging->buffer);
+		PackStateScope packState;
+
+#if !UNITY_OSX
+		if (_textureSubImage)
+		{
+			// layers, cube faces and depth slices are all addressed by z
+			glGetTextureSubImage(name, copyRegion.mipLevel, copyRegion.x, copyRegion.y, copyRegion.firstSlice, copyRegion.width, copyRegion.height, 
+				copyRegion.sliceCount, staging->format, staging->type, staging->size, NULL);
+		}
+		else
+#endif
+		{
+			ReadFramebuffer(name, copyRegion, staging);
+		}
+	}
+
+	// fence is signaled after the read, render thread polls it instead of mapping the buffer
+	if (staging->fence != NULL)
+		glDeleteSync(staging->fence);
+	staging->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	staging->flushed = false;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::ReadFramebuffer()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_GL::ReadFramebuffer(GLuint texture, const CopyRegion& copyRegion, StagingResource_GL* staging)
+{
+	// every slice is attached to read framebuffer and read by glReadPixels
+	if (_readFramebuffer == 0)
+		glGenFramebuffers(1, &_readFramebuffer);
+
+	GLint previous = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, _readFramebuffer);
+
+	GLenum attachment = staging->format == GL_DEPTH_COMPONENT ? GL_DEPTH_ATTACHMENT : staging->format == GL_DEPTH_STENCIL ? GL_DEPTH_STENCIL_ATTACHMENT : GL_COLOR_ATTACHMENT0;
+	glReadBuffer(attachment == GL_COLOR_ATTACHMENT0 ? GL_COLOR_ATTACHMENT0 : GL_NONE);
+
+	for (int i = 0; i < copyRegion.sliceCount; ++i)
+	{
+		int slice = copyRegion.firstSlice + i;
+		if (staging->target == GL_TEXTURE_2D)
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, copyRegion.mipLevel);
+		else if (staging->target == GL_TEXTURE_CUBE_MAP)
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_CUBE_MAP_POSITIVE_X + slice, texture, copyRegion.mipLevel);
+		else
+			glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, attachment, texture, copyRegion.mipLevel, slice);
+
+		glReadPixels(copyRegion.x, copyRegion.y, copyRegion.width, copyRegion.height, staging->format, staging->type, 
+			(void*)((size_t)i * staging->slicePitch));
+	}
+
+	// framebuffer doesn't keep the texture alive after the read
+	glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previous);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::QueryCompletion()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_GL::QueryCompletion(StagingSlot* slot)
+{
+	StagingResource_GL* staging = (StagingResource_GL*)slot->staging;
+	if (staging->fence == NULL)
+		return Status::Succeeded;
+
+	// first poll flushes the commands so the fence gets to gpu, following polls don't flush again
+	GLenum result = glClientWaitSync(staging->fence, staging->flushed ? 0 : GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	staging->flushed = true;
+
+	if (result == GL_TIMEOUT_EXPIRED)
+		return Status::NotReady;
+
+	if (result == GL_WAIT_FAILED)
+		return Status::Error_UnknownError;
+
+	glDeleteSync(staging->fence);
+	staging->fence = NULL;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::MapStaging()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_GL::MapStaging(StagingSlot* slot)
+{
+	StagingResource_GL* staging = (StagingResource_GL*)slot->staging;
+	char* data = (char*)staging->persistentData;
+	if (data == NULL)
+	{
+		// read is already finished, map doesn't stall
+		BufferBindingScope binding(GL_PIXEL_PACK_BUFFER, GL_PIXEL_PACK_BUFFER_BINDING, staging->buffer);
+		data = (char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, staging->size, GL_MAP_READ_BIT);
+		if (data == NULL)
+			return Status::Error_UnknownError;
+	}
+
+	int slicesPerSubresource = slot->stagingSlices / staging->subresources;
+	slot->mapped.resize(staging->subresources);
+	for (int subresource = 0; subresource < staging->subresources; ++subresource)
+	{
+		slot->mapped[subresource].data = data + (size_t)subresource * slicesPerSubresource * staging->slicePitch;
+		slot->mapped[subresource].rowPitch = staging->rowPitch;
+		slot->mapped[subresource].depthPitch = staging->slicePitch;
+	}
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL::UnmapStaging()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_GL::UnmapStaging(StagingSlot* slot)
+{
+	// persistent mapping stays until the staging buffer is deleted
+	StagingResource_GL* staging = (StagingResource_GL*)slot->staging;
+	if (staging->persistentData == NULL && !slot->mapped.empty())
+	{
+		BufferBindingScope binding(GL_PIXEL_PACK_BUFFER, GL_PIXEL_PACK_BUFFER_BINDING, staging->buffer);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	slot->mapped.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CreateRendererAPI_GL
+//-------------------------------------------------------------------------------------------------
+RendererAPI* CreateRendererAPI_GL()
+{
+	return new RendererAPI_GL();
+}
+
+#endif // SUPPORT_OPENGL_CORE_BACKEND
@@ -0,0 +1,116 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "RendererAPI_Staging.h"
+#include "PlatformBase.h"
+
+#if SUPPORT_OPENGL_CORE_BACKEND
+
+#include "FormatTraits_GL.h"
+
+//-------------------------------------------------------------------------------------------------
+// StagingResource_GL
+//-------------------------------------------------------------------------------------------------
+struct StagingResource_GL : public StagingResource
+{
+	// pixel pack buffer the region is read to, slices are tightly packed one after another
+	GLuint buffer;
+	// fence inserted right after the read, deleted once it is signaled
+	GLsync fence;
+	// persistent mapping of buffer when buffer storage is available
+	void* persistentData;
+	int size;
+	int rowPitch;
+	int slicePitch;
+	// one per 2D slice, single one for buffers and 3D textures
+	int subresources;
+	// texture target and pixel transfer format/type of the read, resolved when the staging copy is created
+	GLenum target;
+	GLenum format;
+	GLenum type;
+	// first poll flushes the command stream so the fence gets signaled
+	bool flushed;
+
+	StagingResource_GL() : buffer(0), fence(NULL), persistentData(NULL), size(0), rowPitch(0), slicePitch(0), subresources(0), target(0), format(0), type(0), flushed(false) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// TextureDesc_GL
+//-------------------------------------------------------------------------------------------------
+struct TextureDesc_GL
+{
+	GLenum target;
+	const GLFormatEntry* format;
+	int width;
+	int height;
+	// array layers (layer-faces of cube map arrays, 6 faces of cube map), depth of 3D texture
+	int slices;
+	int mipLevels;
+};
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_GL
+//-------------------------------------------------------------------------------------------------
+// OpenGL core profile backend. native resources are texture/buffer names, regions are read to pixel pack 
+// buffers and fence sync tells when the read finished. rows come in GL order, first row is the bottom one
+class RendererAPI_GL : public RendererAPI_Staging
+{
+public:
+	RendererAPI_GL();
+	virtual ~RendererAPI_GL();
+
+	virtual void ProcessDeviceEvent(UnityGfxDeviceEventType eventType, IUnityInterfaces* interfaces);
+
+protected:
+	virtual Status DescribeResource(CpuResource* cpuResource, ResourceDesc* desc);
+	virtual Status CreateStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot);
+	virtual void ReleaseStaging(StagingResource* staging);
+	virtual void IssueGpuCopy(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot);
+	virtual Status QueryCompletion(StagingSlot* slot);
+	virtual Status MapStaging(StagingSlot* slot);
+	virtual void UnmapStaging(StagingSlot* slot);
+
+private:
+	void InitializeCaps();
+	Status DescribeTexture(GLuint texture, TextureDesc_GL* desc);
+	void ReadFramebuffer(GLuint texture, const CopyRegion& copyRegion, StagingResource_GL* staging);
+
+private:
+	// caps are queried on render thread where the context is current, device initialization can run elsewhere
+	bool _capsInitialized;
+	// GL 4.4 or ARB_buffer_storage, staging buffers stay mapped for their whole life
+	bool _bufferStorage;
+	// GL 4.5 or ARB_get_texture_sub_image, region is read directly from the texture without framebuffer
+	bool _textureSubImage;
+	// framebuffer the texture is attached to when glGetTextureSubImage isn't available
+	GLuint _readFramebuffer;
+};
+
+#endif // SUPPORT_OPENGL_CORE_BACKEND
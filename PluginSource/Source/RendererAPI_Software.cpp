@@ -0,0 +1,441 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "RendererAPI_Software.h"
+
+#if SUPPORT_SOFTWARE
+
+#include <mutex>
+#include <set>
+#include <thread>
+
+// simulated gpu state shared by every RendererAPI_Software and the host
+static std::mutex sDeviceMutex;
+static SoftwareDeviceConfig sDeviceConfig;
+static std::set<SoftwareResource*> sResources;
+static std::atomic<unsigned int> sFrame(0);
+
+//-------------------------------------------------------------------------------------------------
+// MipSize
+//-------------------------------------------------------------------------------------------------
+static int MipSize(int size, int mipLevel)
+{
+	size >>= mipLevel;
+	return size > 0 ? size : 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SoftwareResource::MipWidth()
+//-------------------------------------------------------------------------------------------------
+int SoftwareResource::MipWidth(int mipLevel) const
+{
+	return MipSize(width, mipLevel);
+}
+
+//-------------------------------------------------------------------------------------------------
+// SoftwareResource::MipHeight()
+//-------------------------------------------------------------------------------------------------
+int SoftwareResource::MipHeight(int mipLevel) const
+{
+	return MipSize(height, mipLevel);
+}
+
+//-------------------------------------------------------------------------------------------------
+// SoftwareResource::MipSlices()
+//-------------------------------------------------------------------------------------------------
+int SoftwareResource::MipSlices(int mipLevel) const
+{
+	// depth of 3D texture gets smaller with every mip level, array size stays the same
+	return is3D ? MipSize(slices, mipLevel) : slices;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SoftwareResource::CreateTexture()
+//-------------------------------------------------------------------------------------------------
+SoftwareResource* SoftwareResource::CreateTexture(int width, int height, int slices, int mipLevels, bool is3D, const FormatTraits& format)
+{
+	if (width <= 0 || height <= 0 || slices <= 0 || mipLevels <= 0 || !format.IsSupported())
+		return NULL;
+
+	SoftwareResource* resource = new SoftwareResource();
+	resource->isBuffer = false;
+	resource->width = width;
+	resource->height = height;
+	resource->slices = slices;
+	resource->mipLevels = mipLevels;
+	resource->is3D = is3D;
+	resource->format = format;
+	resource->mips.resize(mipLevels);
+	for (int mip = 0; mip < mipLevels; ++mip)
+		resource->mips[mip].resize((size_t)resource->SlicePitch(mip) * resource->MipSlices(mip));
+
+	std::lock_guard<std::mutex> lock(sDeviceMutex);
+	sResources.insert(resource);
+	return resource;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SoftwareResource::CreateBuffer()
+//-------------------------------------------------------------------------------------------------
+SoftwareResource* SoftwareResource::CreateBuffer(int size)
+{
+	if (size <= 0)
+		return NULL;
+
+	// buffer is a texture with one row of bytes
+	SoftwareResource* resource = new SoftwareResource();
+	resource->isBuffer = true;
+	resource->width = size;
+	resource->height = 1;
+	resource->slices = 1;
+	resource->mipLevels = 1;
+	resource->is3D = false;
+	resource->format = RawTraits(1, ComponentType::Typeless);
+	resource->mips.resize(1);
+	resource->mips[0].resize(size);
+
+	std::lock_guard<std::mutex> lock(sDeviceMutex);
+	sResources.insert(resource);
+	return resource;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SoftwareResource::Release()
+//-------------------------------------------------------------------------------------------------
+void SoftwareResource::Release(SoftwareResource* resource)
+{
+	{
+		std::lock_guard<std::mutex> lock(sDeviceMutex);
+		if (sResources.erase(resource) == 0)
+			return;
+	}
+
+	delete resource;
+}
+
+//-------------------------------------------------------------------------------------------------
+// SoftwareResource::IsValid()
+//-------------------------------------------------------------------------------------------------
+bool SoftwareResource::IsValid(void* resource, bool isBuffer)
+{
+	std::lock_guard<std::mutex> lock(sDeviceMutex);
+	std::set<SoftwareResource*>::const_iterator it = sResources.find((SoftwareResource*)resource);
+	return it != sResources.end() && (*it)->isBuffer == isBuffer;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::RendererAPI_Software()
+//-------------------------------------------------------------------------------------------------
+RendererAPI_Software::RendererAPI_Software()
+	: _createCount(0), _mapCount(0)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::~RendererAPI_Software()
+//-------------------------------------------------------------------------------------------------
+RendererAPI_Software::~RendererAPI_Software()
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::SetDeviceConfig()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Software::SetDeviceConfig(const SoftwareDeviceConfig& config)
+{
+	std::lock_guard<std::mutex> lock(sDeviceMutex);
+	sDeviceConfig = config;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::GetDeviceConfig()
+//-------------------------------------------------------------------------------------------------
+SoftwareDeviceConfig RendererAPI_Software::GetDeviceConfig()
+{
+	std::lock_guard<std::mutex> lock(sDeviceMutex);
+	return sDeviceConfig;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::EndFrame()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Software::EndFrame()
+{
+	++sFrame;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::ProcessDeviceEvent()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Software::ProcessDeviceEvent(UnityGfxDeviceEventType eventType, IUnityInterfaces* interfaces)
+{
+	if (eventType == kUnityGfxDeviceEventShutdown)
+		ReleaseResources();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::RegisterResource_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Software::RegisterResource_MainThread(void* nativeResource, bool isBuffer, int* resourceHandle)
+{
+	// null device gives Unity textures without native pointer the backend could read
+	if (!SoftwareResource::IsValid(nativeResource, isBuffer))
+		return Status::Error_InvalidArguments;
+
+	return RendererAPI_Staging::RegisterResource_MainThread(nativeResource, isBuffer, resourceHandle);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::DescribeResource()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Software::DescribeResource(CpuResource* cpuResource, ResourceDesc* desc)
+{
+	SoftwareResource* resource = (SoftwareResource*)cpuResource->gpuResource;
+	desc->width = resource->width;
+	desc->height = resource->height;
+	desc->slices = resource->slices;
+	desc->mipLevels = resource->mipLevels;
+	desc->is3D = resource->is3D;
+	desc->format = resource->format;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::CreateStaging()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Software::CreateStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot)
+{
+	SoftwareDeviceConfig config = GetDeviceConfig();
+	++_createCount;
+	if (config.createFailureInterval > 0 && _createCount % config.createFailureInterval == 0)
+		return Status::Error_UnknownError;
+
+	// buffers are tightly packed, texture rows are padded to the alignment
+	int rowPitch = copyRegion.format.RowPitch(copyRegion.width);
+	if (!cpuResource->isBuffer && config.rowPitchAlignment > 1)
+		rowPitch = (rowPitch + config.rowPitchAlignment - 1) / config.rowPitchAlignment * config.rowPitchAlignment;
+
+	StagingResource_Software* staging = new StagingResource_Software();
+	staging->rowPitch = rowPitch;
+	staging->slicePitch = rowPitch * copyRegion.format.RowCount(copyRegion.height);
+	staging->subresources = cpuResource->isBuffer || copyRegion.is3D ? 1 : copyRegion.sliceCount;
+	staging->memory.resize((size_t)staging->slicePitch * copyRegion.sliceCount);
+	slot->staging = staging;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::ReleaseStaging()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Software::ReleaseStaging(StagingResource* staging)
+{
+	// gpu thread can still write to the staging memory
+	if (!((StagingResource_Software*)staging)->copied)
+		_gpuQueue.WaitIdle();
+
+	delete staging;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::IssueGpuCopy()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Software::IssueGpuCopy(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot)
+{
+	SoftwareDeviceConfig config = GetDeviceConfig();
+	SoftwareResource* resource = (SoftwareResource*)cpuResource->gpuResource;
+	StagingResource_Software* staging = (StagingResource_Software*)slot->staging;
+	staging->copied = false;
+	staging->readyFrame = sFrame + config.latencyFrames;
+
+	// region starts at block boundary, ResolveRegion aligned it
+	const FormatTraits& format = copyRegion.format;
+	int rowSize = format.RowPitch(copyRegion.width);
+	int rowCount = format.RowCount(copyRegion.height);
+	int offset = copyRegion.y / format.blockHeight * resource->RowPitch(copyRegion.mipLevel) + copyRegion.x / format.blockWidth * format.blockSize;
+	CopyRegion region = copyRegion;
+
+	_gpuQueue.Push([this, resource, staging, region, rowSize, rowCount, offset, config](CopyEngine* copyEngine)
+	{
+		int srcPitch = resource->RowPitch(region.mipLevel);
+		for (int slice = 0; slice < region.sliceCount; ++slice)
+		{
+			const char* src = resource->GetData(region.mipLevel, region.firstSlice + slice) + offset;
+			char* dest = &staging->memory[0] + (size_t)slice * staging->slicePitch;
+			copyEngine->CopyRows(dest, staging->rowPitch, src, srcPitch, rowSize, rowCount);
+		}
+
+		ThrottleCopy((size_t)rowSize * rowCount * region.sliceCount, config.bandwidth);
+		staging->copied = true;
+	});
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::ThrottleCopy()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Software::ThrottleCopy(size_t size, double bandwidth)
+{
+	// copies are serialized on simulated gpu, every copy starts when the previous one ended
+	if (bandwidth <= 0.0)
+		return;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (_gpuBusyUntil < now)
+		_gpuBusyUntil = now;
+
+	_gpuBusyUntil += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(size / bandwidth));
+	std::this_thread::sleep_until(_gpuBusyUntil);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::QueryCompletion()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Software::QueryCompletion(StagingSlot* slot)
+{
+	StagingResource_Software* staging = (StagingResource_Software*)slot->staging;
+	if (!staging->copied || (int)(sFrame - staging->readyFrame) < 0)
+		return Status::NotReady;
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::MapStaging()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Software::MapStaging(StagingSlot* slot)
+{
+	SoftwareDeviceConfig config = GetDeviceConfig();
+	++_mapCount;
+	if (config.mapFailureInterval > 0 && _mapCount % config.mapFailureInterval == 0)
+		return Status::Error_UnknownError;
+
+	StagingResource_Software* staging = (StagingResource_Software*)slot->staging;
+	int slicesPerSubresource = slot->stagingSlices / staging->subresources;
+
+	slot->mapped.resize(staging->subresources);
+	for (int subresource = 0; subresource < staging->subresources; ++subresource)
+	{
+		slot->mapped[subresource].data = &staging->memory[0] + (size_t)subresource * slicesPerSubresource * staging->slicePitch;
+		slot->mapped[subresource].rowPitch = staging->rowPitch;
+		slot->mapped[subresource].depthPitch = staging->slicePitch;
+	}
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software::UnmapStaging()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Software::UnmapStaging(StagingSlot* slot)
+{
+	slot->mapped.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CreateRendererAPI_Software
+//-------------------------------------------------------------------------------------------------
+RendererAPI* CreateRendererAPI_Software()
+{
+	return new RendererAPI_Software();
+}
+
+//-------------------------------------------------------------------------------------------------
+// SetSoftwareDeviceConfig
+//-------------------------------------------------------------------------------------------------
+extern "C" int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetSoftwareDeviceConfig(int latencyFrames, float bandwidthMBps, int rowPitchAlignment, int createFailureInterval, int mapFailureInterval)
+{
+	if (latencyFrames < 0 || bandwidthMBps < 0.0f || rowPitchAlignment < 0 || createFailureInterval < 0 || mapFailureInterval < 0)
+		return (int)Status::Error_InvalidArguments;
+
+	SoftwareDeviceConfig config;
+	config.latencyFrames = latencyFrames;
+	config.bandwidth = bandwidthMBps * 1000000.0;
+	config.rowPitchAlignment = rowPitchAlignment;
+	config.createFailureInterval = createFailureInterval;
+	config.mapFailureInterval = mapFailureInterval;
+	RendererAPI_Software::SetDeviceConfig(config);
+	return (int)Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// EndSoftwareDeviceFrame
+//-------------------------------------------------------------------------------------------------
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API EndSoftwareDeviceFrame()
+{
+	RendererAPI_Software::EndFrame();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CreateSoftwareTexture
+//-------------------------------------------------------------------------------------------------
+extern "C" void* UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateSoftwareTexture(int width, int height, int slices, int mipLevels, int is3D, int componentType, int channels, int formatFlags)
+{
+	// block compressed formats take block size in bytes instead of channels (8 for BC1/BC4, 16 for the rest),
+	// contents are opaque blocks. other raw formats can be created from C++
+	if (componentType == (int)ComponentType::Compressed)
+		return channels == 8 || channels == 16 ? SoftwareResource::CreateTexture(width, height, slices, mipLevels, is3D != 0, BlockTraits(channels, formatFlags)) : NULL;
+
+	// formats with per-channel type
+	if (componentType < 0 || componentType > (int)ComponentType::SInt8 || channels < 1 || channels > 4)
+		return NULL;
+
+	return SoftwareResource::CreateTexture(width, height, slices, mipLevels, is3D != 0, PixelTraits(channels, (ComponentType)componentType, formatFlags));
+}
+
+//-------------------------------------------------------------------------------------------------
+// CreateSoftwareBuffer
+//-------------------------------------------------------------------------------------------------
+extern "C" void* UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateSoftwareBuffer(int size)
+{
+	return SoftwareResource::CreateBuffer(size);
+}
+
+//-------------------------------------------------------------------------------------------------
+// GetSoftwareResourceData
+//-------------------------------------------------------------------------------------------------
+extern "C" void* UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetSoftwareResourceData(void* nativeResource, int mipLevel, int slice, int* rowPitch)
+{
+	// memory of the mip level/slice the host fills, rows are tightly packed
+	SoftwareResource* resource = (SoftwareResource*)nativeResource;
+	if (resource == NULL || mipLevel < 0 || mipLevel >= resource->mipLevels || slice < 0 || slice >= resource->MipSlices(mipLevel))
+		return NULL;
+
+	if (rowPitch != NULL)
+		*rowPitch = resource->RowPitch(mipLevel);
+
+	return resource->GetData(mipLevel, slice);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReleaseSoftwareResource
+//-------------------------------------------------------------------------------------------------
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseSoftwareResource(void* nativeResource)
+{
+	SoftwareResource::Release((SoftwareResource*)nativeResource);
+}
+
+#endif // SUPPORT_SOFTWARE
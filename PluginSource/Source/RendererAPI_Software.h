@@ -0,0 +1,151 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "RendererAPI_Staging.h"
+#include "PlatformBase.h"
+
+#if SUPPORT_SOFTWARE
+
+#include <chrono>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+// SoftwareDeviceConfig
+//-------------------------------------------------------------------------------------------------
+// behaviour of simulated gpu, copies issued after the change use the new values
+struct SoftwareDeviceConfig
+{
+	// frames (SoftwareDeviceEndFrame calls) between copy submission and its completion
+	int latencyFrames;
+	// copy bandwidth in bytes per second, zero means copies take no time
+	double bandwidth;
+	// row pitch of staging textures is aligned to this many bytes, rows are padded like in real drivers
+	int rowPitchAlignment;
+	// every n-th staging creation/map fails with Error_UnknownError, zero disables failures
+	int createFailureInterval;
+	int mapFailureInterval;
+
+	SoftwareDeviceConfig() : latencyFrames(2), bandwidth(0.0), rowPitchAlignment(256), createFailureInterval(0), mapFailureInterval(0) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// SoftwareResource
+//-------------------------------------------------------------------------------------------------
+// "gpu" texture/buffer in host memory, native pointer registered by RegisterTexture/RegisterBuffer.
+// every mip level is stored tightly packed, slices (array slices or depth slices) one after another
+struct SoftwareResource
+{
+	bool isBuffer;
+	int width;
+	int height;
+	// array size of 2D texture, depth of 3D texture
+	int slices;
+	int mipLevels;
+	bool is3D;
+	FormatTraits format;
+	std::vector<std::vector<char>> mips;
+
+	int MipWidth(int mipLevel) const;
+	int MipHeight(int mipLevel) const;
+	int MipSlices(int mipLevel) const;
+	int RowPitch(int mipLevel) const { return format.RowPitch(MipWidth(mipLevel)); }
+	int SlicePitch(int mipLevel) const { return RowPitch(mipLevel) * format.RowCount(MipHeight(mipLevel)); }
+	char* GetData(int mipLevel, int slice) { return &mips[mipLevel][0] + slice * SlicePitch(mipLevel); }
+
+	// resources can be created and released at any time from any thread. resource must stay alive
+	// while it has requests in flight, like gpu resources owned by Unity
+	static SoftwareResource* CreateTexture(int width, int height, int slices, int mipLevels, bool is3D, const FormatTraits& format);
+	static SoftwareResource* CreateBuffer(int size);
+	static void Release(SoftwareResource* resource);
+	static bool IsValid(void* resource, bool isBuffer);
+};
+
+//-------------------------------------------------------------------------------------------------
+// StagingResource_Software
+//-------------------------------------------------------------------------------------------------
+struct StagingResource_Software : public StagingResource
+{
+	std::vector<char> memory;
+	int rowPitch;
+	int slicePitch;
+	// one per 2D slice, single one for buffers and 3D textures
+	int subresources;
+	// copy is complete when the gpu thread wrote the data and readyFrame was reached
+	std::atomic<bool> copied;
+	unsigned int readyFrame;
+
+	StagingResource_Software() : rowPitch(0), slicePitch(0), subresources(0), copied(true), readyFrame(0) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Software
+//-------------------------------------------------------------------------------------------------
+// backend for the null device (batch mode, native hosts and benchmarks). gpu resources live in host memory,
+// copies are executed in order by simulated gpu thread with configurable latency and bandwidth
+class RendererAPI_Software : public RendererAPI_Staging
+{
+public:
+	RendererAPI_Software();
+	virtual ~RendererAPI_Software();
+
+	virtual void ProcessDeviceEvent(UnityGfxDeviceEventType eventType, IUnityInterfaces* interfaces);
+
+	// simulated gpu is shared by every instance, config and frame counter can be set before the device is created
+	static void SetDeviceConfig(const SoftwareDeviceConfig& config);
+	static SoftwareDeviceConfig GetDeviceConfig();
+	// frame boundary of simulated gpu, host calls it once per frame
+	static void EndFrame();
+
+	// only resources created by CreateSoftwareTexture/CreateSoftwareBuffer can be registered
+	virtual Status RegisterResource_MainThread(void* nativeResource, bool isBuffer, int* resourceHandle);
+
+protected:
+	virtual Status DescribeResource(CpuResource* cpuResource, ResourceDesc* desc);
+	virtual Status CreateStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot);
+	virtual void ReleaseStaging(StagingResource* staging);
+	virtual void IssueGpuCopy(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot);
+	virtual Status QueryCompletion(StagingSlot* slot);
+	virtual Status MapStaging(StagingSlot* slot);
+	virtual void UnmapStaging(StagingSlot* slot);
+
+private:
+	void ThrottleCopy(size_t size, double bandwidth);
+
+private:
+	// failure injection counters, render thread only
+	int _createCount;
+	int _mapCount;
+	// end of the last copy on simulated gpu timeline, gpu thread only
+	std::chrono::steady_clock::time_point _gpuBusyUntil;
+	// simulated gpu, executes copies in submission order. declared last, it is joined before the rest is destroyed
+	CopyThread _gpuQueue;
+};
+
+#endif // SUPPORT_SOFTWARE
@@ -0,0 +1,1539 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "RendererAPI_Staging.h"
+#include "CompletionNotifier.h"
+#include "PlatformBase.h"
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+// buffers are read as one row of bytes
+static const FormatTraits kBufferFormat = RawTraits(1, ComponentType::Typeless);
+// staging copies of buffers up to this size share one size class
+static const int kMinStagingBufferSize = 4096;
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RendererAPI_Staging()
+//-------------------------------------------------------------------------------------------------
+RendererAPI_Staging::RendererAPI_Staging() : _subscriptionCopies(0), _pooledBytes(0), _lentBytes(0), _frame(0)
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::~RendererAPI_Staging()
+//-------------------------------------------------------------------------------------------------
+RendererAPI_Staging::~RendererAPI_Staging()
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReleaseResources()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::ReleaseResources()
+{
+	// release resource copies in staging memory
+	_subscriptions.Clear([this](Subscription* subscription) { ReleaseSubscription(subscription); });
+	_activeSubscriptions.clear();
+	_closingCaptures.clear();
+	_resources.Clear([this](CpuResource* cpuResource) { ReleaseCpuResource(cpuResource); });
+	ReleaseStagingPool();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReleaseCpuResource()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::ReleaseCpuResource(CpuResource* cpuResource)
+{
+	if (cpuResource == NULL)
+		return;
+
+	if (cpuResource->polled)
+	{
+		for (size_t i = 0; i < _polledResources.size(); ++i)
+		{
+			if (_polledResources[i] == cpuResource)
+			{
+				_polledResources[i] = _polledResources.back();
+				_polledResources.pop_back();
+				break;
+			}
+		}
+	}
+
+	for (int i = 0; i < cpuResource->slotCount; ++i)
+		ReleaseStagingSlot(&cpuResource->slots[i]);
+
+	SAFE_DELETE(cpuResource);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReleaseStagingSlot()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::ReleaseStagingSlot(StagingSlot* slot)
+{
+	// copy thread can still read mapped memory of the slot
+	if (slot->bufferStatus == CpuResourceStatus::Copying)
+		_copyThread.WaitIdle();
+
+	// mapped copy is finished and can be used by other resources, copy in flight is destroyed
+	if (!slot->mapped.empty())
+		ReturnStaging(slot);
+	else if (slot->staging != NULL)
+		DiscardStaging(slot);
+
+	if (slot->cpuBuffer != NULL)
+		delete[] (char*)slot->cpuBuffer;
+
+	slot->cpuBuffer = NULL;
+	slot->cpuBufferSize = 0;
+	slot->bufferSize = 0;
+	slot->dataSize = 0;
+	slot->dataRowPitch = 0;
+	slot->rowPitch = 0;
+	slot->rowCount = 0;
+	slot->format = kUnsupportedFormat;
+	slot->stagingWidth = 0;
+	slot->stagingHeight = 0;
+	slot->stagingSlices = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RegisterResource_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RegisterResource_MainThread(void* nativeResource, bool isBuffer, int* resourceHandle)
+{
+	CpuResource* cpuResource = new CpuResource(nativeResource, isBuffer, _stagingRingSize);
+	int handle = _resources.Add(cpuResource);
+	if (handle == -1)
+	{
+		delete cpuResource;
+		return Status::Error_TooManyRequests;
+	}
+
+	cpuResource->handle = handle;
+	*resourceHandle = handle;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::GetCpuResource()
+//-------------------------------------------------------------------------------------------------
+CpuResource* RendererAPI_Staging::GetCpuResource(int resourceHandle, bool isBuffer)
+{
+	CpuResource* cpuResource = _resources.Get(resourceHandle);
+	if (cpuResource == NULL || cpuResource->isBuffer != isBuffer)
+		return NULL;
+
+	return cpuResource;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReleaseTempResources_MainThread()
+//-------------------------------------------------------------------------------------------------
+void* RendererAPI_Staging::ReleaseTempResources_MainThread(int resourceHandle)
+{
+	// handle is invalid from now on, render thread commands that still use it are ignored
+	return _resources.Remove(resourceHandle);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReleaseTempResources_RenderThread()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::ReleaseTempResources_RenderThread(void* resource)
+{
+	ReleaseCpuResource((CpuResource*)resource);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::Subscribe_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::Subscribe_MainThread(int resourceHandle, int everyNFrames, int ringDepth, int* subscription)
+{
+	if (ringDepth <= 0 || ringDepth > kMaxSubscriptionDepth)
+		return Status::Error_InvalidArguments;
+
+	return AddSubscription(resourceHandle, everyNFrames, ringDepth, _stagingRingSize, NULL, subscription);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::StartCapture_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::StartCapture_MainThread(int resourceHandle, int everyNFrames, int depth, const char* path, long long maxBytes, int* capture)
+{
+	if (_resources.Get(resourceHandle) == NULL || everyNFrames <= 0 || depth <= 0 || depth > kMaxStagingRingSize || path == NULL)
+		return Status::Error_InvalidArguments;
+
+	// file errors are reported right away, disk space for the whole capture is reserved here
+	CaptureSink* sink = new CaptureSink();
+	if (!sink->Open(path, maxBytes))
+	{
+		delete sink;
+		return Status::Error_UnknownError;
+	}
+
+	// slots of the private ring hold the data until the writer is done with them
+	Status status = AddSubscription(resourceHandle, everyNFrames, 0, depth, sink, capture);
+	if (status != Status::Succeeded)
+		delete sink;
+
+	return status;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::GetCaptureStatus_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::GetCaptureStatus_MainThread(int capture, int* written, int* skipped, int* failed, long long* bytes, bool* finished)
+{
+	Subscription* readCapture = _subscriptions.Get(capture);
+	if (readCapture == NULL || readCapture->capture == NULL)
+		return Status::Error_InvalidArguments;
+
+	// counters are final once the capture finished, render thread doesn't use it anymore
+	*finished = readCapture->finished;
+	*written = readCapture->capture->GetWritten();
+	*skipped = readCapture->capture->GetSkipped();
+	*failed = readCapture->capture->GetFailed();
+	*bytes = readCapture->capture->GetBytes();
+
+	if (*finished)
+	{
+		_subscriptions.Remove(capture);
+		SAFE_DELETE(readCapture->capture);
+		SAFE_DELETE(readCapture);
+	}
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::AddSubscription()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::AddSubscription(int resourceHandle, int everyNFrames, int ringDepth, int slotCount, CaptureSink* capture, int* subscription)
+{
+	CpuResource* cpuResource = _resources.Get(resourceHandle);
+	if (cpuResource == NULL || everyNFrames <= 0)
+		return Status::Error_InvalidArguments;
+
+	// private ring reads the same gpu resource, it isn't in the resource table so user requests can't reach it
+	CpuResource* subscriptionResource = new CpuResource(cpuResource->gpuResource, cpuResource->isBuffer, slotCount);
+	subscriptionResource->handle = resourceHandle;
+
+	Subscription* newSubscription = new Subscription(resourceHandle, everyNFrames, ringDepth, subscriptionResource, capture);
+	int handle = _subscriptions.Add(newSubscription);
+	if (handle == -1)
+	{
+		delete subscriptionResource;
+		delete newSubscription;
+		return Status::Error_TooManyRequests;
+	}
+
+	*subscription = handle;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::Subscribe_RenderThread()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::Subscribe_RenderThread(int subscription)
+{
+	// subscription could have been cancelled before its render event
+	Subscription* newSubscription = _subscriptions.Get(subscription);
+	if (newSubscription == NULL)
+		return;
+
+	newSubscription->startFrame = _frame + 1;
+	_activeSubscriptions.push_back(newSubscription);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::Unsubscribe_MainThread()
+//-------------------------------------------------------------------------------------------------
+void* RendererAPI_Staging::Unsubscribe_MainThread(int subscription)
+{
+	Subscription* oldSubscription = _subscriptions.Get(subscription);
+	if (oldSubscription == NULL || oldSubscription->capture == NULL)
+		return _subscriptions.Remove(subscription);
+
+	// capture handle stays valid so progress can be queried until its file is closed
+	if (oldSubscription->stopped)
+		return NULL;
+
+	oldSubscription->stopped = true;
+	return oldSubscription;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::Unsubscribe_RenderThread()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::Unsubscribe_RenderThread(void* subscription)
+{
+	for (size_t i = 0; i < _activeSubscriptions.size(); ++i)
+	{
+		if (_activeSubscriptions[i] == subscription)
+		{
+			_activeSubscriptions.erase(_activeSubscriptions.begin() + i);
+			break;
+		}
+	}
+
+	// writer finishes the file in the background, slots it holds are released by a later poll event
+	Subscription* oldSubscription = (Subscription*)subscription;
+	if (oldSubscription->capture != NULL)
+	{
+		oldSubscription->capture->Close();
+		_closingCaptures.push_back(oldSubscription);
+		return;
+	}
+
+	ReleaseSubscription(oldSubscription);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReleaseSubscription()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::ReleaseSubscription(Subscription* subscription)
+{
+	if (subscription == NULL)
+		return;
+
+	// writer still reads cpuBuffers of the slots it holds, sink waits for it when the device is shut down
+	SAFE_DELETE(subscription->capture);
+
+	ReleaseCpuResource(subscription->cpuResource);
+
+	for (size_t i = 0; i < subscription->results.size(); ++i)
+	{
+		if (subscription->results[i].data != NULL)
+			delete[] (char*)subscription->results[i].data;
+	}
+
+	SAFE_DELETE(subscription);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReleaseClosedCaptures()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::ReleaseClosedCaptures()
+{
+	for (size_t i = 0; i < _closingCaptures.size();)
+	{
+		Subscription* subscription = _closingCaptures[i];
+		if (!subscription->capture->IsClosed())
+		{
+			++i;
+			continue;
+		}
+
+		// every done callback was called, no slot is leased anymore. sink stays for GetCaptureStatus
+		ReleaseCpuResource(subscription->cpuResource);
+		subscription->cpuResource = NULL;
+		_closingCaptures[i] = _closingCaptures.back();
+		_closingCaptures.pop_back();
+		subscription->finished = true;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::UpdateSubscription()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::UpdateSubscription(Subscription* subscription)
+{
+	// copies finished by this poll event (or by copy thread since the last one) are published first
+	PublishResults(subscription);
+
+	if ((_frame - subscription->startFrame) % subscription->everyNFrames != 0)
+		return;
+
+	// released resource isn't copied anymore, subscription only delivers results already in flight
+	if (_resources.Get(subscription->resourceHandle) == NULL)
+		return;
+
+	// render thread takes the role of main thread for the private ring. copy is skipped when every slot is in flight
+	// (or waits for the writer of capture)
+	int requestId = -2 - (int)(_subscriptionCopies++ & 0x3fffffff);
+	if (BeginRequest(subscription->cpuResource, requestId, ReadRequest()) == Status::Succeeded)
+		IssueCopy(subscription->cpuResource);
+	else if (subscription->capture != NULL)
+		subscription->capture->Skip();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::PublishResults()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::PublishResults(Subscription* subscription)
+{
+	CpuResource* cpuResource = subscription->cpuResource;
+	int depth = (int)subscription->results.size();
+
+	Status status;
+	StagingSlot* slot;
+	while ((slot = PeekFinishedSlot(cpuResource, &status)) != NULL)
+	{
+		// captured copy is written from cpuBuffer, slot is handed back by the writer
+		bool leased = false;
+		if (subscription->capture != NULL)
+		{
+			if (status == Status::Succeeded)
+				leased = WriteCapture(subscription->capture, slot);
+			else
+				subscription->capture->Fail();
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(subscription->mutex);
+
+			// newest result takes the place of the oldest one. result main thread is reading can't be overwritten,
+			// the new one is dropped instead
+			SubscriptionResult& result = subscription->results[subscription->published % depth];
+			if (result.pinned)
+			{
+				++subscription->dropped;
+			}
+			else
+			{
+				// buffers are swapped, data aren't copied again
+				if (status == Status::Succeeded)
+				{
+					std::swap(result.data, slot->cpuBuffer);
+					std::swap(result.capacity, slot->cpuBufferSize);
+				}
+
+				result.dataSize = status == Status::Succeeded ? slot->dataSize : 0;
+				result.frame = slot->issueFrame;
+				result.status = status;
+				++subscription->published;
+			}
+		}
+
+		if (status == Status::Succeeded && _stats != NULL)
+			ReadbackStats::Add(_stats->bytesRetrieved, slot->dataSize);
+		TraceStep(TracePhase::Delivered, cpuResource->handle, slot->requestId, status, TraceStart());
+
+		if (!leased)
+			slot->bufferStatus = CpuResourceStatus::Ready;
+		++cpuResource->retrieveIndex;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::WriteCapture()
+//-------------------------------------------------------------------------------------------------
+bool RendererAPI_Staging::WriteCapture(CaptureSink* capture, StagingSlot* slot)
+{
+	CaptureEntry entry = {};
+	entry.size = slot->dataSize;
+	entry.frame = slot->issueFrame;
+	entry.width = slot->stagingWidth;
+	entry.height = slot->stagingHeight;
+	entry.slices = slot->stagingSlices;
+	entry.rowPitch = slot->dataRowPitch;
+	entry.blockSize = slot->format.blockSize;
+	entry.blockWidth = slot->format.blockWidth;
+	entry.blockHeight = slot->format.blockHeight;
+	entry.channels = slot->format.channels;
+	entry.type = (unsigned char)slot->format.type;
+	entry.flags = slot->format.flags;
+
+	// slot is leased before the writer can hand it back, BeginRequest skips it meanwhile
+	slot->bufferStatus = CpuResourceStatus::Leased;
+	if (capture->Write(slot->cpuBuffer, entry, [slot] { slot->bufferStatus = CpuResourceStatus::Ready; }))
+		return true;
+
+	// file is full, copy is dropped
+	slot->bufferStatus = CpuResourceStatus::Ready;
+	return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RetrieveSubscription_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RetrieveSubscription_MainThread(int subscription, bool latest, void* data, int dataSize, unsigned int* frame, int* dropped)
+{
+	Subscription* readSubscription = _subscriptions.Get(subscription);
+	if (readSubscription == NULL || readSubscription->capture != NULL)
+		return Status::Error_InvalidArguments;
+
+	std::unique_lock<std::mutex> lock(readSubscription->mutex);
+	unsigned long long depth = readSubscription->results.size();
+
+	// consumer fell behind, results older than the ring were overwritten
+	unsigned long long oldest = readSubscription->published > depth ? readSubscription->published - depth : 0;
+	if (readSubscription->read < oldest)
+	{
+		readSubscription->dropped += (int)(oldest - readSubscription->read);
+		readSubscription->read = oldest;
+	}
+
+	if (readSubscription->read == readSubscription->published)
+		return Status::NotReady;
+
+	// skipped results aren't counted as dropped, user asked for the newest one
+	if (latest)
+		readSubscription->read = readSubscription->published - 1;
+
+	// result is kept, user can try again with bigger buffer
+	SubscriptionResult& result = readSubscription->results[readSubscription->read % depth];
+	if (result.status == Status::Succeeded && result.dataSize > dataSize)
+		return Status::Error_WrongBufferSize;
+
+	*frame = result.frame;
+	*dropped = readSubscription->dropped;
+	readSubscription->dropped = 0;
+
+	// render thread keeps publishing while the data are copied, only this result can't be overwritten
+	Status status = result.status;
+	if (status == Status::Succeeded)
+	{
+		result.pinned = true;
+		lock.unlock();
+		memcpy(data, result.data, result.dataSize);
+		lock.lock();
+		result.pinned = false;
+	}
+
+	++readSubscription->read;
+	return status;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::BeginRequest()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::BeginRequest(CpuResource* cpuResource, int requestId, const ReadRequest& request)
+{
+	// executed on main thread 
+	// reserve staging slot for render thread request that will come later
+	if (cpuResource == NULL)
+	{
+		if (_stats != NULL)
+			ReadbackStats::Add(_stats->rejectedRequests, 1);
+		TraceStep(TracePhase::Rejected, -1, requestId, Status::Error_InvalidArguments, TraceStart());
+		return Status::Error_InvalidArguments;
+	}
+
+	// every slot is either in flight or waiting to be retrieved
+	StagingSlot* slot = cpuResource->GetSlot(cpuResource->requestIndex);
+	if (slot->bufferStatus != CpuResourceStatus::Ready)
+	{
+		if (_stats != NULL)
+			ReadbackStats::Add(_stats->rejectedRequests, 1);
+		TraceStep(TracePhase::Rejected, cpuResource->handle, requestId, Status::Error_CopyInProgress, TraceStart());
+		return Status::Error_CopyInProgress;
+	}
+
+	slot->requestId = requestId;
+	slot->request = request;
+	slot->requestTime = ReadbackStats::Clock::now();
+	slot->lastStatus = Status::NotReady;
+	slot->bufferStatus = CpuResourceStatus::WaitingForGpu;
+	++cpuResource->requestIndex;
+
+	if (_stats != NULL)
+		ReadbackStats::Add(_stats->requests, 1);
+	TraceStep(TracePhase::Request, cpuResource->handle, requestId, Status::Succeeded, slot->requestTime);
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::IssueRequest()
+//-------------------------------------------------------------------------------------------------
+StagingSlot* RendererAPI_Staging::IssueRequest(CpuResource* cpuResource)
+{
+	if (cpuResource == NULL)
+		return NULL;
+
+	// render thread requests come in the same order as main thread requests, 
+	// next slot is the one reserved by BeginRequest
+	StagingSlot* slot = cpuResource->GetSlot(cpuResource->issueIndex);
+	if (slot->bufferStatus != CpuResourceStatus::WaitingForGpu)
+		return NULL;
+
+	++cpuResource->issueIndex;
+	return slot;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::PeekFinishedSlot()
+//-------------------------------------------------------------------------------------------------
+StagingSlot* RendererAPI_Staging::PeekFinishedSlot(CpuResource* cpuResource, Status* status)
+{
+	// data weren't requested, there's nothing to retrieve
+	if (cpuResource == NULL)
+	{
+		*status = Status::Error_NoRequest;
+		return NULL;
+	}
+
+	// results are always handed out from the oldest request
+	StagingSlot* slot = cpuResource->GetSlot(cpuResource->retrieveIndex);
+	CpuResourceStatus bufferStatus = slot->bufferStatus;
+	if (bufferStatus == CpuResourceStatus::Ready || bufferStatus == CpuResourceStatus::Leased)
+	{
+		*status = Status::Error_NoRequest;
+		return NULL;
+	}
+
+	if (bufferStatus == CpuResourceStatus::WaitingForGpu || bufferStatus == CpuResourceStatus::Copying)
+	{
+		*status = slot->lastStatus;
+		return NULL;
+	}
+
+	assert(bufferStatus == CpuResourceStatus::CopyFinished);
+
+	*status = slot->lastStatus;
+	return slot;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::IssueCopy()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::IssueCopy(CpuResource* cpuResource)
+{
+	StagingSlot* slot = IssueRequest(cpuResource);
+	if (slot == NULL)
+		return Status::Error_NoRequest;
+
+	ReadbackTrace::Clock::time_point traceStart = TraceStart();
+	slot->issueFrame = _frame;
+
+	// previous request of the slot could have been copied by copy thread, its staging copy is still mapped
+	if (slot->staging != NULL)
+		ReturnStaging(slot);
+
+	CopyRegion copyRegion;
+	Status status = ResolveRegion(cpuResource, slot->request.region, &copyRegion);
+
+	// any free staging copy of the right layout will do, previous request could have read different region
+	if (status == Status::Succeeded)
+		status = AcquireStaging(cpuResource, copyRegion, slot);
+
+	if (status == Status::Succeeded && (slot->request.reduction.flags != 0 || slot->request.conversion.IsEnabled() || slot->request.delta.IsEnabled()))
+		status = ValidateRequest(cpuResource, slot);
+
+	if (status == Status::Succeeded)
+		status = ReserveCpuBuffer(slot, copyRegion);
+
+	if (status != Status::Succeeded)
+	{
+		if (slot->staging != NULL)
+			ReturnStaging(slot);
+
+		int requestId = slot->requestId;
+		RecordCompletion(slot, status, 0);
+		TraceStep(TracePhase::Failed, cpuResource->handle, requestId, status, traceStart);
+		slot->lastStatus = status;
+		slot->bufferStatus = CpuResourceStatus::CopyFinished;
+		NotifyCompletion(cpuResource->handle, requestId, status);
+		return status;
+	}
+
+	// request copy to cpu memory, only the region is transferred
+	IssueGpuCopy(cpuResource, copyRegion, slot);
+	TraceStep(TracePhase::CopyIssued, cpuResource->handle, slot->requestId, Status::Succeeded, traceStart);
+
+	if (_stats != NULL)
+	{
+		ReadbackStats::Add(_stats->copies, 1);
+		ReadbackStats::Raise(_stats->maxSlotsInFlight, (long long)(cpuResource->issueIndex - cpuResource->copyIndex));
+	}
+
+	if (!cpuResource->polled)
+	{
+		cpuResource->polled = true;
+		_polledResources.push_back(cpuResource);
+	}
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// StagingBufferSize
+//-------------------------------------------------------------------------------------------------
+static int StagingBufferSize(int size)
+{
+	// size classes step by the largest power of two not above 1/8 of the size, less than 12.5% of the copy is wasted
+	if (size <= kMinStagingBufferSize)
+		return kMinStagingBufferSize;
+
+	long long step = kMinStagingBufferSize;
+	while (step * 16 <= size)
+		step *= 2;
+
+	long long classSize = (size + step - 1) / step * step;
+	return classSize <= INT_MAX ? (int)classSize : size;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::AcquireStaging()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::AcquireStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot)
+{
+	int rowPitch = copyRegion.format.RowPitch(copyRegion.width);
+	int rowCount = copyRegion.format.RowCount(copyRegion.height);
+
+	StagingKey key;
+	key.stagingFormat = copyRegion.stagingFormat;
+	key.width = cpuResource->isBuffer ? StagingBufferSize(copyRegion.width) : copyRegion.width;
+	key.height = copyRegion.height;
+	key.slices = copyRegion.sliceCount;
+	key.rowPitch = cpuResource->isBuffer ? key.width : rowPitch;
+	key.rowCount = rowCount;
+	key.isBuffer = cpuResource->isBuffer;
+	key.is3D = copyRegion.is3D;
+
+	// the most recently returned copy is taken first, the pool keeps least recently used ones at the front
+	for (size_t i = _stagingPool.size(); i-- > 0;)
+	{
+		if (_stagingPool[i].key == key)
+		{
+			slot->staging = _stagingPool[i].staging;
+			_stagingPool.erase(_stagingPool.begin() + i);
+			_pooledBytes -= key.Size();
+			break;
+		}
+	}
+
+	if (slot->staging == NULL)
+	{
+		// free copies make room for the new one, request fails when copies in use alone exceed the budget
+		long long budget = _stagingBudget;
+		if (budget > 0)
+		{
+			if (key.Size() > budget)
+				return Status::Error_TooManyRequests;
+
+			EvictStaging(budget - key.Size(), 0);
+			if (_lentBytes + key.Size() > budget)
+				return Status::Error_TooManyRequests;
+		}
+
+		// staging copy of buffer covers the whole size class
+		CopyRegion stagingRegion = copyRegion;
+		stagingRegion.width = key.width;
+		Status status = CreateStaging(cpuResource, stagingRegion, slot);
+		if (status != Status::Succeeded)
+			return status;
+	}
+
+	_lentBytes += key.Size();
+	RecordStagingBytes();
+	slot->stagingKey = key;
+	slot->bufferSize = rowPitch * rowCount * copyRegion.sliceCount;
+	slot->rowPitch = rowPitch;
+	slot->rowCount = rowCount;
+	slot->format = copyRegion.format;
+	slot->stagingWidth = copyRegion.width;
+	slot->stagingHeight = copyRegion.height;
+	slot->stagingSlices = copyRegion.sliceCount;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReturnStaging()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::ReturnStaging(StagingSlot* slot)
+{
+	// data are in cpuBuffer already, next copy can go to the same staging memory
+	if (!slot->mapped.empty())
+		UnmapStaging(slot);
+
+	PooledStaging pooled;
+	pooled.key = slot->stagingKey;
+	pooled.staging = slot->staging;
+	pooled.lastUsed = _frame;
+	_stagingPool.push_back(pooled);
+
+	_lentBytes -= slot->stagingKey.Size();
+	_pooledBytes += slot->stagingKey.Size();
+	slot->staging = NULL;
+	RecordStagingBytes();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::DiscardStaging()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::DiscardStaging(StagingSlot* slot)
+{
+	if (!slot->mapped.empty())
+		UnmapStaging(slot);
+
+	ReleaseStaging(slot->staging);
+	_lentBytes -= slot->stagingKey.Size();
+	slot->staging = NULL;
+	RecordStagingBytes();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::EvictStaging()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::EvictStaging(long long maxBytes, int idleFrames)
+{
+	// least recently used copies go first until all copies fit to maxBytes (negative is no limit) and
+	// no free copy is idle for idleFrames (zero is no limit)
+	while (!_stagingPool.empty())
+	{
+		const PooledStaging& pooled = _stagingPool.front();
+		bool overBudget = maxBytes >= 0 && _lentBytes + _pooledBytes > maxBytes;
+		bool idle = idleFrames > 0 && (int)(_frame - pooled.lastUsed) >= idleFrames;
+		if (!overBudget && !idle)
+			break;
+
+		ReleaseStaging(pooled.staging);
+		_pooledBytes -= pooled.key.Size();
+		_stagingPool.pop_front();
+	}
+
+	RecordStagingBytes();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReleaseStagingPool()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::ReleaseStagingPool()
+{
+	for (size_t i = 0; i < _stagingPool.size(); ++i)
+		ReleaseStaging(_stagingPool[i].staging);
+
+	_stagingPool.clear();
+	_pooledBytes = 0;
+	RecordStagingBytes();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ValidateRequest()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::ValidateRequest(CpuResource* cpuResource, StagingSlot* slot)
+{
+	const ReadRequest& request = slot->request;
+
+	// tiles are hashed on raw data of any texture format, delta can't be reduced or converted
+	if (request.delta.IsEnabled())
+		return cpuResource->isBuffer || request.reduction.flags != 0 || request.conversion.IsEnabled() ? Status::Error_InvalidArguments : Status::Succeeded;
+
+	// buffers don't have pixel format, pixels are either reduced or converted
+	if (cpuResource->isBuffer || (request.reduction.flags != 0 && request.conversion.IsEnabled()))
+		return Status::Error_InvalidArguments;
+
+	// packed, typeless and compressed formats can be read only as raw data
+	if (!slot->format.HasChannels() || slot->format.IsCompressed())
+		return Status::Error_UnsupportedFormat;
+
+	if (request.reduction.flags != 0 && !Reducer::IsSupported(request.reduction, slot->format))
+		return Status::Error_InvalidArguments;
+
+	if (request.conversion.IsEnabled() && !Converter::IsSupported(request.conversion, slot->format))
+		return Status::Error_InvalidArguments;
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReserveCpuBuffer()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::ReserveCpuBuffer(StagingSlot* slot, const CopyRegion& copyRegion)
+{
+	// size of the request result, staging data are written to cpuBuffer raw, converted or reduced
+	const ReadRequest& request = slot->request;
+	int size = slot->bufferSize;
+	if (request.reduction.flags != 0)
+		size = sizeof(ReductionResult);
+	else if (request.conversion.IsEnabled())
+		size = Converter::GetPixelSize(request.conversion, slot->format) * slot->stagingWidth * slot->stagingHeight * slot->stagingSlices;
+
+	// vector of the slot was swapped with hashes of the previous delivery, it is resized for every delta request.
+	// layout keeps the source subresource, delta of other mip level or slices has every tile dirty
+	if (request.delta.IsEnabled())
+	{
+		slot->deltaLayout = DeltaLayout(request.delta.tileSize, slot->format, copyRegion.mipLevel, copyRegion.firstSlice, copyRegion.x, copyRegion.y, 
+			slot->stagingWidth, slot->stagingHeight, slot->stagingSlices);
+		slot->tileHashes.resize(slot->deltaLayout.GetTileCount());
+	}
+	else
+	{
+		slot->deltaLayout = DeltaLayout();
+	}
+
+	if (slot->cpuBuffer != NULL && slot->cpuBufferSize >= size)
+		return Status::Succeeded;
+
+	if (slot->cpuBuffer != NULL)
+		delete[] (char*)slot->cpuBuffer;
+
+	slot->cpuBuffer = new char[size];
+	slot->cpuBufferSize = size;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// MipSize
+//-------------------------------------------------------------------------------------------------
+static int MipSize(int size, int mipLevel)
+{
+	size >>= mipLevel;
+	return size > 0 ? size : 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ResolveRegion()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::ResolveRegion(CpuResource* cpuResource, const ReadRegion& region, CopyRegion* copyRegion)
+{
+	// size of the whole resource, slices are array slices or depth of 3D texture
+	ResourceDesc desc;
+	desc.stagingFormat = 0;
+	Status status = DescribeResource(cpuResource, &desc);
+	if (status != Status::Succeeded)
+		return status;
+
+	// buffers are one row of bytes
+	if (cpuResource->isBuffer)
+	{
+		desc.height = 1;
+		desc.slices = 1;
+		desc.mipLevels = 1;
+		desc.is3D = false;
+		desc.format = kBufferFormat;
+		desc.stagingFormat = 0;
+	}
+
+	if (!desc.format.IsSupported())
+		return Status::Error_UnsupportedFormat;
+
+	if (region.mipLevel < 0 || region.mipLevel >= desc.mipLevels)
+		return Status::Error_InvalidArguments;
+
+	// depth of 3D texture gets smaller with every mip level too
+	int width = MipSize(desc.width, region.mipLevel);
+	int height = MipSize(desc.height, region.mipLevel);
+	int slices = desc.is3D ? MipSize(desc.slices, region.mipLevel) : desc.slices;
+
+	ReadRegion r = region;
+	if (r.IsWholeLevel())
+	{
+		r.width = width;
+		r.height = height;
+	}
+
+	if (cpuResource->isBuffer)
+	{
+		r.y = 0;
+		r.height = 1;
+	}
+
+	if (r.x < 0 || r.y < 0 || r.width <= 0 || r.height <= 0 || r.width > width - r.x || r.height > height - r.y)
+		return Status::Error_InvalidArguments;
+
+	if (r.slice < 0 || r.sliceCount <= 0 || r.sliceCount > slices - r.slice)
+		return Status::Error_InvalidArguments;
+
+	// compressed formats are copied in whole blocks, region is extended to block boundaries.
+	// only the edge of the mip level can cut a block
+	const FormatTraits& traits = desc.format;
+	if (traits.IsCompressed())
+	{
+		int right = traits.AlignWidth(r.x + r.width);
+		int bottom = traits.AlignHeight(r.y + r.height);
+		r.x -= r.x % traits.blockWidth;
+		r.y -= r.y % traits.blockHeight;
+		r.width = (right < width ? right : width) - r.x;
+		r.height = (bottom < height ? bottom : height) - r.y;
+	}
+
+	// D3D11 can't copy box of depth-stencil resource, depth formats are read only as whole subresources on every backend
+	bool wholeSubresource = r.width == width && r.height == height && (!desc.is3D || r.sliceCount == slices);
+	if ((traits.flags & kFormatDepth) != 0 && !wholeSubresource)
+		return Status::Error_InvalidArguments;
+
+	copyRegion->x = r.x;
+	copyRegion->y = r.y;
+	copyRegion->width = r.width;
+	copyRegion->height = r.height;
+	copyRegion->mipLevel = r.mipLevel;
+	copyRegion->mipLevels = desc.mipLevels;
+	copyRegion->firstSlice = r.slice;
+	copyRegion->sliceCount = r.sliceCount;
+	copyRegion->is3D = desc.is3D;
+	copyRegion->wholeSubresource = wholeSubresource;
+	copyRegion->format = desc.format;
+	copyRegion->stagingFormat = desc.stagingFormat;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RetrieveData()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RetrieveData(CpuResource* cpuResource, void* data, int dataSize, int* deltaSize, int* requestId)
+{
+	Status status;
+	StagingSlot* slot = PeekFinishedSlot(cpuResource, &status);
+	if (slot == NULL)
+		return status;
+
+	ReadbackTrace::Clock::time_point traceStart = TraceStart();
+	if (status == Status::Succeeded && deltaSize != NULL)
+	{
+		// raw request can't be returned as delta, it stays until it is retrieved as raw data
+		if (!slot->request.delta.IsEnabled())
+			return Status::Error_InvalidArguments;
+
+		// tiles are compared with the last delivered request, everything is dirty after layout or source change
+		const DeltaLayout& layout = slot->deltaLayout;
+		const unsigned long long* previous = cpuResource->deliveredLayout == layout && !cpuResource->deliveredHashes.empty() ? &cpuResource->deliveredHashes[0] : NULL;
+		int dirtyTiles = CountDirtyTiles(layout, &slot->tileHashes[0], previous);
+		long long size = layout.GetDeltaSize(dirtyTiles);
+
+		// keep the slot, user can try again with bigger buffer
+		*deltaSize = size <= INT_MAX ? (int)size : INT_MAX;
+		if (size > dataSize)
+			return Status::Error_WrongBufferSize;
+
+		// only dirty tiles are copied to managed mem
+		WriteDelta(layout, slot->cpuBuffer, &slot->tileHashes[0], previous, dirtyTiles, data);
+		if (_stats != NULL)
+			ReadbackStats::Add(_stats->bytesRetrieved, size);
+	}
+	else if (status == Status::Succeeded)
+	{
+		// keep the slot, user can try again with bigger buffer
+		if (slot->dataSize > dataSize)
+			return Status::Error_WrongBufferSize;
+
+		// copy to managed mem
+		memcpy(data, slot->cpuBuffer, slot->dataSize);
+		if (_stats != NULL)
+			ReadbackStats::Add(_stats->bytesRetrieved, slot->dataSize);
+	}
+
+	if (status == Status::Succeeded)
+		DeliverHashes(cpuResource, slot);
+
+	if (requestId != NULL)
+		*requestId = slot->requestId;
+	TraceStep(TracePhase::Delivered, cpuResource->handle, slot->requestId, status, traceStart);
+
+	// failed requests are dropped as well so they don't block the ring
+	slot->bufferStatus = CpuResourceStatus::Ready;
+	++cpuResource->retrieveIndex;
+	return status;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::DeliverHashes()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::DeliverHashes(CpuResource* cpuResource, StagingSlot* slot)
+{
+	// user now has data of the slot. hashes are swapped, render thread refills the vector of the slot
+	// only after the slot is requested again. user can't build deltas on raw request without hashes
+	cpuResource->deliveredLayout = slot->deltaLayout;
+	if (slot->request.delta.IsEnabled())
+		cpuResource->deliveredHashes.swap(slot->tileHashes);
+	else
+		cpuResource->deliveredHashes.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::AcquireData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::AcquireData_MainThread(int resourceHandle, const void** data, int* dataSize, int* rowPitch, int* requestId)
+{
+	CpuResource* cpuResource = _resources.Get(resourceHandle);
+
+	Status status;
+	StagingSlot* slot = PeekFinishedSlot(cpuResource, &status);
+	if (slot == NULL)
+		return status;
+
+	*requestId = slot->requestId;
+	++cpuResource->retrieveIndex;
+	TraceStep(TracePhase::Delivered, resourceHandle, slot->requestId, status, TraceStart());
+
+	if (status != Status::Succeeded)
+	{
+		slot->bufferStatus = CpuResourceStatus::Ready;
+		return status;
+	}
+
+	// leased data are delivered as well, next delta request is relative to them
+	DeliverHashes(cpuResource, slot);
+
+	// slot can't be reused by new request until the lease is released
+	slot->bufferStatus = CpuResourceStatus::Leased;
+
+	*data = slot->cpuBuffer;
+	*dataSize = slot->dataSize;
+	*rowPitch = slot->dataRowPitch;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::ReleaseData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::ReleaseData_MainThread(int resourceHandle, int requestId)
+{
+	CpuResource* cpuResource = _resources.Get(resourceHandle);
+	if (cpuResource == NULL)
+		return Status::Error_NoRequest;
+
+	for (int i = 0; i < cpuResource->slotCount; ++i)
+	{
+		StagingSlot* slot = &cpuResource->slots[i];
+		if (slot->bufferStatus == CpuResourceStatus::Leased && slot->requestId == requestId)
+		{
+			slot->bufferStatus = CpuResourceStatus::Ready;
+			return Status::Succeeded;
+		}
+	}
+
+	return Status::Error_InvalidArguments;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::CopyData()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::CopyData(CpuResource* cpuResource)
+{
+	if (cpuResource == NULL)
+		return;
+
+	// copy thread is done with these slots, staging memory can be unmapped and returned to the pool
+	for (int i = 0; i < cpuResource->slotCount; ++i)
+	{
+		StagingSlot* slot = &cpuResource->slots[i];
+		if (!slot->mapped.empty() && slot->bufferStatus != CpuResourceStatus::Copying)
+			ReturnStaging(slot);
+	}
+
+	// gpu finishes copies in the same order they were issued. 
+	// go from the oldest one and stop at the first one that isn't finished yet
+	while (cpuResource->copyIndex != cpuResource->issueIndex)
+	{
+		// failed request has no staging copy, main thread can already reuse its slot for request that isn't issued yet
+		StagingSlot* slot = cpuResource->GetSlot(cpuResource->copyIndex);
+		if (slot->bufferStatus == CpuResourceStatus::WaitingForGpu && slot->staging != NULL)
+		{
+			// polling the completion marker is cheap, staging copy is mapped only once the copy is complete
+			ReadbackTrace::Clock::time_point traceStart = TraceStart();
+			Status status = QueryCompletion(slot);
+			if (status == Status::Succeeded)
+				status = MapStaging(slot);
+
+			if (status == Status::NotReady)
+			{
+				if (_stats != NULL)
+					ReadbackStats::Add(_stats->notReadyPolls, 1);
+				return;
+			}
+
+			// main thread can reuse the slot as soon as it is finished, request id is read before
+			int resourceHandle = cpuResource->handle;
+			int requestId = slot->requestId;
+			unsigned int frames = _frame - slot->issueFrame;
+
+			// staging copy in unknown state isn't reused
+			if (status != Status::Succeeded)
+			{
+				if (_stats != NULL)
+					ReadbackStats::Add(_stats->mapFailures, 1);
+				DiscardStaging(slot);
+				TraceStep(TracePhase::Failed, resourceHandle, requestId, status, traceStart);
+			}
+			else
+			{
+				TraceStep(TracePhase::Mapped, resourceHandle, requestId, status, traceStart);
+			}
+
+			if (status == Status::Succeeded && _copyThreadEnabled)
+			{
+				// render thread cost doesn't depend on the size of the data, slot stays mapped until copy thread finishes
+				slot->bufferStatus = CpuResourceStatus::Copying;
+				_copyThread.Push([this, slot, resourceHandle, requestId, frames](CopyEngine* copyEngine)
+				{
+					ReadbackTrace::Clock::time_point copyStart = TraceStart();
+					Status copyStatus = CopyStaging(slot, copyEngine);
+					RecordCompletion(slot, copyStatus, frames);
+					TraceStep(copyStatus == Status::Succeeded ? TracePhase::CopyFinished : TracePhase::Failed, resourceHandle, requestId, copyStatus, copyStart);
+					slot->lastStatus = copyStatus;
+					slot->bufferStatus = CpuResourceStatus::CopyFinished;
+					NotifyCompletion(resourceHandle, requestId, copyStatus);
+				});
+			}
+			else
+			{
+				if (status == Status::Succeeded)
+				{
+					ReadbackTrace::Clock::time_point copyStart = TraceStart();
+					status = CopyStaging(slot, &_copyEngine);
+					ReturnStaging(slot);
+					TraceStep(status == Status::Succeeded ? TracePhase::CopyFinished : TracePhase::Failed, resourceHandle, requestId, status, copyStart);
+				}
+
+				RecordCompletion(slot, status, frames);
+				slot->lastStatus = status;
+				slot->bufferStatus = CpuResourceStatus::CopyFinished;
+				NotifyCompletion(resourceHandle, requestId, status);
+			}
+		}
+
+		++cpuResource->copyIndex;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::PollCopies_RenderThread()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::PollCopies_RenderThread()
+{
+	++_frame;
+
+	// resource leaves the list once gpu finished all its copies and copy thread gave back their staging copies,
+	// it is added again by the next copy
+	for (size_t i = 0; i < _polledResources.size();)
+	{
+		CpuResource* cpuResource = _polledResources[i];
+		CopyData(cpuResource);
+
+		if (cpuResource->copyIndex == cpuResource->issueIndex && !HoldsStaging(cpuResource))
+		{
+			cpuResource->polled = false;
+			_polledResources[i] = _polledResources.back();
+			_polledResources.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	for (size_t i = 0; i < _activeSubscriptions.size(); ++i)
+		UpdateSubscription(_activeSubscriptions[i]);
+	ReleaseClosedCaptures();
+
+	long long budget = _stagingBudget;
+	EvictStaging(budget > 0 ? budget : -1, _stagingIdleFrames);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::HoldsStaging()
+//-------------------------------------------------------------------------------------------------
+bool RendererAPI_Staging::HoldsStaging(CpuResource* cpuResource)
+{
+	for (int i = 0; i < cpuResource->slotCount; ++i)
+	{
+		if (cpuResource->slots[i].staging != NULL)
+			return true;
+	}
+
+	return false;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::NotifyCompletion()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::NotifyCompletion(int resourceHandle, int requestId, Status status)
+{
+	// render thread or copy thread. subscription copies (negative ids) are delivered to the subscription instead
+	if (_notifier != NULL && requestId >= 0 && !_notifier->Notify(resourceHandle, requestId, (int)status) && _stats != NULL)
+		ReadbackStats::Add(_stats->completionOverflows, 1);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RecordCompletion()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::RecordCompletion(StagingSlot* slot, Status status, unsigned int frames)
+{
+	// render thread or copy thread, before the slot is handed back to main thread
+	if (_stats == NULL)
+		return;
+
+	if (status != Status::Succeeded)
+	{
+		ReadbackStats::Add(_stats->failed, 1);
+		return;
+	}
+
+	ReadbackStats::Add(_stats->completed, 1);
+	_stats->latencyFrames.Add(frames);
+	_stats->latencyUs.Add(ReadbackStats::Microseconds(slot->requestTime, ReadbackStats::Clock::now()));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RecordStagingBytes()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::RecordStagingBytes()
+{
+	if (_stats == NULL)
+		return;
+
+	_stats->stagingBytes.store(_lentBytes + _pooledBytes, std::memory_order_relaxed);
+	_stats->pooledStagingBytes.store(_pooledBytes, std::memory_order_relaxed);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::TraceStart()
+//-------------------------------------------------------------------------------------------------
+ReadbackTrace::Clock::time_point RendererAPI_Staging::TraceStart() const
+{
+	// clock isn't read at all while the trace is disabled
+	return _trace != NULL && _trace->IsEnabled() ? ReadbackTrace::Clock::now() : ReadbackTrace::Clock::time_point();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::TraceStep()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::TraceStep(TracePhase phase, int resourceHandle, int requestId, Status status, ReadbackTrace::Clock::time_point start)
+{
+	// step from start to now, start taken while the trace was disabled makes the step instant
+	if (_trace == NULL || !_trace->IsEnabled())
+		return;
+
+	ReadbackTrace::Clock::time_point end = ReadbackTrace::Clock::now();
+	_trace->Record(phase, resourceHandle, requestId, (int)status, start == ReadbackTrace::Clock::time_point() ? end : start, end);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::CopyStaging()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::CopyStaging(StagingSlot* slot, CopyEngine* copyEngine)
+{
+	// runs on render thread or copy thread, slot is already mapped.
+	// 3D staging texture has all slices in one subresource, 2D staging texture has one subresource per slice.
+	// slices are packed one after another without padding
+	int subresources = (int)slot->mapped.size();
+	int slicesPerSubresource = slot->stagingSlices / subresources;
+
+	// reduction reads pixels straight from staging memory, only the result is stored in cpuBuffer
+	bool reduce = slot->request.reduction.flags != 0;
+	Reducer reducer(slot->request.reduction, slot->format);
+
+	// conversion is done row by row while the data are copied to cpuBuffer
+	bool convert = slot->request.conversion.IsEnabled();
+	Converter converter(slot->request.conversion, slot->format);
+	int dataRowPitch = convert ? Converter::GetPixelSize(slot->request.conversion, slot->format) * slot->stagingWidth : slot->rowPitch;
+	int sliceSize = dataRowPitch * slot->rowCount;
+	bool delta = slot->request.delta.IsEnabled();
+
+	for (int subresource = 0; subresource < subresources; ++subresource)
+	{
+		const MappedSubresource& resource = slot->mapped[subresource];
+		for (int slice = 0; slice < slicesPerSubresource; ++slice)
+		{
+			char* dest = ((char*)slot->cpuBuffer) + (subresource + slice) * sliceSize;
+			char* src = ((char*)resource.data) + slice * resource.depthPitch;
+
+			if (reduce)
+			{
+				for (int row = 0; row < slot->rowCount; ++row)
+					reducer.AddPixels(src + row * resource.rowPitch, slot->stagingWidth);
+				continue;
+			}
+
+			if (convert)
+			{
+				for (int row = 0; row < slot->rowCount; ++row)
+					converter.ConvertPixels(src + row * resource.rowPitch, slot->stagingWidth, dest + row * dataRowPitch);
+				continue;
+			}
+
+			// tiles are hashed band by band right after the band is copied, while it is still in cache
+			if (delta)
+			{
+				const DeltaLayout& layout = slot->deltaLayout;
+				unsigned long long* hashes = &slot->tileHashes[(subresource + slice) * layout.tilesX * layout.tilesY];
+				for (int row = 0; row < slot->rowCount; row += layout.tileRowCount)
+				{
+					int rows = slot->rowCount - row < layout.tileRowCount ? slot->rowCount - row : layout.tileRowCount;
+					copyEngine->CopyRows(dest + row * slot->rowPitch, slot->rowPitch, src + row * resource.rowPitch, resource.rowPitch, slot->rowPitch, rows);
+					HashTileBand(layout, dest + row * slot->rowPitch, rows, hashes + row / layout.tileRowCount * layout.tilesX);
+				}
+				continue;
+			}
+
+			// copy rows to system memory, large slices are copied in parallel
+			copyEngine->CopyRows(dest, slot->rowPitch, src, resource.rowPitch, slot->rowPitch, slot->rowCount);
+		}
+	}
+
+	if (reduce)
+	{
+		reducer.GetResult((ReductionResult*)slot->cpuBuffer);
+		slot->dataSize = sizeof(ReductionResult);
+		slot->dataRowPitch = sizeof(ReductionResult);
+	}
+	else
+	{
+		slot->dataSize = sliceSize * slot->stagingSlices;
+		slot->dataRowPitch = dataRowPitch;
+	}
+
+	if (_stats != NULL)
+		ReadbackStats::Add(_stats->bytesCopied, slot->bufferSize);
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::CanRequestData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::CanRequestData_MainThread(int resourceHandle)
+{
+	CpuResource* cpuResource = _resources.Get(resourceHandle);
+	if (cpuResource == NULL)
+		return Status::Error_InvalidArguments;
+
+	if (cpuResource->GetSlot(cpuResource->requestIndex)->bufferStatus != CpuResourceStatus::Ready)
+		return Status::Error_CopyInProgress;
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RequestData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RequestData_MainThread(int resourceHandle, int requestId, const ReadRequest& request)
+{
+	return BeginRequest(_resources.Get(resourceHandle), requestId, request);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RequestData_RenderThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RequestData_RenderThread(int resourceHandle)
+{
+	return IssueCopy(_resources.Get(resourceHandle));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::CopyData_RenderThread()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::CopyData_RenderThread(int resourceHandle)
+{
+	CopyData(_resources.Get(resourceHandle));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::PeekData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::PeekData_MainThread(int resourceHandle, int* requestId, int* dataSize)
+{
+	Status status;
+	StagingSlot* slot = PeekFinishedSlot(_resources.Get(resourceHandle), &status);
+	if (slot != NULL)
+	{
+		*requestId = slot->requestId;
+		*dataSize = slot->dataSize;
+	}
+
+	return status;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RetrieveData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RetrieveData_MainThread(int resourceHandle, void* data, int dataSize, int* requestId)
+{
+	return RetrieveData(_resources.Get(resourceHandle), data, dataSize, NULL, requestId);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RetrieveDelta_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RetrieveDelta_MainThread(int resourceHandle, void* data, int dataSize, int* deltaSize, int* requestId)
+{
+	*deltaSize = 0;
+	return RetrieveData(_resources.Get(resourceHandle), data, dataSize, deltaSize, requestId);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RequestTextureData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RequestTextureData_MainThread(int textureHandle, int requestId, const ReadRequest& request)
+{
+	// executed on main thread 
+	// prepare for render thread request that will come later
+	return BeginRequest(GetCpuResource(textureHandle, false), requestId, request);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RequestTextureData_RenderThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RequestTextureData_RenderThread(int textureHandle)
+{
+	return IssueCopy(GetCpuResource(textureHandle, false));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::CopyTextureData_RenderThread()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::CopyTextureData_RenderThread(int textureHandle)
+{
+	CopyData(GetCpuResource(textureHandle, false));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RetrieveTextureData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RetrieveTextureData_MainThread(int textureHandle, void* data, int dataSize, int* requestId)
+{
+	return RetrieveData(GetCpuResource(textureHandle, false), data, dataSize, NULL, requestId);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RequestBufferData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RequestBufferData_MainThread(int bufferHandle, int requestId, const ReadRequest& request)
+{
+	// executed on main thread 
+	// prepare for render thread request that will come later
+	return BeginRequest(GetCpuResource(bufferHandle, true), requestId, request);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RequestBufferData_RenderThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RequestBufferData_RenderThread(int bufferHandle)
+{
+	return IssueCopy(GetCpuResource(bufferHandle, true));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::CopyBufferData_RenderThread()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Staging::CopyBufferData_RenderThread(int bufferHandle)
+{
+	CopyData(GetCpuResource(bufferHandle, true));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging::RetrieveBufferData_MainThread()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Staging::RetrieveBufferData_MainThread(int bufferHandle, void* data, int dataSize, int* requestId)
+{
+	return RetrieveData(GetCpuResource(bufferHandle, true), data, dataSize, NULL, requestId);
+}
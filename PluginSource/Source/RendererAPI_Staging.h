@@ -0,0 +1,398 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "RendererAPI.h"
+#include "HandleTable.h"
+#include "CopyThread.h"
+#include "ReadbackStats.h"
+#include "ReadbackTrace.h"
+#include "CaptureSink.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+enum class CpuResourceStatus
+{
+	Ready,
+	WaitingForGpu,
+	// staging memory is mapped and copy thread copies it to cpuBuffer
+	Copying,
+	CopyFinished,
+	Leased
+};
+
+//-------------------------------------------------------------------------------------------------
+// StagingResource
+//-------------------------------------------------------------------------------------------------
+// backend part of staging slot, staging texture/buffer in cpu readable memory and completion marker
+// of the last copy. created and released by the backend, lent to slots from the staging pool
+struct StagingResource
+{
+	virtual ~StagingResource() {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// StagingKey
+//-------------------------------------------------------------------------------------------------
+// staging copies with equal keys have the same layout and can be used by any resource.
+// buffer copies are rounded up to size classes so buffers of similar size share them
+struct StagingKey
+{
+	// backend specific format of the staging copy, zero when the layout is given by pitch and size alone
+	int stagingFormat;
+	int width;
+	int height;
+	int slices;
+	int rowPitch;
+	int rowCount;
+	bool isBuffer;
+	bool is3D;
+
+	bool operator==(const StagingKey& key) const
+	{
+		return stagingFormat == key.stagingFormat && width == key.width && height == key.height && slices == key.slices &&
+			rowPitch == key.rowPitch && rowCount == key.rowCount && isBuffer == key.isBuffer && is3D == key.is3D;
+	}
+
+	// approximate memory of the copy, backends can add row alignment
+	long long Size() const { return (long long)rowPitch * rowCount * slices; }
+};
+
+//-------------------------------------------------------------------------------------------------
+// PooledStaging
+//-------------------------------------------------------------------------------------------------
+struct PooledStaging
+{
+	StagingKey key;
+	StagingResource* staging;
+	// frame the copy was returned in
+	unsigned int lastUsed;
+};
+
+//-------------------------------------------------------------------------------------------------
+// MappedSubresource
+//-------------------------------------------------------------------------------------------------
+struct MappedSubresource
+{
+	void* data;
+	int rowPitch;
+	// distance between depth slices of 3D texture
+	int depthPitch;
+};
+
+//-------------------------------------------------------------------------------------------------
+// StagingSlot
+//-------------------------------------------------------------------------------------------------
+struct StagingSlot
+{
+	// taken from the pool by the copy and returned once its data are in cpuBuffer
+	StagingResource* staging;
+	StagingKey stagingKey;
+	void* cpuBuffer;
+	// allocated size of cpuBuffer, can be bigger than bufferSize when pixels are converted
+	int cpuBufferSize;
+	int bufferSize;
+	// size and row pitch of data of the finished request, they differ from bufferSize/rowPitch when pixels
+	// are converted or reduced
+	int dataSize;
+	int dataRowPitch;
+	// tightly packed row of pixels (row of 4x4 blocks for compressed formats) and number of rows in one slice
+	int rowPitch;
+	int rowCount;
+	FormatTraits format;
+	// size of the copied region in texels (bytes and 1 for buffers), staging copy of buffer can be bigger
+	int stagingWidth;
+	int stagingHeight;
+	int stagingSlices;
+	// mapped subresources of staging copy, render thread maps/unmaps them and copy thread reads them while Copying
+	std::vector<MappedSubresource> mapped;
+	// delta request, tiles of cpuBuffer and their hashes computed while the data are copied to cpuBuffer
+	DeltaLayout deltaLayout;
+	std::vector<unsigned long long> tileHashes;
+	// written by main thread before the slot is handed to render thread
+	ReadRequest request;
+	int requestId;
+	ReadbackStats::Clock::time_point requestTime;
+	// written by render thread when the copy is issued
+	unsigned int issueFrame;
+	std::atomic<CpuResourceStatus> bufferStatus;
+	std::atomic<Status> lastStatus;
+
+	StagingSlot() : staging(NULL), stagingKey(), cpuBuffer(NULL), cpuBufferSize(0), bufferSize(0), dataSize(0), dataRowPitch(0), rowPitch(0), rowCount(0), format(kUnsupportedFormat), stagingWidth(0), stagingHeight(0), stagingSlices(0), requestId(-1), issueFrame(0), bufferStatus(CpuResourceStatus::Ready), lastStatus(Status::Succeeded) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// ResourceDesc
+//-------------------------------------------------------------------------------------------------
+// size of gpu resource. buffers are one row of width bytes
+struct ResourceDesc
+{
+	int width;
+	int height;
+	// array size of 2D texture (6 per cube), depth of 3D texture
+	int slices;
+	int mipLevels;
+	bool is3D;
+	FormatTraits format;
+	// backend specific staging format, see StagingKey. zero unless DescribeResource sets it
+	int stagingFormat;
+};
+
+//-------------------------------------------------------------------------------------------------
+// CopyRegion
+//-------------------------------------------------------------------------------------------------
+// ReadRegion resolved against the gpu resource on render thread
+struct CopyRegion
+{
+	// texels within the mip level, bytes of buffer
+	int x;
+	int y;
+	int width;
+	int height;
+	int mipLevel;
+	// mip count of the gpu resource, needed to compute subresource index
+	int mipLevels;
+	// first array slice/cube face of 2D texture, first depth slice of 3D texture
+	int firstSlice;
+	int sliceCount;
+	bool is3D;
+	// region covers the whole subresource, always set for depth formats (ResolveRegion rejects other regions)
+	bool wholeSubresource;
+	FormatTraits format;
+	int stagingFormat;
+};
+
+//-------------------------------------------------------------------------------------------------
+// CpuResource
+//-------------------------------------------------------------------------------------------------
+// ring of staging slots, every request takes the next one so several copies can be in flight at once.
+// requestIndex and retrieveIndex are used only on main thread, issueIndex and copyIndex only on render thread.
+// slots are handed over between threads through bufferStatus
+struct CpuResource
+{
+	// native resource as passed by Unity
+	void* gpuResource;
+	bool isBuffer;
+	// handle returned by RegisterResource_MainThread, reported with completions
+	int handle;
+	// resource is in the list of resources checked by PollCopies_RenderThread, render thread only
+	bool polled;
+
+	StagingSlot* slots;
+	int slotCount;
+	unsigned int requestIndex;
+	unsigned int retrieveIndex;
+	unsigned int issueIndex;
+	unsigned int copyIndex;
+	// tile hashes of the last delivered request, delta requests return tiles that differ from them. main thread only,
+	// empty when the last delivered request wasn't delta request
+	DeltaLayout deliveredLayout;
+	std::vector<unsigned long long> deliveredHashes;
+
+	CpuResource(void* resource, bool buffer, int count) : gpuResource(resource), isBuffer(buffer), handle(-1), polled(false), slots(new StagingSlot[count]), slotCount(count), requestIndex(0), retrieveIndex(0), issueIndex(0), copyIndex(0) {}
+	~CpuResource() { delete[] slots; }
+
+	StagingSlot* GetSlot(unsigned int index) { return &slots[index % slotCount]; }
+};
+
+//-------------------------------------------------------------------------------------------------
+// SubscriptionResult
+//-------------------------------------------------------------------------------------------------
+struct SubscriptionResult
+{
+	// cpuBuffer of the slot that finished the copy, the slot gets the previous buffer of the result instead
+	void* data;
+	int capacity;
+	int dataSize;
+	// poll event that issued the copy
+	unsigned int frame;
+	Status status;
+	// main thread copies the data out, render thread doesn't overwrite the result meanwhile
+	bool pinned;
+
+	SubscriptionResult() : data(NULL), capacity(0), dataSize(0), frame(0), status(Status::Succeeded), pinned(false) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// Subscription
+//-------------------------------------------------------------------------------------------------
+// continuous readback of one resource. copies go through private ring of staging slots whose indices are all
+// used on render thread, poll event requests copy every everyNFrames events and publishes finished ones to
+// ring of the newest results. results main thread didn't read in time are overwritten (drop oldest).
+// capture has no results, finished copies are handed to its sink and their slots are reused once written. stopped
+// capture stays in the handle table until main thread saw it finished
+struct Subscription
+{
+	int resourceHandle;
+	int everyNFrames;
+	CpuResource* cpuResource;
+	CaptureSink* capture;
+	// poll event of the first copy, render thread only
+	unsigned int startFrame;
+	// capture was stopped, main thread only
+	bool stopped;
+	// stopped capture closed its file and render thread released the slots, main thread owns it from then on
+	std::atomic<bool> finished;
+
+	// guards results and counters, held by main thread only while it looks for the result it reads
+	std::mutex mutex;
+	std::vector<SubscriptionResult> results;
+	// result n is results[n % results.size()]
+	unsigned long long published;
+	unsigned long long read;
+	int dropped;
+
+	Subscription(int handle, int frames, int depth, CpuResource* resource, CaptureSink* sink) : resourceHandle(handle), everyNFrames(frames), cpuResource(resource), capture(sink), startFrame(0), stopped(false), finished(false), results(depth), published(0), read(0), dropped(0) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Staging
+//-------------------------------------------------------------------------------------------------
+// request/completion state machine shared by backends that read resources through staging copies.
+// backend only creates staging copies, issues gpu copy followed by completion marker (event query, fence, 
+// timeline value), polls the marker and maps finished copies. staging memory is mapped only after the marker
+// says the copy is complete
+class RendererAPI_Staging : public RendererAPI
+{
+public:
+	RendererAPI_Staging();
+	virtual ~RendererAPI_Staging();
+
+	virtual Status RegisterResource_MainThread(void* nativeResource, bool isBuffer, int* resourceHandle);
+
+	virtual Status RequestTextureData_MainThread(int textureHandle, int requestId, const ReadRequest& request);
+	virtual Status RequestTextureData_RenderThread(int textureHandle);
+	virtual void CopyTextureData_RenderThread(int textureHandle);
+	virtual Status RetrieveTextureData_MainThread(int textureHandle, void* data, int dataSize, int* requestId);
+
+	virtual Status RequestBufferData_MainThread(int bufferHandle, int requestId, const ReadRequest& request);
+	virtual Status RequestBufferData_RenderThread(int bufferHandle);
+	virtual void CopyBufferData_RenderThread(int bufferHandle);
+	virtual Status RetrieveBufferData_MainThread(int bufferHandle, void* data, int dataSize, int* requestId);
+
+	virtual Status AcquireData_MainThread(int resourceHandle, const void** data, int* dataSize, int* rowPitch, int* requestId);
+	virtual Status ReleaseData_MainThread(int resourceHandle, int requestId);
+
+	virtual Status CanRequestData_MainThread(int resourceHandle);
+	virtual Status RequestData_MainThread(int resourceHandle, int requestId, const ReadRequest& request);
+	virtual Status RequestData_RenderThread(int resourceHandle);
+	virtual void CopyData_RenderThread(int resourceHandle);
+	virtual Status PeekData_MainThread(int resourceHandle, int* requestId, int* dataSize);
+	virtual Status RetrieveData_MainThread(int resourceHandle, void* data, int dataSize, int* requestId);
+	virtual Status RetrieveDelta_MainThread(int resourceHandle, void* data, int dataSize, int* deltaSize, int* requestId);
+	virtual void PollCopies_RenderThread();
+
+	virtual void* ReleaseTempResources_MainThread(int resourceHandle);
+	virtual void ReleaseTempResources_RenderThread(void* resource);
+
+	virtual Status Subscribe_MainThread(int resourceHandle, int everyNFrames, int ringDepth, int* subscription);
+	virtual void Subscribe_RenderThread(int subscription);
+	virtual void* Unsubscribe_MainThread(int subscription);
+	virtual void Unsubscribe_RenderThread(void* subscription);
+	virtual Status RetrieveSubscription_MainThread(int subscription, bool latest, void* data, int dataSize, unsigned int* frame, int* dropped);
+	virtual Status StartCapture_MainThread(int resourceHandle, int everyNFrames, int depth, const char* path, long long maxBytes, int* capture);
+	virtual Status GetCaptureStatus_MainThread(int capture, int* written, int* skipped, int* failed, long long* bytes, bool* finished);
+
+protected:
+	// backend interface, everything is called on render thread
+	virtual Status DescribeResource(CpuResource* cpuResource, ResourceDesc* desc) = 0;
+	// creates slot->staging big enough for the region, the copy is later reused for any region with the same key
+	virtual Status CreateStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot) = 0;
+	// copy can still be in flight when its resource is released
+	virtual void ReleaseStaging(StagingResource* staging) = 0;
+	// copies the region to staging copy and puts completion marker after it
+	virtual void IssueGpuCopy(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot) = 0;
+	// checks only the completion marker, NotReady while the copy is in flight
+	virtual Status QueryCompletion(StagingSlot* slot) = 0;
+	// fills slot->mapped, one entry per array slice of 2D texture, single entry for buffers and 3D textures
+	virtual Status MapStaging(StagingSlot* slot) = 0;
+	virtual void UnmapStaging(StagingSlot* slot) = 0;
+
+	// releases every resource, backend calls it when the device is shut down
+	void ReleaseResources();
+
+private:
+	void ReleaseCpuResource(CpuResource* cpuResource);
+	void ReleaseStagingSlot(StagingSlot* slot);
+	Status AddSubscription(int resourceHandle, int everyNFrames, int ringDepth, int slotCount, CaptureSink* capture, int* subscription);
+	void ReleaseSubscription(Subscription* subscription);
+	void ReleaseClosedCaptures();
+	void UpdateSubscription(Subscription* subscription);
+	void PublishResults(Subscription* subscription);
+	bool WriteCapture(CaptureSink* capture, StagingSlot* slot);
+	CpuResource* GetCpuResource(int resourceHandle, bool isBuffer);
+	Status BeginRequest(CpuResource* cpuResource, int requestId, const ReadRequest& request);
+	StagingSlot* IssueRequest(CpuResource* cpuResource);
+	Status IssueCopy(CpuResource* cpuResource);
+	Status ResolveRegion(CpuResource* cpuResource, const ReadRegion& region, CopyRegion* copyRegion);
+	Status AcquireStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot);
+	void ReturnStaging(StagingSlot* slot);
+	void DiscardStaging(StagingSlot* slot);
+	void EvictStaging(long long budget, int idleFrames);
+	void ReleaseStagingPool();
+	bool HoldsStaging(CpuResource* cpuResource);
+	Status ValidateRequest(CpuResource* cpuResource, StagingSlot* slot);
+	Status ReserveCpuBuffer(StagingSlot* slot, const CopyRegion& copyRegion);
+	// delta request is returned as delta when deltaSize isn't NULL, raw data are returned otherwise
+	Status RetrieveData(CpuResource* cpuResource, void* data, int dataSize, int* deltaSize, int* requestId);
+	void DeliverHashes(CpuResource* cpuResource, StagingSlot* slot);
+	StagingSlot* PeekFinishedSlot(CpuResource* cpuResource, Status* status);
+	void CopyData(CpuResource* cpuResource);
+	Status CopyStaging(StagingSlot* slot, CopyEngine* copyEngine);
+	void NotifyCompletion(int resourceHandle, int requestId, Status status);
+	void RecordCompletion(StagingSlot* slot, Status status, unsigned int frames);
+	void RecordStagingBytes();
+	ReadbackTrace::Clock::time_point TraceStart() const;
+	void TraceStep(TracePhase phase, int resourceHandle, int requestId, Status status, ReadbackTrace::Clock::time_point start);
+
+private:
+	HandleTable<CpuResource> _resources;
+	// resources with copies in flight on gpu, render thread only
+	std::vector<CpuResource*> _polledResources;
+	HandleTable<Subscription> _subscriptions;
+	// subscriptions started on render thread, updated by every poll event
+	std::vector<Subscription*> _activeSubscriptions;
+	// stopped captures whose writer is still busy, their slots are released once the file is closed. render thread only
+	std::vector<Subscription*> _closingCaptures;
+	// subscription copies get negative request ids so they don't collide with user requests, render thread only
+	unsigned int _subscriptionCopies;
+	// free staging copies from the least recently used one, render thread only
+	std::deque<PooledStaging> _stagingPool;
+	// memory of copies in the pool and of copies lent to slots
+	long long _pooledBytes;
+	long long _lentBytes;
+	// counts poll events (one per frame), copies idle for too many of them are released
+	unsigned int _frame;
+	// copies mapped staging memory to cpuBuffer, render thread only
+	CopyEngine _copyEngine;
+	// used instead of _copyEngine when copy thread is enabled. declared last, it is joined before slots are destroyed
+	CopyThread _copyThread;
+};
@@ -0,0 +1,455 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "RendererAPI_Vulkan.h"
+
+#if SUPPORT_VULKAN
+
+#include <string.h>
+
+// functions are loaded through Unity's vkGetInstanceProcAddr, so layers and hooks installed by Unity see them
+#define VULKAN_INSTANCE_FUNCTIONS(apply) \
+	apply(vkGetDeviceProcAddr) \
+	apply(vkGetPhysicalDeviceMemoryProperties)
+
+#define VULKAN_DEVICE_FUNCTIONS(apply) \
+	apply(vkCreateBuffer) \
+	apply(vkDestroyBuffer) \
+	apply(vkGetBufferMemoryRequirements) \
+	apply(vkAllocateMemory) \
+	apply(vkFreeMemory) \
+	apply(vkBindBufferMemory) \
+	apply(vkMapMemory) \
+	apply(vkInvalidateMappedMemoryRanges) \
+	apply(vkCmdCopyBuffer) \
+	apply(vkCmdCopyImageToBuffer) \
+	apply(vkCmdPipelineBarrier) \
+	apply(vkDeviceWaitIdle)
+
+#define VULKAN_DECLARE_FUNCTION(name) static PFN_##name name = NULL;
+VULKAN_INSTANCE_FUNCTIONS(VULKAN_DECLARE_FUNCTION)
+VULKAN_DEVICE_FUNCTIONS(VULKAN_DECLARE_FUNCTION)
+#undef VULKAN_DECLARE_FUNCTION
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::RendererAPI_Vulkan()
+//-------------------------------------------------------------------------------------------------
+RendererAPI_Vulkan::RendererAPI_Vulkan()
+	: _vulkan(NULL), _safeFrame(0)
+{
+	memset(&_instance, 0, sizeof(_instance));
+	memset(&_memoryProperties, 0, sizeof(_memoryProperties));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::~RendererAPI_Vulkan()
+//-------------------------------------------------------------------------------------------------
+RendererAPI_Vulkan::~RendererAPI_Vulkan()
+{
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::ProcessDeviceEvent()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Vulkan::ProcessDeviceEvent(UnityGfxDeviceEventType eventType, IUnityInterfaces* interfaces)
+{
+	switch (eventType)
+	{
+	case kUnityGfxDeviceEventInitialize:
+		_vulkan = interfaces->Get<IUnityGraphicsVulkan>();
+		if (_vulkan == NULL)
+			break;
+
+		_instance = _vulkan->Instance();
+		if (!LoadFunctions())
+		{
+			_vulkan = NULL;
+			break;
+		}
+
+		vkGetPhysicalDeviceMemoryProperties(_instance.physicalDevice, &_memoryProperties);
+		break;
+
+	case kUnityGfxDeviceEventShutdown:
+		if (_vulkan == NULL)
+			break;
+
+		// slots are retired, nothing can be in flight once the device is idle
+		ReleaseResources();
+		vkDeviceWaitIdle(_instance.device);
+		DestroyRetiredBuffers(true);
+		_vulkan = NULL;
+		break;
+
+	default:
+		break;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::LoadFunctions()
+//-------------------------------------------------------------------------------------------------
+bool RendererAPI_Vulkan::LoadFunctions()
+{
+	bool loaded = true;
+
+#define VULKAN_LOAD_INSTANCE_FUNCTION(name) \
+	name = (PFN_##name)_instance.getInstanceProcAddr(_instance.instance, #name); \
+	loaded = loaded && name != NULL;
+	VULKAN_INSTANCE_FUNCTIONS(VULKAN_LOAD_INSTANCE_FUNCTION)
+#undef VULKAN_LOAD_INSTANCE_FUNCTION
+
+	if (!loaded)
+		return false;
+
+#define VULKAN_LOAD_DEVICE_FUNCTION(name) \
+	name = (PFN_##name)vkGetDeviceProcAddr(_instance.device, #name); \
+	loaded = loaded && name != NULL;
+	VULKAN_DEVICE_FUNCTIONS(VULKAN_LOAD_DEVICE_FUNCTION)
+#undef VULKAN_LOAD_DEVICE_FUNCTION
+
+	return loaded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::FindMemoryType()
+//-------------------------------------------------------------------------------------------------
+int RendererAPI_Vulkan::FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags* flags)
+{
+	// cached memory is read by cpu at full speed, uncached memory is read one bus transaction at a time
+	const VkMemoryPropertyFlags preferred[] =
+	{
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+	};
+
+	for (size_t i = 0; i < sizeof(preferred) / sizeof(preferred[0]); ++i)
+	{
+		for (uint32_t type = 0; type < _memoryProperties.memoryTypeCount; ++type)
+		{
+			VkMemoryPropertyFlags typeFlags = _memoryProperties.memoryTypes[type].propertyFlags;
+			if ((typeBits & (1u << type)) != 0 && (typeFlags & preferred[i]) == preferred[i])
+			{
+				*flags = typeFlags;
+				return (int)type;
+			}
+		}
+	}
+
+	return -1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::IsFrameFinished()
+//-------------------------------------------------------------------------------------------------
+bool RendererAPI_Vulkan::IsFrameFinished(unsigned long long frame)
+{
+	// Unity tracks completion of its command buffers with its own fences, gpu has finished every frame
+	// up to safeFrameNumber. cached value answers most polls with one compare
+	if (frame <= _safeFrame)
+		return true;
+
+	UnityVulkanRecordingState state;
+	if (!_vulkan->CommandRecordingState(&state, kUnityVulkanGraphicsQueueAccess_DontCare))
+		return false;
+
+	_safeFrame = state.safeFrameNumber;
+	return frame <= _safeFrame;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::DescribeResource()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Vulkan::DescribeResource(CpuResource* cpuResource, ResourceDesc* desc)
+{
+	if (_vulkan == NULL)
+		return Status::Error_UnsupportedAPI;
+
+	// observe only access doesn't record barriers, it only returns the description
+	if (cpuResource->isBuffer)
+	{
+		UnityVulkanBuffer buffer;
+		if (!_vulkan->AccessBuffer(cpuResource->gpuResource, 0, 0, kUnityVulkanResourceAccess_ObserveOnly, &buffer))
+			return Status::Error_InvalidArguments;
+
+		desc->width = (int)buffer.sizeInBytes;
+		return Status::Succeeded;
+	}
+
+	UnityVulkanImage image;
+	if (!_vulkan->AccessTexture(cpuResource->gpuResource, UnityVulkanWholeImage, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, kUnityVulkanResourceAccess_ObserveOnly, &image))
+		return Status::Error_InvalidArguments;
+
+	if (image.samples != VK_SAMPLE_COUNT_1_BIT)
+		return Status::Error_UnsupportedFormat;
+
+	// cube textures are 2D images with 6 layers per cube
+	desc->width = image.extent.width;
+	desc->height = image.extent.height;
+	desc->slices = image.type == VK_IMAGE_TYPE_3D ? (int)image.extent.depth : image.layers;
+	desc->mipLevels = image.mipCount;
+	desc->is3D = image.type == VK_IMAGE_TYPE_3D;
+	desc->format = GetVkFormatTraits(image.format);
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::CreateStaging()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Vulkan::CreateStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot)
+{
+	// rows and slices are tightly packed, copy uses zero buffer row length and image height
+	StagingResource_Vulkan* staging = new StagingResource_Vulkan();
+	staging->rowPitch = copyRegion.format.RowPitch(copyRegion.width);
+	staging->slicePitch = staging->rowPitch * copyRegion.format.RowCount(copyRegion.height);
+	staging->subresources = cpuResource->isBuffer || copyRegion.is3D ? 1 : copyRegion.sliceCount;
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = (VkDeviceSize)staging->slicePitch * copyRegion.sliceCount;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(_instance.device, &bufferInfo, NULL, &staging->buffer) != VK_SUCCESS)
+	{
+		ReleaseStaging(staging);
+		return Status::Error_UnknownError;
+	}
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(_instance.device, staging->buffer, &requirements);
+	VkMemoryPropertyFlags flags = 0;
+	int memoryType = FindMemoryType(requirements.memoryTypeBits, &flags);
+
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = (uint32_t)memoryType;
+
+	void* data = NULL;
+	if (memoryType < 0 ||
+		vkAllocateMemory(_instance.device, &allocateInfo, NULL, &staging->memory) != VK_SUCCESS ||
+		vkBindBufferMemory(_instance.device, staging->buffer, staging->memory, 0) != VK_SUCCESS ||
+		vkMapMemory(_instance.device, staging->memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS)
+	{
+		ReleaseStaging(staging);
+		return Status::Error_UnknownError;
+	}
+
+	staging->data = (char*)data;
+	staging->coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	slot->staging = staging;
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::ReleaseStaging()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Vulkan::ReleaseStaging(StagingResource* staging)
+{
+	// gpu can still write to the buffer when its resource is released before the copy finished
+	StagingResource_Vulkan* stagingVulkan = (StagingResource_Vulkan*)staging;
+	if (stagingVulkan->buffer != VK_NULL_HANDLE || stagingVulkan->memory != VK_NULL_HANDLE)
+	{
+		if (IsFrameFinished(stagingVulkan->frame))
+		{
+			DestroyBuffer(stagingVulkan->buffer, stagingVulkan->memory);
+		}
+		else
+		{
+			RetiredBuffer retired = { stagingVulkan->buffer, stagingVulkan->memory, stagingVulkan->frame };
+			_retired.push_back(retired);
+		}
+	}
+
+	delete stagingVulkan;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::DestroyBuffer()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Vulkan::DestroyBuffer(VkBuffer buffer, VkDeviceMemory memory)
+{
+	// freeing the memory unmaps it
+	if (buffer != VK_NULL_HANDLE)
+		vkDestroyBuffer(_instance.device, buffer, NULL);
+	if (memory != VK_NULL_HANDLE)
+		vkFreeMemory(_instance.device, memory, NULL);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::DestroyRetiredBuffers()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Vulkan::DestroyRetiredBuffers(bool all)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < _retired.size(); ++i)
+	{
+		if (all || IsFrameFinished(_retired[i].frame))
+			DestroyBuffer(_retired[i].buffer, _retired[i].memory);
+		else
+			_retired[kept++] = _retired[i];
+	}
+
+	_retired.resize(kept);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::IssueGpuCopy()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Vulkan::IssueGpuCopy(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot)
+{
+	StagingResource_Vulkan* staging = (StagingResource_Vulkan*)slot->staging;
+	staging->failed = true;
+	DestroyRetiredBuffers(false);
+
+	// transfer commands can't be recorded inside render pass. resource access records barrier that moves 
+	// the resource to transfer source and invalidates recording state, so the state is queried after it
+	_vulkan->EnsureOutsideRenderPass();
+
+	UnityVulkanRecordingState state;
+	if (cpuResource->isBuffer)
+	{
+		UnityVulkanBuffer buffer;
+		if (!_vulkan->AccessBuffer(cpuResource->gpuResource, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, kUnityVulkanResourceAccess_PipelineBarrier, &buffer) ||
+			!_vulkan->CommandRecordingState(&state, kUnityVulkanGraphicsQueueAccess_DontCare))
+			return;
+
+		VkBufferCopy region = {};
+		region.srcOffset = copyRegion.x;
+		region.dstOffset = 0;
+		region.size = copyRegion.width;
+		vkCmdCopyBuffer(state.commandBuffer, buffer.buffer, staging->buffer, 1, &region);
+	}
+	else
+	{
+		UnityVulkanImage image;
+		if (!_vulkan->AccessTexture(cpuResource->gpuResource, UnityVulkanWholeImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+			VK_ACCESS_TRANSFER_READ_BIT, kUnityVulkanResourceAccess_PipelineBarrier, &image) ||
+			!_vulkan->CommandRecordingState(&state, kUnityVulkanGraphicsQueueAccess_DontCare))
+			return;
+
+		// one aspect per copy, depth of depth/stencil images
+		VkImageAspectFlags aspect = (image.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) != 0 ? VK_IMAGE_ASPECT_DEPTH_BIT :
+			(image.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) != 0 ? VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+
+		// array layers/cube faces are layers of the subresource, depth slices of 3D image are z.
+		// both are copied in one region, slices end up one after another in the buffer
+		VkBufferImageCopy region = {};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = aspect;
+		region.imageSubresource.mipLevel = copyRegion.mipLevel;
+		region.imageSubresource.baseArrayLayer = copyRegion.is3D ? 0 : copyRegion.firstSlice;
+		region.imageSubresource.layerCount = copyRegion.is3D ? 1 : copyRegion.sliceCount;
+		region.imageOffset.x = copyRegion.x;
+		region.imageOffset.y = copyRegion.y;
+		region.imageOffset.z = copyRegion.is3D ? copyRegion.firstSlice : 0;
+		region.imageExtent.width = copyRegion.width;
+		region.imageExtent.height = copyRegion.height;
+		region.imageExtent.depth = copyRegion.is3D ? copyRegion.sliceCount : 1;
+		vkCmdCopyImageToBuffer(state.commandBuffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging->buffer, 1, &region);
+	}
+
+	// copy result has to be visible to host reads once the frame is finished
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = staging->buffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(state.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &barrier, 0, NULL);
+
+	staging->frame = state.currentFrameNumber;
+	staging->failed = false;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::QueryCompletion()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Vulkan::QueryCompletion(StagingSlot* slot)
+{
+	StagingResource_Vulkan* staging = (StagingResource_Vulkan*)slot->staging;
+	if (staging->failed)
+		return Status::Error_UnknownError;
+
+	return IsFrameFinished(staging->frame) ? Status::Succeeded : Status::NotReady;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::MapStaging()
+//-------------------------------------------------------------------------------------------------
+Status RendererAPI_Vulkan::MapStaging(StagingSlot* slot)
+{
+	// buffer is mapped persistently, cached non-coherent memory only needs cpu caches invalidated
+	StagingResource_Vulkan* staging = (StagingResource_Vulkan*)slot->staging;
+	if (!staging->coherent)
+	{
+		VkMappedMemoryRange range = {};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = staging->memory;
+		range.offset = 0;
+		range.size = VK_WHOLE_SIZE;
+		if (vkInvalidateMappedMemoryRanges(_instance.device, 1, &range) != VK_SUCCESS)
+			return Status::Error_UnknownError;
+	}
+
+	int slicesPerSubresource = slot->stagingSlices / staging->subresources;
+	slot->mapped.resize(staging->subresources);
+	for (int subresource = 0; subresource < staging->subresources; ++subresource)
+	{
+		slot->mapped[subresource].data = staging->data + (size_t)subresource * slicesPerSubresource * staging->slicePitch;
+		slot->mapped[subresource].rowPitch = staging->rowPitch;
+		slot->mapped[subresource].depthPitch = staging->slicePitch;
+	}
+
+	return Status::Succeeded;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan::UnmapStaging()
+//-------------------------------------------------------------------------------------------------
+void RendererAPI_Vulkan::UnmapStaging(StagingSlot* slot)
+{
+	// persistent mapping stays until the buffer is destroyed
+	slot->mapped.clear();
+}
+
+//-------------------------------------------------------------------------------------------------
+// CreateRendererAPI_Vulkan
+//-------------------------------------------------------------------------------------------------
+RendererAPI* CreateRendererAPI_Vulkan()
+{
+	return new RendererAPI_Vulkan();
+}
+
+#endif // SUPPORT_VULKAN
@@ -0,0 +1,108 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "RendererAPI_Staging.h"
+#include "PlatformBase.h"
+
+#if SUPPORT_VULKAN
+
+#include "FormatTraits_Vulkan.h"
+#include "Unity/IUnityGraphicsVulkan.h"
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+// StagingResource_Vulkan
+//-------------------------------------------------------------------------------------------------
+struct StagingResource_Vulkan : public StagingResource
+{
+	// readback buffer in host visible (cached when available) memory, mapped for its whole life
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+	char* data;
+	// non-coherent memory is invalidated before the data are read
+	bool coherent;
+	int rowPitch;
+	int slicePitch;
+	// one per 2D slice, single one for buffers and 3D textures
+	int subresources;
+	// Unity frame whose command buffer contains the copy, copy is finished once Unity's safe frame reaches it
+	unsigned long long frame;
+	// Unity refused access to the resource, the copy wasn't recorded
+	bool failed;
+
+	StagingResource_Vulkan() : buffer(VK_NULL_HANDLE), memory(VK_NULL_HANDLE), data(NULL), coherent(false), rowPitch(0), slicePitch(0), subresources(0), frame(0), failed(false) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// RendererAPI_Vulkan
+//-------------------------------------------------------------------------------------------------
+// copies are recorded into Unity's command buffer, completion is tracked on Unity's frame timeline
+class RendererAPI_Vulkan : public RendererAPI_Staging
+{
+public:
+	RendererAPI_Vulkan();
+	virtual ~RendererAPI_Vulkan();
+
+	virtual void ProcessDeviceEvent(UnityGfxDeviceEventType eventType, IUnityInterfaces* interfaces);
+
+protected:
+	virtual Status DescribeResource(CpuResource* cpuResource, ResourceDesc* desc);
+	virtual Status CreateStaging(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot);
+	virtual void ReleaseStaging(StagingResource* staging);
+	virtual void IssueGpuCopy(CpuResource* cpuResource, const CopyRegion& copyRegion, StagingSlot* slot);
+	virtual Status QueryCompletion(StagingSlot* slot);
+	virtual Status MapStaging(StagingSlot* slot);
+	virtual void UnmapStaging(StagingSlot* slot);
+
+private:
+	struct RetiredBuffer
+	{
+		VkBuffer buffer;
+		VkDeviceMemory memory;
+		unsigned long long frame;
+	};
+
+	bool LoadFunctions();
+	int FindMemoryType(uint32_t typeBits, VkMemoryPropertyFlags* flags);
+	bool IsFrameFinished(unsigned long long frame);
+	void DestroyBuffer(VkBuffer buffer, VkDeviceMemory memory);
+	void DestroyRetiredBuffers(bool all);
+
+private:
+	IUnityGraphicsVulkan* _vulkan;
+	UnityVulkanInstance _instance;
+	VkPhysicalDeviceMemoryProperties _memoryProperties;
+	// last safe frame reported by Unity, polls compare against it and ask Unity only when it's behind
+	unsigned long long _safeFrame;
+	// readback buffers released while gpu could still write to them, destroyed once their frame is safe
+	std::vector<RetiredBuffer> _retired;
+};
+
+#endif // SUPPORT_VULKAN
@@ -17,6 +17,7 @@ typedef enum UnityGfxRenderer
 	kUnityGfxRendererMetal             = 16, // iOS Metal
 	kUnityGfxRendererOpenGLCore        = 17, // OpenGL core
 	kUnityGfxRendererD3D12             = 18, // Direct3D 12
+	kUnityGfxRendererVulkan            = 21, // Vulkan
 } UnityGfxRenderer;
 
 typedef enum UnityGfxDeviceEventType
@@ -47,3 +48,9 @@ UNITY_REGISTER_INTERFACE_GUID(0x7CBA0A9CA4DDB544ULL,0x8C5AD4926EB17B11ULL,IUnity
 // Certain Unity APIs (GL.IssuePluginEvent, CommandBuffer.IssuePluginEvent) can callback into native plugins.
 // Provide them with an address to a function of this signature.
 typedef void (UNITY_INTERFACE_API * UnityRenderingEvent)(int eventId);
+
+// Same as UnityRenderingEvent, with user data pointer
+typedef void (UNITY_INTERFACE_API * UnityRenderingEventAndData)(int eventId, void* data);
+
+struct RenderSurfaceBase;
+typedef struct RenderSurfaceBase* UnityRenderBuffer;
@@ -0,0 +1,924 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// readback benchmark. drives exported functions of the plugin the same way AsyncTextureReader.cs does,
+// against the software backend (null device). reports per call latency percentiles, frames between request
+// and data, throughput and render thread time per frame, optionally writes the results as json.
+// --verify checks correctness of the results instead (Verify.cpp)
+
+#include "PluginAPI.h"
+#include "ReadbackStats.h"
+#include "CaptureSink.h"
+#include "Verify.h"
+#include "UnityHost/UnityHost.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// plugin default, free staging copies are released after this many poll events
+static const int kStagingIdleFrames = 120;
+
+//-------------------------------------------------------------------------------------------------
+// Options
+//-------------------------------------------------------------------------------------------------
+struct Options
+{
+	int frames;
+	// zero runs frames back to back
+	double frameMs;
+	int latencyFrames;
+	float bandwidthMBps;
+	int rowPitchAlignment;
+	int ringSize;
+	// memory budget of the staging pool in MB, zero is unlimited
+	int stagingBudgetMB;
+	bool copyThread;
+	// plugin events run on render thread of the host instead of inline on the benchmark thread
+	bool renderThread;
+	// one poll event per frame, resources are retrieved only after their completion is reported
+	bool notify;
+	// resources are subscribed instead of requested, poll event copies them and main thread only reads results
+	bool subscribe;
+	// textures are requested as deltas with tiles of this size, zero requests raw data
+	int deltaTile;
+	// resources are captured to files with this prefix instead of being requested, files are checked after each scenario
+	const char* capturePath;
+	bool quick;
+	// results are compared with cpu reference instead of being measured
+	bool verify;
+	const char* filter;
+	const char* jsonPath;
+	// request timeline of the last scenarios (the trace ring keeps the newest events)
+	const char* tracePath;
+
+	Options() : frames(120), frameMs(0.0), latencyFrames(2), bandwidthMBps(0.0f), rowPitchAlignment(256), ringSize(3), stagingBudgetMB(0), copyThread(false), renderThread(false), notify(false), subscribe(false), deltaTile(0), capturePath(NULL), quick(false), verify(false), filter(NULL), jsonPath(NULL), tracePath(NULL) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// Scenario
+//-------------------------------------------------------------------------------------------------
+struct Scenario
+{
+	std::string name;
+	bool isBuffer;
+	int resourceCount;
+	// bytes for buffers
+	int width;
+	int height;
+	int componentType;
+	int channels;
+	int pixelSize;
+	// every resource is requested every interval frames, requests of resources are spread over the interval
+	int interval;
+
+	int DataSize() const { return width * height * pixelSize; }
+};
+
+//-------------------------------------------------------------------------------------------------
+// Samples
+//-------------------------------------------------------------------------------------------------
+struct Samples
+{
+	std::vector<double> values;
+
+	void Add(double value) { values.push_back(value); }
+	size_t Count() const { return values.size(); }
+
+	double Mean() const
+	{
+		double sum = 0.0;
+		for (size_t i = 0; i < values.size(); ++i)
+			sum += values[i];
+		return values.empty() ? 0.0 : sum / values.size();
+	}
+
+	// nearest rank percentile, p in 0..100
+	double Percentile(double p)
+	{
+		if (values.empty())
+			return 0.0;
+
+		std::sort(values.begin(), values.end());
+		size_t rank = (size_t)(p / 100.0 * (values.size() - 1) + 0.5);
+		return values[rank];
+	}
+};
+
+//-------------------------------------------------------------------------------------------------
+// Result
+//-------------------------------------------------------------------------------------------------
+struct Result
+{
+	Scenario scenario;
+	int requests;
+	int completed;
+	int failed;
+	// requests that couldn't be issued because every staging slot of the resource was busy
+	int rejected;
+	// subscription results overwritten before they were read
+	int dropped;
+	double seconds;
+	double bytes;
+	// microseconds
+	Samples requestCall;
+	Samples retrieveCall;
+	Samples renderEvent;
+	Samples renderPerFrame;
+	Samples framesToData;
+	// plugin side counters of the scenario
+	ReadbackStatsSnapshot stats;
+};
+
+// null device host, plugin is linked to the benchmark
+static UnityHost* sHost = NULL;
+static bool sRenderThread = false;
+// poll events issued so far, subscription results are tagged with the poll event that copied them
+static int sPollCount = 0;
+static int sDeltaTile = 0;
+
+//-------------------------------------------------------------------------------------------------
+// Microseconds
+//-------------------------------------------------------------------------------------------------
+static double Microseconds(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+//-------------------------------------------------------------------------------------------------
+// RenderEvent
+//-------------------------------------------------------------------------------------------------
+// returns time spent on render thread, events issued to render thread of the host are timed by the host
+static double RenderEvent(UnityRenderingEvent func, int eventId, Result* result)
+{
+	if (eventId < 0)
+		return 0.0;
+
+	if (sRenderThread)
+	{
+		sHost->IssuePluginEvent(func, eventId);
+		return 0.0;
+	}
+
+	Clock::time_point start = Clock::now();
+	func(eventId);
+	double time = Microseconds(start, Clock::now());
+	result->renderEvent.Add(time);
+	return time;
+}
+
+//-------------------------------------------------------------------------------------------------
+// ResourceState
+//-------------------------------------------------------------------------------------------------
+struct PendingRequest
+{
+	int requestId;
+	int frame;
+};
+
+struct ResourceState
+{
+	void* nativeResource;
+	int handle;
+	int subscription;
+	std::deque<PendingRequest> pending;
+	// reported completions that weren't retrieved yet
+	int finished;
+	std::vector<char> data;
+
+	ResourceState() : nativeResource(NULL), handle(-1), subscription(-1), finished(0) {}
+};
+
+//-------------------------------------------------------------------------------------------------
+// CreateResource
+//-------------------------------------------------------------------------------------------------
+static bool CreateResource(const Scenario& scenario, int index, ResourceState* state)
+{
+	if (scenario.isBuffer)
+		state->nativeResource = CreateSoftwareBuffer(scenario.width);
+	else
+		state->nativeResource = CreateSoftwareTexture(scenario.width, scenario.height, 1, 1, 0, scenario.componentType, scenario.channels, 0);
+
+	if (state->nativeResource == NULL)
+		return false;
+
+	// some content so the copies aren't reading zero pages
+	int rowPitch = 0;
+	char* data = (char*)GetSoftwareResourceData(state->nativeResource, 0, 0, &rowPitch);
+	memset(data, 0x40 + index, (size_t)rowPitch * scenario.height);
+
+	state->handle = scenario.isBuffer ? RegisterBuffer(state->nativeResource) : RegisterTexture(state->nativeResource);
+	state->data.resize(scenario.DataSize());
+	if (state->handle >= 0)
+		SetResourceName(state->handle, (scenario.name + " #" + std::to_string(index)).c_str());
+	return state->handle >= 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// TouchResource
+//-------------------------------------------------------------------------------------------------
+// changes small square of the texture every frame so delta requests have something to deliver
+static void TouchResource(const Scenario& scenario, int frame, ResourceState* state)
+{
+	const int kSize = 16;
+	int rowPitch = 0;
+	char* data = (char*)GetSoftwareResourceData(state->nativeResource, 0, 0, &rowPitch);
+	int x = frame * kSize % (scenario.width - kSize + 1);
+	int y = frame * 7 * kSize % (scenario.height - kSize + 1);
+	for (int row = 0; row < kSize; ++row)
+		memset(data + (size_t)(y + row) * rowPitch + x * scenario.pixelSize, frame, kSize * scenario.pixelSize);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReleaseResource
+//-------------------------------------------------------------------------------------------------
+static void ReleaseResource(ResourceState* state, Result* result)
+{
+	if (state->handle >= 0)
+		RenderEvent(GetReleaseTempResourcesEventFunc(), ReleaseTempResources(state->handle), result);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Request
+//-------------------------------------------------------------------------------------------------
+static double Request(const Scenario& scenario, int frame, ResourceState* state, Result* result)
+{
+	Clock::time_point start = Clock::now();
+	int eventId = scenario.isBuffer ? RequestBufferData(state->handle) : 
+		sDeltaTile != 0 ? RequestTextureDelta(state->handle, 0, 0, 1, sDeltaTile) : RequestTextureData(state->handle);
+	result->requestCall.Add(Microseconds(start, Clock::now()));
+
+	int status = GetLastStatus();
+	if (status != kStatusSucceeded)
+	{
+		++result->rejected;
+		return 0.0;
+	}
+
+	PendingRequest request = { GetLastRequestId(), frame };
+	state->pending.push_back(request);
+	++result->requests;
+
+	return RenderEvent(scenario.isBuffer ? GetRequestBufferEventFunc() : GetRequestTextureEventFunc(), eventId, result);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Retrieve
+//-------------------------------------------------------------------------------------------------
+static double Retrieve(const Scenario& scenario, int frame, ResourceState* state, Result* result)
+{
+	Clock::time_point start = Clock::now();
+	int eventId;
+	int size = scenario.DataSize();
+	if (scenario.isBuffer)
+		eventId = RetrieveBufferData(state->handle, &state->data[0], (int)state->data.size());
+	else if (sDeltaTile != 0)
+		eventId = RetrieveTextureDelta(state->handle, &state->data[0], (int)state->data.size(), &size);
+	else
+		eventId = RetrieveTextureData(state->handle, &state->data[0], (int)state->data.size());
+	result->retrieveCall.Add(Microseconds(start, Clock::now()));
+
+	// delta with every tile dirty is bigger than the texture, the request stays until it fits
+	int status = GetLastStatus();
+	if (status == kStatusErrorWrongBufferSize && sDeltaTile != 0)
+	{
+		state->data.resize(size);
+		return Retrieve(scenario, frame, state, result);
+	}
+
+	// copy event asks render thread to check whether the oldest copy is finished
+	if (status == kStatusNotReady)
+		return RenderEvent(scenario.isBuffer ? GetCopyBufferEventFunc() : GetCopyTextureEventFunc(), eventId, result);
+
+	// results come in request order
+	PendingRequest request = state->pending.front();
+	state->pending.pop_front();
+
+	if (status == kStatusSucceeded)
+	{
+		++result->completed;
+		result->bytes += size;
+		result->framesToData.Add(frame - request.frame);
+	}
+	else
+	{
+		++result->failed;
+	}
+
+	return 0.0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Consume
+//-------------------------------------------------------------------------------------------------
+static void Consume(const Scenario& scenario, ResourceState* state, Result* result)
+{
+	// every published result in order, plugin drops the oldest ones when they aren't read in time
+	while (true)
+	{
+		int frame = 0;
+		int dropped = 0;
+		Clock::time_point start = Clock::now();
+		int status = RetrieveSubscription(state->subscription, 0, &state->data[0], (int)state->data.size(), &frame, &dropped);
+		result->retrieveCall.Add(Microseconds(start, Clock::now()));
+		result->dropped += dropped;
+
+		if (status == kStatusNotReady)
+			return;
+
+		++result->requests;
+		if (status == kStatusSucceeded)
+		{
+			++result->completed;
+			result->bytes += scenario.DataSize();
+			result->framesToData.Add(sPollCount - frame);
+		}
+		else
+		{
+			++result->failed;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// CaptureFile
+//-------------------------------------------------------------------------------------------------
+static std::string CaptureFile(const Options& options, int resource)
+{
+	return std::string(options.capturePath) + "." + std::to_string(resource);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadCapture
+//-------------------------------------------------------------------------------------------------
+// counts copies in the index of closed capture file, copies of unexpected size are counted as failed
+static bool ReadCapture(const std::string& path, const Scenario& scenario, Result* result)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == NULL)
+		return false;
+
+	CaptureHeader header;
+	std::vector<CaptureEntry> index;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "ATRCAPT", sizeof(header.magic)) == 0 && 
+		header.entrySize == sizeof(CaptureEntry) && header.indexOffset != 0;
+	if (valid && header.entryCount > 0)
+	{
+		index.resize(header.entryCount);
+		valid = fseek(file, (long)header.indexOffset, SEEK_SET) == 0 && fread(&index[0], sizeof(CaptureEntry), index.size(), file) == index.size();
+	}
+	fclose(file);
+	if (!valid)
+		return false;
+
+	result->requests += header.entryCount + header.skipped;
+	result->rejected += header.skipped;
+	for (size_t i = 0; i < index.size(); ++i)
+	{
+		if (index[i].size == scenario.DataSize() && index[i].width == scenario.width)
+		{
+			++result->completed;
+			result->bytes += index[i].size;
+		}
+		else
+		{
+			++result->failed;
+		}
+	}
+
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// TakeCompletions
+//-------------------------------------------------------------------------------------------------
+// false when completions were lost because the completion queue was full
+static bool TakeCompletions(std::vector<ResourceState>& resources)
+{
+	int resourceHandle;
+	int requestId;
+	int status;
+	int popped;
+	bool complete = true;
+	while ((popped = PopCompletion(&resourceHandle, &requestId, &status)) != 0)
+	{
+		complete = complete && popped != 2;
+		for (size_t i = 0; i < resources.size(); ++i)
+		{
+			if (resources[i].handle == resourceHandle)
+			{
+				++resources[i].finished;
+				break;
+			}
+		}
+	}
+
+	return complete;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RunScenario
+//-------------------------------------------------------------------------------------------------
+static bool RunScenario(const Scenario& scenario, const Options& options, Result* result)
+{
+	result->scenario = scenario;
+	result->requests = 0;
+	result->completed = 0;
+	result->failed = 0;
+	result->rejected = 0;
+	result->dropped = 0;
+	result->bytes = 0.0;
+
+	// start new stats window
+	GetReadbackStats(&result->stats, sizeof(result->stats), 1);
+
+	std::vector<ResourceState> resources(scenario.resourceCount);
+	bool created = true;
+	for (int i = 0; i < scenario.resourceCount; ++i)
+		created = CreateResource(scenario, i, &resources[i]) && created;
+
+	// results are kept for a few intervals so a slow frame doesn't drop them
+	const int kSubscriptionDepth = 4;
+	for (int i = 0; created && options.subscribe && i < scenario.resourceCount; ++i)
+	{
+		int eventId = Subscribe(resources[i].handle, scenario.interval, kSubscriptionDepth, &resources[i].subscription);
+		created = eventId >= 0;
+		RenderEvent(GetSubscriptionEventFunc(), eventId, result);
+	}
+
+	// file of every resource fits all copies of the scenario
+	int captureMB = (int)(((long long)scenario.DataSize() + kCaptureAlignment) * (options.frames / scenario.interval + 2) >> 20) + 1;
+	for (int i = 0; created && options.capturePath != NULL && i < scenario.resourceCount; ++i)
+	{
+		int eventId = StartCapture(resources[i].handle, scenario.interval, kSubscriptionDepth, CaptureFile(options, i).c_str(), captureMB, &resources[i].subscription);
+		created = eventId >= 0;
+		RenderEvent(GetSubscriptionEventFunc(), eventId, result);
+	}
+	bool continuous = options.subscribe || options.capturePath != NULL;
+
+	// requests that are still in flight after the last frame are finished in extra frames
+	const int kMaxDrainFrames = 10000;
+	// completions were lost, the rest of the scenario retrieves every pending resource
+	bool polling = false;
+	Clock::time_point start = Clock::now();
+	Clock::time_point frameStart = start;
+	for (int frame = 0; created && frame < options.frames + kMaxDrainFrames; ++frame)
+	{
+		bool pending = false;
+		double renderTime = 0.0;
+		if (options.notify && !TakeCompletions(resources))
+			polling = true;
+
+		for (int i = 0; i < scenario.resourceCount; ++i)
+		{
+			ResourceState* state = &resources[i];
+
+			// render thread of the host could be copying the texture
+			if (sDeltaTile != 0 && !scenario.isBuffer && !sRenderThread && frame < options.frames)
+				TouchResource(scenario, frame, state);
+
+			if (continuous)
+			{
+				// copies still in flight after the last frame are dropped with the subscription, captured copies are 
+				// only counted when the file is closed
+				if (options.subscribe)
+					Consume(scenario, state, result);
+				continue;
+			}
+
+			if (frame < options.frames && frame % scenario.interval == i % scenario.interval)
+				renderTime += Request(scenario, frame, state, result);
+
+			if (options.notify && !polling)
+			{
+				// reported requests are finished, retrieve can't return NotReady
+				for (; state->finished > 0; --state->finished)
+					Retrieve(scenario, frame, state, result);
+			}
+			else if (!state->pending.empty())
+			{
+				renderTime += Retrieve(scenario, frame, state, result);
+			}
+
+			pending = pending || !state->pending.empty();
+		}
+
+		if (options.notify || continuous)
+		{
+			renderTime += RenderEvent(GetPollEventFunc(), 0, result);
+			++sPollCount;
+		}
+
+		if (sRenderThread)
+		{
+			// host ends simulated device frame on render thread and paces frames
+			sHost->EndFrame();
+			if (frame >= options.frames && !pending)
+				break;
+			continue;
+		}
+
+		EndSoftwareDeviceFrame();
+		if (frame < options.frames)
+			result->renderPerFrame.Add(renderTime);
+		else if (!pending)
+			break;
+
+		if (options.frameMs > 0.0)
+		{
+			frameStart += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(options.frameMs));
+			std::this_thread::sleep_until(frameStart);
+		}
+		else
+		{
+			// let simulated gpu thread run on machines with few cores
+			std::this_thread::yield();
+		}
+	}
+
+	if (sRenderThread)
+	{
+		sHost->WaitForRenderThread();
+		std::vector<double> frameTimes = sHost->TakeRenderFrameTimes();
+		for (size_t i = 0; i < frameTimes.size() && i < (size_t)options.frames; ++i)
+			result->renderPerFrame.Add(frameTimes[i]);
+	}
+
+	result->seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	GetReadbackStats(&result->stats, sizeof(result->stats), 1);
+
+	// software resources can be released only after render thread released their staging copies. stopped capture
+	// writes its remaining copies and index on writer thread, poll events release its copies once the file is closed
+	for (int i = 0; i < scenario.resourceCount; ++i)
+	{
+		if (resources[i].subscription >= 0)
+			RenderEvent(GetSubscriptionEventFunc(), Unsubscribe(resources[i].subscription), result);
+		ReleaseResource(&resources[i], result);
+	}
+	for (int i = 0; options.capturePath != NULL && i < scenario.resourceCount; ++i)
+	{
+		int written, skipped, failed, finished = 0;
+		long long bytes;
+		while (resources[i].subscription >= 0 && !finished)
+		{
+			if (GetCaptureStatus(resources[i].subscription, &written, &skipped, &failed, &bytes, &finished) != kStatusSucceeded)
+			{
+				++result->failed;
+				break;
+			}
+
+			if (!finished)
+			{
+				RenderEvent(GetPollEventFunc(), 0, result);
+				++sPollCount;
+				if (sRenderThread)
+					sHost->WaitForRenderThread();
+				std::this_thread::yield();
+			}
+		}
+	}
+	if (sRenderThread)
+	{
+		sHost->WaitForRenderThread();
+		sHost->TakeRenderFrameTimes();
+	}
+	for (int i = 0; created && options.capturePath != NULL && i < scenario.resourceCount; ++i)
+	{
+		if (!ReadCapture(CaptureFile(options, i), scenario, result))
+			++result->failed;
+	}
+	for (int i = 0; i < scenario.resourceCount; ++i)
+		ReleaseSoftwareResource(resources[i].nativeResource);
+
+	return created;
+}
+
+//-------------------------------------------------------------------------------------------------
+// MakeScenarios
+//-------------------------------------------------------------------------------------------------
+static std::vector<Scenario> MakeScenarios(const Options& options)
+{
+	struct Format
+	{
+		const char* name;
+		int componentType;
+		int channels;
+		int pixelSize;
+	};
+
+	static const Format kFormats[] = 
+	{
+		{ "rgba8", kSoftwareUNorm8, 4, 4 },
+		{ "rgba16f", kSoftwareFloat16, 4, 8 },
+		{ "r32f", kSoftwareFloat32, 1, 4 },
+	};
+	static const int kResourceCounts[] = { 1, 4, 16 };
+	static const int kSizes[] = { 256, 1024, 2048 };
+	static const int kIntervals[] = { 1, 4 };
+	static const int kBufferSizes[] = { 64 * 1024, 4 * 1024 * 1024 };
+
+	// quick run is a smoke test of every path
+	int formatCount = options.quick ? 1 : 3;
+	int resourceCountCount = options.quick ? 2 : 3;
+	int sizeCount = options.quick ? 2 : 3;
+	int intervalCount = options.quick ? 1 : 2;
+
+	// source and staging copies of the biggest scenarios would need gigabytes
+	const double kMaxScenarioBytes = 128.0 * 1024 * 1024;
+
+	std::vector<Scenario> scenarios;
+	for (int f = 0; f < formatCount; ++f)
+		for (int r = 0; r < resourceCountCount; ++r)
+			for (int s = 0; s < sizeCount; ++s)
+				for (int i = 0; i < intervalCount; ++i)
+				{
+					Scenario scenario;
+					scenario.isBuffer = false;
+					scenario.resourceCount = kResourceCounts[r];
+					scenario.width = kSizes[s];
+					scenario.height = kSizes[s];
+					scenario.componentType = kFormats[f].componentType;
+					scenario.channels = kFormats[f].channels;
+					scenario.pixelSize = kFormats[f].pixelSize;
+					scenario.interval = kIntervals[i];
+					if ((double)scenario.DataSize() * scenario.resourceCount > kMaxScenarioBytes)
+						continue;
+
+					char name[128];
+					snprintf(name, sizeof(name), "texture/%s/%dx%d/x%d/every%d", kFormats[f].name, scenario.width, scenario.height, scenario.resourceCount, scenario.interval);
+					scenario.name = name;
+					scenarios.push_back(scenario);
+				}
+
+	for (int r = 0; r < resourceCountCount - 1; ++r)
+		for (int s = 0; s < 2; ++s)
+		{
+			Scenario scenario;
+			scenario.isBuffer = true;
+			scenario.resourceCount = kResourceCounts[r];
+			scenario.width = kBufferSizes[s];
+			scenario.height = 1;
+			scenario.componentType = 0;
+			scenario.channels = 0;
+			scenario.pixelSize = 1;
+			scenario.interval = 1;
+
+			char name[128];
+			snprintf(name, sizeof(name), "buffer/%dKB/x%d/every1", scenario.width / 1024, scenario.resourceCount);
+			scenario.name = name;
+			scenarios.push_back(scenario);
+		}
+
+	if (options.filter != NULL)
+		scenarios.erase(std::remove_if(scenarios.begin(), scenarios.end(), [&options](const Scenario& scenario) { return scenario.name.find(options.filter) == std::string::npos; }), scenarios.end());
+
+	return scenarios;
+}
+
+//-------------------------------------------------------------------------------------------------
+// WriteCallJson
+//-------------------------------------------------------------------------------------------------
+static void WriteCallJson(FILE* file, const char* name, Samples& samples, bool last)
+{
+	fprintf(file, "        \"%s\": { \"count\": %d, \"meanUs\": %.3f, \"p50Us\": %.3f, \"p90Us\": %.3f, \"p99Us\": %.3f, \"maxUs\": %.3f }%s\n",
+		name, (int)samples.Count(), samples.Mean(), samples.Percentile(50), samples.Percentile(90), samples.Percentile(99), samples.Percentile(100), last ? "" : ",");
+}
+
+//-------------------------------------------------------------------------------------------------
+// HistogramMean
+//-------------------------------------------------------------------------------------------------
+static double HistogramMean(const HistogramSnapshot& histogram)
+{
+	return histogram.count > 0 ? (double)histogram.sum / histogram.count : 0.0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// WriteJson
+//-------------------------------------------------------------------------------------------------
+static bool WriteJson(const char* path, const Options& options, std::vector<Result>& results)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"config\": { \"frames\": %d, \"frameMs\": %.3f, \"latencyFrames\": %d, \"bandwidthMBps\": %.1f, \"rowPitchAlignment\": %d, \"ringSize\": %d, \"stagingBudgetMB\": %d, \"copyThread\": %s, \"renderThread\": %s, \"notify\": %s, \"subscribe\": %s, \"deltaTile\": %d, \"capture\": %s },\n",
+		options.frames, options.frameMs, options.latencyFrames, options.bandwidthMBps, options.rowPitchAlignment, options.ringSize, options.stagingBudgetMB, options.copyThread ? "true" : "false", options.renderThread ? "true" : "false", options.notify ? "true" : "false", options.subscribe ? "true" : "false", options.deltaTile, options.capturePath != NULL ? "true" : "false");
+	fprintf(file, "  \"scenarios\": [\n");
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		Result& r = results[i];
+		fprintf(file, "    {\n");
+		fprintf(file, "      \"name\": \"%s\",\n", r.scenario.name.c_str());
+		fprintf(file, "      \"resources\": %d, \"width\": %d, \"height\": %d, \"dataSize\": %d, \"interval\": %d,\n", r.scenario.resourceCount, r.scenario.width, r.scenario.height, r.scenario.DataSize(), r.scenario.interval);
+		fprintf(file, "      \"requests\": %d, \"completed\": %d, \"failed\": %d, \"rejected\": %d, \"dropped\": %d,\n", r.requests, r.completed, r.failed, r.rejected, r.dropped);
+		fprintf(file, "      \"seconds\": %.6f, \"bytesPerSecond\": %.1f,\n", r.seconds, r.seconds > 0.0 ? r.bytes / r.seconds : 0.0);
+		fprintf(file, "      \"framesToData\": { \"mean\": %.3f, \"p50\": %.0f, \"p99\": %.0f, \"max\": %.0f },\n", r.framesToData.Mean(), r.framesToData.Percentile(50), r.framesToData.Percentile(99), r.framesToData.Percentile(100));
+		fprintf(file, "      \"calls\": {\n");
+		WriteCallJson(file, "request", r.requestCall, false);
+		WriteCallJson(file, "retrieve", r.retrieveCall, false);
+		WriteCallJson(file, "renderEvent", r.renderEvent, false);
+		WriteCallJson(file, "renderPerFrame", r.renderPerFrame, true);
+		fprintf(file, "      },\n");
+		const ReadbackStatsSnapshot& s = r.stats;
+		fprintf(file, "      \"plugin\": { \"copies\": %lld, \"notReadyPolls\": %lld, \"mapFailures\": %lld, \"bytesCopied\": %lld, \"stagingBytes\": %lld, \"maxSlotsInFlight\": %lld, \"maxQueuedCommands\": %lld, \"completionOverflows\": %lld, "
+			"\"latencyFramesMean\": %.3f, \"latencyUsMean\": %.1f, \"latencyUsMax\": %lld, \"renderEventUsMean\": %.3f }\n",
+			s.copies, s.notReadyPolls, s.mapFailures, s.bytesCopied, s.stagingBytes, s.maxSlotsInFlight, s.maxQueuedCommands, s.completionOverflows,
+			HistogramMean(s.latencyFrames), HistogramMean(s.latencyUs), s.latencyUs.max, HistogramMean(s.renderEventUs));
+		fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+
+	fclose(file);
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// PrintUsage
+//-------------------------------------------------------------------------------------------------
+static void PrintUsage()
+{
+	printf("usage: Benchmark [options]\n");
+	printf("  --frames N          frames with requests per scenario (120)\n");
+	printf("  --frame-ms MS       frame pacing, 0 runs frames back to back (0)\n");
+	printf("  --latency N         simulated gpu latency in frames (2)\n");
+	printf("  --bandwidth MBPS    simulated copy bandwidth, 0 is unlimited (0)\n");
+	printf("  --alignment N       row pitch alignment of staging textures (256)\n");
+	printf("  --ring N            staging ring size (3)\n");
+	printf("  --staging-budget MB memory budget of the staging pool, 0 is unlimited (0)\n");
+	printf("  --copy-thread       copy staging memory on copy thread\n");
+	printf("  --render-thread     run plugin events on render thread of the host\n");
+	printf("  --notify            poll event once per frame and retrieve only reported completions\n");
+	printf("  --subscribe         subscribe resources, poll event copies them every interval frames\n");
+	printf("  --delta TILE        request textures as deltas of TILE x TILE tiles, small part changes every frame\n");
+	printf("  --capture PATH      capture resources to PATH.N files every interval frames, files are checked after each scenario\n");
+	printf("  --quick             small subset of scenarios\n");
+	printf("  --verify            compare results of every readback path with cpu reference instead of measuring\n");
+	printf("  --filter TEXT       only scenarios with TEXT in the name\n");
+	printf("  --json PATH         write results as json\n");
+	printf("  --trace PATH        write request timeline as Chrome trace json\n");
+}
+
+//-------------------------------------------------------------------------------------------------
+// ParseOptions
+//-------------------------------------------------------------------------------------------------
+static bool ParseOptions(int argc, char** argv, Options* options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (strcmp(arg, "--copy-thread") == 0)
+			options->copyThread = true;
+		else if (strcmp(arg, "--render-thread") == 0)
+			options->renderThread = true;
+		else if (strcmp(arg, "--notify") == 0)
+			options->notify = true;
+		else if (strcmp(arg, "--subscribe") == 0)
+			options->subscribe = true;
+		else if (strcmp(arg, "--verify") == 0)
+			options->verify = true;
+		else if (strcmp(arg, "--quick") == 0)
+		{
+			options->quick = true;
+			options->frames = 60;
+		}
+		else if (value == NULL)
+			return false;
+		else if (strcmp(arg, "--frames") == 0)
+			options->frames = atoi(argv[++i]);
+		else if (strcmp(arg, "--frame-ms") == 0)
+			options->frameMs = atof(argv[++i]);
+		else if (strcmp(arg, "--latency") == 0)
+			options->latencyFrames = atoi(argv[++i]);
+		else if (strcmp(arg, "--bandwidth") == 0)
+			options->bandwidthMBps = (float)atof(argv[++i]);
+		else if (strcmp(arg, "--alignment") == 0)
+			options->rowPitchAlignment = atoi(argv[++i]);
+		else if (strcmp(arg, "--ring") == 0)
+			options->ringSize = atoi(argv[++i]);
+		else if (strcmp(arg, "--staging-budget") == 0)
+			options->stagingBudgetMB = atoi(argv[++i]);
+		else if (strcmp(arg, "--delta") == 0)
+			options->deltaTile = atoi(argv[++i]);
+		else if (strcmp(arg, "--capture") == 0)
+			options->capturePath = argv[++i];
+		else if (strcmp(arg, "--filter") == 0)
+			options->filter = argv[++i];
+		else if (strcmp(arg, "--json") == 0)
+			options->jsonPath = argv[++i];
+		else if (strcmp(arg, "--trace") == 0)
+			options->tracePath = argv[++i];
+		else
+			return false;
+	}
+
+	return options->frames > 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// main
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, &options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	UnityHost host(kUnityGfxRendererNull);
+	host.SetFrameFunc(EndSoftwareDeviceFrame);
+	host.SetTargetFrameTime(options.frameMs);
+	host.LoadPlugin(UnityPluginLoad, UnityPluginUnload);
+	sHost = &host;
+	sRenderThread = options.renderThread;
+	sDeltaTile = options.deltaTile;
+
+	if (SetSoftwareDeviceConfig(options.latencyFrames, options.bandwidthMBps, options.rowPitchAlignment, 0, 0) != kStatusSucceeded ||
+		SetStagingRingSize(options.ringSize) != kStatusSucceeded ||
+		SetStagingPool(options.stagingBudgetMB, kStagingIdleFrames) != kStatusSucceeded)
+	{
+		printf("invalid device configuration\n");
+		return 1;
+	}
+	SetCopyThread(options.copyThread ? 1 : 0);
+	if (options.tracePath != NULL)
+		SetReadbackTrace(1);
+
+	if (options.verify)
+	{
+		bool verified = RunVerify();
+		host.Shutdown();
+		return verified ? 0 : 1;
+	}
+
+	std::vector<Scenario> scenarios = MakeScenarios(options);
+	std::vector<Result> results(scenarios.size());
+
+	printf("%-36s %6s %5s %5s %10s %9s %9s %9s %9s %9s\n", "scenario", "done", "fail", "rej", "MB/s", "frames", "req p99", "ret p99", "rt/frame", "rt p99");
+	bool succeeded = true;
+	for (size_t i = 0; i < scenarios.size(); ++i)
+	{
+		Result& r = results[i];
+		if (!RunScenario(scenarios[i], options, &r))
+		{
+			printf("%-36s failed to create resources\n", scenarios[i].name.c_str());
+			succeeded = false;
+			continue;
+		}
+
+		printf("%-36s %6d %5d %5d %10.1f %9.2f %9.2f %9.2f %9.2f %9.2f\n", r.scenario.name.c_str(), r.completed, r.failed, r.rejected,
+			r.seconds > 0.0 ? r.bytes / r.seconds / 1000000.0 : 0.0, r.framesToData.Mean(), r.requestCall.Percentile(99), r.retrieveCall.Percentile(99),
+			r.renderPerFrame.Mean(), r.renderPerFrame.Percentile(99));
+		fflush(stdout);
+	}
+
+	if (options.jsonPath != NULL && !WriteJson(options.jsonPath, options, results))
+	{
+		printf("can't write %s\n", options.jsonPath);
+		succeeded = false;
+	}
+
+	if (options.tracePath != NULL && WriteReadbackTrace(options.tracePath) != kStatusSucceeded)
+	{
+		printf("can't write %s\n", options.tracePath);
+		succeeded = false;
+	}
+
+	host.Shutdown();
+	return succeeded ? 0 : 1;
+}
@@ -0,0 +1,1221 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// correctness checks run by Benchmark --verify. resources are filled with pseudo random data, every readback
+// path (regions, subresources, compressed blocks, conversions, reductions, deltas, batches, leases, captures) is compared
+// with reference computed on cpu. conversion and reduction kernels are picked at compile time, build the plugin
+// with every SIMD variant (see Makefile) to check all of them
+
+#include "Verify.h"
+#include "PluginAPI.h"
+#include "CaptureSink.h"
+#include "Conversion.h"
+#include "Delta.h"
+#include "Reduction.h"
+#include <algorithm>
+#include <functional>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// frames one request can take before it is reported as stuck
+static const int kMaxFrames = 100000;
+
+static int sChecks = 0;
+static int sFailures = 0;
+static unsigned int sRandom = 0x2545f491u;
+
+//-------------------------------------------------------------------------------------------------
+// Region
+//-------------------------------------------------------------------------------------------------
+// texel box of one mip level, slices are array slices or depth slices of 3D texture
+struct Region
+{
+	int mipLevel;
+	int slice;
+	int sliceCount;
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+//-------------------------------------------------------------------------------------------------
+// Resource
+//-------------------------------------------------------------------------------------------------
+// software texture or buffer, buffers are one row of bytes
+struct Resource
+{
+	void* native;
+	int handle;
+	bool isBuffer;
+	int width;
+	int height;
+	int slices;
+	int mipLevels;
+	bool is3D;
+	int componentType;
+	int channels;
+	int flags;
+	// bytes per block of blockDim x blockDim texels, compressed formats have 4x4 blocks
+	int blockSize;
+	int blockDim;
+
+	Resource() : native(NULL), handle(-1), isBuffer(false), width(0), height(0), slices(0), mipLevels(0), is3D(false), componentType(0), channels(0), flags(0), blockSize(0), blockDim(1) {}
+	~Resource();
+
+	int MipWidth(int mipLevel) const { return std::max(width >> mipLevel, 1); }
+	int MipHeight(int mipLevel) const { return std::max(height >> mipLevel, 1); }
+	int MipSlices(int mipLevel) const { return is3D ? std::max(slices >> mipLevel, 1) : slices; }
+	int RowPitch(int texels) const { return (texels + blockDim - 1) / blockDim * blockSize; }
+	int RowCount(int texels) const { return (texels + blockDim - 1) / blockDim; }
+	int DataSize(const Region& region) const { return RowPitch(region.width) * RowCount(region.height) * region.sliceCount; }
+
+	Region Level(int mipLevel, int slice = 0, int sliceCount = 1) const
+	{
+		Region region = { mipLevel, slice, sliceCount, 0, 0, MipWidth(mipLevel), MipHeight(mipLevel) };
+		return region;
+	}
+};
+
+//-------------------------------------------------------------------------------------------------
+// Resource::~Resource()
+//-------------------------------------------------------------------------------------------------
+Resource::~Resource()
+{
+	// events run inline, staging copies are released before the software resource
+	if (handle >= 0)
+	{
+		int eventId = ReleaseTempResources(handle);
+		if (eventId >= 0)
+			GetReleaseTempResourcesEventFunc()(eventId);
+	}
+
+	if (native != NULL)
+		ReleaseSoftwareResource(native);
+}
+
+//-------------------------------------------------------------------------------------------------
+// NextRandom
+//-------------------------------------------------------------------------------------------------
+// xorshift, every run uses the same data
+static unsigned int NextRandom()
+{
+	sRandom ^= sRandom << 13;
+	sRandom ^= sRandom >> 17;
+	sRandom ^= sRandom << 5;
+	return sRandom;
+}
+
+//-------------------------------------------------------------------------------------------------
+// ComponentSize
+//-------------------------------------------------------------------------------------------------
+static int ComponentSize(int componentType)
+{
+	if (componentType == kSoftwareFloat32)
+		return 4;
+	return componentType >= kSoftwareUNorm8 ? 1 : 2;
+}
+
+//-------------------------------------------------------------------------------------------------
+// FillRandom
+//-------------------------------------------------------------------------------------------------
+// float textures get values between -1 and 2 with occasional NaN so sums stay finite, other formats get
+// random bits (half textures include infinities, NaNs and denormals)
+static void FillRandom(const Resource& resource, char* data, int size)
+{
+	if (!resource.isBuffer && resource.componentType == kSoftwareFloat32)
+	{
+		for (int i = 0; i + 4 <= size; i += 4)
+		{
+			float value = (NextRandom() >> 8) * (3.0f / 16777216.0f) - 1.0f;
+			if (NextRandom() % 97 == 0)
+				value = NAN;
+			memcpy(data + i, &value, sizeof(value));
+		}
+		return;
+	}
+
+	for (int i = 0; i < size; ++i)
+		data[i] = (char)(NextRandom() >> 24);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RegisterResource
+//-------------------------------------------------------------------------------------------------
+static bool RegisterResource(Resource* resource, const char* name)
+{
+	if (resource->native == NULL)
+		return false;
+
+	for (int mip = 0; mip < resource->mipLevels; ++mip)
+	{
+		for (int slice = 0; slice < resource->MipSlices(mip); ++slice)
+		{
+			int rowPitch = 0;
+			char* data = (char*)GetSoftwareResourceData(resource->native, mip, slice, &rowPitch);
+			FillRandom(*resource, data, rowPitch * resource->RowCount(resource->MipHeight(mip)));
+		}
+	}
+
+	resource->handle = resource->isBuffer ? RegisterBuffer(resource->native) : RegisterTexture(resource->native);
+	if (resource->handle >= 0)
+		SetResourceName(resource->handle, name);
+	return resource->handle >= 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+// CreateTexture
+//-------------------------------------------------------------------------------------------------
+// compressed textures take block size in bytes instead of channels
+static bool CreateTexture(Resource* resource, const char* name, int width, int height, int slices, int mipLevels, bool is3D, int componentType, int channels, int flags = 0)
+{
+	resource->width = width;
+	resource->height = height;
+	resource->slices = slices;
+	resource->mipLevels = mipLevels;
+	resource->is3D = is3D;
+	resource->componentType = componentType;
+	resource->channels = componentType == kSoftwareCompressed ? 0 : channels;
+	resource->flags = flags;
+	resource->blockSize = componentType == kSoftwareCompressed ? channels : channels * ComponentSize(componentType);
+	resource->blockDim = componentType == kSoftwareCompressed ? 4 : 1;
+	resource->native = CreateSoftwareTexture(width, height, slices, mipLevels, is3D ? 1 : 0, componentType, channels, flags);
+	return RegisterResource(resource, name);
+}
+
+//-------------------------------------------------------------------------------------------------
+// CreateBuffer
+//-------------------------------------------------------------------------------------------------
+static bool CreateBuffer(Resource* resource, const char* name, int size)
+{
+	resource->isBuffer = true;
+	resource->width = size;
+	resource->height = 1;
+	resource->slices = 1;
+	resource->mipLevels = 1;
+	resource->blockSize = 1;
+	resource->native = CreateSoftwareBuffer(size);
+	return RegisterResource(resource, name);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadReference
+//-------------------------------------------------------------------------------------------------
+// tightly packed rows of the region straight from the software resource, slices one after another.
+// region of compressed texture has to start at block boundary
+static std::vector<char> ReadReference(const Resource& resource, const Region& region)
+{
+	std::vector<char> result(resource.DataSize(region));
+	int rowSize = resource.RowPitch(region.width);
+	int rowCount = resource.RowCount(region.height);
+	char* dest = result.data();
+	for (int slice = 0; slice < region.sliceCount; ++slice)
+	{
+		int rowPitch = 0;
+		const char* src = (const char*)GetSoftwareResourceData(resource.native, region.mipLevel, region.slice + slice, &rowPitch);
+		src += region.y / resource.blockDim * rowPitch + region.x / resource.blockDim * resource.blockSize;
+		for (int row = 0; row < rowCount; ++row, dest += rowSize)
+			memcpy(dest, src + row * rowPitch, rowSize);
+	}
+
+	return result;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Report
+//-------------------------------------------------------------------------------------------------
+// empty error means the check passed
+static void Report(const std::string& name, const std::string& error)
+{
+	++sChecks;
+	if (!error.empty())
+		++sFailures;
+
+	printf("%-52s %s%s\n", name.c_str(), error.empty() ? "ok" : "FAILED: ", error.c_str());
+	fflush(stdout);
+}
+
+//-------------------------------------------------------------------------------------------------
+// StatusError
+//-------------------------------------------------------------------------------------------------
+static std::string StatusError(int status, int expected = kStatusSucceeded)
+{
+	if (status == expected)
+		return std::string();
+
+	return status == kStatusNotReady ? "request didn't finish" : "status " + std::to_string(status) + ", expected " + std::to_string(expected);
+}
+
+//-------------------------------------------------------------------------------------------------
+// CompareBytes
+//-------------------------------------------------------------------------------------------------
+static std::string CompareBytes(const std::vector<char>& result, const std::vector<char>& reference)
+{
+	if (result.size() != reference.size())
+		return "size " + std::to_string(result.size()) + ", expected " + std::to_string(reference.size());
+
+	for (size_t i = 0; i < result.size(); ++i)
+	{
+		if (result[i] != reference[i])
+			return "byte " + std::to_string(i) + " is " + std::to_string((unsigned char)result[i]) + ", expected " + std::to_string((unsigned char)reference[i]);
+	}
+
+	return std::string();
+}
+
+//-------------------------------------------------------------------------------------------------
+// FloatsEqual
+//-------------------------------------------------------------------------------------------------
+// NaNs are equal to each other, finite values can differ in rounding of the last bits
+static bool FloatsEqual(float value, float reference, float tolerance)
+{
+	if (value != value || reference != reference)
+		return value != value && reference != reference;
+
+	return value == reference || fabsf(value - reference) <= tolerance * std::max(1.0f, fabsf(reference));
+}
+
+//-------------------------------------------------------------------------------------------------
+// RenderEvent
+//-------------------------------------------------------------------------------------------------
+static void RenderEvent(int eventId)
+{
+	// every plugin event except poll executes the commands queued up to its id
+	if (eventId >= 0)
+		GetRequestTextureEventFunc()(eventId);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Issue
+//-------------------------------------------------------------------------------------------------
+// request call returns event id and leaves status of the request in GetLastStatus
+static int Issue(int eventId)
+{
+	int status = GetLastStatus();
+	if (status == kStatusSucceeded)
+		RenderEvent(eventId);
+	return status;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Finish
+//-------------------------------------------------------------------------------------------------
+// calls retrieve until it stops returning NotReady, every NotReady call gets its copy event and device frame
+static int Finish(const std::function<int()>& retrieve)
+{
+	for (int frame = 0; frame < kMaxFrames; ++frame)
+	{
+		int eventId = retrieve();
+		int status = GetLastStatus();
+		if (status != kStatusNotReady)
+			return status;
+
+		RenderEvent(eventId);
+		EndSoftwareDeviceFrame();
+		std::this_thread::yield();
+	}
+
+	return kStatusNotReady;
+}
+
+//-------------------------------------------------------------------------------------------------
+// RetrieveResult
+//-------------------------------------------------------------------------------------------------
+// result of the oldest request of the resource, buffer is prefilled so short results don't pass
+static int RetrieveResult(const Resource& resource, std::vector<char>* data)
+{
+	std::fill(data->begin(), data->end(), (char)0xcd);
+	return Finish([&resource, data]()
+	{
+		return resource.isBuffer ? RetrieveBufferData(resource.handle, data->data(), (int)data->size()) :
+			RetrieveTextureData(resource.handle, data->data(), (int)data->size());
+	});
+}
+
+//-------------------------------------------------------------------------------------------------
+// CheckRead
+//-------------------------------------------------------------------------------------------------
+// raw data of request that was just issued, expected is the region after alignment to compressed blocks
+static void CheckRead(const std::string& name, const Resource& resource, int eventId, const Region& expected)
+{
+	int status = Issue(eventId);
+	if (status != kStatusSucceeded)
+	{
+		Report(name, StatusError(status));
+		return;
+	}
+
+	std::vector<char> reference = ReadReference(resource, expected);
+	std::vector<char> data(reference.size());
+	status = RetrieveResult(resource, &data);
+	Report(name, status != kStatusSucceeded ? StatusError(status) : CompareBytes(data, reference));
+}
+
+//-------------------------------------------------------------------------------------------------
+// CheckRejected
+//-------------------------------------------------------------------------------------------------
+// request is accepted on main thread and fails on render thread
+static void CheckRejected(const std::string& name, const Resource& resource, int eventId, int expectedStatus)
+{
+	int status = Issue(eventId);
+	if (status == kStatusSucceeded)
+	{
+		std::vector<char> data(resource.DataSize(resource.Level(0)));
+		status = RetrieveResult(resource, &data);
+	}
+
+	Report(name, StatusError(status, expectedStatus));
+}
+
+//-------------------------------------------------------------------------------------------------
+// VerifyRegions
+//-------------------------------------------------------------------------------------------------
+static void VerifyRegions()
+{
+	Resource rgba8;
+	if (CreateTexture(&rgba8, "verify rgba8", 37, 29, 1, 1, false, kSoftwareUNorm8, 4))
+	{
+		CheckRead("region/rgba8/whole", rgba8, RequestTextureData(rgba8.handle), rgba8.Level(0));
+		Region region = { 0, 0, 1, 36, 28, 1, 1 };
+		CheckRead("region/rgba8/last-texel", rgba8, RequestTextureRegion(rgba8.handle, 36, 28, 1, 1), region);
+	}
+
+	Resource rgba16f;
+	if (CreateTexture(&rgba16f, "verify rgba16f", 61, 45, 1, 1, false, kSoftwareFloat16, 4))
+	{
+		Region region = { 0, 0, 1, 5, 7, 33, 20 };
+		CheckRead("region/rgba16f/5,7 33x20", rgba16f, RequestTextureRegion(rgba16f.handle, 5, 7, 33, 20), region);
+	}
+
+	// every slice is tightly packed after the previous one
+	Resource array;
+	if (CreateTexture(&array, "verify r32f array", 67, 33, 4, 4, false, kSoftwareFloat32, 1))
+	{
+		Region region = { 1, 1, 2, 3, 2, 20, 9 };
+		CheckRead("subresource/array/mip1 slices1-2 region", array, RequestTextureSubresource(array.handle, 1, 1, 2, 3, 2, 20, 9), region);
+		CheckRead("subresource/array/mip3 all slices", array, RequestTextureSubresource(array.handle, 3, 0, 4, 0, 0, 0, 0), array.Level(3, 0, 4));
+	}
+
+	// depth of 3D texture gets smaller with mip levels
+	Resource volume;
+	if (CreateTexture(&volume, "verify rgba8 3D", 19, 17, 9, 3, true, kSoftwareUNorm8, 4))
+	{
+		CheckRead("subresource/3D/mip1 depth1-3", volume, RequestTextureSubresource(volume.handle, 1, 1, 3, 0, 0, 0, 0), volume.Level(1, 1, 3));
+		Region region = { 0, 2, 5, 2, 3, 10, 11 };
+		CheckRead("subresource/3D/mip0 depth2-6 region", volume, RequestTextureSubresource(volume.handle, 0, 2, 5, 2, 3, 10, 11), region);
+	}
+
+	Resource buffer;
+	if (CreateBuffer(&buffer, "verify buffer", 1000))
+	{
+		CheckRead("buffer/whole", buffer, RequestBufferData(buffer.handle), buffer.Level(0));
+		Region range = { 0, 0, 1, 13, 0, 517, 1 };
+		CheckRead("buffer/range 13+517", buffer, RequestBufferRange(buffer.handle, 13, 517), range);
+	}
+
+	// depth formats are read only as whole subresources
+	Resource depth;
+	if (CreateTexture(&depth, "verify depth", 16, 16, 1, 1, false, kSoftwareFloat32, 1, kFormatDepth))
+	{
+		CheckRejected("region/depth/partial rejected", depth, RequestTextureRegion(depth.handle, 0, 0, 8, 8), kStatusErrorInvalidArguments);
+		CheckRead("region/depth/whole", depth, RequestTextureData(depth.handle), depth.Level(0));
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// VerifyBlocks
+//-------------------------------------------------------------------------------------------------
+// regions of compressed textures are extended to 4x4 blocks, only the edge of the mip level cuts a block
+static void VerifyBlocks()
+{
+	Resource bc7;
+	if (CreateTexture(&bc7, "verify BC 16 byte", 30, 22, 1, 2, false, kSoftwareCompressed, 16))
+	{
+		Region inner = { 0, 0, 1, 4, 4, 12, 12 };
+		CheckRead("blocks/16B/5,6 10x9 -> 4,4 12x12", bc7, RequestTextureRegion(bc7.handle, 5, 6, 10, 9), inner);
+		Region edge = { 0, 0, 1, 24, 16, 6, 6 };
+		CheckRead("blocks/16B/25,18 5x4 -> 24,16 6x6", bc7, RequestTextureRegion(bc7.handle, 25, 18, 5, 4), edge);
+		CheckRead("blocks/16B/mip1 15x11", bc7, RequestTextureSubresource(bc7.handle, 1, 0, 1, 0, 0, 0, 0), bc7.Level(1));
+	}
+
+	Resource bc1;
+	if (CreateTexture(&bc1, "verify BC 8 byte", 13, 9, 2, 1, false, kSoftwareCompressed, 8))
+	{
+		Region region = { 0, 1, 1, 0, 0, 4, 4 };
+		CheckRead("blocks/8B/slice1 1,1 3x3 -> 0,0 4x4", bc1, RequestTextureSubresource(bc1.handle, 0, 1, 1, 1, 1, 3, 3), region);
+		Region edge = { 0, 0, 2, 12, 8, 1, 1 };
+		CheckRead("blocks/8B/slices0-1 12,8 1x1", bc1, RequestTextureSubresource(bc1.handle, 0, 0, 2, 12, 8, 1, 1), edge);
+	}
+
+	Resource bc4;
+	if (CreateTexture(&bc4, "verify BC rejected", 16, 16, 1, 1, false, kSoftwareCompressed, 8))
+		CheckRejected("blocks/conversion rejected", bc4, RequestTextureConversion(bc4.handle, 0, 0, 1, 0, 0, 0, 0, (int)OutputType::Float32, 0, 0), kStatusErrorUnsupportedFormat);
+}
+
+//-------------------------------------------------------------------------------------------------
+// HalfReference
+//-------------------------------------------------------------------------------------------------
+static float HalfReference(unsigned short half)
+{
+	int exponent = (half >> 10) & 0x1f;
+	int mantissa = half & 0x3ff;
+	float value = exponent == 0x1f ? (mantissa != 0 ? NAN : INFINITY) :
+		exponent == 0 ? ldexpf((float)mantissa, -24) : ldexpf((float)(mantissa | 0x400), exponent - 25);
+	return (half & 0x8000) != 0 ? -value : value;
+}
+
+//-------------------------------------------------------------------------------------------------
+// ComponentReference
+//-------------------------------------------------------------------------------------------------
+// channel of the pixel in memory order as float, normalized formats are 0-1 or -1-1
+static float ComponentReference(const char* pixel, int channel, int componentType)
+{
+	switch (componentType)
+	{
+	case kSoftwareFloat32:
+	{
+		float value;
+		memcpy(&value, pixel + channel * 4, sizeof(value));
+		return value;
+	}
+	case kSoftwareFloat16:
+	{
+		unsigned short value;
+		memcpy(&value, pixel + channel * 2, sizeof(value));
+		return HalfReference(value);
+	}
+	case kSoftwareUNorm16:
+	{
+		unsigned short value;
+		memcpy(&value, pixel + channel * 2, sizeof(value));
+		return value * (1.0f / 65535.0f);
+	}
+	case kSoftwareUNorm8:
+		return (unsigned char)pixel[channel] * (1.0f / 255.0f);
+	case kSoftwareSNorm8:
+		return std::max((signed char)pixel[channel] * (1.0f / 127.0f), -1.0f);
+	default:
+		return 0.0f;
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// SRGBToLinear
+//-------------------------------------------------------------------------------------------------
+static float SRGBToLinear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+//-------------------------------------------------------------------------------------------------
+// CheckConversion
+//-------------------------------------------------------------------------------------------------
+static void CheckConversion(const std::string& name, const Resource& resource, const Region& region, int outputType, int channelMask, int flags)
+{
+	int status = Issue(RequestTextureConversion(resource.handle, region.mipLevel, region.slice, region.sliceCount, region.x, region.y, region.width, region.height, outputType, channelMask, flags));
+	if (status != kStatusSucceeded)
+	{
+		Report(name, StatusError(status));
+		return;
+	}
+
+	// channels are returned in RGBA order, selected channels the format doesn't have are 0, alpha is 1
+	bool bgra = (resource.flags & kFormatBGRA) != 0;
+	bool linear = (flags & kConversionLinear) != 0;
+	bool toFloat = outputType == (int)OutputType::Float32;
+	// halves and floats have exact float values, normalized values can differ in the last bit
+	float tolerance = resource.componentType == kSoftwareFloat32 || resource.componentType == kSoftwareFloat16 ? 0.0f : 1e-6f;
+	int mask = channelMask != 0 ? channelMask : (1 << resource.channels) - 1;
+	int outputChannels = 0;
+	for (int c = 0; c < 4; ++c)
+		outputChannels += (mask >> c) & 1;
+
+	std::vector<char> source = ReadReference(resource, region);
+	int pixels = (int)source.size() / resource.blockSize;
+	int outputSize = pixels * outputChannels * (toFloat ? 4 : 1);
+	std::vector<char> data(outputSize);
+	status = RetrieveResult(resource, &data);
+	if (status != kStatusSucceeded)
+	{
+		Report(name, StatusError(status));
+		return;
+	}
+
+	const float* floats = (const float*)data.data();
+	const unsigned char* bytes = (const unsigned char*)data.data();
+	for (int p = 0, index = 0; p < pixels; ++p)
+	{
+		const char* pixel = source.data() + p * resource.blockSize;
+		for (int c = 0; c < 4; ++c)
+		{
+			if ((mask & (1 << c)) == 0)
+				continue;
+
+			int channel = bgra && (c == 0 || c == 2) ? 2 - c : c;
+			float value = channel < resource.channels ? ComponentReference(pixel, channel, resource.componentType) : (c == 3 ? 1.0f : 0.0f);
+			bool decode = linear && c < 3 && channel < resource.channels;
+			if (decode)
+				value = SRGBToLinear(value);
+
+			bool equal;
+			if (toFloat)
+			{
+				equal = FloatsEqual(floats[index], value, tolerance);
+			}
+			else
+			{
+				// 8 bit unorm channels are passed as they are, the rest is saturated and rounded (NaN is 0)
+				unsigned char expected = channel < resource.channels && resource.componentType == kSoftwareUNorm8 && !decode ? (unsigned char)pixel[channel] :
+					(unsigned char)((value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f) * 255.0f + 0.5f);
+				equal = bytes[index] == expected;
+			}
+
+			if (!equal)
+			{
+				char error[128];
+				snprintf(error, sizeof(error), "pixel %d channel %d is %g, expected %g", p, c, toFloat ? (double)floats[index] : (double)bytes[index], toFloat ? value : value * 255.0);
+				Report(name, error);
+				return;
+			}
+			++index;
+		}
+	}
+
+	Report(name, std::string());
+}
+
+//-------------------------------------------------------------------------------------------------
+// VerifyConversions
+//-------------------------------------------------------------------------------------------------
+// odd widths leave tails after the 4/8 pixel SIMD blocks, so both vector and scalar code of a kernel run
+static void VerifyConversions()
+{
+	const int kFloat = (int)OutputType::Float32;
+	const int kUNorm8 = (int)OutputType::UNorm8;
+
+	Resource rgba16f;
+	if (CreateTexture(&rgba16f, "verify conversion rgba16f", 41, 9, 3, 2, false, kSoftwareFloat16, 4))
+	{
+		Region region = { 0, 0, 1, 2, 1, 37, 7 };
+		CheckConversion("conversion/rgba16f->float", rgba16f, region, kFloat, 0, 0);
+		CheckConversion("conversion/rgba16f->float RGA", rgba16f, region, kFloat, kChannelR | kChannelG | kChannelA, 0);
+		CheckConversion("conversion/rgba16f->unorm8", rgba16f, region, kUNorm8, 0, 0);
+		Region slices = { 1, 1, 2, 1, 0, 19, 4 };
+		CheckConversion("conversion/rgba16f->float mip1 slices1-2", rgba16f, slices, kFloat, 0, 0);
+	}
+
+	Resource r16f;
+	if (CreateTexture(&r16f, "verify conversion r16f", 37, 5, 1, 1, false, kSoftwareFloat16, 1))
+		CheckConversion("conversion/r16f->float", r16f, r16f.Level(0), kFloat, 0, 0);
+
+	Resource rg16f;
+	if (CreateTexture(&rg16f, "verify conversion rg16f", 23, 5, 1, 1, false, kSoftwareFloat16, 2))
+		CheckConversion("conversion/rg16f->float RGBA", rg16f, rg16f.Level(0), kFloat, kChannelRGBA, 0);
+
+	Resource rgba8;
+	if (CreateTexture(&rgba8, "verify conversion rgba8", 37, 6, 1, 1, false, kSoftwareUNorm8, 4))
+	{
+		CheckConversion("conversion/rgba8->float", rgba8, rgba8.Level(0), kFloat, 0, 0);
+		CheckConversion("conversion/rgba8->float linear", rgba8, rgba8.Level(0), kFloat, 0, kConversionLinear);
+		CheckConversion("conversion/rgba8->unorm8 linear RGB", rgba8, rgba8.Level(0), kUNorm8, kChannelR | kChannelG | kChannelB, kConversionLinear);
+	}
+
+	Resource bgra8;
+	if (CreateTexture(&bgra8, "verify conversion bgra8", 37, 6, 1, 1, false, kSoftwareUNorm8, 4, kFormatBGRA))
+	{
+		CheckConversion("conversion/bgra8->unorm8 RGBA", bgra8, bgra8.Level(0), kUNorm8, kChannelRGBA, 0);
+		CheckConversion("conversion/bgra8->float RB", bgra8, bgra8.Level(0), kFloat, kChannelR | kChannelB, 0);
+	}
+
+	Resource r32f;
+	if (CreateTexture(&r32f, "verify conversion r32f", 29, 5, 1, 1, false, kSoftwareFloat32, 1))
+	{
+		CheckConversion("conversion/r32f->float", r32f, r32f.Level(0), kFloat, 0, 0);
+		CheckConversion("conversion/r32f->unorm8 RGBA", r32f, r32f.Level(0), kUNorm8, kChannelRGBA, 0);
+	}
+
+	Resource rg16;
+	if (CreateTexture(&rg16, "verify conversion rg16", 21, 5, 1, 1, false, kSoftwareUNorm16, 2))
+		CheckConversion("conversion/rg16->float", rg16, rg16.Level(0), kFloat, 0, 0);
+
+	Resource rgba8s;
+	if (CreateTexture(&rgba8s, "verify conversion rgba8 snorm", 21, 5, 1, 1, false, kSoftwareSNorm8, 4))
+		CheckConversion("conversion/rgba8 snorm->float", rgba8s, rgba8s.Level(0), kFloat, 0, 0);
+}
+
+//-------------------------------------------------------------------------------------------------
+// CheckReduction
+//-------------------------------------------------------------------------------------------------
+static void CheckReduction(const std::string& name, const Resource& resource, int mipLevel, int slice, int flags, int histogramChannel, float histogramMin, float histogramMax)
+{
+	int status = Issue(RequestTextureReduction(resource.handle, mipLevel, slice, flags, histogramChannel, histogramMin, histogramMax));
+	if (status != kStatusSucceeded)
+	{
+		Report(name, StatusError(status));
+		return;
+	}
+
+	std::vector<char> data(sizeof(ReductionResult));
+	status = RetrieveResult(resource, &data);
+	if (status != kStatusSucceeded)
+	{
+		Report(name, StatusError(status));
+		return;
+	}
+
+	ReductionResult result;
+	memcpy(&result, data.data(), sizeof(result));
+
+	// channels in RGBA order, NaNs are ignored by min/max and histogram, values that weren't requested are zero
+	bool bgra = (resource.flags & kFormatBGRA) != 0;
+	float min[4] = { INFINITY, INFINITY, INFINITY, INFINITY };
+	float max[4] = { -INFINITY, -INFINITY, -INFINITY, -INFINITY };
+	double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+	std::vector<unsigned int> histogram(kHistogramBins);
+	float scale = kHistogramBins / (histogramMax - histogramMin);
+
+	std::vector<char> source = ReadReference(resource, resource.Level(mipLevel, slice));
+	int pixels = (int)source.size() / resource.blockSize;
+	for (int p = 0; p < pixels; ++p)
+	{
+		for (int c = 0; c < resource.channels; ++c)
+		{
+			int channel = bgra && (c == 0 || c == 2) ? 2 - c : c;
+			float value = ComponentReference(source.data() + p * resource.blockSize, channel, resource.componentType);
+			sum[c] += value;
+			if (value != value)
+				continue;
+
+			min[c] = std::min(min[c], value);
+			max[c] = std::max(max[c], value);
+			if (c == histogramChannel)
+			{
+				float bin = (value - histogramMin) * scale;
+				++histogram[bin < 0.0f ? 0 : (bin >= kHistogramBins - 1 ? kHistogramBins - 1 : (int)bin)];
+			}
+		}
+	}
+
+	char error[128] = "";
+	for (int c = 0; c < 4 && error[0] == 0; ++c)
+	{
+		bool channel = c < resource.channels;
+		float expectedMin = channel && (flags & kReductionMinMax) != 0 ? min[c] : 0.0f;
+		float expectedMax = channel && (flags & kReductionMinMax) != 0 ? max[c] : 0.0f;
+		float expectedMean = channel && (flags & kReductionMean) != 0 ? (float)(sum[c] / pixels) : 0.0f;
+		if (!FloatsEqual(result.min[c], expectedMin, 0.0f) || !FloatsEqual(result.max[c], expectedMax, 0.0f))
+			snprintf(error, sizeof(error), "channel %d min/max %g/%g, expected %g/%g", c, result.min[c], result.max[c], expectedMin, expectedMax);
+		else if (!FloatsEqual(result.mean[c], expectedMean, 1e-4f))
+			snprintf(error, sizeof(error), "channel %d mean %g, expected %g", c, result.mean[c], expectedMean);
+	}
+
+	for (int i = 0; i < kHistogramBins && error[0] == 0; ++i)
+	{
+		unsigned int expected = (flags & kReductionHistogram) != 0 ? histogram[i] : 0;
+		if (result.histogram[i] != expected)
+			snprintf(error, sizeof(error), "histogram bin %d is %u, expected %u", i, result.histogram[i], expected);
+	}
+
+	Report(name, error);
+}
+
+//-------------------------------------------------------------------------------------------------
+// VerifyReductions
+//-------------------------------------------------------------------------------------------------
+static void VerifyReductions()
+{
+	const int kAll = kReductionMinMax | kReductionMean | kReductionHistogram;
+
+	Resource rgba8;
+	if (CreateTexture(&rgba8, "verify reduction rgba8", 37, 29, 1, 1, false, kSoftwareUNorm8, 4))
+	{
+		CheckReduction("reduction/rgba8 all", rgba8, 0, 0, kAll, 1, 0.0f, 1.0f);
+		CheckReduction("reduction/rgba8 mean", rgba8, 0, 0, kReductionMean, 0, 0.0f, 1.0f);
+	}
+
+	// min/max/mean and histogram channel are in RGBA order
+	Resource bgra8;
+	if (CreateTexture(&bgra8, "verify reduction bgra8", 33, 17, 1, 1, false, kSoftwareUNorm8, 4, kFormatBGRA))
+		CheckReduction("reduction/bgra8 all, histogram R 0.25-0.75", bgra8, 0, 0, kAll, 0, 0.25f, 0.75f);
+
+	Resource r32f;
+	if (CreateTexture(&r32f, "verify reduction r32f", 45, 31, 1, 1, false, kSoftwareFloat32, 1))
+		CheckReduction("reduction/r32f all with NaNs", r32f, 0, 0, kAll, 0, -1.0f, 2.0f);
+
+	Resource rgba32f;
+	if (CreateTexture(&rgba32f, "verify reduction rgba32f", 19, 7, 1, 1, false, kSoftwareFloat32, 4))
+		CheckReduction("reduction/rgba32f all", rgba32f, 0, 0, kAll, 2, 0.0f, 1.0f);
+
+	Resource rgba16f;
+	if (CreateTexture(&rgba16f, "verify reduction rgba16f", 35, 21, 3, 2, false, kSoftwareFloat16, 4))
+		CheckReduction("reduction/rgba16f mip1 slice2", rgba16f, 1, 2, kAll, 3, -2.0f, 2.0f);
+
+	Resource rg16;
+	if (CreateTexture(&rg16, "verify reduction rg16", 23, 13, 1, 1, false, kSoftwareUNorm16, 2))
+		CheckReduction("reduction/rg16 min/max", rg16, 0, 0, kReductionMinMax, 0, 0.0f, 1.0f);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RetrieveDelta
+//-------------------------------------------------------------------------------------------------
+static int RetrieveDelta(const Resource& resource, std::vector<char>* data)
+{
+	return Finish([&resource, data]()
+	{
+		int deltaSize = 0;
+		int eventId = RetrieveTextureDelta(resource.handle, data->data(), (int)data->size(), &deltaSize);
+
+		// delta is bigger than the buffer, the request stays until it fits
+		if (GetLastStatus() == kStatusErrorWrongBufferSize)
+		{
+			data->resize(deltaSize);
+			eventId = RetrieveTextureDelta(resource.handle, data->data(), (int)data->size(), &deltaSize);
+		}
+
+		if (GetLastStatus() == kStatusSucceeded)
+			data->resize(deltaSize);
+		return eventId;
+	});
+}
+
+//-------------------------------------------------------------------------------------------------
+// DeltaState
+//-------------------------------------------------------------------------------------------------
+// reference and image rebuilt from the deltas of one region so far, empty before the first delta
+struct DeltaState
+{
+	Region region;
+	std::vector<char> reference;
+	std::vector<char> image;
+};
+
+//-------------------------------------------------------------------------------------------------
+// ApplyDelta
+//-------------------------------------------------------------------------------------------------
+// writes dirty tiles to image (tightly packed slices of the region). checks the header, that dirty tiles are
+// exactly the tiles that differ between previous and current reference and zero padding of edge tiles
+static std::string ApplyDelta(const Resource& resource, const Region& region, int tileSize, const std::vector<char>& delta, 
+	const std::vector<char>& previous, const std::vector<char>& current, std::vector<char>* image)
+{
+	int rowPitch = resource.RowPitch(region.width);
+	int rowCount = resource.RowCount(region.height);
+	DeltaHeader expected = { tileSize, (region.width + tileSize - 1) / tileSize, (region.height + tileSize - 1) / tileSize, region.sliceCount, 0,
+		resource.RowPitch(tileSize), resource.RowCount(tileSize), resource.RowPitch(tileSize) * resource.RowCount(tileSize) };
+	int tileCount = expected.tilesX * expected.tilesY * expected.slices;
+	size_t bitmapSize = (tileCount + 31) / 32 * 4;
+
+	DeltaHeader header;
+	if (delta.size() < sizeof(header) + bitmapSize)
+		return "delta of " + std::to_string(delta.size()) + " bytes is too small";
+	memcpy(&header, delta.data(), sizeof(header));
+	expected.dirtyTiles = header.dirtyTiles;
+	if (memcmp(&header, &expected, sizeof(header)) != 0)
+		return "unexpected header";
+	if (delta.size() != sizeof(header) + bitmapSize + (size_t)header.dirtyTiles * header.tileDataSize)
+		return "size doesn't match dirty tiles";
+
+	std::vector<unsigned int> bitmap(bitmapSize / 4);
+	memcpy(bitmap.data(), delta.data() + sizeof(header), bitmapSize);
+	const char* tileData = delta.data() + sizeof(header) + bitmapSize;
+	int dirtyTiles = 0;
+	for (int tile = 0; tile < tileCount; ++tile)
+	{
+		int tileX = tile % header.tilesX;
+		int tileY = tile / header.tilesX % header.tilesY;
+		int slice = tile / (header.tilesX * header.tilesY);
+		int left = tileX * header.tileRowPitch;
+		int width = std::min(header.tileRowPitch, rowPitch - left);
+
+		bool changed = previous.empty();
+		for (int row = 0; row < header.tileRowCount && !changed; ++row)
+		{
+			int imageRow = tileY * header.tileRowCount + row;
+			size_t offset = ((size_t)slice * rowCount + imageRow) * rowPitch + left;
+			changed = imageRow < rowCount && memcmp(&previous[offset], &current[offset], width) != 0;
+		}
+
+		bool dirty = (bitmap[tile / 32] & (1u << (tile % 32))) != 0;
+		if (dirty != changed)
+			return "tile " + std::to_string(tile) + (dirty ? " is dirty but didn't change" : " changed but isn't dirty");
+		if (!dirty)
+			continue;
+
+		for (int row = 0; row < header.tileRowCount; ++row, tileData += header.tileRowPitch)
+		{
+			int imageRow = tileY * header.tileRowCount + row;
+			int copied = imageRow < rowCount ? width : 0;
+			if (copied > 0)
+				memcpy(&(*image)[((size_t)slice * rowCount + imageRow) * rowPitch + left], tileData, copied);
+
+			// part of edge tile outside the region
+			for (int i = copied; i < header.tileRowPitch; ++i)
+			{
+				if (tileData[i] != 0)
+					return "padding of tile " + std::to_string(tile) + " isn't zero";
+			}
+		}
+		++dirtyTiles;
+	}
+
+	return dirtyTiles == header.dirtyTiles ? std::string() : "header has " + std::to_string(header.dirtyTiles) + " dirty tiles, bitmap " + std::to_string(dirtyTiles);
+}
+
+//-------------------------------------------------------------------------------------------------
+// CheckDelta
+//-------------------------------------------------------------------------------------------------
+// requests delta of the region and applies it to the image rebuilt from the previous deltas, the image has
+// to match the resource. delta of other region than the previous one has every tile dirty
+static void CheckDelta(const std::string& name, const Resource& resource, const Region& region, int tileSize, DeltaState* state)
+{
+	int status = Issue(RequestTextureDelta(resource.handle, region.mipLevel, region.slice, region.sliceCount, tileSize));
+	std::vector<char> delta(sizeof(DeltaHeader));
+	if (status == kStatusSucceeded)
+		status = RetrieveDelta(resource, &delta);
+	if (status != kStatusSucceeded)
+	{
+		Report(name, StatusError(status));
+		return;
+	}
+
+	if (memcmp(&state->region, &region, sizeof(region)) != 0)
+	{
+		state->region = region;
+		state->reference.clear();
+		state->image.clear();
+	}
+
+	std::vector<char> reference = ReadReference(resource, region);
+	state->image.resize(reference.size());
+	std::string error = ApplyDelta(resource, region, tileSize, delta, state->reference, reference, &state->image);
+	if (error.empty())
+		error = CompareBytes(state->image, reference);
+
+	state->reference = reference;
+	Report(name, error);
+}
+
+//-------------------------------------------------------------------------------------------------
+// TouchTexel
+//-------------------------------------------------------------------------------------------------
+// changes first byte of the texel (block of compressed texture)
+static void TouchTexel(const Resource& resource, int mipLevel, int slice, int x, int y)
+{
+	int rowPitch = 0;
+	char* data = (char*)GetSoftwareResourceData(resource.native, mipLevel, slice, &rowPitch);
+	data[y / resource.blockDim * rowPitch + x / resource.blockDim * resource.blockSize] ^= 0x5a;
+}
+
+//-------------------------------------------------------------------------------------------------
+// VerifyDeltas
+//-------------------------------------------------------------------------------------------------
+static void VerifyDeltas()
+{
+	Resource rgba8;
+	if (CreateTexture(&rgba8, "verify delta rgba8", 100, 70, 1, 1, false, kSoftwareUNorm8, 4))
+	{
+		DeltaState state = {};
+		Region level = rgba8.Level(0);
+		CheckDelta("delta/rgba8/first, every tile", rgba8, level, 16, &state);
+		CheckDelta("delta/rgba8/unchanged, no tile", rgba8, level, 16, &state);
+		TouchTexel(rgba8, 0, 0, 20, 21);
+		TouchTexel(rgba8, 0, 0, 99, 69);
+		CheckDelta("delta/rgba8/inner and edge tile", rgba8, level, 16, &state);
+	}
+
+	// tiles of compressed formats cover whole blocks, slices are tiled one after another
+	Resource bc7;
+	if (CreateTexture(&bc7, "verify delta BC", 40, 22, 2, 1, false, kSoftwareCompressed, 16))
+	{
+		DeltaState state = {};
+		Region level = bc7.Level(0, 0, 2);
+		CheckDelta("delta/blocks/first, every tile", bc7, level, 8, &state);
+		TouchTexel(bc7, 0, 1, 37, 21);
+		CheckDelta("delta/blocks/edge tile of slice1", bc7, level, 8, &state);
+	}
+
+	// tiles are compared only with the same subresource, equal content of other slice or mip level is every tile dirty
+	Resource array;
+	if (CreateTexture(&array, "verify delta array", 48, 40, 2, 1, false, kSoftwareUNorm8, 4))
+	{
+		int rowPitch = 0;
+		const char* slice0 = (const char*)GetSoftwareResourceData(array.native, 0, 0, &rowPitch);
+		memcpy(GetSoftwareResourceData(array.native, 0, 1, NULL), slice0, rowPitch * array.height);
+
+		DeltaState state = {};
+		CheckDelta("delta/array/slice0", array, array.Level(0, 0), 16, &state);
+		CheckDelta("delta/array/equal slice1, every tile", array, array.Level(0, 1), 16, &state);
+		CheckDelta("delta/array/slice1 again, no tile", array, array.Level(0, 1), 16, &state);
+	}
+
+	Resource mips;
+	if (CreateTexture(&mips, "verify delta 1x1 mips", 1, 1, 1, 2, false, kSoftwareFloat32, 4))
+	{
+		memcpy(GetSoftwareResourceData(mips.native, 1, 0, NULL), GetSoftwareResourceData(mips.native, 0, 0, NULL), 16);
+
+		DeltaState state = {};
+		CheckDelta("delta/mips/mip0", mips, mips.Level(0), 8, &state);
+		CheckDelta("delta/mips/equal mip1, every tile", mips, mips.Level(1), 8, &state);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// VerifyBatch
+//-------------------------------------------------------------------------------------------------
+// members of one batch are retrieved together, every one has the whole resource
+static void VerifyBatch()
+{
+	Resource resources[3];
+	if (!CreateTexture(&resources[0], "verify batch rgba8", 37, 29, 1, 1, false, kSoftwareUNorm8, 4) ||
+		!CreateTexture(&resources[1], "verify batch r32f", 23, 11, 2, 2, false, kSoftwareFloat32, 1) ||
+		!CreateBuffer(&resources[2], "verify batch buffer", 777))
+	{
+		Report("batch/texture, array, buffer", "can't create resources");
+		return;
+	}
+
+	int handles[3];
+	std::vector<char> data[3];
+	void* pointers[3];
+	int sizes[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		handles[i] = resources[i].handle;
+		data[i].assign(resources[i].DataSize(resources[i].Level(0)), (char)0xcd);
+		pointers[i] = data[i].data();
+		sizes[i] = (int)data[i].size();
+	}
+
+	auto compare = [&]()
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			std::string error = CompareBytes(data[i], ReadReference(resources[i], resources[i].Level(0)));
+			if (!error.empty())
+				return "member " + std::to_string(i) + " " + error;
+		}
+		return std::string();
+	};
+
+	int batchId = -1;
+	int status = Issue(RequestBatch(handles, 3, &batchId));
+	if (status == kStatusSucceeded)
+		status = Finish([&]() { return RetrieveBatch(batchId, pointers, sizes, 3); });
+
+	std::string error = StatusError(status);
+	Report("batch/texture, array, buffer", error.empty() ? compare() : error);
+
+	// older request of a member failed on render thread, it has to be retrieved first and doesn't fail the batch
+	Issue(RequestTextureRegion(resources[1].handle, 20, 0, 10, 10));
+	status = Issue(RequestBatch(handles, 3, &batchId));
+	if (status == kStatusSucceeded)
+		status = Finish([&]() { return RetrieveBatch(batchId, pointers, sizes, 3); });
+
+	error = StatusError(status, kStatusErrorCopyInProgress);
+	if (error.empty())
+	{
+		std::vector<char> older(resources[1].DataSize(resources[1].Level(0)));
+		error = StatusError(RetrieveResult(resources[1], &older), kStatusErrorInvalidArguments);
+	}
+	if (error.empty())
+	{
+		for (int i = 0; i < 3; ++i)
+			data[i].assign(data[i].size(), (char)0xcd);
+		error = StatusError(Finish([&]() { return RetrieveBatch(batchId, pointers, sizes, 3); }));
+	}
+
+	Report("batch/after older failed request", error.empty() ? compare() : error);
+}
+
+//-------------------------------------------------------------------------------------------------
+// CheckLease
+//-------------------------------------------------------------------------------------------------
+// leased data of request that was just issued stay in staging slot until the lease is released
+static void CheckLease(const std::string& name, const Resource& resource, int eventId, const std::vector<char>& reference, int rowPitch)
+{
+	int status = Issue(eventId);
+	const void* data = NULL;
+	int dataSize = 0;
+	int dataRowPitch = 0;
+	int lease = -1;
+	if (status == kStatusSucceeded)
+		status = Finish([&]() { return AcquireReadback(resource.handle, &data, &dataSize, &dataRowPitch, &lease); });
+	if (status != kStatusSucceeded)
+	{
+		Report(name, StatusError(status));
+		return;
+	}
+
+	std::string error;
+	if (dataRowPitch != rowPitch)
+		error = "row pitch " + std::to_string(dataRowPitch) + ", expected " + std::to_string(rowPitch);
+	else
+		error = CompareBytes(std::vector<char>((const char*)data, (const char*)data + dataSize), reference);
+
+	// lease can be released only once
+	if (error.empty())
+		error = StatusError(ReleaseReadback(lease));
+	if (error.empty())
+		error = StatusError(ReleaseReadback(lease), kStatusErrorInvalidArguments);
+
+	Report(name, error);
+}
+
+//-------------------------------------------------------------------------------------------------
+// VerifyLeases
+//-------------------------------------------------------------------------------------------------
+static void VerifyLeases()
+{
+	Resource rgba16f;
+	if (!CreateTexture(&rgba16f, "verify lease rgba16f", 31, 19, 1, 1, false, kSoftwareFloat16, 4))
+		return;
+
+	Region region = { 0, 0, 1, 3, 4, 17, 9 };
+	CheckLease("lease/rgba16f region", rgba16f, RequestTextureRegion(rgba16f.handle, 3, 4, 17, 9), ReadReference(rgba16f, region), 17 * 8);
+
+	// converted rows are tightly packed in the output format, halves are saturated and rounded (NaN is 0)
+	std::vector<char> halves = ReadReference(rgba16f, region);
+	std::vector<char> bytes(halves.size() / 2);
+	for (size_t i = 0; i < bytes.size(); ++i)
+	{
+		float value = ComponentReference(halves.data(), (int)i, kSoftwareFloat16);
+		bytes[i] = (char)(unsigned char)((value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f) * 255.0f + 0.5f);
+	}
+	CheckLease("lease/rgba16f region converted to unorm8", rgba16f, 
+		RequestTextureConversion(rgba16f.handle, 0, 0, 1, 3, 4, 17, 9, (int)OutputType::UNorm8, 0, 0), bytes, 17 * 4);
+}
+
+//-------------------------------------------------------------------------------------------------
+// ReadCaptureFile
+//-------------------------------------------------------------------------------------------------
+// every copy in the index of closed capture file has to be the whole resource
+static std::string ReadCaptureFile(const char* path, const std::vector<char>& reference, int written)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+		return "file can't be opened";
+
+	std::string error;
+	CaptureHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "ATRCAPT", sizeof(header.magic)) != 0 || header.indexOffset == 0)
+		error = "file wasn't closed";
+	else if (header.entryCount != written)
+		error = std::to_string(header.entryCount) + " copies in the index, " + std::to_string(written) + " written";
+
+	std::vector<CaptureEntry> index(error.empty() ? header.entryCount : 0);
+	if (!index.empty() && (fseek(file, (long)header.indexOffset, SEEK_SET) != 0 || fread(&index[0], sizeof(CaptureEntry), index.size(), file) != index.size()))
+		error = "index can't be read";
+
+	std::vector<char> data(reference.size());
+	for (size_t i = 0; i < index.size() && error.empty(); ++i)
+	{
+		if (index[i].size != (int)reference.size())
+			error = "copy " + std::to_string(i) + " has " + std::to_string(index[i].size) + " bytes";
+		else if (fseek(file, (long)index[i].offset, SEEK_SET) != 0 || fread(data.data(), 1, data.size(), file) != data.size())
+			error = "copy " + std::to_string(i) + " can't be read";
+		else
+			error = CompareBytes(data, reference);
+	}
+
+	fclose(file);
+	return error;
+}
+
+//-------------------------------------------------------------------------------------------------
+// VerifyCapture
+//-------------------------------------------------------------------------------------------------
+// stopped capture stays queryable while its writer closes the file, the handle is invalid once it reported finished
+static void VerifyCapture()
+{
+	Resource rgba8;
+	if (!CreateTexture(&rgba8, "verify capture rgba8", 37, 23, 1, 1, false, kSoftwareUNorm8, 4))
+		return;
+
+	const char* path = "verify_capture.tmp";
+	int capture = -1;
+	int status = Issue(StartCapture(rgba8.handle, 1, 4, path, 1, &capture));
+	if (status != kStatusSucceeded)
+	{
+		Report("capture/stopped capture finishes in background", StatusError(status));
+		return;
+	}
+
+	int written = 0, skipped = 0, failed = 0, finished = 0;
+	long long bytes = 0;
+	for (int frame = 0; frame < kMaxFrames && status == kStatusSucceeded && written < 3; ++frame)
+	{
+		GetPollEventFunc()(0);
+		EndSoftwareDeviceFrame();
+		std::this_thread::yield();
+		status = GetCaptureStatus(capture, &written, &skipped, &failed, &bytes, &finished);
+	}
+
+	// handle is still valid right after stop, poll events release the copies once the file is closed
+	if (status == kStatusSucceeded)
+		status = Issue(StopCapture(capture));
+	for (int frame = 0; frame < kMaxFrames && status == kStatusSucceeded && !finished; ++frame)
+	{
+		status = GetCaptureStatus(capture, &written, &skipped, &failed, &bytes, &finished);
+		GetPollEventFunc()(0);
+		std::this_thread::yield();
+	}
+
+	std::string error = StatusError(status);
+	if (error.empty() && !finished)
+		error = "capture didn't finish";
+	if (error.empty())
+		error = StatusError(GetCaptureStatus(capture, &written, &skipped, &failed, &bytes, &finished), kStatusErrorInvalidArguments);
+	if (error.empty() && failed != 0)
+		error = std::to_string(failed) + " copies failed";
+	if (error.empty())
+		error = ReadCaptureFile(path, ReadReference(rgba8, rgba8.Level(0)), written);
+
+	remove(path);
+	Report("capture/stopped capture finishes in background", error);
+}
+
+//-------------------------------------------------------------------------------------------------
+// RunVerify
+//-------------------------------------------------------------------------------------------------
+bool RunVerify()
+{
+	VerifyRegions();
+	VerifyBlocks();
+	VerifyConversions();
+	VerifyReductions();
+	VerifyDeltas();
+	VerifyBatch();
+	VerifyLeases();
+	VerifyCapture();
+
+	printf("%d checks, %d failed\n", sChecks, sFailures);
+	return sFailures == 0;
+}
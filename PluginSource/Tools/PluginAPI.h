@@ -0,0 +1,120 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "Unity/IUnityGraphics.h"
+#include <stdint.h>
+
+// exported functions of the plugin used by native tools. status values are the same as Status in RendererAPI.h
+enum PluginStatus
+{
+	kStatusSucceeded = 0,
+	kStatusNotReady = 1,
+	kStatusErrorUnsupportedFormat = 4,
+	kStatusErrorWrongBufferSize = 5,
+	kStatusErrorInvalidArguments = 7,
+	kStatusErrorCopyInProgress = 9
+};
+
+// ComponentType values accepted by CreateSoftwareTexture
+enum SoftwareComponentType
+{
+	kSoftwareFloat32 = 0,
+	kSoftwareFloat16 = 1,
+	kSoftwareUNorm16 = 4,
+	kSoftwareUNorm8 = 8,
+	kSoftwareSNorm8 = 9,
+	// channels is block size in bytes
+	kSoftwareCompressed = 14
+};
+
+extern "C"
+{
+	void UNITY_INTERFACE_API UnityPluginLoad(IUnityInterfaces* unityInterfaces);
+	void UNITY_INTERFACE_API UnityPluginUnload();
+
+	UnityRenderingEvent UNITY_INTERFACE_API GetRequestTextureEventFunc();
+	UnityRenderingEvent UNITY_INTERFACE_API GetRequestBufferEventFunc();
+	UnityRenderingEvent UNITY_INTERFACE_API GetCopyTextureEventFunc();
+	UnityRenderingEvent UNITY_INTERFACE_API GetCopyBufferEventFunc();
+	UnityRenderingEvent UNITY_INTERFACE_API GetReleaseTempResourcesEventFunc();
+	UnityRenderingEvent UNITY_INTERFACE_API GetPollEventFunc();
+
+	int UNITY_INTERFACE_API RegisterTexture(void* nativeTexture);
+	int UNITY_INTERFACE_API RegisterBuffer(void* nativeBuffer);
+	int UNITY_INTERFACE_API ReleaseTempResources(int resourceHandle);
+
+	int UNITY_INTERFACE_API RequestTextureData(int textureHandle);
+	int UNITY_INTERFACE_API RequestTextureRegion(int textureHandle, int x, int y, int width, int height);
+	int UNITY_INTERFACE_API RequestTextureSubresource(int textureHandle, int mipLevel, int slice, int sliceCount, int x, int y, int width, int height);
+	int UNITY_INTERFACE_API RequestTextureReduction(int textureHandle, int mipLevel, int slice, int flags, int histogramChannel, float histogramMin, float histogramMax);
+	int UNITY_INTERFACE_API RequestTextureConversion(int textureHandle, int mipLevel, int slice, int sliceCount, int x, int y, int width, int height, int outputType, int channelMask, int flags);
+	int UNITY_INTERFACE_API RetrieveTextureData(int textureHandle, void* data, int dataSize);
+	int UNITY_INTERFACE_API RequestTextureDelta(int textureHandle, int mipLevel, int slice, int sliceCount, int tileSize);
+	int UNITY_INTERFACE_API RetrieveTextureDelta(int textureHandle, void* data, int dataSize, int* deltaSize);
+	int UNITY_INTERFACE_API RequestBufferData(int bufferHandle);
+	int UNITY_INTERFACE_API RequestBufferRange(int bufferHandle, int offset, int length);
+	int UNITY_INTERFACE_API RetrieveBufferData(int bufferHandle, void* data, int dataSize);
+
+	int UNITY_INTERFACE_API RequestBatch(const int* resourceHandles, int count, int* batchId);
+	int UNITY_INTERFACE_API RetrieveBatch(int batchId, void** data, const int* dataSizes, int count);
+	int UNITY_INTERFACE_API AcquireReadback(int resourceHandle, const void** data, int* dataSize, int* rowPitch, int* lease);
+	int UNITY_INTERFACE_API ReleaseReadback(int lease);
+
+	int UNITY_INTERFACE_API GetLastStatus();
+	int UNITY_INTERFACE_API GetLastRequestId();
+	int UNITY_INTERFACE_API SetStagingRingSize(int size);
+	int UNITY_INTERFACE_API SetCopyThread(int enabled);
+	int UNITY_INTERFACE_API SetStagingPool(int budgetMB, int idleFrames);
+	// stats points to ReadbackStatsSnapshot (ReadbackStats.h), statsSize is its size
+	int UNITY_INTERFACE_API GetReadbackStats(void* stats, int statsSize, int reset);
+	int UNITY_INTERFACE_API SetReadbackTrace(int enabled);
+	int UNITY_INTERFACE_API SetResourceName(int resourceHandle, const char* name);
+	int UNITY_INTERFACE_API WriteReadbackTrace(const char* path);
+
+	UnityRenderingEvent UNITY_INTERFACE_API GetSubscriptionEventFunc();
+	int UNITY_INTERFACE_API Subscribe(int resourceHandle, int everyNFrames, int ringDepth, int* subscription);
+	int UNITY_INTERFACE_API Unsubscribe(int subscription);
+	int UNITY_INTERFACE_API RetrieveSubscription(int subscription, int latest, void* data, int dataSize, int* frame, int* dropped);
+	int UNITY_INTERFACE_API StartCapture(int resourceHandle, int everyNFrames, int depth, const char* path, int maxMB, int* capture);
+	int UNITY_INTERFACE_API StopCapture(int capture);
+	int UNITY_INTERFACE_API GetCaptureStatus(int capture, int* written, int* skipped, int* failed, long long* bytes, int* finished);
+
+	int UNITY_INTERFACE_API SetCompletionCallback(void (*callback)(int resourceHandle, int requestId, int status, void* userData), void* userData);
+	intptr_t UNITY_INTERFACE_API GetCompletionHandle();
+	// 1 when completion was popped, 2 when completions were lost because the queue was full (fall back to polling)
+	int UNITY_INTERFACE_API PopCompletion(int* resourceHandle, int* requestId, int* status);
+
+	int UNITY_INTERFACE_API SetSoftwareDeviceConfig(int latencyFrames, float bandwidthMBps, int rowPitchAlignment, int createFailureInterval, int mapFailureInterval);
+	void UNITY_INTERFACE_API EndSoftwareDeviceFrame();
+	void* UNITY_INTERFACE_API CreateSoftwareTexture(int width, int height, int slices, int mipLevels, int is3D, int componentType, int channels, int formatFlags);
+	void* UNITY_INTERFACE_API CreateSoftwareBuffer(int size);
+	void* UNITY_INTERFACE_API GetSoftwareResourceData(void* nativeResource, int mipLevel, int slice, int* rowPitch);
+	void UNITY_INTERFACE_API ReleaseSoftwareResource(void* nativeResource);
+}
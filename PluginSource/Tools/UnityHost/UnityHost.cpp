@@ -0,0 +1,300 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "UnityHost.h"
+#include <algorithm>
+#include <assert.h>
+#include <dlfcn.h>
+
+static UnityHost* sHost = NULL;
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::UnityHost()
+//-------------------------------------------------------------------------------------------------
+UnityHost::UnityHost(UnityGfxRenderer renderer)
+	: _renderer(renderer), _library(NULL), _unload(NULL), _frameFunc(NULL), _targetFrameTime(0.0), _maxFramesAhead(1), _frame(0),
+	_pushed(0), _executed(0), _renderedFrames(0)
+{
+	assert(sHost == NULL);
+	sHost = this;
+
+	_graphics.GetRenderer = GetRenderer;
+	_graphics.RegisterDeviceEventCallback = RegisterDeviceEventCallback;
+	_graphics.UnregisterDeviceEventCallback = UnregisterDeviceEventCallback;
+	_interfaces.GetInterface = GetInterface;
+	_interfaces.RegisterInterface = RegisterInterface;
+	_interfaces.Register<IUnityGraphics>(&_graphics);
+
+	_frameStart = std::chrono::steady_clock::now();
+	_renderThread = std::thread(&UnityHost::RenderThreadFunc, this);
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::~UnityHost()
+//-------------------------------------------------------------------------------------------------
+UnityHost::~UnityHost()
+{
+	Shutdown();
+	sHost = NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::LoadPlugin()
+//-------------------------------------------------------------------------------------------------
+bool UnityHost::LoadPlugin(PluginLoadFunc load, PluginUnloadFunc unload)
+{
+	if (load == NULL || _unload != NULL || !_renderThread.joinable())
+		return false;
+
+	// device already exists, plugin sends initialize event to itself like in Unity
+	_unload = unload;
+	load(&_interfaces);
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::LoadPlugin()
+//-------------------------------------------------------------------------------------------------
+bool UnityHost::LoadPlugin(const char* path)
+{
+	if (_library != NULL)
+		return false;
+
+	void* library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (library == NULL)
+		return false;
+
+	PluginLoadFunc load = (PluginLoadFunc)dlsym(library, "UnityPluginLoad");
+	PluginUnloadFunc unload = (PluginUnloadFunc)dlsym(library, "UnityPluginUnload");
+	if (!LoadPlugin(load, unload))
+	{
+		dlclose(library);
+		return false;
+	}
+
+	_library = library;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::Shutdown()
+//-------------------------------------------------------------------------------------------------
+void UnityHost::Shutdown()
+{
+	if (!_renderThread.joinable())
+		return;
+
+	// device is destroyed before plugins are unloaded
+	SendDeviceEvent(kUnityGfxDeviceEventShutdown);
+	if (_unload != NULL)
+		_unload();
+
+	Command command = { CommandType::Quit, NULL, 0, kUnityGfxDeviceEventShutdown };
+	Push(command);
+	_renderThread.join();
+
+	if (_library != NULL)
+		dlclose(_library);
+
+	_library = NULL;
+	_unload = NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::IssuePluginEvent()
+//-------------------------------------------------------------------------------------------------
+void UnityHost::IssuePluginEvent(UnityRenderingEvent func, int eventId)
+{
+	// plugin functions return -1 when there's nothing to do on render thread
+	if (func == NULL || eventId < 0)
+		return;
+
+	Command command = { CommandType::PluginEvent, func, eventId, kUnityGfxDeviceEventInitialize };
+	Push(command);
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::EndFrame()
+//-------------------------------------------------------------------------------------------------
+void UnityHost::EndFrame()
+{
+	Command command = { CommandType::EndFrame, NULL, 0, kUnityGfxDeviceEventInitialize };
+	Push(command);
+	++_frame;
+
+	// main thread can't get more than maxFramesAhead frames in front of render thread
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_progress.wait(lock, [this] { return _frame - _renderedFrames <= _maxFramesAhead; });
+	}
+
+	if (_targetFrameTime > 0.0)
+	{
+		_frameStart += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(_targetFrameTime));
+		std::this_thread::sleep_until(_frameStart);
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::WaitForRenderThread()
+//-------------------------------------------------------------------------------------------------
+void UnityHost::WaitForRenderThread()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_progress.wait(lock, [this] { return _executed == _pushed; });
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::TakeRenderFrameTimes()
+//-------------------------------------------------------------------------------------------------
+std::vector<double> UnityHost::TakeRenderFrameTimes()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::vector<double> times;
+	times.swap(_renderFrameTimes);
+	return times;
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::Push()
+//-------------------------------------------------------------------------------------------------
+void UnityHost::Push(const Command& command)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_commands.push_back(command);
+		++_pushed;
+	}
+	_wake.notify_one();
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::SendDeviceEvent()
+//-------------------------------------------------------------------------------------------------
+void UnityHost::SendDeviceEvent(UnityGfxDeviceEventType eventType)
+{
+	Command command = { CommandType::DeviceEvent, NULL, 0, eventType };
+	Push(command);
+	WaitForRenderThread();
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::RenderThreadFunc()
+//-------------------------------------------------------------------------------------------------
+void UnityHost::RenderThreadFunc()
+{
+	typedef std::chrono::steady_clock Clock;
+	double frameTime = 0.0;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	{
+		_wake.wait(lock, [this] { return !_commands.empty(); });
+		Command command = _commands.front();
+		_commands.pop_front();
+		if (command.type == CommandType::Quit)
+			return;
+
+		// callbacks can't be changed while device events are sent
+		std::vector<IUnityGraphicsDeviceEventCallback> callbacks = _deviceCallbacks;
+		lock.unlock();
+
+		Clock::time_point start = Clock::now();
+		switch (command.type)
+		{
+		case CommandType::PluginEvent:
+			command.func(command.eventId);
+			break;
+		case CommandType::DeviceEvent:
+			for (size_t i = 0; i < callbacks.size(); ++i)
+				callbacks[i](command.deviceEvent);
+			break;
+		case CommandType::EndFrame:
+			if (_frameFunc != NULL)
+				_frameFunc();
+			break;
+		case CommandType::Quit:
+			break;
+		}
+		frameTime += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+		lock.lock();
+		++_executed;
+		if (command.type == CommandType::EndFrame)
+		{
+			_renderFrameTimes.push_back(frameTime);
+			frameTime = 0.0;
+			++_renderedFrames;
+		}
+		_progress.notify_all();
+	}
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::GetInterface()
+//-------------------------------------------------------------------------------------------------
+IUnityInterface* UNITY_INTERFACE_API UnityHost::GetInterface(UnityInterfaceGUID guid)
+{
+	std::map<UnityInterfaceGUID, IUnityInterface*>::const_iterator it = sHost->_registry.find(guid);
+	return it != sHost->_registry.end() ? it->second : NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::RegisterInterface()
+//-------------------------------------------------------------------------------------------------
+void UNITY_INTERFACE_API UnityHost::RegisterInterface(UnityInterfaceGUID guid, IUnityInterface* ptr)
+{
+	sHost->_registry[guid] = ptr;
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::GetRenderer()
+//-------------------------------------------------------------------------------------------------
+UnityGfxRenderer UNITY_INTERFACE_API UnityHost::GetRenderer()
+{
+	return sHost->_renderer;
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::RegisterDeviceEventCallback()
+//-------------------------------------------------------------------------------------------------
+void UNITY_INTERFACE_API UnityHost::RegisterDeviceEventCallback(IUnityGraphicsDeviceEventCallback callback)
+{
+	std::lock_guard<std::mutex> lock(sHost->_mutex);
+	sHost->_deviceCallbacks.push_back(callback);
+}
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost::UnregisterDeviceEventCallback()
+//-------------------------------------------------------------------------------------------------
+void UNITY_INTERFACE_API UnityHost::UnregisterDeviceEventCallback(IUnityGraphicsDeviceEventCallback callback)
+{
+	std::lock_guard<std::mutex> lock(sHost->_mutex);
+	std::vector<IUnityGraphicsDeviceEventCallback>& callbacks = sHost->_deviceCallbacks;
+	callbacks.erase(std::remove(callbacks.begin(), callbacks.end(), callback), callbacks.end());
+}
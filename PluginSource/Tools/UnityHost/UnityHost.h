@@ -0,0 +1,136 @@
+//  Copyright(c) 2016, Michal Skalsky
+//  All rights reserved.
+//
+//  Redistribution and use in source and binary forms, with or without modification,
+//  are permitted provided that the following conditions are met:
+//
+//  1. Redistributions of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//  2. Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//  3. Neither the name of the copyright holder nor the names of its contributors
+//     may be used to endorse or promote products derived from this software without
+//     specific prior written permission.
+//
+//  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+//  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+//  OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.IN NO EVENT
+//  SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+//  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+//  OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+//  HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+//  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+//  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include "Unity/IUnityGraphics.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+// UnityHost
+//-------------------------------------------------------------------------------------------------
+// headless stand-in for Unity so native plugins can be loaded and driven outside the editor.
+// it provides IUnityInterfaces registry with IUnityGraphics, render thread that executes plugin events
+// in the order they were issued (GL.IssuePluginEvent) and frame loop that keeps main thread at most
+// maxFramesAhead frames in front of render thread. device events are delivered on render thread.
+// IUnityInterfaces are plain function pointers, so only one host can exist at a time
+class UnityHost
+{
+public:
+	typedef void (UNITY_INTERFACE_API * PluginLoadFunc)(IUnityInterfaces* unityInterfaces);
+	typedef void (UNITY_INTERFACE_API * PluginUnloadFunc)();
+	typedef void (*FrameFunc)();
+
+	explicit UnityHost(UnityGfxRenderer renderer = kUnityGfxRendererNull);
+	~UnityHost();
+
+	IUnityInterfaces* GetInterfaces() { return &_interfaces; }
+
+	// plugin linked to the host, or shared library loaded by path. plugin is unloaded by Shutdown
+	bool LoadPlugin(PluginLoadFunc load, PluginUnloadFunc unload);
+	bool LoadPlugin(const char* path);
+	// sends shutdown device event, unloads the plugin and stops render thread
+	void Shutdown();
+
+	// main thread, same as GL.IssuePluginEvent
+	void IssuePluginEvent(UnityRenderingEvent func, int eventId);
+	// ends main thread frame, waits for render thread when it's too far behind and paces frames
+	void EndFrame();
+	// blocks until render thread executed everything issued so far
+	void WaitForRenderThread();
+	int GetFrame() const { return _frame; }
+
+	// called on render thread at the end of every frame, e.g. present of simulated device
+	void SetFrameFunc(FrameFunc func) { _frameFunc = func; }
+	// zero runs frames as fast as possible
+	void SetTargetFrameTime(double milliseconds) { _targetFrameTime = milliseconds; }
+	void SetMaxFramesAhead(int frames) { _maxFramesAhead = frames; }
+	// time render thread spent in plugin events of every finished frame (microseconds), cleared by the call
+	std::vector<double> TakeRenderFrameTimes();
+
+private:
+	enum class CommandType
+	{
+		PluginEvent,
+		DeviceEvent,
+		EndFrame,
+		Quit
+	};
+
+	struct Command
+	{
+		CommandType type;
+		UnityRenderingEvent func;
+		int eventId;
+		UnityGfxDeviceEventType deviceEvent;
+	};
+
+	void Push(const Command& command);
+	void SendDeviceEvent(UnityGfxDeviceEventType eventType);
+	void RenderThreadFunc();
+
+	static IUnityInterface* UNITY_INTERFACE_API GetInterface(UnityInterfaceGUID guid);
+	static void UNITY_INTERFACE_API RegisterInterface(UnityInterfaceGUID guid, IUnityInterface* ptr);
+	static UnityGfxRenderer UNITY_INTERFACE_API GetRenderer();
+	static void UNITY_INTERFACE_API RegisterDeviceEventCallback(IUnityGraphicsDeviceEventCallback callback);
+	static void UNITY_INTERFACE_API UnregisterDeviceEventCallback(IUnityGraphicsDeviceEventCallback callback);
+
+private:
+	UnityGfxRenderer _renderer;
+	IUnityInterfaces _interfaces;
+	IUnityGraphics _graphics;
+	std::map<UnityInterfaceGUID, IUnityInterface*> _registry;
+	std::vector<IUnityGraphicsDeviceEventCallback> _deviceCallbacks;
+
+	void* _library;
+	PluginUnloadFunc _unload;
+
+	FrameFunc _frameFunc;
+	double _targetFrameTime;
+	int _maxFramesAhead;
+	int _frame;
+	std::chrono::steady_clock::time_point _frameStart;
+
+	// render thread queue, guarded by _mutex
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _progress;
+	std::deque<Command> _commands;
+	// commands pushed/executed so far, WaitForRenderThread waits until they are equal
+	unsigned int _pushed;
+	unsigned int _executed;
+	int _renderedFrames;
+	std::vector<double> _renderFrameTimes;
+	std::thread _renderThread;
+};
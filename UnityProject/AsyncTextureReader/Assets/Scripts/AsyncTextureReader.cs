@@ -26,6 +26,7 @@
 //  EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 using UnityEngine;
+using UnityEngine.Rendering;
 using System.Runtime.InteropServices;
 using System;
 using System.Collections.Generic;
@@ -82,6 +83,223 @@ public class AsyncTextureReader
         Error_CopyInProgress
     }    
 
+    /// <summary>
+    /// Read-only view of finished request data owned by the plugin. Valid until ReleaseReadback is called.
+    /// </summary>
+    public struct ReadbackLease
+    {
+        /// <summary>
+        /// Lease id, same as id of the request.
+        /// </summary>
+        public int Id;
+        /// <summary>
+        /// Pointer to the data.
+        /// </summary>
+        public IntPtr Data;
+        /// <summary>
+        /// Size of the data in bytes.
+        /// </summary>
+        public int Size;
+        /// <summary>
+        /// Size of one texture row in bytes. Same as Size for buffers.
+        /// </summary>
+        public int RowPitch;
+    }
+
+    /// <summary>
+    /// Values computed by RequestTextureReduction.
+    /// </summary>
+    [Flags]
+    public enum Reduction
+    {
+        /// <summary>
+        /// Min and max of every channel.
+        /// </summary>
+        MinMax = 1,
+        /// <summary>
+        /// Mean of every channel.
+        /// </summary>
+        Mean = 2,
+        /// <summary>
+        /// Histogram of one channel.
+        /// </summary>
+        Histogram = 4
+    }
+
+    /// <summary>
+    /// Result of texture reduction. Values that weren't requested and missing channels are zero.
+    /// </summary>
+    public class ReductionResult
+    {
+        /// <summary>
+        /// Number of histogram bins.
+        /// </summary>
+        public const int HistogramBins = 256;
+
+        public Vector4 Min;
+        public Vector4 Max;
+        public Vector4 Mean;
+        /// <summary>
+        /// Pixel counts, bins split histogram range evenly. Values outside of the range are in the first/last bin.
+        /// </summary>
+        public int[] Histogram = new int[HistogramBins];
+    }
+
+    /// <summary>
+    /// Start of the data returned by RetrieveTextureDelta. It is followed by bitmap of dirty tiles (see IsDirty) and by 
+    /// dirty tiles in tile order. Tile n is column n % TilesX, row n / TilesX % TilesY and slice n / (TilesX * TilesY).
+    /// Every tile is TileRowCount rows of TileRowPitch bytes in texture format, part of edge tile outside the texture is zero.
+    /// </summary>
+    public class DeltaHeader
+    {
+        /// <summary>
+        /// Size of the header in bytes.
+        /// </summary>
+        public const int Size = 32;
+
+        public int TileSize;
+        public int TilesX;
+        public int TilesY;
+        public int Slices;
+        public int DirtyTiles;
+        public int TileRowPitch;
+        public int TileRowCount;
+        public int TileDataSize;
+
+        /// <summary>
+        /// Offset of the first dirty tile in the data.
+        /// </summary>
+        public int TilesOffset { get { return Size + (TilesX * TilesY * Slices + 31) / 32 * 4; } }
+
+        /// <summary>
+        /// Returns true when the tile changed and its data were returned.
+        /// </summary>
+        public static bool IsDirty(byte[] data, int tile)
+        {
+            return (data[Size + tile / 8] & (1 << (tile % 8))) != 0;
+        }
+    }
+
+    /// <summary>
+    /// Histogram with power of two buckets. Bucket 0 counts zero values, bucket i values from 2^(i-1) to 2^i - 1,
+    /// the last bucket everything bigger.
+    /// </summary>
+    public class StatsHistogram
+    {
+        /// <summary>
+        /// Number of buckets.
+        /// </summary>
+        public const int BucketCount = 20;
+
+        public long Count;
+        public long Sum;
+        public long Max;
+        public long[] Buckets = new long[BucketCount];
+
+        public double Mean { get { return Count > 0 ? (double)Sum / Count : 0.0; } }
+    }
+
+    /// <summary>
+    /// Plugin counters returned by GetReadbackStats. Counters, histograms and high-water marks cover the time since
+    /// the last reset, StagingBytes and PooledStagingBytes are current values.
+    /// </summary>
+    public class ReadbackStats
+    {
+        /// <summary>
+        /// Number of 64 bit values of the native snapshot.
+        /// </summary>
+        public const int ValueCount = 13 + 3 * (3 + StatsHistogram.BucketCount) + 1;
+
+        public long Requests;
+        /// <summary>
+        /// Requests refused because every staging slot of the texture/buffer was busy.
+        /// </summary>
+        public long RejectedRequests;
+        /// <summary>
+        /// Gpu copies issued on render thread.
+        /// </summary>
+        public long Copies;
+        public long Completed;
+        public long Failed;
+        /// <summary>
+        /// Polls that found the copy still in flight.
+        /// </summary>
+        public long NotReadyPolls;
+        /// <summary>
+        /// Completion or map errors.
+        /// </summary>
+        public long MapFailures;
+        /// <summary>
+        /// Bytes copied from staging memory to plugin memory.
+        /// </summary>
+        public long BytesCopied;
+        /// <summary>
+        /// Bytes copied from plugin memory to managed arrays.
+        /// </summary>
+        public long BytesRetrieved;
+        /// <summary>
+        /// Memory of all staging copies, free copies in the pool included.
+        /// </summary>
+        public long StagingBytes;
+        public long PooledStagingBytes;
+        /// <summary>
+        /// Most copies in flight of one texture/buffer.
+        /// </summary>
+        public long MaxSlotsInFlight;
+        /// <summary>
+        /// Most commands waiting for render thread event.
+        /// </summary>
+        public long MaxQueuedCommands;
+        /// <summary>
+        /// Poll events (see IssuePollEvent) between the copy and finished data. Zero without poll events.
+        /// </summary>
+        public StatsHistogram LatencyFrames = new StatsHistogram();
+        /// <summary>
+        /// Microseconds between the request and finished data.
+        /// </summary>
+        public StatsHistogram LatencyUs = new StatsHistogram();
+        /// <summary>
+        /// Render thread microseconds spent in one plugin event.
+        /// </summary>
+        public StatsHistogram RenderEventUs = new StatsHistogram();
+        /// <summary>
+        /// Finished requests that didn't fit into the full completion queue, TryGetCompletion never returned them.
+        /// </summary>
+        public long CompletionOverflows;
+    }
+
+    /// <summary>
+    /// Type of one channel of the data returned by RequestTextureConversion.
+    /// </summary>
+    public enum OutputType
+    {
+        /// <summary>
+        /// 32 bit float, use float[] to retrieve the data.
+        /// </summary>
+        Float32 = 1,
+        /// <summary>
+        /// 8 bit unorm, use byte[] to retrieve the data.
+        /// </summary>
+        UNorm8 = 2
+    }
+
+    /// <summary>
+    /// Channels returned by RequestTextureConversion. Channels are always returned in RGBA order, also for BGRA textures.
+    /// </summary>
+    [Flags]
+    public enum Channels
+    {
+        /// <summary>
+        /// All channels of the texture format.
+        /// </summary>
+        Default = 0,
+        R = 1,
+        G = 2,
+        B = 4,
+        A = 8,
+        RGBA = R | G | B | A
+    }
+
     /// <summary>
     /// 
     /// </summary>
@@ -109,11 +327,18 @@ public class AsyncTextureReader
         }
         else
         {
-            int requestSlot = ReleaseTempResources(GetTexturePtr(texture));
-            if (requestSlot == -1)
-                status = (Status)GetLastStatus();
-            else
-                GL.IssuePluginEvent(GetReleaseTempResourcesEventFunc(), requestSlot);
+            // nothing to release if it was never requested
+            int handle;
+            if (_textureHandles.TryGetValue(texture, out handle))
+            {
+                _textureHandles.Remove(texture);
+
+                int requestSlot = ReleaseTempResources(handle);
+                if (requestSlot == -1)
+                    status = (Status)GetLastStatus();
+                else
+                    GL.IssuePluginEvent(GetReleaseTempResourcesEventFunc(), requestSlot);
+            }
         }
 
 #if UNITY_EDITOR // check for errors in editor
@@ -130,6 +355,59 @@ public class AsyncTextureReader
     /// <returns></returns>
     public static Status RequestTextureData(Texture texture)
     {
+        int requestId;
+        return RequestTextureData(texture, out requestId);
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
+    /// <returns></returns>
+    public static Status RequestTextureData(Texture texture, out int requestId)
+    {
+        requestId = -1;
+        Status status = Status.Succeeded;
+        if (texture == null)
+        {
+            status = Status.Error_InvalidArguments;
+        }
+        else
+        {
+            int handle = GetTextureHandle(texture);
+            int requestSlot = handle != -1 ? RequestTextureData(handle) : -1;
+            if (requestSlot == -1)
+            {
+                status = (Status)GetLastStatus();
+            }
+            else
+            {
+                requestId = GetLastRequestId();
+                GL.IssuePluginEvent(GetRequestTextureEventFunc(), requestSlot);
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if(Failed(status))
+            Debug.LogError("RequestTextureData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Requests only part of the texture. Retrieved data contain width * height pixels of the region.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="x">Left edge of the region in pixels.</param>
+    /// <param name="y">Top edge of the region in pixels.</param>
+    /// <param name="width"></param>
+    /// <param name="height"></param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
+    /// <returns></returns>
+    public static Status RequestTextureData(Texture texture, int x, int y, int width, int height, out int requestId)
+    {
+        requestId = -1;
         Status status = Status.Succeeded;
         if (texture == null)
         {
@@ -137,11 +415,17 @@ public class AsyncTextureReader
         }
         else
         {
-            int requestSlot = RequestTextureData(GetTexturePtr(texture));
+            int handle = GetTextureHandle(texture);
+            int requestSlot = handle != -1 ? RequestTextureRegion(handle, x, y, width, height) : -1;
             if (requestSlot == -1)
+            {
                 status = (Status)GetLastStatus();
+            }
             else
+            {
+                requestId = GetLastRequestId();
                 GL.IssuePluginEvent(GetRequestTextureEventFunc(), requestSlot);
+            }
         }
 
 #if UNITY_EDITOR // check for errors in editor
@@ -151,6 +435,64 @@ public class AsyncTextureReader
         return status;
     }
     
+    /// <summary>
+    /// Requests mip level and slices of the texture. Slice is array slice, cube face (array slice of cubemap) 
+    /// or depth slice of 3D texture. Retrieved data contain sliceCount slices of the mip level one after another.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="mipLevel"></param>
+    /// <param name="slice">First slice.</param>
+    /// <param name="sliceCount">Number of consecutive slices.</param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
+    /// <returns></returns>
+    public static Status RequestTextureData(Texture texture, int mipLevel, int slice, int sliceCount, out int requestId)
+    {
+        return RequestTextureData(texture, mipLevel, slice, sliceCount, 0, 0, 0, 0, out requestId);
+    }
+
+    /// <summary>
+    /// Requests region of mip level and slices of the texture. Zero width and height read the whole mip level.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="mipLevel"></param>
+    /// <param name="slice">First slice.</param>
+    /// <param name="sliceCount">Number of consecutive slices.</param>
+    /// <param name="x">Left edge of the region in pixels of the mip level.</param>
+    /// <param name="y">Top edge of the region in pixels of the mip level.</param>
+    /// <param name="width"></param>
+    /// <param name="height"></param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
+    /// <returns></returns>
+    public static Status RequestTextureData(Texture texture, int mipLevel, int slice, int sliceCount, int x, int y, int width, int height, out int requestId)
+    {
+        requestId = -1;
+        Status status = Status.Succeeded;
+        if (texture == null)
+        {
+            status = Status.Error_InvalidArguments;
+        }
+        else
+        {
+            int handle = GetTextureHandle(texture);
+            int requestSlot = handle != -1 ? RequestTextureSubresource(handle, mipLevel, slice, sliceCount, x, y, width, height) : -1;
+            if (requestSlot == -1)
+            {
+                status = (Status)GetLastStatus();
+            }
+            else
+            {
+                requestId = GetLastRequestId();
+                GL.IssuePluginEvent(GetRequestTextureEventFunc(), requestSlot);
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if(Failed(status))
+            Debug.LogError("RequestTextureData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
     /// <summary>
     /// 
     /// </summary>
@@ -159,12 +501,26 @@ public class AsyncTextureReader
     /// <returns></returns>
     public static Status RetrieveTextureData(Texture texture, int[] data)
     {
+        int requestId;
+        return RetrieveTextureData(texture, data, out requestId);
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="data"></param>
+    /// <param name="requestId">Id of the request the data belong to.</param>
+    /// <returns></returns>
+    public static Status RetrieveTextureData(Texture texture, int[] data, out int requestId)
+    {
+        requestId = -1;
         Status status;
         if (texture == null || data == null)
             status = Status.Error_InvalidArguments;
         else
         {
-            int slot = RetrieveTextureData(GetTexturePtr(texture), data, data.Length * sizeof(int));
+            int slot = RetrieveTextureData(FindTextureHandle(texture), data, data.Length * sizeof(int));
             if (slot != -1)
             {
                 status = Status.NotReady;
@@ -173,6 +529,8 @@ public class AsyncTextureReader
             else
             {
                 status = (Status)GetLastStatus();
+                if (status == Status.Succeeded)
+                    requestId = GetLastRequestId();
             }
         }
 
@@ -191,12 +549,26 @@ public class AsyncTextureReader
     /// <returns></returns>
     public static Status RetrieveTextureData(Texture texture, float[] data)
     {
+        int requestId;
+        return RetrieveTextureData(texture, data, out requestId);
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="data"></param>
+    /// <param name="requestId">Id of the request the data belong to.</param>
+    /// <returns></returns>
+    public static Status RetrieveTextureData(Texture texture, float[] data, out int requestId)
+    {
+        requestId = -1;
         Status status;
         if (texture == null || data == null)
             status = Status.Error_InvalidArguments;
         else
         {
-            int slot = RetrieveTextureData(GetTexturePtr(texture), data, data.Length * sizeof(float));
+            int slot = RetrieveTextureData(FindTextureHandle(texture), data, data.Length * sizeof(float));
             if (slot != -1)
             {
                 status = Status.NotReady;
@@ -205,6 +577,8 @@ public class AsyncTextureReader
             else
             {
                 status = (Status)GetLastStatus();
+                if (status == Status.Succeeded)
+                    requestId = GetLastRequestId();
             }
         }
 
@@ -223,12 +597,26 @@ public class AsyncTextureReader
     /// <returns></returns>
     public static Status RetrieveTextureData(Texture texture, byte[] data)
     {
+        int requestId;
+        return RetrieveTextureData(texture, data, out requestId);
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="data"></param>
+    /// <param name="requestId">Id of the request the data belong to.</param>
+    /// <returns></returns>
+    public static Status RetrieveTextureData(Texture texture, byte[] data, out int requestId)
+    {
+        requestId = -1;
         Status status;
         if (texture == null || data == null)
             status = Status.Error_InvalidArguments;
         else
         {
-            int slot = RetrieveTextureData(GetTexturePtr(texture), data, data.Length * sizeof(byte));
+            int slot = RetrieveTextureData(FindTextureHandle(texture), data, data.Length * sizeof(byte));
             if(slot != -1)
             {
                 status = Status.NotReady;
@@ -237,6 +625,8 @@ public class AsyncTextureReader
             else
             {
                 status = (Status)GetLastStatus();
+                if (status == Status.Succeeded)
+                    requestId = GetLastRequestId();
             }
         }
 
@@ -247,168 +637,1215 @@ public class AsyncTextureReader
         return status;
     }
 
-#if UNITY_5_5_OR_NEWER
     /// <summary>
-    /// 
+    /// Requests texture data converted to another type. Conversion is done in the plugin while the data are copied
+    /// from gpu, retrieve them with RetrieveTextureData as float[] or byte[].
     /// </summary>
     /// <param name="texture"></param>
+    /// <param name="outputType">Type of one channel of the returned data.</param>
+    /// <param name="channels">Returned channels. Channels the texture doesn't have are 0, alpha is 1.</param>
+    /// <param name="linear">Decode sRGB color channels to linear, works only with 8 bit per channel textures.</param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
     /// <returns></returns>
-    public static Status ReleaseTempResources(ComputeBuffer buffer)
+    public static Status RequestTextureConversion(Texture texture, OutputType outputType, Channels channels, bool linear, out int requestId)
+    {
+        return RequestTextureConversion(texture, 0, 0, 1, 0, 0, 0, 0, outputType, channels, linear, out requestId);
+    }
+
+    /// <summary>
+    /// Requests region of mip level/slices of the texture converted to another type.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="mipLevel"></param>
+    /// <param name="slice">First slice.</param>
+    /// <param name="sliceCount">Number of consecutive slices.</param>
+    /// <param name="x">Left edge of the region in pixels of the mip level.</param>
+    /// <param name="y">Top edge of the region in pixels of the mip level.</param>
+    /// <param name="width">Width of the region, zero width and height read the whole mip level.</param>
+    /// <param name="height"></param>
+    /// <param name="outputType">Type of one channel of the returned data.</param>
+    /// <param name="channels">Returned channels. Channels the texture doesn't have are 0, alpha is 1.</param>
+    /// <param name="linear">Decode sRGB color channels to linear, works only with 8 bit per channel textures.</param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
+    /// <returns></returns>
+    public static Status RequestTextureConversion(Texture texture, int mipLevel, int slice, int sliceCount, int x, int y, int width, int height, OutputType outputType, Channels channels, bool linear, out int requestId)
     {
+        requestId = -1;
         Status status = Status.Succeeded;
-        if (buffer == null)
+        if (texture == null)
         {
             status = Status.Error_InvalidArguments;
         }
         else
         {
-            int requestSlot = ReleaseTempResources(GetBufferPtr(buffer));
+            int handle = GetTextureHandle(texture);
+            int requestSlot = handle != -1 ? RequestTextureConversion(handle, mipLevel, slice, sliceCount, x, y, width, height, (int)outputType, (int)channels, linear ? 1 : 0) : -1;
             if (requestSlot == -1)
+            {
                 status = (Status)GetLastStatus();
+            }
             else
-                GL.IssuePluginEvent(GetReleaseTempResourcesEventFunc(), requestSlot);
+            {
+                requestId = GetLastRequestId();
+                GL.IssuePluginEvent(GetRequestTextureEventFunc(), requestSlot);
+            }
         }
 
 #if UNITY_EDITOR // check for errors in editor
         if (Failed(status))
-            Debug.LogError("RequestTextureData failed: " + status);
+            Debug.LogError("RequestTextureConversion failed: " + status);
 #endif // UNITY_EDITOR
         return status;
     }
 
     /// <summary>
-    /// 
+    /// Requests only tiles of the texture that changed since the last retrieved request of the texture. Tiles are hashed
+    /// in the plugin while the data are copied from gpu, retrieve them with RetrieveTextureDelta. Works with any texture format.
     /// </summary>
-    /// <param name="buffer"></param>
+    /// <param name="texture"></param>
+    /// <param name="tileSize">Tile size in pixels, power of two from 8 to 256.</param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
     /// <returns></returns>
-    public static Status RequestBufferData(ComputeBuffer buffer)
+    public static Status RequestTextureDelta(Texture texture, int tileSize, out int requestId)
+    {
+        return RequestTextureDelta(texture, 0, 0, 1, tileSize, out requestId);
+    }
+
+    /// <summary>
+    /// Requests changed tiles of mip level/slices of the texture.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="mipLevel"></param>
+    /// <param name="slice">First slice.</param>
+    /// <param name="sliceCount">Number of consecutive slices.</param>
+    /// <param name="tileSize">Tile size in pixels, power of two from 8 to 256.</param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
+    /// <returns></returns>
+    public static Status RequestTextureDelta(Texture texture, int mipLevel, int slice, int sliceCount, int tileSize, out int requestId)
     {
+        requestId = -1;
         Status status = Status.Succeeded;
-        if (buffer == null)
+        if (texture == null)
+        {
             status = Status.Error_InvalidArguments;
+        }
         else
         {
-            int requestSlot = RequestBufferData(GetBufferPtr(buffer));
+            int handle = GetTextureHandle(texture);
+            int requestSlot = handle != -1 ? RequestTextureDelta(handle, mipLevel, slice, sliceCount, tileSize) : -1;
             if (requestSlot == -1)
+            {
                 status = (Status)GetLastStatus();
+            }
             else
-                GL.IssuePluginEvent(GetRequestBufferEventFunc(), requestSlot);
-        }
+            {
+                requestId = GetLastRequestId();
+                GL.IssuePluginEvent(GetRequestTextureEventFunc(), requestSlot);
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RequestTextureDelta failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Retrieves the oldest finished request made by RequestTextureDelta. The first delta of the texture, the first one
+    /// after its data were retrieved by RetrieveTextureData and the first one of other mip level or slices have every tile dirty.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="data">Filled with DeltaHeader, bitmap and dirty tiles.</param>
+    /// <param name="header">Filled with header of the data.</param>
+    /// <param name="deltaSize">Size of the data. When it is bigger than the array, Error_WrongBufferSize is returned
+    /// and the request can be retrieved again with array of deltaSize bytes.</param>
+    /// <param name="requestId">Id of the retrieved request.</param>
+    /// <returns></returns>
+    public static Status RetrieveTextureDelta(Texture texture, byte[] data, DeltaHeader header, out int deltaSize, out int requestId)
+    {
+        requestId = -1;
+        deltaSize = 0;
+        Status status;
+        if (texture == null || data == null || header == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            int slot = RetrieveTextureDelta(FindTextureHandle(texture), data, data.Length, out deltaSize);
+            if (slot != -1)
+            {
+                status = Status.NotReady;
+                GL.IssuePluginEvent(GetCopyTextureEventFunc(), slot);
+            }
+            else
+            {
+                status = (Status)GetLastStatus();
+                if (status == Status.Succeeded)
+                {
+                    requestId = GetLastRequestId();
+                    Buffer.BlockCopy(data, 0, _deltaHeaderData, 0, DeltaHeader.Size);
+                    header.TileSize = _deltaHeaderData[0];
+                    header.TilesX = _deltaHeaderData[1];
+                    header.TilesY = _deltaHeaderData[2];
+                    header.Slices = _deltaHeaderData[3];
+                    header.DirtyTiles = _deltaHeaderData[4];
+                    header.TileRowPitch = _deltaHeaderData[5];
+                    header.TileRowCount = _deltaHeaderData[6];
+                    header.TileDataSize = _deltaHeaderData[7];
+                }
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RetrieveTextureDelta failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Requests reduction of the texture instead of its data. Reduction is computed in the plugin when the data
+    /// are copied from gpu, only the result is returned by RetrieveTextureReduction.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="reduction">Values to compute.</param>
+    /// <param name="histogramChannel">Channel used by histogram (0 - R, 3 - A).</param>
+    /// <param name="histogramMin">Lower bound of the histogram range.</param>
+    /// <param name="histogramMax">Upper bound of the histogram range.</param>
+    /// <param name="requestId">Id of the request, it is returned again together with the result.</param>
+    /// <returns></returns>
+    public static Status RequestTextureReduction(Texture texture, Reduction reduction, int histogramChannel, float histogramMin, float histogramMax, out int requestId)
+    {
+        return RequestTextureReduction(texture, 0, 0, reduction, histogramChannel, histogramMin, histogramMax, out requestId);
+    }
+
+    /// <summary>
+    /// Requests reduction of one mip level/slice of the texture. Use low mip level to save bandwidth when exact value isn't needed.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="mipLevel"></param>
+    /// <param name="slice">Array slice, cube face or depth slice.</param>
+    /// <param name="reduction">Values to compute.</param>
+    /// <param name="histogramChannel">Channel used by histogram (0 - R, 3 - A).</param>
+    /// <param name="histogramMin">Lower bound of the histogram range.</param>
+    /// <param name="histogramMax">Upper bound of the histogram range.</param>
+    /// <param name="requestId">Id of the request, it is returned again together with the result.</param>
+    /// <returns></returns>
+    public static Status RequestTextureReduction(Texture texture, int mipLevel, int slice, Reduction reduction, int histogramChannel, float histogramMin, float histogramMax, out int requestId)
+    {
+        requestId = -1;
+        Status status = Status.Succeeded;
+        if (texture == null)
+        {
+            status = Status.Error_InvalidArguments;
+        }
+        else
+        {
+            int handle = GetTextureHandle(texture);
+            int requestSlot = handle != -1 ? RequestTextureReduction(handle, mipLevel, slice, (int)reduction, histogramChannel, histogramMin, histogramMax) : -1;
+            if (requestSlot == -1)
+            {
+                status = (Status)GetLastStatus();
+            }
+            else
+            {
+                requestId = GetLastRequestId();
+                GL.IssuePluginEvent(GetRequestTextureEventFunc(), requestSlot);
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RequestTextureReduction failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Retrieves result of the oldest finished request made by RequestTextureReduction. 
+    /// Don't mix reductions and data requests of the same texture, requests are retrieved in order.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="result">Filled with the result.</param>
+    /// <param name="requestId">Id of the retrieved request.</param>
+    /// <returns></returns>
+    public static Status RetrieveTextureReduction(Texture texture, ReductionResult result, out int requestId)
+    {
+        requestId = -1;
+        Status status;
+        if (texture == null || result == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            int slot = RetrieveTextureData(FindTextureHandle(texture), _reductionData, _reductionData.Length * sizeof(float));
+            if (slot != -1)
+            {
+                status = Status.NotReady;
+                GL.IssuePluginEvent(GetCopyTextureEventFunc(), slot);
+            }
+            else
+            {
+                status = (Status)GetLastStatus();
+                if (status == Status.Succeeded)
+                {
+                    requestId = GetLastRequestId();
+                    // min, max and mean are followed by histogram
+                    result.Min = new Vector4(_reductionData[0], _reductionData[1], _reductionData[2], _reductionData[3]);
+                    result.Max = new Vector4(_reductionData[4], _reductionData[5], _reductionData[6], _reductionData[7]);
+                    result.Mean = new Vector4(_reductionData[8], _reductionData[9], _reductionData[10], _reductionData[11]);
+                    Buffer.BlockCopy(_reductionData, 12 * sizeof(float), result.Histogram, 0, ReductionResult.HistogramBins * sizeof(int));
+                }
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RetrieveTextureReduction failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Gives direct access to the oldest finished request without copying it to managed memory.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="lease">Data of the request. Has to be returned with ReleaseReadback.</param>
+    /// <returns></returns>
+    public static Status AcquireTextureData(Texture texture, out ReadbackLease lease)
+    {
+        lease = new ReadbackLease();
+        lease.Id = -1;
+        Status status;
+        if (texture == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            int slot = AcquireReadback(FindTextureHandle(texture), out lease.Data, out lease.Size, out lease.RowPitch, out lease.Id);
+            if (slot != -1)
+            {
+                status = Status.NotReady;
+                GL.IssuePluginEvent(GetCopyTextureEventFunc(), slot);
+            }
+            else
+            {
+                status = (Status)GetLastStatus();
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("AcquireTextureData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Returns data acquired by AcquireTextureData/AcquireBufferData back to the plugin.
+    /// </summary>
+    /// <param name="lease"></param>
+    /// <returns></returns>
+    public static Status ReleaseReadback(ReadbackLease lease)
+    {
+        Status status = (Status)ReleaseReadback(lease.Id);
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("ReleaseReadback failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+#if UNITY_5_5_OR_NEWER
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <returns></returns>
+    public static Status ReleaseTempResources(ComputeBuffer buffer)
+    {
+        Status status = Status.Succeeded;
+        if (buffer == null)
+        {
+            status = Status.Error_InvalidArguments;
+        }
+        else
+        {
+            // nothing to release if it was never requested
+            int handle;
+            if (_bufferHandles.TryGetValue(buffer, out handle))
+            {
+                _bufferHandles.Remove(buffer);
+
+                int requestSlot = ReleaseTempResources(handle);
+                if (requestSlot == -1)
+                    status = (Status)GetLastStatus();
+                else
+                    GL.IssuePluginEvent(GetReleaseTempResourcesEventFunc(), requestSlot);
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RequestTextureData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <returns></returns>
+    public static Status RequestBufferData(ComputeBuffer buffer)
+    {
+        int requestId;
+        return RequestBufferData(buffer, out requestId);
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
+    /// <returns></returns>
+    public static Status RequestBufferData(ComputeBuffer buffer, out int requestId)
+    {
+        requestId = -1;
+        Status status = Status.Succeeded;
+        if (buffer == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            int handle = GetBufferHandle(buffer);
+            int requestSlot = handle != -1 ? RequestBufferData(handle) : -1;
+            if (requestSlot == -1)
+            {
+                status = (Status)GetLastStatus();
+            }
+            else
+            {
+                requestId = GetLastRequestId();
+                GL.IssuePluginEvent(GetRequestBufferEventFunc(), requestSlot);
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RequestBufferData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Requests only part of the buffer. Retrieved data contain length bytes starting at offset.
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <param name="offset">Offset in bytes.</param>
+    /// <param name="length">Length in bytes.</param>
+    /// <param name="requestId">Id of the request, it is returned again together with the data.</param>
+    /// <returns></returns>
+    public static Status RequestBufferData(ComputeBuffer buffer, int offset, int length, out int requestId)
+    {
+        requestId = -1;
+        Status status = Status.Succeeded;
+        if (buffer == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            int handle = GetBufferHandle(buffer);
+            int requestSlot = handle != -1 ? RequestBufferRange(handle, offset, length) : -1;
+            if (requestSlot == -1)
+            {
+                status = (Status)GetLastStatus();
+            }
+            else
+            {
+                requestId = GetLastRequestId();
+                GL.IssuePluginEvent(GetRequestBufferEventFunc(), requestSlot);
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RequestBufferData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <param name="data"></param>
+    /// <returns></returns>
+    public static Status RetrieveBufferData(ComputeBuffer buffer, int[] data)
+    {
+        int requestId;
+        return RetrieveBufferData(buffer, data, out requestId);
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <param name="data"></param>
+    /// <param name="requestId">Id of the request the data belong to.</param>
+    /// <returns></returns>
+    public static Status RetrieveBufferData(ComputeBuffer buffer, int[] data, out int requestId)
+    {
+        requestId = -1;
+        Status status;
+        if (buffer == null || data == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            int slot = RetrieveBufferData(FindBufferHandle(buffer), data, data.Length * sizeof(int));
+            if (slot != -1)
+            {
+                status = Status.NotReady;
+                GL.IssuePluginEvent(GetCopyBufferEventFunc(), slot);
+            }
+            else
+            {
+                status = (Status)GetLastStatus();
+                if (status == Status.Succeeded)
+                    requestId = GetLastRequestId();
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RetrieveBufferData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <param name="data"></param>
+    /// <returns></returns>
+    public static Status RetrieveBufferData(ComputeBuffer buffer, float[] data)
+    {
+        int requestId;
+        return RetrieveBufferData(buffer, data, out requestId);
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <param name="data"></param>
+    /// <param name="requestId">Id of the request the data belong to.</param>
+    /// <returns></returns>
+    public static Status RetrieveBufferData(ComputeBuffer buffer, float[] data, out int requestId)
+    {
+        requestId = -1;
+        Status status;
+        if (buffer == null || data == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            int slot = RetrieveBufferData(FindBufferHandle(buffer), data, data.Length * sizeof(float));
+            if (slot != -1)
+            {
+                status = Status.NotReady;
+                GL.IssuePluginEvent(GetCopyBufferEventFunc(), slot);
+            }
+            else
+            {
+                status = (Status)GetLastStatus();
+                if (status == Status.Succeeded)
+                    requestId = GetLastRequestId();
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RetrieveBufferData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <param name="data"></param>
+    /// <returns></returns>
+    public static Status RetrieveBufferData(ComputeBuffer buffer, byte[] data)
+    {
+        int requestId;
+        return RetrieveBufferData(buffer, data, out requestId);
+    }
+
+    /// <summary>
+    /// 
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <param name="data"></param>
+    /// <param name="requestId">Id of the request the data belong to.</param>
+    /// <returns></returns>
+    public static Status RetrieveBufferData(ComputeBuffer buffer, byte[] data, out int requestId)
+    {
+        requestId = -1;
+        Status status;
+        if (buffer == null || data == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            int slot = RetrieveBufferData(FindBufferHandle(buffer), data, data.Length * sizeof(byte));
+            if (slot != -1)
+            {
+                status = Status.NotReady;
+                GL.IssuePluginEvent(GetCopyBufferEventFunc(), slot);
+            }
+            else
+            {
+                status = (Status)GetLastStatus();
+                if (status == Status.Succeeded)
+                    requestId = GetLastRequestId();
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RetrieveBufferData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Gives direct access to the oldest finished request without copying it to managed memory.
+    /// </summary>
+    /// <param name="buffer"></param>
+    /// <param name="lease">Data of the request. Has to be returned with ReleaseReadback.</param>
+    /// <returns></returns>
+    public static Status AcquireBufferData(ComputeBuffer buffer, out ReadbackLease lease)
+    {
+        lease = new ReadbackLease();
+        lease.Id = -1;
+        Status status;
+        if (buffer == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            int slot = AcquireReadback(FindBufferHandle(buffer), out lease.Data, out lease.Size, out lease.RowPitch, out lease.Id);
+            if (slot != -1)
+            {
+                status = Status.NotReady;
+                GL.IssuePluginEvent(GetCopyBufferEventFunc(), slot);
+            }
+            else
+            {
+                status = (Status)GetLastStatus();
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("AcquireBufferData failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    private static int GetBufferHandle(ComputeBuffer buffer)
+    {
+        int handle;
+        if (_bufferHandles.TryGetValue(buffer, out handle))
+            return handle;
+
+        handle = RegisterBuffer(buffer.GetNativeBufferPtr());
+        if (handle != -1)
+            _bufferHandles.Add(buffer, handle);
+        return handle;
+    }
+
+    private static int FindBufferHandle(ComputeBuffer buffer)
+    {
+        int handle;
+        if (_bufferHandles.TryGetValue(buffer, out handle))
+            return handle;
+        return -1;
+    }
+#endif // UNITY_5_5_OR_NEWER
+
+    /// <summary>
+    /// Requests several textures/buffers in one render event. All of them are copied from the same frame.
+    /// </summary>
+    /// <param name="resources">Textures and compute buffers, each at most once.</param>
+    /// <param name="batchId">Id used to retrieve the batch with RetrieveBatch.</param>
+    /// <returns></returns>
+    public static Status RequestBatch(object[] resources, out int batchId)
+    {
+        batchId = -1;
+        Status status = Status.Succeeded;
+        if (resources == null || resources.Length == 0)
+            status = Status.Error_InvalidArguments;
+
+        int[] handles = null;
+        if (status == Status.Succeeded)
+        {
+            handles = new int[resources.Length];
+            for (int i = 0; i < resources.Length && status == Status.Succeeded; ++i)
+            {
+                handles[i] = GetResourceHandle(resources[i]);
+                if (handles[i] == -1)
+                    status = resources[i] == null ? Status.Error_InvalidArguments : (Status)GetLastStatus();
+            }
+        }
+
+        if (status == Status.Succeeded)
+        {
+            int eventId = RequestBatch(handles, handles.Length, out batchId);
+            if (eventId != -1)
+                GL.IssuePluginEvent(GetRequestTextureEventFunc(), eventId);
+            else
+                status = (Status)GetLastStatus();
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RequestBatch failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Retrieves all members of the batch at once. Returns NotReady until every member is finished and Error_CopyInProgress
+    /// while older request of any member resource (finished or failed) wasn't retrieved yet.
+    /// </summary>
+    /// <param name="batchId">Id returned by RequestBatch.</param>
+    /// <param name="data">One array per member, in the order of RequestBatch resources.</param>
+    /// <returns></returns>
+    public static Status RetrieveBatch(int batchId, Array[] data)
+    {
+        Status status;
+        if (data == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            GCHandle[] pins = new GCHandle[data.Length];
+            IntPtr[] pointers = new IntPtr[data.Length];
+            int[] sizes = new int[data.Length];
+            try
+            {
+                for (int i = 0; i < data.Length; ++i)
+                {
+                    pins[i] = GCHandle.Alloc(data[i], GCHandleType.Pinned);
+                    pointers[i] = pins[i].AddrOfPinnedObject();
+                    sizes[i] = Buffer.ByteLength(data[i]);
+                }
+
+                int eventId = RetrieveBatch(batchId, pointers, sizes, data.Length);
+                if (eventId != -1)
+                {
+                    status = Status.NotReady;
+                    GL.IssuePluginEvent(GetCopyTextureEventFunc(), eventId);
+                }
+                else
+                {
+                    status = (Status)GetLastStatus();
+                }
+            }
+            catch (ArgumentException)
+            {
+                status = Status.Error_InvalidArguments;
+            }
+            finally
+            {
+                for (int i = 0; i < pins.Length; ++i)
+                {
+                    if (pins[i].IsAllocated)
+                        pins[i].Free();
+                }
+            }
+        }
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("RetrieveBatch failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Sets how many requests of one texture/buffer can be in flight at the same time.
+    /// Applies to textures/buffers requested for the first time (or after ReleaseTempResources).
+    /// </summary>
+    /// <param name="size">Number of staging copies per texture/buffer, 1 to 16. Default is 3.</param>
+    /// <returns></returns>
+    public static Status SetStagingRingSize(int size)
+    {
+        Status status = (Status)SetStagingRingSizeNative(size);
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("SetStagingRingSize failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Moves copying of finished requests from render thread to dedicated copy thread. Render thread only maps
+    /// the staging copy, so its cost doesn't depend on the size of the data. Finished data are available one
+    /// retrieve call later than without the copy thread.
+    /// </summary>
+    /// <param name="enabled"></param>
+    /// <returns></returns>
+    public static Status SetCopyThread(bool enabled)
+    {
+        Status status = (Status)SetCopyThreadNative(enabled ? 1 : 0);
 
 #if UNITY_EDITOR // check for errors in editor
         if (Failed(status))
-            Debug.LogError("RequestBufferData failed: " + status);
+            Debug.LogError("SetCopyThread failed: " + status);
 #endif // UNITY_EDITOR
         return status;
     }
 
     /// <summary>
-    /// 
+    /// Configures the pool of staging copies shared by all textures/buffers. Copies are taken from the pool by requests
+    /// and returned once their data are retrieved from gpu, so resources of the same format and region size reuse them.
+    /// Free copies unused for idleFrames poll events (see IssuePollEvent) are released.
     /// </summary>
-    /// <param name="buffer"></param>
-    /// <param name="data"></param>
+    /// <param name="budgetMB">Memory limit of all staging copies, requests that don't fit fail with Error_TooManyRequests. Zero is unlimited (default).</param>
+    /// <param name="idleFrames">Poll events a free copy is kept for, zero keeps free copies until shutdown. Default is 120.</param>
     /// <returns></returns>
-    public static Status RetrieveBufferData(ComputeBuffer buffer, int[] data)
+    public static Status SetStagingPool(int budgetMB, int idleFrames)
+    {
+        Status status = (Status)SetStagingPoolNative(budgetMB, idleFrames);
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("SetStagingPool failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Reads plugin counters. Counting is cheap and always on, call it with reset once per frame (or any other
+    /// window) to get per window values.
+    /// </summary>
+    /// <param name="stats">Filled with the counters.</param>
+    /// <param name="reset">Starts new window, counters, histograms and high-water marks start from zero.</param>
+    /// <returns></returns>
+    public static Status GetReadbackStats(ReadbackStats stats, bool reset)
     {
         Status status;
-        if (buffer == null || data == null)
+        if (stats == null)
             status = Status.Error_InvalidArguments;
         else
         {
-            int slot = RetrieveBufferData(GetBufferPtr(buffer), data, data.Length * sizeof(int));
-            if (slot != -1)
+            status = (Status)GetReadbackStatsNative(_statsData, _statsData.Length * sizeof(long), reset ? 1 : 0);
+            if (status == Status.Succeeded)
             {
-                status = Status.NotReady;
-                GL.IssuePluginEvent(GetCopyBufferEventFunc(), slot);
-            }
-            else
-            {
-                status = (Status)GetLastStatus();
+                int i = 0;
+                stats.Requests = _statsData[i++];
+                stats.RejectedRequests = _statsData[i++];
+                stats.Copies = _statsData[i++];
+                stats.Completed = _statsData[i++];
+                stats.Failed = _statsData[i++];
+                stats.NotReadyPolls = _statsData[i++];
+                stats.MapFailures = _statsData[i++];
+                stats.BytesCopied = _statsData[i++];
+                stats.BytesRetrieved = _statsData[i++];
+                stats.StagingBytes = _statsData[i++];
+                stats.PooledStagingBytes = _statsData[i++];
+                stats.MaxSlotsInFlight = _statsData[i++];
+                stats.MaxQueuedCommands = _statsData[i++];
+                i = ReadHistogram(stats.LatencyFrames, i);
+                i = ReadHistogram(stats.LatencyUs, i);
+                i = ReadHistogram(stats.RenderEventUs, i);
+                stats.CompletionOverflows = _statsData[i++];
             }
         }
 
 #if UNITY_EDITOR // check for errors in editor
         if (Failed(status))
-            Debug.LogError("RetrieveBufferData failed: " + status);
+            Debug.LogError("GetReadbackStats failed: " + status);
 #endif // UNITY_EDITOR
         return status;
     }
 
     /// <summary>
-    /// 
+    /// Records every step of every request (request, copy issued on render thread, staging copy mapped, data copied
+    /// to plugin memory, data delivered) with its thread and time. The newest 32768 steps are kept, write them with
+    /// WriteReadbackTrace. Tracing costs a few atomic stores per step while enabled.
+    /// </summary>
+    /// <param name="enabled">False stops recording, recorded steps are kept.</param>
+    /// <returns></returns>
+    public static Status SetReadbackTrace(bool enabled)
+    {
+        return (Status)SetReadbackTraceNative(enabled ? 1 : 0);
+    }
+
+    /// <summary>
+    /// Writes recorded steps as Chrome trace json. Open it in chrome://tracing or https://ui.perfetto.dev, every thread
+    /// has its own track with the steps it did and every request has a track from the request to the delivery.
+    /// </summary>
+    /// <param name="path">Path of the json file.</param>
+    /// <returns></returns>
+    public static Status WriteReadbackTrace(string path)
+    {
+        Status status;
+        if (string.IsNullOrEmpty(path))
+            status = Status.Error_InvalidArguments;
+        else
+            status = (Status)WriteReadbackTraceNative(path);
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("WriteReadbackTrace failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Called when a request is finished, successfully or not. Runs on render thread or copy thread, so it
+    /// shouldn't call Unity or AsyncTextureReader functions. Remember the request id and retrieve the data on main thread.
+    /// </summary>
+    /// <param name="requestId">Id returned by the request.</param>
+    /// <param name="status">Succeeded when the data are ready, error of the request otherwise.</param>
+    public delegate void CompletionCallback(int requestId, Status status);
+
+    /// <summary>
+    /// Sets callback called for every finished request. Finished requests are found by poll events (see IssuePollEvent),
+    /// so data don't have to be retrieved every frame just to find out they aren't ready yet.
+    /// </summary>
+    /// <param name="callback">Null removes the callback. Old callback isn't called anymore once the function returns.</param>
+    /// <returns></returns>
+    public static Status SetCompletionCallback(CompletionCallback callback)
+    {
+        _completionCallback = callback;
+        Status status = (Status)SetCompletionCallback(callback != null ? _nativeCompletionCallback : null, IntPtr.Zero);
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("SetCompletionCallback failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Checks every copy in flight on render thread and reports finished requests (completion callback, TryGetCompletion).
+    /// </summary>
+    public static void IssuePollEvent()
+    {
+        GL.IssuePluginEvent(GetPollEventFunc(), 0);
+    }
+
+    /// <summary>
+    /// Adds poll event to command buffer. Command buffer attached to camera polls copies every frame without any script call.
+    /// </summary>
+    /// <param name="commandBuffer"></param>
+    public static void IssuePollEvent(CommandBuffer commandBuffer)
+    {
+        commandBuffer.IssuePluginEvent(GetPollEventFunc(), 0);
+    }
+
+    /// <summary>
+    /// Returns the oldest finished request that wasn't returned yet. Doesn't issue any render event.
+    /// Can be called from any thread.
+    /// </summary>
+    /// <param name="requestId">Id returned by the request.</param>
+    /// <param name="status">Succeeded when the data are ready, error of the request otherwise.</param>
+    /// <returns>False when no request was finished since the last call.</returns>
+    public static bool TryGetCompletion(out int requestId, out Status status)
+    {
+        bool overflowed;
+        return TryGetCompletion(out requestId, out status, out overflowed);
+    }
+
+    /// <summary>
+    /// Same as TryGetCompletion above. Queue holds 1024 completions, when it is full (nobody pops them) newer ones
+    /// are lost and overflowed is set with the next returned completion. Requests whose completion was lost are never 
+    /// returned, retrieve every texture/buffer with requests in flight until it returns NotReady then.
+    /// </summary>
+    /// <param name="requestId">Id returned by the request.</param>
+    /// <param name="status">Succeeded when the data are ready, error of the request otherwise.</param>
+    /// <param name="overflowed">Completions were lost since the last call.</param>
+    /// <returns>False when no request was finished since the last call.</returns>
+    public static bool TryGetCompletion(out int requestId, out Status status, out bool overflowed)
+    {
+        int resourceHandle;
+        int completionStatus;
+        int popped = PopCompletion(out resourceHandle, out requestId, out completionStatus);
+        status = (Status)completionStatus;
+        overflowed = popped == 2;
+        return popped != 0;
+    }
+
+    /// <summary>
+    /// Native handle signaled when a request is finished, consumer thread can block on it and then call TryGetCompletion
+    /// until it returns false. Auto-reset event on Windows, eventfd on Linux/Android, read end of a pipe on macOS/iOS.
+    /// </summary>
+    /// <returns>-1 when the handle can't be created.</returns>
+    public static IntPtr GetCompletionHandle()
+    {
+        return GetCompletionHandleNative();
+    }
+
+    /// <summary>
+    /// Starts continuous readback of the whole texture. Every poll event (see IssuePollEvent) copies it every everyNFrames
+    /// poll events and the newest ringDepth copies are kept until they are retrieved, older ones are dropped.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="everyNFrames">Poll events between two copies, 1 copies every poll event.</param>
+    /// <param name="ringDepth">Number of kept copies, 1 to 64.</param>
+    /// <param name="subscription">Id used to retrieve the copies and to unsubscribe.</param>
+    /// <returns></returns>
+    public static Status Subscribe(Texture texture, int everyNFrames, int ringDepth, out int subscription)
+    {
+        subscription = -1;
+        Status status;
+        if (texture == null)
+            status = Status.Error_InvalidArguments;
+        else
+            status = Subscribe(GetTextureHandle(texture), everyNFrames, ringDepth, out subscription);
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("Subscribe failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+#if UNITY_5_5_OR_NEWER
+    /// <summary>
+    /// Starts continuous readback of the whole buffer, see Subscribe for textures.
     /// </summary>
     /// <param name="buffer"></param>
-    /// <param name="data"></param>
+    /// <param name="everyNFrames">Poll events between two copies, 1 copies every poll event.</param>
+    /// <param name="ringDepth">Number of kept copies, 1 to 64.</param>
+    /// <param name="subscription">Id used to retrieve the copies and to unsubscribe.</param>
     /// <returns></returns>
-    public static Status RetrieveBufferData(ComputeBuffer buffer, float[] data)
+    public static Status Subscribe(ComputeBuffer buffer, int everyNFrames, int ringDepth, out int subscription)
     {
+        subscription = -1;
         Status status;
-        if (buffer == null || data == null)
+        if (buffer == null)
             status = Status.Error_InvalidArguments;
         else
+            status = Subscribe(GetBufferHandle(buffer), everyNFrames, ringDepth, out subscription);
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("Subscribe failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+#endif // UNITY_5_5_OR_NEWER
+
+    /// <summary>
+    /// Stops the subscription, copies that weren't retrieved are lost.
+    /// </summary>
+    /// <param name="subscription">Id returned by Subscribe.</param>
+    /// <returns></returns>
+    public static Status Unsubscribe(int subscription)
+    {
+        Status status;
+        int eventId = UnsubscribeNative(subscription);
+        if (eventId != -1)
         {
-            int slot = RetrieveBufferData(GetBufferPtr(buffer), data, data.Length * sizeof(float));
-            if (slot != -1)
+            status = Status.Succeeded;
+            GL.IssuePluginEvent(GetSubscriptionEventFunc(), eventId);
+        }
+        else
+            status = (Status)GetLastStatus();
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("Unsubscribe failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Retrieves the oldest copy that wasn't retrieved yet. Doesn't issue any render event.
+    /// </summary>
+    /// <param name="subscription">Id returned by Subscribe.</param>
+    /// <param name="data">Array of the whole texture/buffer size.</param>
+    /// <param name="latest">Retrieves the newest copy and skips older ones (they are counted as dropped).</param>
+    /// <param name="frame">Poll event that made the copy, counted from the first poll event.</param>
+    /// <param name="dropped">Number of copies dropped since the last call.</param>
+    /// <returns>NotReady when there is no new copy.</returns>
+    public static Status RetrieveSubscription(int subscription, Array data, bool latest, out int frame, out int dropped)
+    {
+        frame = 0;
+        dropped = 0;
+        Status status;
+        if (data == null)
+            status = Status.Error_InvalidArguments;
+        else
+        {
+            GCHandle pin = new GCHandle();
+            try
             {
-                status = Status.NotReady;
-                GL.IssuePluginEvent(GetCopyBufferEventFunc(), slot);
+                pin = GCHandle.Alloc(data, GCHandleType.Pinned);
+                status = (Status)RetrieveSubscriptionNative(subscription, latest ? 1 : 0, pin.AddrOfPinnedObject(), Buffer.ByteLength(data), out frame, out dropped);
             }
-            else
+            catch (ArgumentException)
             {
-                status = (Status)GetLastStatus();
+                status = Status.Error_InvalidArguments;
+            }
+            finally
+            {
+                if (pin.IsAllocated)
+                    pin.Free();
             }
         }
 
 #if UNITY_EDITOR // check for errors in editor
         if (Failed(status))
-            Debug.LogError("RetrieveBufferData failed: " + status);
+            Debug.LogError("RetrieveSubscription failed: " + status);
 #endif // UNITY_EDITOR
         return status;
     }
 
     /// <summary>
-    /// 
+    /// Starts capture of the whole texture to a file. Every poll event (see IssuePollEvent) copies it every everyNFrames
+    /// poll events and the copies are written to the file on a background thread, main thread doesn't touch them.
+    /// Copy is skipped when depth copies already wait for the disk or when the file is full.
+    /// </summary>
+    /// <param name="texture"></param>
+    /// <param name="everyNFrames">Poll events between two copies, 1 copies every poll event.</param>
+    /// <param name="depth">Copies in flight or waiting to be written, 1 to 16.</param>
+    /// <param name="path">File is created (or overwritten) and maxMB of disk space is reserved for it.</param>
+    /// <param name="maxMB">Size limit of the file including its index.</param>
+    /// <param name="capture">Id used to query and stop the capture.</param>
+    /// <returns></returns>
+    public static Status StartCapture(Texture texture, int everyNFrames, int depth, string path, int maxMB, out int capture)
+    {
+        capture = -1;
+        Status status;
+        if (texture == null || path == null)
+            status = Status.Error_InvalidArguments;
+        else
+            status = StartCapture(GetTextureHandle(texture), everyNFrames, depth, path, maxMB, out capture);
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("StartCapture failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+#if UNITY_5_5_OR_NEWER
+    /// <summary>
+    /// Starts capture of the whole buffer to a file, see StartCapture for textures.
     /// </summary>
     /// <param name="buffer"></param>
-    /// <param name="data"></param>
+    /// <param name="everyNFrames">Poll events between two copies, 1 copies every poll event.</param>
+    /// <param name="depth">Copies in flight or waiting to be written, 1 to 16.</param>
+    /// <param name="path">File is created (or overwritten) and maxMB of disk space is reserved for it.</param>
+    /// <param name="maxMB">Size limit of the file including its index.</param>
+    /// <param name="capture">Id used to query and stop the capture.</param>
     /// <returns></returns>
-    public static Status RetrieveBufferData(ComputeBuffer buffer, byte[] data)
+    public static Status StartCapture(ComputeBuffer buffer, int everyNFrames, int depth, string path, int maxMB, out int capture)
     {
+        capture = -1;
         Status status;
-        if (buffer == null || data == null)
+        if (buffer == null || path == null)
             status = Status.Error_InvalidArguments;
         else
+            status = StartCapture(GetBufferHandle(buffer), everyNFrames, depth, path, maxMB, out capture);
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("StartCapture failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+#endif // UNITY_5_5_OR_NEWER
+
+    /// <summary>
+    /// Stops the capture. Background thread writes the remaining copies and the index and closes the file,
+    /// render thread doesn't wait for it. Call GetCaptureStatus until it reports the capture finished.
+    /// </summary>
+    /// <param name="capture">Id returned by StartCapture.</param>
+    /// <returns></returns>
+    public static Status StopCapture(int capture)
+    {
+        Status status;
+        int eventId = StopCaptureNative(capture);
+        if (eventId != -1)
         {
-            int slot = RetrieveBufferData(GetBufferPtr(buffer), data, data.Length * sizeof(byte));
-            if (slot != -1)
-            {
-                status = Status.NotReady;
-                GL.IssuePluginEvent(GetCopyBufferEventFunc(), slot);
-            }
-            else
-            {
-                status = (Status)GetLastStatus();
-            }
+            status = Status.Succeeded;
+            GL.IssuePluginEvent(GetSubscriptionEventFunc(), eventId);
         }
+        else
+            status = (Status)GetLastStatus();
 
 #if UNITY_EDITOR // check for errors in editor
         if (Failed(status))
-            Debug.LogError("RetrieveBufferData failed: " + status);
+            Debug.LogError("StopCapture failed: " + status);
+#endif // UNITY_EDITOR
+        return status;
+    }
+
+    /// <summary>
+    /// Progress of running or stopped capture. Doesn't issue any render event.
+    /// </summary>
+    /// <param name="capture">Id returned by StartCapture.</param>
+    /// <param name="written">Copies written to the file.</param>
+    /// <param name="skipped">Copies skipped because the disk fell behind or the file was full.</param>
+    /// <param name="failed">Copies that failed on gpu side or couldn't be written.</param>
+    /// <param name="bytes">Bytes of copies written to the file.</param>
+    /// <param name="finished">Stopped capture closed its file (poll events release its memory). Capture id is invalid afterwards.</param>
+    /// <returns></returns>
+    public static Status GetCaptureStatus(int capture, out int written, out int skipped, out int failed, out long bytes, out bool finished)
+    {
+        int captureFinished;
+        Status status = (Status)GetCaptureStatusNative(capture, out written, out skipped, out failed, out bytes, out captureFinished);
+        finished = captureFinished != 0;
+
+#if UNITY_EDITOR // check for errors in editor
+        if (Failed(status))
+            Debug.LogError("GetCaptureStatus failed: " + status);
 #endif // UNITY_EDITOR
         return status;
     }
 
-    private static IntPtr GetBufferPtr(ComputeBuffer buffer)
+    private static Status Subscribe(int resourceHandle, int everyNFrames, int ringDepth, out int subscription)
     {
-        IntPtr ptr;
-        if (_bufferHandles.TryGetValue(buffer, out ptr))
-            return ptr;
+        subscription = -1;
+        if (resourceHandle == -1)
+            return (Status)GetLastStatus();
 
-        ptr = buffer.GetNativeBufferPtr();
-        _bufferHandles.Add(buffer, ptr);
-        return ptr;
+        int eventId = SubscribeNative(resourceHandle, everyNFrames, ringDepth, out subscription);
+        if (eventId == -1)
+            return (Status)GetLastStatus();
+
+        GL.IssuePluginEvent(GetSubscriptionEventFunc(), eventId);
+        return Status.Succeeded;
     }
-#endif // UNITY_5_5_OR_NEWER
+
+    private static Status StartCapture(int resourceHandle, int everyNFrames, int depth, string path, int maxMB, out int capture)
+    {
+        capture = -1;
+        if (resourceHandle == -1)
+            return (Status)GetLastStatus();
+
+        int eventId = StartCaptureNative(resourceHandle, everyNFrames, depth, path, maxMB, out capture);
+        if (eventId == -1)
+            return (Status)GetLastStatus();
+
+        GL.IssuePluginEvent(GetSubscriptionEventFunc(), eventId);
+        return Status.Succeeded;
+    }
+
+    [AOT.MonoPInvokeCallback(typeof(NativeCompletionCallback))]
+    private static void OnCompletion(int resourceHandle, int requestId, int status, IntPtr userData)
+    {
+        CompletionCallback callback = _completionCallback;
+        if (callback != null)
+            callback(requestId, (Status)status);
+    }
+
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    private delegate void NativeCompletionCallback(int resourceHandle, int requestId, int status, IntPtr userData);
 
     /// <summary>
     /// 
@@ -429,40 +1866,116 @@ public class AsyncTextureReader
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
     private delegate void MyDelegate(string str);
 
-    private static IntPtr GetTexturePtr(Texture texture)
+    private static int GetTextureHandle(Texture texture)
+    {
+        int handle;
+        if (_textureHandles.TryGetValue(texture, out handle))
+            return handle;
+
+        handle = RegisterTexture(texture.GetNativeTexturePtr());
+        if (handle != -1)
+        {
+            _textureHandles.Add(texture, handle);
+            // label for the request timeline (SetReadbackTrace), buffers are labeled by their handle
+            SetResourceName(handle, texture.name);
+        }
+        return handle;
+    }
+
+    private static int FindTextureHandle(Texture texture)
+    {
+        int handle;
+        if (_textureHandles.TryGetValue(texture, out handle))
+            return handle;
+        return -1;
+    }
+
+    private static int GetResourceHandle(object resource)
     {
-        IntPtr ptr;
-        if (_textureHandles.TryGetValue(texture, out ptr))
-            return ptr;
+        Texture texture = resource as Texture;
+        if (texture != null)
+            return GetTextureHandle(texture);
+#if UNITY_5_5_OR_NEWER
+        ComputeBuffer buffer = resource as ComputeBuffer;
+        if (buffer != null)
+            return GetBufferHandle(buffer);
+#endif // UNITY_5_5_OR_NEWER
+        return -1;
+    }
 
-        ptr = texture.GetNativeTexturePtr();
-        _textureHandles.Add(texture, ptr);
-        return ptr;
+    // unpacks native histogram starting at index, returns index after it
+    private static int ReadHistogram(StatsHistogram histogram, int index)
+    {
+        histogram.Count = _statsData[index++];
+        histogram.Sum = _statsData[index++];
+        histogram.Max = _statsData[index++];
+        Array.Copy(_statsData, index, histogram.Buckets, 0, StatsHistogram.BucketCount);
+        return index + StatsHistogram.BucketCount;
     }
 
-    private static Dictionary<Texture, IntPtr> _textureHandles = new Dictionary<Texture, IntPtr>();
-    private static Dictionary<ComputeBuffer, IntPtr> _bufferHandles = new Dictionary<ComputeBuffer, IntPtr>();
+    // user callback and the delegate passed to the plugin, kept here so they aren't garbage collected
+    private static CompletionCallback _completionCallback;
+    private static NativeCompletionCallback _nativeCompletionCallback = OnCompletion;
+
+    // native reduction result, reused by every RetrieveTextureReduction call
+    private static float[] _reductionData = new float[12 + ReductionResult.HistogramBins];
+    private static int[] _deltaHeaderData = new int[DeltaHeader.Size / sizeof(int)];
+    private static long[] _statsData = new long[ReadbackStats.ValueCount];
+
+    // plugin handles of registered textures and buffers
+    private static Dictionary<Texture, int> _textureHandles = new Dictionary<Texture, int>();
+#if UNITY_5_5_OR_NEWER
+    private static Dictionary<ComputeBuffer, int> _bufferHandles = new Dictionary<ComputeBuffer, int>();
+#endif // UNITY_5_5_OR_NEWER
 
     #region DllImport
     [DllImport("AsyncTextureReader")]
-    private static extern int ReleaseTempResources(IntPtr resourceHandle);
+    private static extern int RegisterTexture(IntPtr nativeTexture);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RegisterBuffer(IntPtr nativeBuffer);
+    [DllImport("AsyncTextureReader")]
+    private static extern int ReleaseTempResources(int resourceHandle);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RequestTextureData(int textureHandle);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RequestTextureRegion(int textureHandle, int x, int y, int width, int height);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RequestTextureSubresource(int textureHandle, int mipLevel, int slice, int sliceCount, int x, int y, int width, int height);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RequestTextureReduction(int textureHandle, int mipLevel, int slice, int flags, int histogramChannel, float histogramMin, float histogramMax);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RequestTextureConversion(int textureHandle, int mipLevel, int slice, int sliceCount, int x, int y, int width, int height, int outputType, int channelMask, int flags);
     [DllImport("AsyncTextureReader")]
-    private static extern int RequestTextureData(IntPtr textureHandle);
+    private static extern int RequestTextureDelta(int textureHandle, int mipLevel, int slice, int sliceCount, int tileSize);
     [DllImport("AsyncTextureReader")]
-    private static extern int RetrieveTextureData(IntPtr textureHandle, int[] data, int dataSize);
+    private static extern int RetrieveTextureDelta(int textureHandle, byte[] data, int dataSize, out int deltaSize);
     [DllImport("AsyncTextureReader")]
-    private static extern int RetrieveTextureData(IntPtr textureHandle, float[] data, int dataSize);
+    private static extern int RetrieveTextureData(int textureHandle, int[] data, int dataSize);
     [DllImport("AsyncTextureReader")]
-    private static extern int RetrieveTextureData(IntPtr textureHandle, byte[] data, int dataSize);
+    private static extern int RetrieveTextureData(int textureHandle, float[] data, int dataSize);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RetrieveTextureData(int textureHandle, byte[] data, int dataSize);
+
+    [DllImport("AsyncTextureReader")]
+    private static extern int RequestBufferData(int bufferHandle);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RequestBufferRange(int bufferHandle, int offset, int length);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RetrieveBufferData(int bufferHandle, int[] data, int dataSize);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RetrieveBufferData(int bufferHandle, float[] data, int dataSize);
+    [DllImport("AsyncTextureReader")]
+    private static extern int RetrieveBufferData(int bufferHandle, byte[] data, int dataSize);
 
     [DllImport("AsyncTextureReader")]
-    private static extern int RequestBufferData(IntPtr textureHandle);
+    private static extern int RequestBatch(int[] resourceHandles, int count, out int batchId);
     [DllImport("AsyncTextureReader")]
-    private static extern int RetrieveBufferData(IntPtr bufferHandle, int[] data, int dataSize);
+    private static extern int RetrieveBatch(int batchId, IntPtr[] data, int[] dataSizes, int count);
+
     [DllImport("AsyncTextureReader")]
-    private static extern int RetrieveBufferData(IntPtr bufferHandle, float[] data, int dataSize);
+    private static extern int AcquireReadback(int resourceHandle, out IntPtr data, out int dataSize, out int rowPitch, out int lease);
     [DllImport("AsyncTextureReader")]
-    private static extern int RetrieveBufferData(IntPtr bufferHandle, byte[] data, int dataSize);
+    private static extern int ReleaseReadback(int lease);
 
     [DllImport("AsyncTextureReader")]
     private static extern IntPtr GetReleaseTempResourcesEventFunc();
@@ -474,9 +1987,49 @@ public class AsyncTextureReader
     private static extern IntPtr GetCopyTextureEventFunc();
     [DllImport("AsyncTextureReader")]
     private static extern IntPtr GetCopyBufferEventFunc();
+    [DllImport("AsyncTextureReader")]
+    private static extern IntPtr GetPollEventFunc();
+
+    [DllImport("AsyncTextureReader")]
+    private static extern int SetCompletionCallback(NativeCompletionCallback callback, IntPtr userData);
+    [DllImport("AsyncTextureReader", EntryPoint = "GetCompletionHandle")]
+    private static extern IntPtr GetCompletionHandleNative();
+    [DllImport("AsyncTextureReader")]
+    private static extern int PopCompletion(out int resourceHandle, out int requestId, out int status);
+
+    [DllImport("AsyncTextureReader")]
+    private static extern IntPtr GetSubscriptionEventFunc();
+    [DllImport("AsyncTextureReader", EntryPoint = "Subscribe")]
+    private static extern int SubscribeNative(int resourceHandle, int everyNFrames, int ringDepth, out int subscription);
+    [DllImport("AsyncTextureReader", EntryPoint = "Unsubscribe")]
+    private static extern int UnsubscribeNative(int subscription);
+    [DllImport("AsyncTextureReader", EntryPoint = "RetrieveSubscription")]
+    private static extern int RetrieveSubscriptionNative(int subscription, int latest, IntPtr data, int dataSize, out int frame, out int dropped);
+    [DllImport("AsyncTextureReader", EntryPoint = "StartCapture")]
+    private static extern int StartCaptureNative(int resourceHandle, int everyNFrames, int depth, string path, int maxMB, out int capture);
+    [DllImport("AsyncTextureReader", EntryPoint = "StopCapture")]
+    private static extern int StopCaptureNative(int capture);
+    [DllImport("AsyncTextureReader", EntryPoint = "GetCaptureStatus")]
+    private static extern int GetCaptureStatusNative(int capture, out int written, out int skipped, out int failed, out long bytes, out int finished);
 
     [DllImport("AsyncTextureReader")]
     private static extern int GetLastStatus();
+    [DllImport("AsyncTextureReader")]
+    private static extern int GetLastRequestId();
+    [DllImport("AsyncTextureReader", EntryPoint = "SetStagingRingSize")]
+    private static extern int SetStagingRingSizeNative(int size);
+    [DllImport("AsyncTextureReader", EntryPoint = "SetCopyThread")]
+    private static extern int SetCopyThreadNative(int enabled);
+    [DllImport("AsyncTextureReader", EntryPoint = "SetStagingPool")]
+    private static extern int SetStagingPoolNative(int budgetMB, int idleFrames);
+    [DllImport("AsyncTextureReader", EntryPoint = "GetReadbackStats")]
+    private static extern int GetReadbackStatsNative(long[] stats, int statsSize, int reset);
+    [DllImport("AsyncTextureReader", EntryPoint = "SetReadbackTrace")]
+    private static extern int SetReadbackTraceNative(int enabled);
+    [DllImport("AsyncTextureReader", EntryPoint = "WriteReadbackTrace")]
+    private static extern int WriteReadbackTraceNative(string path);
+    [DllImport("AsyncTextureReader")]
+    private static extern int SetResourceName(int resourceHandle, string name);
 
     [DllImport("AsyncTextureReader")]
     private static extern int SetDebugFunction(IntPtr functionPointer);